@@ -42,6 +42,11 @@ if (ZOM_DISABLE_GLOB_CTOR)
   endif ()
 endif ()
 
+if (ZOM_SAVE_LOCK_LOCATIONS)
+  message(STATUS "Save lock locations")
+  add_compile_definitions(ZC_SAVE_LOCK_LOCATIONS=1)
+endif ()
+
 if (ZOM_ENABLE_UNITTESTS)
   message(STATUS "Enable Unitttests")
   enable_testing()
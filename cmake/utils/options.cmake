@@ -9,7 +9,10 @@ option(ZOM_ENABLE_WALL "Enable most warnings (-Wall -Wextra)" ON)
 option(ZOM_DISABLE_GLOB_CTOR
        "Disable declare global or static variables with dynamic constructors"
        ON)
+option(ZOM_SAVE_LOCK_LOCATIONS
+       "Record where each mutex is locked from, for the lock profiler" OFF)
 option(BUILD_STATIC_LIB "Build ZOM as a static library" ON)
 option(BUILD_CLI "Build ZOM CLI" ON)
 option(ZOM_ENABLE_UNITTESTS "Enable ZOM unittests" ON)
-option(ZOM_ENABLE_COVERAGE "Enable coverage reporting" OFF)
\ No newline at end of file
+option(ZOM_ENABLE_COVERAGE "Enable coverage reporting" OFF)
+option(ZOM_ENABLE_FUZZING "Link the fuzz targets against libFuzzer (Clang only)" OFF)
@@ -2109,7 +2109,7 @@ private:
     return evalLater([this] {
              // Attempt to fill any sinks that exist.
 
-             Vector<Promise<void>> promises;
+             InlineVector<Promise<void>, 2> promises;
 
              for (auto& branch : branches) {
                ZC_IF_SOME(sink, branch.sink) { promises.add(sink.fill(branch.buffer, stoppage)); }
@@ -2241,8 +2241,8 @@ void AsyncTee::Buffer::produce(Array<byte> bytes) { bufferList.push_back(mv(byte
 Array<const ArrayPtr<const byte>> AsyncTee::Buffer::asArray(uint64_t maxBytes, uint64_t& amount) {
   amount = 0;
 
-  Vector<ArrayPtr<const byte>> buffers;
-  Vector<Array<byte>> ownBuffers;
+  InlineVector<ArrayPtr<const byte>, 4> buffers;
+  InlineVector<Array<byte>, 4> ownBuffers;
 
   while (maxBytes > 0 && !bufferList.empty()) {
     auto& bytes = bufferList.front();
@@ -2970,13 +2970,33 @@ ArrayPtr<const CidrRange> exampleAddresses() {
   return zc::arrayPtr(result, zc::size(result));
 }
 
-bool matchesAny(ArrayPtr<const CidrRange> cidrs, const struct sockaddr* addr) {
-  for (auto& cidr : cidrs) {
-    if (cidr.matches(addr)) return true;
-  }
-  return false;
+namespace {
+
+const CidrSet& nonPublicCidrs() {
+  // Addresses that "public" excludes.
+  static const CidrSet result = []() {
+    CidrSet set;
+    set.addAll(privateCidrs());
+    set.addAll(localCidrs());
+    set.addAll(reservedCidrs());
+    return set;
+  }();
+  return result;
+}
+
+const CidrSet& nonNetworkCidrs() {
+  // Addresses that "network" excludes.
+  static const CidrSet result = []() {
+    CidrSet set;
+    set.addAll(localCidrs());
+    set.addAll(reservedCidrs());
+    return set;
+  }();
+  return result;
 }
 
+}  // namespace
+
 NetworkFilter::NetworkFilter() : allowUnix(true), allowAbstractUnix(true) {
   allowCidrs.add(CidrRange::inet4({0, 0, 0, 0}, 0));
   allowCidrs.add(CidrRange::inet6({}, {}, 0));
@@ -3045,8 +3065,7 @@ bool NetworkFilter::shouldAllow(const struct sockaddr* addr, uint addrlen) {
 
   if (allowPublic) {
     if ((addr->sa_family == AF_INET || addr->sa_family == AF_INET6) &&
-        !matchesAny(privateCidrs(), addr) && !matchesAny(localCidrs(), addr) &&
-        !matchesAny(reservedCidrs(), addr)) {
+        !nonPublicCidrs().matches(addr)) {
       allowed = true;
       // Don't adjust allowSpecificity as this match has an effective specificity of zero.
     }
@@ -3054,23 +3073,19 @@ bool NetworkFilter::shouldAllow(const struct sockaddr* addr, uint addrlen) {
 
   if (allowNetwork) {
     if ((addr->sa_family == AF_INET || addr->sa_family == AF_INET6) &&
-        !matchesAny(localCidrs(), addr) && !matchesAny(reservedCidrs(), addr)) {
+        !nonNetworkCidrs().matches(addr)) {
       allowed = true;
       // Don't adjust allowSpecificity as this match has an effective specificity of zero.
     }
   }
 
-  for (auto& cidr : allowCidrs) {
-    if (cidr.matches(addr)) {
-      allowSpecificity = zc::max(allowSpecificity, cidr.getSpecificity());
-      allowed = true;
-    }
+  ZC_IF_SOME(specificity, allowCidrs.longestMatch(addr)) {
+    allowSpecificity = specificity;
+    allowed = true;
   }
   if (!allowed) return false;
-  for (auto& cidr : denyCidrs) {
-    if (cidr.matches(addr)) {
-      if (cidr.getSpecificity() >= allowSpecificity) return false;
-    }
+  ZC_IF_SOME(specificity, denyCidrs.longestMatch(addr)) {
+    if (specificity >= allowSpecificity) return false;
   }
 
   ZC_IF_SOME(n, next) { return n.shouldAllow(addr, addrlen); }
@@ -3093,9 +3108,7 @@ bool NetworkFilter::shouldAllowParse(const struct sockaddr* addr, uint addrlen)
         (allowPublic || allowNetwork)) {
       matched = true;
     }
-    for (auto& cidr : allowCidrs) {
-      if (cidr.matchesFamily(addr->sa_family)) { matched = true; }
-    }
+    if (allowCidrs.matchesFamily(addr->sa_family)) { matched = true; }
 #if !_WIN32
   }
 #endif
@@ -22,9 +22,11 @@
 #pragma once
 
 #include <zc/core/common.h>
+#include <zc/core/concurrent-queue.h>
 #include <zc/core/debug.h>
 #include <zc/core/list.h>
 #include <zc/core/memory.h>
+#include <zc/core/mutex.h>
 
 #include <list>
 
@@ -146,6 +148,62 @@ private:
   WaiterQueue<T> waiters;
 };
 
+class CrossThreadQueueWaker final : public QueueWaker {
+  // Lets a consumer running an event loop sleep until another thread pushes onto one of the
+  // lock-free queues in zc/core/concurrent-queue.h:
+  //
+  //     MpmcQueue<Job> queue(1024);
+  //     CrossThreadQueueWaker waker;
+  //     queue.setWaker(waker);
+  //     ...
+  //     for (;;) {
+  //       ZC_IF_SOME(job, queue.tryPop()) {
+  //         run(job);
+  //       } else {
+  //         co_await waker.wait([&]() { return !queue.isEmpty(); });
+  //       }
+  //     }
+  //
+  // While nobody is waiting, wake() is a fence and a load, so producers stay lock-free. Only
+  // waking a sleeping consumer takes a lock, to fulfill a CrossThreadPromiseFulfiller.
+
+public:
+  template <typename Func>
+  Promise<void> wait(Func&& isReady) {
+    // Resolves after the next wake(). `isReady()` is checked once the waiter is registered, and
+    // the promise is ready at once if it returns true; this catches pushes that happened after the
+    // caller last found the queue empty. Only one wait() may be outstanding at a time.
+
+    auto paf = newPromiseAndCrossThreadFulfiller<void>();
+    *fulfiller.lockExclusive() = zc::mv(paf.fulfiller);
+    __atomic_store_n(&waiting, true, __ATOMIC_SEQ_CST);
+
+    if (isReady()) {
+      __atomic_store_n(&waiting, false, __ATOMIC_RELAXED);
+      auto lock = fulfiller.lockExclusive();
+      ZC_IF_SOME(f, *lock) { f->fulfill(); }
+      *lock = zc::none;
+    }
+    return zc::mv(paf.promise);
+  }
+
+  void wake() const override {
+    // Pairs with the store in wait(): either wait()'s isReady() sees the new item, or this sees
+    // `waiting`.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&waiting, __ATOMIC_RELAXED)) return;
+    if (!__atomic_exchange_n(&waiting, false, __ATOMIC_ACQ_REL)) return;
+
+    auto lock = fulfiller.lockExclusive();
+    ZC_IF_SOME(f, *lock) { f->fulfill(); }
+    *lock = zc::none;
+  }
+
+private:
+  mutable bool waiting = false;
+  MutexGuarded<Maybe<Own<CrossThreadPromiseFulfiller<void>>>> fulfiller;
+};
+
 }  // namespace zc
 
 ZC_END_HEADER
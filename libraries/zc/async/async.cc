@@ -49,6 +49,7 @@
 #include "zc/core/map.h"
 #include "zc/core/mutex.h"
 #include "zc/core/one-of.h"
+#include "zc/core/rcu.h"
 #include "zc/core/vector.h"
 
 #if __linux__
@@ -1700,6 +1701,8 @@ struct FiberStack::Impl {
     void EventLoop::run(uint maxTurnCount) {
       running = true;
       ZC_DEFER(running = false);
+      rcuThreadOnline();
+      ZC_DEFER(rcuThreadOffline());
 
       for (uint i = 0; i < maxTurnCount; i++) {
         if (!turn()) { break; }
@@ -1735,6 +1738,11 @@ struct FiberStack::Impl {
         }
 
         depthFirstInsertPoint = &head;
+
+        // Between events, this thread holds no references into Rcu<T>s except through RcuPtrs.
+        // The thread is only online while the loop runs events, so that it doesn't hold back
+        // reclamation while it blocks anywhere else.
+        rcuQuiescentState();
         return true;
       }
     }
@@ -1776,6 +1784,10 @@ struct FiberStack::Impl {
         return;
       }
 
+      // Don't hold back Rcu<T> reclamation while asleep.
+      rcuThreadOffline();
+      ZC_DEFER(rcuThreadOnline());
+
       ZC_IF_SOME(p, port) {
         if (p.wait()) {
           // Another thread called wake(). Check for cross-thread events.
@@ -1809,6 +1821,8 @@ struct FiberStack::Impl {
 
       loop.running = true;
       ZC_DEFER(loop.running = false);
+      rcuThreadOnline();
+      ZC_DEFER(rcuThreadOffline());
 
       uint turnCount = 0;
       runOnStackPool([&]() {
@@ -1911,6 +1925,8 @@ struct FiberStack::Impl {
 
         loop.running = true;
         ZC_DEFER(loop.running = false);
+        rcuThreadOnline();
+        ZC_DEFER(rcuThreadOffline());
 
         for (;;) {
           waitScope.runOnStackPool([&]() {
@@ -1956,6 +1972,8 @@ struct FiberStack::Impl {
 
       loop.running = true;
       ZC_DEFER(loop.running = false);
+      rcuThreadOnline();
+      ZC_DEFER(rcuThreadOffline());
 
       waitScope.runOnStackPool([&]() {
         while (!doneEvent.fired) {
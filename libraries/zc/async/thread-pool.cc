@@ -0,0 +1,347 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // for pthread_setaffinity_np()
+#endif
+
+#if _WIN32
+#include <zc/core/win32-api-version.h>
+#endif
+
+#include "zc/async/thread-pool.h"
+
+#include "zc/async/async-queue.h"
+#include "zc/core/concurrent-queue.h"
+#include "zc/core/debug.h"
+#include "zc/core/mutex.h"
+#include "zc/core/refcount.h"
+#include "zc/core/thread.h"
+
+#if _WIN32
+#include <windows.h>
+#include <zc/core/windows-sanity.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace zc {
+
+namespace {
+
+static constexpr size_t INJECTED_QUEUE_SIZE = 4096;
+// Capacity of the queue for work submitted from outside the pool. Submitting blocks while it is
+// full.
+
+static constexpr uint POLL_INTERVAL = 64;
+// A busy worker polls its event loop, to pick up work sent with Executor::executeAsync(), at
+// least once per this many tasks.
+
+uint getCpuCount() {
+#if _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count < 1 ? 1 : count;
+#endif
+}
+
+void yieldThread() {
+#if _WIN32
+  Sleep(0);
+#else
+  sched_yield();
+#endif
+}
+
+void pinToCpu(uint index) {
+#if __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % getCpuCount(), &set);
+  int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) { ZC_LOG(WARNING, "couldn't pin thread pool worker to a CPU", index, error); }
+#else
+  (void)index;
+#endif
+}
+
+class ParallelState final : public AtomicRefcounted {
+  // Shared between the thread that called parallelFor() and its helper tasks. Helpers may start
+  // after the call has returned, so this is refcounted, and `job` is only touched while running a
+  // claimed chunk, which the caller always waits for.
+
+public:
+  ParallelState(ThreadPool::ParallelJob& job, size_t chunkCount)
+      : job(job), chunkCount(chunkCount), remaining(chunkCount) {}
+
+  void runChunks() const {
+    for (;;) {
+      size_t chunk = __atomic_fetch_add(&nextChunk, 1, __ATOMIC_RELAXED);
+      if (chunk >= chunkCount) return;
+
+      size_t finished = 1;
+      ZC_IF_SOME(exception, runCatchingExceptions([&]() { job.runChunk(chunk); })) {
+        // Claim every chunk nobody has started yet, so that they never run.
+        size_t next = __atomic_exchange_n(&nextChunk, chunkCount, __ATOMIC_RELAXED);
+        if (next < chunkCount) finished += chunkCount - next;
+
+        auto lock = status.lockExclusive();
+        if (lock->exception == zc::none) lock->exception = zc::mv(exception);
+      }
+
+      if (__atomic_sub_fetch(&remaining, finished, __ATOMIC_ACQ_REL) == 0) {
+        status.lockExclusive()->done = true;
+      }
+    }
+  }
+
+  void wait() const {
+    // Waits for every chunk to finish, and rethrows the first exception.
+    auto lock = status.lockExclusive();
+    lock.wait([](const Status& status) { return status.done; });
+    ZC_IF_SOME(exception, lock->exception) { throwRecoverableException(zc::mv(exception)); }
+  }
+
+private:
+  struct Status {
+    bool done = false;
+    Maybe<Exception> exception;
+  };
+
+  ThreadPool::ParallelJob& job;
+  size_t chunkCount;
+  mutable size_t nextChunk = 0;
+  mutable size_t remaining;
+  MutexGuarded<Status> status;
+};
+
+class ParallelTask final : public ThreadPool::Task {
+public:
+  ParallelTask(Own<const ParallelState> state) : state(zc::mv(state)) {}
+  void run() override { state->runChunks(); }
+
+private:
+  Own<const ParallelState> state;
+};
+
+}  // namespace
+
+class ThreadPool::Scheduler final : public QueueWaker {
+public:
+  Scheduler(Options options) : options(options) {
+    uint count = options.threadCount == 0 ? getCpuCount() : options.threadCount;
+    injected.setWaker(*this);
+
+    auto builder = heapArrayBuilder<Own<Worker>>(count);
+    for (uint i : zeroTo(count)) {
+      builder.add(heap<Worker>(*this, i));
+      builder.back()->deque.setWaker(*this);
+    }
+    workers = builder.finish();
+
+    // Workers steal from each other, so only start them once they all exist.
+    for (auto& worker : workers) {
+      Worker& ref = *worker;
+      worker->thread = heap<Thread>([this, &ref]() { runWorker(ref); });
+    }
+  }
+
+  ~Scheduler() noexcept(false) {
+    __atomic_store_n(&shuttingDown, true, __ATOMIC_SEQ_CST);
+    for (auto& worker : workers) { worker->waker.wake(); }
+
+    // Workers drain all queued work before exiting. Joining them rethrows anything they threw.
+    for (auto& worker : workers) { worker->thread = zc::none; }
+
+    // Anything scheduled concurrently with the destructor never runs. Dropping it rejects its
+    // promise.
+    for (;;) {
+      ZC_IF_SOME(task, injected.tryPop()) {
+        auto drop = zc::mv(task->self);
+      } else {
+        break;
+      }
+    }
+  }
+
+  uint getThreadCount() const { return workers.size(); }
+
+  const Executor& getExecutor(uint index) const {
+    ZC_REQUIRE(index < workers.size(), "no such thread pool worker", index);
+    auto lock = workers[index]->executor.lockExclusive();
+    lock.wait([](const Maybe<Own<const Executor>>& executor) { return executor != zc::none; });
+    return *ZC_ASSERT_NONNULL(*lock);
+  }
+
+  void schedule(Task& task) {
+    Worker* worker = currentWorker;
+    if (worker != nullptr && &worker->scheduler == this) {
+      worker->deque.push(&task);
+    } else {
+      Task* ptr = &task;
+      while (!injected.tryPush(zc::mv(ptr))) { yieldThread(); }
+    }
+  }
+
+  void wake() const override {
+    // Called after every push onto any of our queues. Wakes one sleeping worker, if there is one.
+    // Pairs with the stores in sleep(): either this sees the worker's `sleeping`, or the worker's
+    // isReady() check sees the new task.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&sleepers, __ATOMIC_RELAXED) == 0) return;
+
+    for (auto& worker : workers) {
+      if (__atomic_load_n(&worker->sleeping, __ATOMIC_RELAXED) &&
+          __atomic_exchange_n(&worker->sleeping, false, __ATOMIC_ACQ_REL)) {
+        worker->waker.wake();
+        return;
+      }
+    }
+  }
+
+private:
+  struct Worker {
+    Worker(Scheduler& scheduler, uint index) : scheduler(scheduler), index(index) {}
+
+    Scheduler& scheduler;
+    uint index;
+    WorkStealingDeque<Task*> deque;
+    CrossThreadQueueWaker waker;
+    mutable bool sleeping = false;
+    MutexGuarded<Maybe<Own<const Executor>>> executor;
+    Maybe<Own<Thread>> thread;
+  };
+
+  Options options;
+  Array<Own<Worker>> workers;
+  MpmcQueue<Task*> injected{INJECTED_QUEUE_SIZE};
+  bool shuttingDown = false;
+  uint sleepers = 0;
+
+  static thread_local Worker* currentWorker;
+
+  void runWorker(Worker& worker) {
+    if (options.pinThreads) pinToCpu(worker.index);
+
+    EventLoop loop;
+    WaitScope waitScope(loop);
+    *worker.executor.lockExclusive() = getCurrentThreadExecutor().addRef();
+    currentWorker = &worker;
+    ZC_DEFER(currentWorker = nullptr);
+
+    uint sincePoll = 0;
+    for (;;) {
+      ZC_IF_SOME(task, findTask(worker)) {
+        runTask(*task);
+        if (++sincePoll >= POLL_INTERVAL || loop.isRunnable()) {
+          waitScope.poll();
+          sincePoll = 0;
+        }
+      } else if (__atomic_load_n(&shuttingDown, __ATOMIC_ACQUIRE)) {
+        waitScope.poll();
+        return;
+      } else {
+        sleep(worker, waitScope);
+        sincePoll = 0;
+      }
+    }
+  }
+
+  Maybe<Task*> findTask(Worker& worker) {
+    ZC_IF_SOME(task, worker.deque.pop()) { return task; }
+    ZC_IF_SOME(task, injected.tryPop()) { return task; }
+
+    // Steal, starting from our neighbor so that thieves spread out over victims.
+    for (size_t i : range(size_t(1), workers.size())) {
+      ZC_IF_SOME(task, workers[(worker.index + i) % workers.size()]->deque.steal()) { return task; }
+    }
+    return zc::none;
+  }
+
+  bool hasWork() const {
+    if (!injected.isEmpty()) return true;
+    for (auto& worker : workers) {
+      if (!worker->deque.isEmpty()) return true;
+    }
+    return __atomic_load_n(&shuttingDown, __ATOMIC_SEQ_CST);
+  }
+
+  void sleep(Worker& worker, WaitScope& waitScope) {
+    // Runs the event loop until a task arrives. Executor calls and promises submitted work is
+    // waiting on keep running meanwhile.
+    __atomic_store_n(&worker.sleeping, true, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+    worker.waker.wait([this]() { return hasWork(); }).wait(waitScope);
+    __atomic_store_n(&worker.sleeping, false, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&sleepers, 1, __ATOMIC_SEQ_CST);
+  }
+};
+
+thread_local ThreadPool::Scheduler::Worker* ThreadPool::Scheduler::currentWorker = nullptr;
+
+ThreadPool::ThreadPool(Options options) : scheduler(heap<Scheduler>(options)) {}
+ThreadPool::ThreadPool(uint threadCount) : ThreadPool(Options{threadCount}) {}
+ThreadPool::~ThreadPool() noexcept(false) {}
+
+uint ThreadPool::getThreadCount() const { return scheduler->getThreadCount(); }
+
+const Executor& ThreadPool::getExecutor(uint index) const {
+  return scheduler->getExecutor(index);
+}
+
+void ThreadPool::schedule(Own<Task> task) {
+  Task& ref = *task;
+  ref.self = zc::mv(task);
+  scheduler->schedule(ref);
+}
+
+void ThreadPool::runTask(Task& task) {
+  ZC_IF_SOME(exception, runCatchingExceptions([&]() {
+               auto owned = zc::mv(task.self);
+               owned->run();
+             })) {
+    ZC_LOG(ERROR, "uncaught exception in thread pool task", exception);
+  }
+}
+
+void ThreadPool::runParallel(size_t chunkCount, ParallelJob& job) {
+  if (chunkCount == 0) return;
+  if (chunkCount == 1) {
+    job.runChunk(0);
+    return;
+  }
+
+  auto state = atomicRefcounted<const ParallelState>(job, chunkCount);
+  for (size_t i = 0, n = zc::min(getThreadCount(), chunkCount - 1); i < n; i++) {
+    schedule(heap<ParallelTask>(atomicAddRef(*state)));
+  }
+
+  // Rather than just waiting, this thread runs chunks too.
+  state->runChunks();
+  state->wait();
+}
+
+}  // namespace zc
@@ -0,0 +1,244 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <zc/core/common.h>
+#include <zc/core/debug.h>
+#include <zc/core/memory.h>
+
+#include "zc/async/async.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+class ThreadPool {
+  // A fixed set of worker threads for CPU-bound work.
+  //
+  // Each worker runs its own EventLoop, so work submitted to the pool may use promises, and each
+  // worker's Executor is published (getExecutor()) for callers that need to reach one specific
+  // thread. Work that is not pinned to a thread goes through submit(), parallelFor() and
+  // parallelReduce():
+  //
+  // * Each worker has a work-stealing deque. Work submitted from a worker thread goes onto that
+  //   worker's own deque, where the worker takes the newest item first (its data is likely still
+  //   in cache) and idle workers steal the oldest.
+  // * Work submitted from any other thread goes onto a shared queue which all workers take from.
+  // * A worker with nothing to do sleeps on its event loop. Adding work wakes one sleeping worker.
+  //
+  // parallelFor() and parallelReduce() block the calling thread, which also runs part of the work
+  // itself. They may be called from inside the pool, e.g. from a submitted task or from another
+  // parallelFor(), without deadlocking.
+  //
+  // Destroying the pool waits for all work submitted so far to finish, then joins the workers.
+  // Promises returned by work that is still pending on a worker's event loop at that point are
+  // rejected.
+
+public:
+  struct Options {
+    uint threadCount = 0;
+    // Number of workers. Zero means one per CPU.
+
+    bool pinThreads = false;
+    // Bind worker i to CPU i (modulo the number of CPUs), so that the OS does not migrate workers
+    // and their caches go cold. Only supported on Linux; ignored elsewhere.
+  };
+
+  explicit ThreadPool(Options options);
+  explicit ThreadPool(uint threadCount = 0);
+  ~ThreadPool() noexcept(false);
+  ZC_DISALLOW_COPY_AND_MOVE(ThreadPool);
+
+  uint getThreadCount() const;
+
+  const Executor& getExecutor(uint index) const;
+  // Returns the Executor of worker `index`, for running something on that specific thread.
+
+  template <typename Func>
+  PromiseForResult<Func, void> submit(Func&& func);
+  // Runs `func()` on some worker and returns a promise for its result, which may be waited on
+  // from any thread with an event loop. If `func` returns a promise, it runs on the worker's event
+  // loop and the result is the promise's result. Exceptions thrown by `func` reject the promise.
+  //
+  // `func` is moved to the worker, so must not capture anything that lives on the calling thread
+  // unless the caller keeps it alive until the promise resolves.
+
+  template <typename T, typename Func>
+  void parallelFor(Range<T> range, size_t grain, Func&& func);
+  // Calls `func(i)` for every `i` in `range`, in parallel, and returns once all calls are done.
+  //
+  // The range is split into chunks of `grain` consecutive indexes, which threads claim one at a
+  // time, so faster threads take more chunks. Larger grains cost less scheduling overhead; smaller
+  // grains balance uneven work better.
+  //
+  // If a call throws, no further chunks are started and the first exception is rethrown here once
+  // the chunks already running have finished.
+
+  template <typename T, typename Value, typename MapFunc, typename CombineFunc>
+  Value parallelReduce(Range<T> range, size_t grain, Value identity, MapFunc&& map,
+                       CombineFunc&& combine);
+  // Returns the combination of `map(i)` over all `i` in `range`, computed in parallel.
+  //
+  // Each chunk (as in parallelFor()) folds its values into a copy of `identity` with
+  // `combine(Value&& accumulated, Value&& next)`, so `Value` must be copyable. The caller then
+  // combines the chunks' results in order. `combine` must be associative, but need not be
+  // commutative, and the result does not depend on which threads ran which chunks: e.g. summing
+  // doubles gives the same answer every time.
+
+  class Task {
+    // A unit of work queued on the pool. Implementation detail of the methods above.
+
+  public:
+    virtual ~Task() noexcept(false) = default;
+    virtual void run() = 0;
+
+  private:
+    Own<Task> self;
+    // While queued, a task owns itself: the lock-free queues can only hold plain pointers.
+
+    friend class ThreadPool;
+  };
+
+  class ParallelJob {
+    // The body of a parallelFor(), split into numbered chunks. Implementation detail.
+
+  public:
+    virtual void runChunk(size_t chunk) = 0;
+  };
+
+private:
+  class Scheduler;
+
+  Own<Scheduler> scheduler;
+
+  void schedule(Own<Task> task);
+  static void runTask(Task& task);
+  void runParallel(size_t chunkCount, ParallelJob& job);
+};
+
+// =======================================================================================
+// inline implementation details
+
+namespace _ {  // private
+
+template <typename Func, typename Result>
+class ThreadPoolTask final : public ThreadPool::Task {
+public:
+  ThreadPoolTask(Func&& func, Own<CrossThreadPromiseFulfiller<Result>> fulfiller)
+      : func(zc::fwd<Func>(func)), fulfiller(zc::mv(fulfiller)) {}
+
+  void run() override {
+    if constexpr (isSameType<Decay<ReturnType<Func, void>>, PromiseForResult<Func, void>>()) {
+      // The function returns a promise: let it run on this worker's event loop. Dropping the
+      // fulfiller rejects the result if the loop is torn down first.
+      auto& f = *fulfiller;
+      Promise<void> done = nullptr;
+      if constexpr (isSameType<Result, void>()) {
+        done = evalNow(zc::mv(func)).then([&f]() { f.fulfill(); },
+                                          [&f](Exception&& e) { f.reject(zc::mv(e)); });
+      } else {
+        done = evalNow(zc::mv(func)).then([&f](Result&& value) { f.fulfill(zc::mv(value)); },
+                                          [&f](Exception&& e) { f.reject(zc::mv(e)); });
+      }
+      done.attach(zc::mv(fulfiller)).detach([](Exception&&) {});
+    } else {
+      fulfiller->rejectIfThrows([this]() {
+        if constexpr (isSameType<Result, void>()) {
+          func();
+          fulfiller->fulfill();
+        } else {
+          fulfiller->fulfill(func());
+        }
+      });
+    }
+  }
+
+private:
+  Decay<Func> func;
+  Own<CrossThreadPromiseFulfiller<Result>> fulfiller;
+};
+
+template <typename Func>
+class ThreadPoolJob final : public ThreadPool::ParallelJob {
+public:
+  ThreadPoolJob(Func& func) : func(func) {}
+  void runChunk(size_t chunk) override { func(chunk); }
+
+private:
+  Func& func;
+};
+
+}  // namespace _
+
+template <typename Func>
+PromiseForResult<Func, void> ThreadPool::submit(Func&& func) {
+  using Result = _::UnwrapPromise<PromiseForResult<Func, void>>;
+  auto paf = newPromiseAndCrossThreadFulfiller<Result>();
+  schedule(heap<_::ThreadPoolTask<Func, Result>>(zc::fwd<Func>(func), zc::mv(paf.fulfiller)));
+  return zc::mv(paf.promise);
+}
+
+template <typename T, typename Func>
+void ThreadPool::parallelFor(Range<T> range, size_t grain, Func&& func) {
+  T begin = *range.begin();
+  size_t count = range.size();
+  if (grain == 0) grain = 1;
+
+  auto runChunk = [&](size_t chunk) {
+    size_t first = chunk * grain;
+    size_t last = zc::min(first + grain, count);
+    for (size_t i = first; i < last; i++) { func(static_cast<T>(begin + i)); }
+  };
+  _::ThreadPoolJob<decltype(runChunk)> job(runChunk);
+  runParallel((count + grain - 1) / grain, job);
+}
+
+template <typename T, typename Value, typename MapFunc, typename CombineFunc>
+Value ThreadPool::parallelReduce(Range<T> range, size_t grain, Value identity, MapFunc&& map,
+                                 CombineFunc&& combine) {
+  T begin = *range.begin();
+  size_t count = range.size();
+  if (grain == 0) grain = 1;
+  size_t chunkCount = (count + grain - 1) / grain;
+
+  auto partials = heapArray<Maybe<Value>>(chunkCount);
+  auto runChunk = [&](size_t chunk) {
+    size_t first = chunk * grain;
+    size_t last = zc::min(first + grain, count);
+    Value accumulated = identity;
+    for (size_t i = first; i < last; i++) {
+      accumulated = combine(zc::mv(accumulated), map(static_cast<T>(begin + i)));
+    }
+    partials[chunk] = zc::mv(accumulated);
+  };
+  _::ThreadPoolJob<decltype(runChunk)> job(runChunk);
+  runParallel(chunkCount, job);
+
+  for (auto& partial : partials) {
+    identity = combine(zc::mv(identity), zc::mv(ZC_ASSERT_NONNULL(partial)));
+  }
+  return identity;
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
@@ -46,7 +46,9 @@ class Timer : public MonotonicClock {
   // Note that the value returned by `Timer::now()` only changes each time the
   // event loop waits for I/O from the system. While the event loop is actively
   // running, the time stays constant. This is intended to make behavior more
-  // deterministic and reproducible. However, if you need up-to-the-cycle
+  // deterministic and reproducible. It also makes `now()` as cheap as reading a
+  // variable, so code that arms timeouts on every request, like the HTTP server,
+  // reads no clock to do so. However, if you need up-to-the-cycle
   // accurate time, then `Timer::now()` is not appropriate. Instead, use
   // `systemPreciseMonotonicClock()` directly in this case.
 
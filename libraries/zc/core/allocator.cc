@@ -0,0 +1,413 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32 || __CYGWIN__
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "zc/core/debug.h"
+#include "zc/core/thread-record.h"
+
+#if _WIN32 || __CYGWIN__
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <sched.h>
+#endif
+
+namespace zc {
+
+namespace _ {  // private
+
+uint heapAllocatorState = HEAP_ALLOCATOR_UNDECIDED;
+
+}  // namespace _
+
+namespace {
+
+constexpr uint HEAP_ALLOCATOR_DECIDING = 3;
+// heapAllocatorState while one thread is choosing the allocator.
+
+HeapAllocator* heapAllocator = nullptr;
+// Set before heapAllocatorState leaves HEAP_ALLOCATOR_DECIDING, and never changed after.
+
+void yieldThread() {
+#if _WIN32 || __CYGWIN__
+  Sleep(0);
+#else
+  sched_yield();
+#endif
+}
+
+bool decideHeapAllocator(HeapAllocator& allocator) {
+  uint expected = _::HEAP_ALLOCATOR_UNDECIDED;
+  if (!__atomic_compare_exchange_n(&_::heapAllocatorState, &expected, HEAP_ALLOCATOR_DECIDING,
+                                   false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    return false;
+  }
+  heapAllocator = &allocator;
+  __atomic_store_n(&_::heapAllocatorState,
+                   &allocator == &SystemHeapAllocator::instance ? _::HEAP_ALLOCATOR_SYSTEM
+                                                                : _::HEAP_ALLOCATOR_CUSTOM,
+                   __ATOMIC_RELEASE);
+  return true;
+}
+
+HeapAllocator& allocatorFromEnvironment() {
+  // Can't log here: logging allocates, and no allocator has been chosen yet.
+  const char* name = getenv("ZC_HEAP_ALLOCATOR");
+  if (name != nullptr && strcmp(name, "size-class") == 0) return SizeClassAllocator::instance;
+  return SystemHeapAllocator::instance;
+}
+
+uint decidedHeapAllocatorState() {
+  for (;;) {
+    uint state = __atomic_load_n(&_::heapAllocatorState, __ATOMIC_ACQUIRE);
+    if (state == _::HEAP_ALLOCATOR_UNDECIDED) {
+      decideHeapAllocator(allocatorFromEnvironment());
+    } else if (state == HEAP_ALLOCATOR_DECIDING) {
+      yieldThread();
+    } else {
+      return state;
+    }
+  }
+}
+
+}  // namespace
+
+namespace _ {  // private
+
+void* heapAllocateSlow(size_t size) {
+  if (decidedHeapAllocatorState() == HEAP_ALLOCATOR_SYSTEM) return operator new(size);
+  return heapAllocator->allocate(size);
+}
+
+void heapDeallocateSlow(void* pointer, size_t size) {
+  // Something was allocated, so the allocator has been chosen.
+  heapAllocator->deallocate(pointer, size);
+}
+
+}  // namespace _
+
+HeapAllocator& getHeapAllocator() {
+  decidedHeapAllocatorState();
+  return *heapAllocator;
+}
+
+void setHeapAllocator(HeapAllocator& allocator) {
+  if (decideHeapAllocator(allocator)) return;
+  ZC_REQUIRE(&getHeapAllocator() == &allocator,
+             "setHeapAllocator() must be called before anything is allocated with heap<T>() or "
+             "heapArray<T>()");
+}
+
+// =======================================================================================
+// SystemHeapAllocator
+
+SystemHeapAllocator SystemHeapAllocator::instance;
+
+void* SystemHeapAllocator::allocate(size_t size) { return operator new(size); }
+
+void SystemHeapAllocator::deallocate(void* pointer, size_t size) { operator delete(pointer); }
+
+// =======================================================================================
+// SizeClassAllocator
+
+SizeClassAllocator SizeClassAllocator::instance;
+
+namespace {
+
+constexpr size_t SLAB_SIZE = 64 * 1024;
+
+inline uint batchSize(uint sizeClass) {
+  // How many slots a thread takes from, or returns to, the central pool at once: about 32KiB
+  // worth, within limits.
+  return zc::max(2u, zc::min(64u, uint(32 * 1024 / SizeClassAllocator::sizeOfClass(sizeClass))));
+}
+
+struct FreeSlot {
+  FreeSlot* next;
+};
+
+class SpinLock {
+  // The central pools are only locked to move a batch of slots, so waits are short, and not worth
+  // putting a thread to sleep for.
+
+public:
+  void lock() {
+    for (uint attempt = 0; __atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE); attempt++) {
+      if (attempt >= 16) yieldThread();
+    }
+  }
+  void unlock() { __atomic_store_n(&locked, false, __ATOMIC_RELEASE); }
+
+private:
+  bool locked = false;
+};
+
+struct alignas(64) CentralPool {
+  SpinLock lock;
+
+  FreeSlot* freeSlots = nullptr;
+  size_t freeCount = 0;
+
+  byte* slabPos = nullptr;
+  byte* slabEnd = nullptr;
+  // Not yet handed out.
+
+  size_t bytesReserved = 0;
+
+  uint64_t orphanAllocations = 0;
+  uint64_t orphanDeallocations = 0;
+  // Allocations and frees made while the thread's cache was unavailable, i.e. as it exits.
+};
+
+CentralPool centralPools[SizeClassAllocator::SIZE_CLASS_COUNT];
+
+uint64_t largeAllocations = 0;
+size_t largeBytesInUse = 0;
+
+struct alignas(64) ThreadCache {
+  // Fields written by the owning thread and read by getStats() are accessed with relaxed atomics.
+
+  struct SizeClass {
+    FreeSlot* freeSlots;
+    uint freeCount;
+    uint64_t allocations;
+    uint64_t deallocations;
+    uint64_t misses;
+  };
+  SizeClass classes[SizeClassAllocator::SIZE_CLASS_COUNT];
+
+  ThreadCache* next;
+  bool inUse;
+  // See ThreadRecordList.
+};
+
+_::ThreadRecordList<ThreadCache> threadCaches;
+
+template <typename T>
+inline void increment(T& counter, T amount = 1) {
+  __atomic_store_n(&counter, counter + amount, __ATOMIC_RELAXED);
+}
+
+FreeSlot* takeFromCentral(uint sizeClass, uint count, uint& taken) {
+  // Returns a list of up to `count` free slots, at least one, setting `taken` to their number.
+  CentralPool& pool = centralPools[sizeClass];
+  size_t size = SizeClassAllocator::sizeOfClass(sizeClass);
+
+  pool.lock.lock();
+  ZC_DEFER(pool.lock.unlock());
+
+  FreeSlot* result = nullptr;
+  taken = 0;
+  while (taken < count && pool.freeSlots != nullptr) {
+    FreeSlot* slot = pool.freeSlots;
+    pool.freeSlots = slot->next;
+    slot->next = result;
+    result = slot;
+    ++taken;
+  }
+  pool.freeCount -= taken;
+
+  while (taken < count) {
+    if (pool.slabPos + size > pool.slabEnd) {
+      if (taken > 0) break;
+      // Deliberately never freed: slots are reused for this size class forever.
+      pool.slabPos = reinterpret_cast<byte*>(operator new(SLAB_SIZE));
+      pool.slabEnd = pool.slabPos + SLAB_SIZE;
+      pool.bytesReserved += SLAB_SIZE;
+    }
+    FreeSlot* slot = reinterpret_cast<FreeSlot*>(pool.slabPos);
+    pool.slabPos += size;
+    slot->next = result;
+    result = slot;
+    ++taken;
+  }
+  return result;
+}
+
+void returnToCentral(uint sizeClass, FreeSlot* first, FreeSlot* last, uint count) {
+  CentralPool& pool = centralPools[sizeClass];
+  pool.lock.lock();
+  ZC_DEFER(pool.lock.unlock());
+  last->next = pool.freeSlots;
+  pool.freeSlots = first;
+  pool.freeCount += count;
+}
+
+void releaseBatch(ThreadCache::SizeClass& cached, uint sizeClass, uint count) {
+  // Moves `count` slots from the front of the thread's cache to the central pool.
+  FreeSlot* first = cached.freeSlots;
+  FreeSlot* last = first;
+  for (uint i = 1; i < count; i++) last = last->next;
+  cached.freeSlots = last->next;
+  __atomic_store_n(&cached.freeCount, cached.freeCount - count, __ATOMIC_RELAXED);
+  returnToCentral(sizeClass, first, last, count);
+}
+
+void flushCache(ThreadCache& cache) {
+  for (uint i : zeroTo(SizeClassAllocator::SIZE_CLASS_COUNT)) {
+    auto& cached = cache.classes[i];
+    if (cached.freeCount > 0) releaseBatch(cached, i, cached.freeCount);
+  }
+}
+
+thread_local _::ThreadRecordHolder<ThreadCache, threadCaches, flushCache> threadCacheHolder;
+
+inline ThreadCache* getThreadCache() {
+  // Returns null once the thread has returned its cache. Objects freed by later thread-exit code
+  // go straight to the central pool.
+  return threadCacheHolder.get();
+}
+
+}  // namespace
+
+void* SizeClassAllocator::allocate(size_t size) {
+  if (size > MAX_SMALL_SIZE) {
+    __atomic_add_fetch(&largeAllocations, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&largeBytesInUse, size, __ATOMIC_RELAXED);
+    return operator new(size);
+  }
+
+  uint sizeClass = sizeClassOf(size);
+  ThreadCache* cache = getThreadCache();
+  if (ZC_UNLIKELY(cache == nullptr)) {
+    uint taken;
+    FreeSlot* slot = takeFromCentral(sizeClass, 1, taken);
+    __atomic_add_fetch(&centralPools[sizeClass].orphanAllocations, 1, __ATOMIC_RELAXED);
+    return slot;
+  }
+
+  auto& cached = cache->classes[sizeClass];
+  increment(cached.allocations);
+  if (ZC_UNLIKELY(cached.freeSlots == nullptr)) {
+    increment(cached.misses);
+    uint taken;
+    cached.freeSlots = takeFromCentral(sizeClass, batchSize(sizeClass), taken);
+    __atomic_store_n(&cached.freeCount, taken, __ATOMIC_RELAXED);
+  }
+
+  FreeSlot* slot = cached.freeSlots;
+  cached.freeSlots = slot->next;
+  __atomic_store_n(&cached.freeCount, cached.freeCount - 1, __ATOMIC_RELAXED);
+  return slot;
+}
+
+void SizeClassAllocator::deallocate(void* pointer, size_t size) {
+  if (size > MAX_SMALL_SIZE) {
+    __atomic_sub_fetch(&largeBytesInUse, size, __ATOMIC_RELAXED);
+    operator delete(pointer);
+    return;
+  }
+
+  uint sizeClass = sizeClassOf(size);
+  FreeSlot* slot = reinterpret_cast<FreeSlot*>(pointer);
+  ThreadCache* cache = getThreadCache();
+  if (ZC_UNLIKELY(cache == nullptr)) {
+    returnToCentral(sizeClass, slot, slot, 1);
+    __atomic_add_fetch(&centralPools[sizeClass].orphanDeallocations, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  auto& cached = cache->classes[sizeClass];
+  increment(cached.deallocations);
+  slot->next = cached.freeSlots;
+  cached.freeSlots = slot;
+  __atomic_store_n(&cached.freeCount, cached.freeCount + 1, __ATOMIC_RELAXED);
+
+  uint batch = batchSize(sizeClass);
+  if (ZC_UNLIKELY(cached.freeCount > batch * 2)) releaseBatch(cached, sizeClass, batch);
+}
+
+void SizeClassAllocator::flushThreadCache() {
+  ThreadCache* cache = threadCacheHolder.record;
+  if (cache != nullptr) flushCache(*cache);
+}
+
+SizeClassAllocator::Stats SizeClassAllocator::getStats() const {
+  // Gather into fixed-size totals first: allocating the result may itself use this allocator.
+  struct Totals {
+    uint64_t allocations = 0;
+    int64_t inUse = 0;
+    uint64_t cached = 0;
+    uint64_t misses = 0;
+  };
+  Totals totals[SIZE_CLASS_COUNT];
+
+  for (auto cache = threadCaches.first(); cache != nullptr; cache = cache->next) {
+    for (uint i : zeroTo(SIZE_CLASS_COUNT)) {
+      auto& cached = cache->classes[i];
+      uint64_t allocations = __atomic_load_n(&cached.allocations, __ATOMIC_RELAXED);
+      totals[i].allocations += allocations;
+      totals[i].inUse += allocations - __atomic_load_n(&cached.deallocations, __ATOMIC_RELAXED);
+      totals[i].cached += __atomic_load_n(&cached.freeCount, __ATOMIC_RELAXED);
+      totals[i].misses += __atomic_load_n(&cached.misses, __ATOMIC_RELAXED);
+    }
+  }
+
+  size_t reserved[SIZE_CLASS_COUNT];
+  for (uint i : zeroTo(SIZE_CLASS_COUNT)) {
+    CentralPool& pool = centralPools[i];
+    uint64_t orphanAllocations = __atomic_load_n(&pool.orphanAllocations, __ATOMIC_RELAXED);
+    totals[i].allocations += orphanAllocations;
+    totals[i].misses += orphanAllocations;
+    totals[i].inUse +=
+        orphanAllocations - __atomic_load_n(&pool.orphanDeallocations, __ATOMIC_RELAXED);
+    pool.lock.lock();
+    totals[i].cached += pool.freeCount;
+    reserved[i] = pool.bytesReserved;
+    pool.lock.unlock();
+  }
+
+  Stats result;
+  result.largeAllocations = __atomic_load_n(&largeAllocations, __ATOMIC_RELAXED);
+  result.largeBytesInUse = __atomic_load_n(&largeBytesInUse, __ATOMIC_RELAXED);
+  result.cacheHits = 0;
+  result.cacheMisses = 0;
+
+  auto builder = heapArrayBuilder<SizeClassStats>(SIZE_CLASS_COUNT);
+  for (uint i : zeroTo(SIZE_CLASS_COUNT)) {
+    size_t size = sizeOfClass(i);
+    uint64_t inUse = zc::max(totals[i].inUse, int64_t(0));
+    uint64_t hits = totals[i].allocations - zc::min(totals[i].misses, totals[i].allocations);
+    builder.add(SizeClassStats{size, totals[i].allocations, inUse, size_t(inUse * size),
+                               size_t(totals[i].cached * size), reserved[i], hits,
+                               totals[i].misses});
+    result.cacheHits += hits;
+    result.cacheMisses += totals[i].misses;
+  }
+  result.sizeClasses = builder.finish();
+  return result;
+}
+
+double SizeClassAllocator::Stats::cacheHitRate() const {
+  uint64_t total = cacheHits + cacheMisses;
+  return total == 0 ? 0 : double(cacheHits) / double(total);
+}
+
+}  // namespace zc
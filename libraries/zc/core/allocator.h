@@ -0,0 +1,175 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "zc/core/array.h"
+#include "zc/core/common.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+// =======================================================================================
+// Heap allocators
+//
+// zc::heap<T>() and zc::heapArray<T>() get their memory from the process-wide HeapAllocator. Both
+// know the size of what they free, so an allocator can skip the bookkeeping that malloc needs.
+//
+// By default the allocator is operator new, called inline, so the indirection costs one relaxed
+// load. Since memory must be freed by the allocator that allocated it, a different one can only be
+// selected before the first allocation, which happens very early in most programs. There are two
+// ways to do it:
+// - Set the environment variable ZC_HEAP_ALLOCATOR to "size-class" (or "system" for the default).
+//   It is read at the first allocation.
+// - Call setHeapAllocator() before anything has been allocated.
+//
+// Objects whose class defines its own operator new, or that need more than
+// alignof(std::max_align_t) alignment, are always allocated with `new`.
+
+class HeapAllocator {
+public:
+  virtual void* allocate(size_t size) = 0;
+  // Returns memory for `size` bytes, aligned for any object that fits in it, up to
+  // alignof(std::max_align_t).
+
+  virtual void deallocate(void* pointer, size_t size) = 0;
+  // Frees memory returned by allocate(). `size` must be the size that was passed to allocate().
+
+  // Do not declare a destructor, as doing so will force a global initializer for each instance.
+};
+
+class SystemHeapAllocator final : public HeapAllocator {
+  // Calls operator new and operator delete.
+
+public:
+  static SystemHeapAllocator instance;
+
+  void* allocate(size_t size) override;
+  void deallocate(void* pointer, size_t size) override;
+};
+
+class SizeClassAllocator final : public HeapAllocator {
+  // An allocator for many small, short-lived objects, such as the promise nodes and stream state
+  // that async code allocates on every operation.
+  //
+  // Requests of up to MAX_SMALL_SIZE bytes are rounded up to one of SIZE_CLASS_COUNT size classes:
+  // multiples of 16 up to 128 bytes, then four classes per power of two. Each thread has a cache
+  // of free slots per class, so most allocations and frees touch no shared state at all. A thread
+  // that runs out of slots takes a batch from the class's central pool, which carves them out of
+  // 64KiB slabs; a thread whose cache grows too large returns a batch. Memory freed on another
+  // thread than it was allocated on simply joins that thread's cache. Larger requests go to
+  // operator new.
+  //
+  // Slab memory is never returned to the operating system; it is reused for the same size class.
+  // When a thread exits, its cache goes back to the central pools.
+  //
+  // Each thread running an EventLoop thereby has its own pool, with no extra setup.
+
+public:
+  static SizeClassAllocator instance;
+
+  static constexpr size_t MAX_SMALL_SIZE = 8192;
+  static constexpr uint SIZE_CLASS_COUNT = 32;
+
+  void* allocate(size_t size) override;
+  void deallocate(void* pointer, size_t size) override;
+
+  static inline uint sizeClassOf(size_t size);
+  // Returns the size class for a request of `size` bytes, which must be at most MAX_SMALL_SIZE.
+
+  static inline size_t sizeOfClass(uint sizeClass);
+  // Returns the size of the slots in the given size class.
+
+  struct SizeClassStats {
+    size_t objectSize;
+
+    uint64_t allocations;
+    uint64_t objectsInUse;
+    size_t bytesInUse;
+
+    size_t bytesCached;
+    // Free slots in thread caches and the central pool.
+
+    size_t bytesReserved;
+    // Slab memory carved out for this class: in use, cached, or not yet handed out.
+
+    uint64_t cacheHits;
+    uint64_t cacheMisses;
+    // Allocations served by the thread's cache, and those that had to go to the central pool.
+  };
+
+  struct Stats {
+    Array<SizeClassStats> sizeClasses;
+
+    uint64_t largeAllocations;
+    size_t largeBytesInUse;
+    // Requests over MAX_SMALL_SIZE.
+
+    uint64_t cacheHits;
+    uint64_t cacheMisses;
+
+    double cacheHitRate() const;
+  };
+
+  Stats getStats() const;
+  // Returns statistics for all threads. Other threads may be allocating while this runs, so the
+  // counts are approximate.
+
+  void flushThreadCache();
+  // Returns all free slots cached by the calling thread to the central pools.
+
+private:
+  constexpr SizeClassAllocator() = default;
+};
+
+HeapAllocator& getHeapAllocator();
+// Returns the allocator used by heap<T>() and heapArray<T>(), choosing it if nothing has been
+// allocated yet.
+
+void setHeapAllocator(HeapAllocator& allocator);
+// Selects the allocator for heap<T>() and heapArray<T>(). Throws if a different allocator has
+// already been chosen, i.e. if anything has been allocated yet.
+
+// =======================================================================================
+// inline implementation details
+
+inline uint SizeClassAllocator::sizeClassOf(size_t size) {
+  if (size <= 128) return size == 0 ? 0 : (size - 1) / 16;
+
+  // Four classes between each power of two and the next.
+  uint log = 63 - __builtin_clzll(size - 1);
+  uint step = ((size - 1) - (size_t(1) << log)) >> (log - 2);
+  return 8 + (log - 7) * 4 + step;
+}
+
+inline size_t SizeClassAllocator::sizeOfClass(uint sizeClass) {
+  if (sizeClass < 8) return (sizeClass + 1) * 16;
+  uint log = 7 + (sizeClass - 8) / 4;
+  uint step = (sizeClass - 8) % 4;
+  return (size_t(1) << log) + (step + 1) * (size_t(1) << (log - 2));
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
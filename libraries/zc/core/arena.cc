@@ -27,9 +27,14 @@
 
 namespace zc {
 
-Arena::Arena(size_t chunkSizeHint) : nextChunkSize(zc::max(sizeof(ChunkHeader), chunkSizeHint)) {}
+Arena::Arena(size_t chunkSizeHint, size_t maxChunkSize)
+    : maxChunkSize(zc::max(sizeof(ChunkHeader), maxChunkSize)) {
+  nextChunkSize = zc::min(zc::max(sizeof(ChunkHeader), chunkSizeHint), this->maxChunkSize);
+}
 
-Arena::Arena(ArrayPtr<byte> scratch) : nextChunkSize(zc::max(sizeof(ChunkHeader), scratch.size())) {
+Arena::Arena(ArrayPtr<byte> scratch, size_t maxChunkSize)
+    : maxChunkSize(zc::max(sizeof(ChunkHeader), maxChunkSize)) {
+  nextChunkSize = zc::min(zc::max(sizeof(ChunkHeader), scratch.size()), this->maxChunkSize);
   if (scratch.size() > sizeof(ChunkHeader)) {
     ChunkHeader* chunk = reinterpret_cast<ChunkHeader*>(scratch.begin());
     chunk->end = scratch.end();
@@ -39,6 +44,7 @@ Arena::Arena(ArrayPtr<byte> scratch) : nextChunkSize(zc::max(sizeof(ChunkHeader)
     // Don't place the chunk in the chunk list because it's not ours to delete.  Just make it the
     // current chunk so that we'll allocate from it until it is empty.
     currentChunk = chunk;
+    scratchChunk = chunk;
   }
 }
 
@@ -51,20 +57,70 @@ Arena::~Arena() noexcept(false) {
 }
 
 void Arena::cleanup() {
+  destroyObjects();
+
+  while (chunkList != nullptr) {
+    void* ptr = chunkList;
+    chunkList = chunkList->next;
+    operator delete(ptr);
+  }
+}
+
+void Arena::destroyObjects() {
   while (objectList != nullptr) {
     void* ptr = objectList + 1;
     auto destructor = objectList->destructor;
     objectList = objectList->next;
     destructor(ptr);
   }
+}
 
+void Arena::reset() {
+  destroyObjects();
+
+  // Keep the largest chunk that isn't oversized, and free the rest.
+  ChunkHeader* kept = nullptr;
   while (chunkList != nullptr) {
-    void* ptr = chunkList;
-    chunkList = chunkList->next;
-    operator delete(ptr);
+    ChunkHeader* chunk = chunkList;
+    chunkList = chunk->next;
+    size_t size = chunk->end - reinterpret_cast<byte*>(chunk);
+    if (size <= maxChunkSize &&
+        (kept == nullptr || size > size_t(kept->end - reinterpret_cast<byte*>(kept)))) {
+      ChunkHeader* smaller = kept;
+      kept = chunk;
+      chunk = smaller;
+    }
+    if (chunk != nullptr) operator delete(chunk);
+  }
+
+  if (kept != nullptr) {
+    kept->next = nullptr;
+    kept->pos = reinterpret_cast<byte*>(kept + 1);
+    chunkList = kept;
+    currentChunk = kept;
+  } else {
+    currentChunk = scratchChunk;
+    if (scratchChunk != nullptr) {
+      scratchChunk->pos = reinterpret_cast<byte*>(scratchChunk + 1);
+    }
   }
 }
 
+Arena::Stats Arena::getStats() const {
+  Stats stats{};
+  auto count = [&](ChunkHeader* chunk) {
+    stats.bytesUsed += chunk->pos - reinterpret_cast<byte*>(chunk + 1);
+    if (chunk != currentChunk) stats.bytesWasted += chunk->end - chunk->pos;
+  };
+  for (ChunkHeader* chunk = chunkList; chunk != nullptr; chunk = chunk->next) {
+    count(chunk);
+    stats.bytesReserved += chunk->end - reinterpret_cast<byte*>(chunk);
+    ++stats.chunkCount;
+  }
+  if (scratchChunk != nullptr) count(scratchChunk);
+  return stats;
+}
+
 namespace {
 
 constexpr bool ZC_UNUSED isPowerOfTwo(size_t value) { return (value & (value - 1)) == 0; }
@@ -128,20 +184,33 @@ void* Arena::allocateBytesInternal(size_t amount, uint alignment) {
   // If the ChunkHeader size does not match the alignment, we'll need to pad it up.
   amount += alignTo(sizeof(ChunkHeader), alignment);
 
+  if (amount > maxChunkSize) {
+    // Too big for any chunk we'd allocate; give it a chunk of its own, and keep allocating from
+    // the current one.
+    byte* bytes = reinterpret_cast<byte*>(operator new(amount));
+    ChunkHeader* newChunk = reinterpret_cast<ChunkHeader*>(bytes);
+    newChunk->next = chunkList;
+    newChunk->pos = bytes + amount;
+    newChunk->end = bytes + amount;
+    chunkList = newChunk;
+    return alignTo(bytes + sizeof(ChunkHeader), alignment);
+  }
+
   // Make sure we're going to allocate enough space.
   while (nextChunkSize < amount) { nextChunkSize *= 2; }
+  size_t chunkSize = zc::min(nextChunkSize, maxChunkSize);
 
   // Allocate.
-  byte* bytes = reinterpret_cast<byte*>(operator new(nextChunkSize));
+  byte* bytes = reinterpret_cast<byte*>(operator new(chunkSize));
 
   // Set up the ChunkHeader at the beginning of the allocation.
   ChunkHeader* newChunk = reinterpret_cast<ChunkHeader*>(bytes);
   newChunk->next = chunkList;
   newChunk->pos = bytes + amount;
-  newChunk->end = bytes + nextChunkSize;
+  newChunk->end = bytes + chunkSize;
   currentChunk = newChunk;
   chunkList = newChunk;
-  nextChunkSize *= 2;
+  nextChunkSize = zc::min(chunkSize * 2, maxChunkSize);
 
   // Move past the ChunkHeader to find the position of the allocated object.
   return alignTo(bytes + sizeof(ChunkHeader), alignment);
@@ -161,4 +230,118 @@ void Arena::setDestructor(void* ptr, void (*destructor)(void*)) {
   objectList = header;
 }
 
+// =======================================================================================
+// ConcurrentArena
+
+namespace {
+
+uint nextThreadSlot = 0;
+
+uint threadSlot() {
+  // Threads take slots round-robin in the order they first allocate from any ConcurrentArena.
+  static thread_local uint slot = __atomic_fetch_add(&nextThreadSlot, 1, __ATOMIC_RELAXED);
+  return slot;
+}
+
+}  // namespace
+
+ConcurrentArena::ConcurrentArena(size_t regionSize)
+    : regionSize(zc::max(regionSize, sizeof(Region) * 2)) {}
+
+ConcurrentArena::~ConcurrentArena() noexcept(false) {
+  while (regionList != nullptr) {
+    Region* region = regionList;
+    regionList = region->next;
+    operator delete(region);
+  }
+}
+
+ConcurrentArena::Region* ConcurrentArena::newRegion(size_t size) {
+  byte* bytes = reinterpret_cast<byte*>(operator new(size));
+  Region* region = reinterpret_cast<Region*>(bytes);
+  region->pos = reinterpret_cast<byte*>(region + 1);
+  region->end = bytes + size;
+  return region;
+}
+
+void* ConcurrentArena::allocateBytes(size_t amount, uint alignment) {
+  Region*& slot = slots[threadSlot() % SLOT_COUNT];
+  Region* region = __atomic_load_n(&slot, __ATOMIC_ACQUIRE);
+
+  for (;;) {
+    if (region != nullptr) {
+      byte* pos = __atomic_load_n(&region->pos, __ATOMIC_RELAXED);
+      for (;;) {
+        byte* alignedPos = alignTo(pos, alignment);
+
+        // Careful about overflow here.
+        if (amount + (alignedPos - pos) > size_t(region->end - pos)) break;
+        if (__atomic_compare_exchange_n(&region->pos, &pos, alignedPos + amount, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          return alignedPos;
+        }
+      }
+    }
+
+    // Not enough space in the region.  Allocate a new one.
+    size_t needed = sizeof(Region) + alignment - 1 + amount;
+    bool ownRegion = needed > regionSize;
+    Region* fresh = newRegion(ownRegion ? needed : regionSize);
+    byte* result = alignTo(fresh->pos, alignment);
+    fresh->pos = result + amount;
+
+    // Only replace the slot's region if no other thread beat us to it; otherwise, try the region
+    // that it installed.  An oversized allocation leaves the slot alone.
+    if (ownRegion ||
+        __atomic_compare_exchange_n(&slot, &region, fresh, false, __ATOMIC_ACQ_REL,
+                                    __ATOMIC_ACQUIRE)) {
+      fresh->next = __atomic_load_n(&regionList, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n(&regionList, &fresh->next, fresh, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+      return result;
+    }
+    operator delete(fresh);
+  }
+}
+
+StringPtr ConcurrentArena::copyString(StringPtr content) {
+  char* data = reinterpret_cast<char*>(allocateBytes(content.size() + 1, 1));
+  memcpy(data, content.cStr(), content.size() + 1);
+  return StringPtr(data, content.size());
+}
+
+bool ConcurrentArena::isInSlot(Region* region) const {
+  for (Region* slot : slots) {
+    if (slot == region) return true;
+  }
+  return false;
+}
+
+void ConcurrentArena::reset() {
+  Region* kept = nullptr;
+  while (regionList != nullptr) {
+    Region* region = regionList;
+    regionList = region->next;
+    if (isInSlot(region)) {
+      region->pos = reinterpret_cast<byte*>(region + 1);
+      region->next = kept;
+      kept = region;
+    } else {
+      operator delete(region);
+    }
+  }
+  regionList = kept;
+}
+
+ConcurrentArena::Stats ConcurrentArena::getStats() const {
+  Stats stats{};
+  for (Region* region = regionList; region != nullptr; region = region->next) {
+    stats.bytesUsed += region->pos - reinterpret_cast<byte*>(region + 1);
+    if (!isInSlot(region)) stats.bytesWasted += region->end - region->pos;
+    stats.bytesReserved += region->end - reinterpret_cast<byte*>(region);
+    ++stats.chunkCount;
+  }
+  return stats;
+}
+
 }  // namespace zc
@@ -36,15 +36,18 @@ class Arena {
   // Allocating from the same Arena in multiple threads concurrently is NOT safe, because making
   // it safe would require atomic operations that would slow down allocation even when
   // single-threaded.  If you need to use arena allocation in a multithreaded context, consider
-  // allocating thread-local arenas.
+  // allocating thread-local arenas, or ConcurrentArena.
 
 public:
-  explicit Arena(size_t chunkSizeHint = 1024);
+  static constexpr size_t DEFAULT_MAX_CHUNK_SIZE = 1 << 20;
+
+  explicit Arena(size_t chunkSizeHint = 1024, size_t maxChunkSize = DEFAULT_MAX_CHUNK_SIZE);
   // Create an Arena.  `chunkSizeHint` hints at where to start when allocating chunks, but is only
   // a hint -- the Arena will, for example, allocate progressively larger chunks as time goes on,
-  // in order to reduce overall allocation overhead.
+  // in order to reduce overall allocation overhead.  Chunks stop growing at `maxChunkSize`; an
+  // allocation too big for a chunk of that size gets a chunk of its own.
 
-  explicit Arena(ArrayPtr<byte> scratch);
+  explicit Arena(ArrayPtr<byte> scratch, size_t maxChunkSize = DEFAULT_MAX_CHUNK_SIZE);
   // Allocates from the given scratch space first, only resorting to the heap when it runs out.
 
   ZC_DISALLOW_COPY_AND_MOVE(Arena);
@@ -81,6 +84,31 @@ public:
   StringPtr copyString(StringPtr content);
   // Make a copy of the given string inside the arena, and return a pointer to the copy.
 
+  void reset();
+  // Destroy everything allocated so far, as the destructor would, but keep the largest chunk (of
+  // at most `maxChunkSize`) to allocate from again, so that an Arena reused for one request or
+  // task after another stops touching the heap once it has grown to fit the typical one.  The
+  // scratch space, if any, is only reused when no chunk was kept.
+  //
+  // Everything allocated with allocateOwn*() must have been released already.
+
+  struct Stats {
+    size_t bytesUsed;
+    // Bytes handed out, including alignment padding and destructor bookkeeping.
+
+    size_t bytesWasted;
+    // Bytes left unused at the end of chunks that the arena has moved on from.
+
+    size_t bytesReserved;
+    // Total size of the chunks obtained from the heap.
+
+    size_t chunkCount;
+    // Number of chunks obtained from the heap.
+  };
+
+  Stats getStats() const;
+  // Walks the chunk list, so it takes time proportional to the number of chunks.
+
 private:
   struct ChunkHeader {
     ChunkHeader* next;
@@ -93,16 +121,21 @@ private:
   };
 
   size_t nextChunkSize;
+  size_t maxChunkSize;
   ChunkHeader* chunkList = nullptr;
   ObjectHeader* objectList = nullptr;
 
   ChunkHeader* currentChunk = nullptr;
+  ChunkHeader* scratchChunk = nullptr;
 
   void cleanup();
   // Run all destructors, leaving the above pointers null.  If a destructor throws, the State is
   // left in a consistent state, such that if cleanup() is called again, it will pick up where
   // it left off.
 
+  void destroyObjects();
+  // The first half of cleanup(): run all destructors, leaving objectList null.
+
   void* allocateBytes(size_t amount, uint alignment, bool hasDisposer);
   // Allocate the given number of bytes.  `hasDisposer` must be true if `setDisposer()` may be
   // called on this pointer later.
@@ -130,6 +163,63 @@ private:
   }
 };
 
+class ConcurrentArena {
+  // An arena that any number of threads can allocate from at once, for parallel producers that
+  // build one result.  Each thread bumps a pointer through a region of its own, so allocation is
+  // lock-free and uncontended: threads are spread over a fixed set of region slots, and only
+  // threads that share a slot ever retry a compare-and-swap.
+  //
+  // To keep allocation free of shared bookkeeping, the arena does not run destructors: objects
+  // allocated with allocate() or allocateArray() must be trivially destructible, and others must
+  // be allocated with allocateOwn().
+
+public:
+  explicit ConcurrentArena(size_t regionSize = 16384);
+  // Each thread takes `regionSize` bytes at a time from the heap.  Allocations that would not fit
+  // in a region of that size get a region of their own.
+
+  ZC_DISALLOW_COPY_AND_MOVE(ConcurrentArena);
+  ~ConcurrentArena() noexcept(false);
+
+  template <typename T, typename... Params>
+  T& allocate(Params&&... params);
+  template <typename T>
+  ArrayPtr<T> allocateArray(size_t size);
+  template <typename T, typename... Params>
+  Own<T> allocateOwn(Params&&... params);
+  // Same as the methods of Arena, except for the restriction on destructors above.
+
+  StringPtr copyString(StringPtr content);
+
+  void reset();
+  // Free everything allocated so far, but keep each thread's current region to allocate from
+  // again.  Must not be called while other threads may be allocating.
+
+  using Stats = Arena::Stats;
+  Stats getStats() const;
+  // Must not be called while other threads may be allocating.
+
+private:
+  struct Region {
+    Region* next;
+    byte* pos;  // first unallocated byte; updated atomically
+    byte* end;
+  };
+
+  static constexpr uint SLOT_COUNT = 16;
+
+  size_t regionSize;
+  Region* slots[SLOT_COUNT] = {};
+  // The region each group of threads is allocating from.  Updated atomically.
+
+  Region* regionList = nullptr;
+  // Every region, including the ones that are no longer in a slot.  Updated atomically.
+
+  void* allocateBytes(size_t amount, uint alignment);
+  Region* newRegion(size_t size);
+  bool isInSlot(Region* region) const;
+};
+
 // =======================================================================================
 // Inline implementation details
 
@@ -200,6 +290,36 @@ ArrayBuilder<T> Arena::allocateOwnArrayBuilder(size_t capacity) {
       DestructorOnlyArrayDisposer::instance);
 }
 
+template <typename T, typename... Params>
+T& ConcurrentArena::allocate(Params&&... params) {
+  static_assert(ZC_HAS_TRIVIAL_DESTRUCTOR(T), "ConcurrentArena doesn't run destructors");
+  T& result = *reinterpret_cast<T*>(allocateBytes(sizeof(T), alignof(T)));
+  if (!ZC_HAS_TRIVIAL_CONSTRUCTOR(T) || sizeof...(Params) > 0) {
+    ctor(result, zc::fwd<Params>(params)...);
+  }
+  return result;
+}
+
+template <typename T>
+ArrayPtr<T> ConcurrentArena::allocateArray(size_t size) {
+  static_assert(ZC_HAS_TRIVIAL_DESTRUCTOR(T), "ConcurrentArena doesn't run destructors");
+  ArrayPtr<T> result =
+      arrayPtr(reinterpret_cast<T*>(allocateBytes(sizeof(T) * size, alignof(T))), size);
+  if (!ZC_HAS_TRIVIAL_CONSTRUCTOR(T)) {
+    for (size_t i = 0; i < size; i++) { ctor(result[i]); }
+  }
+  return result;
+}
+
+template <typename T, typename... Params>
+Own<T> ConcurrentArena::allocateOwn(Params&&... params) {
+  T& result = *reinterpret_cast<T*>(allocateBytes(sizeof(T), alignof(T)));
+  if (!ZC_HAS_TRIVIAL_CONSTRUCTOR(T) || sizeof...(Params) > 0) {
+    ctor(result, zc::fwd<Params>(params)...);
+  }
+  return Own<T>(&result, DestructorOnlyDisposer<T>::instance);
+}
+
 }  // namespace zc
 
 ZC_END_HEADER
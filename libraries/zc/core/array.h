@@ -245,6 +245,10 @@ public:
   Array<T> attach(Attachments&&... attachments) ZC_WARN_UNUSED_RESULT;
   // Like Own<T>::attach(), but attaches to an Array.
 
+  inline const ArrayDisposer* getDisposer() const { return disposer; }
+  // Returns the disposer that will free the array. Lets code that allocates arrays with its own
+  // disposer recognize them later, e.g. to share a buffer instead of copying it.
+
   template <typename U>
   inline auto as() {
     return U::from(this);
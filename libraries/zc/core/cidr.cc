@@ -177,4 +177,162 @@ void CidrRange::zeroIrrelevantBits() {
   }
 }
 
+// =======================================================================================
+// CidrSet
+
+namespace {
+
+inline uint64_t loadBigEndian(const byte* bytes, uint count) {
+  // Loads up to 8 bytes as the most significant bytes of the result.
+  uint64_t result = 0;
+  for (uint i = 0; i < count; i++) result |= uint64_t(bytes[i]) << (56 - i * 8);
+  return result;
+}
+
+inline void loadAddress(const byte* bytes, uint byteCount, uint64_t result[2]) {
+  result[0] = loadBigEndian(bytes, zc::min(byteCount, 8u));
+  result[1] = byteCount > 8 ? loadBigEndian(bytes + 8, byteCount - 8) : 0;
+}
+
+inline uint64_t highBits(uint count) {
+  // A mask of the `count` most significant bits of a word, for `count` of at most 64.
+  return count == 0 ? 0 : ~uint64_t(0) << (64 - count);
+}
+
+inline bool prefixMatches(const uint64_t a[2], const uint64_t b[2], uint bitCount) {
+  // Whether the first `bitCount` bits of `a` and `b` are equal.
+  if (bitCount <= 64) return ((a[0] ^ b[0]) & highBits(bitCount)) == 0;
+  return a[0] == b[0] && ((a[1] ^ b[1]) & highBits(bitCount - 64)) == 0;
+}
+
+inline uint commonPrefixLength(const uint64_t a[2], const uint64_t b[2], uint limit) {
+  uint64_t high = a[0] ^ b[0];
+  uint64_t low = a[1] ^ b[1];
+  uint length = high != 0 ? __builtin_clzll(high) : low != 0 ? 64 + __builtin_clzll(low) : 128;
+  return zc::min(length, limit);
+}
+
+inline uint bitAt(const uint64_t bits[2], uint index) {
+  return (bits[index / 64] >> (63 - index % 64)) & 1;
+}
+
+}  // namespace
+
+CidrSet::CidrSet(ArrayPtr<const CidrRange> ranges) { addAll(ranges); }
+
+void CidrSet::add(const CidrRange& range) {
+  uint64_t prefix[2];
+  if (range.family == AF_INET) {
+    loadAddress(range.bits, 4, prefix);
+    inet4.add(prefix, range.bitCount);
+  } else {
+    loadAddress(range.bits, 16, prefix);
+    inet6.add(prefix, range.bitCount);
+  }
+}
+
+void CidrSet::addAll(ArrayPtr<const CidrRange> ranges) {
+  for (auto& range : ranges) add(range);
+}
+
+void CidrSet::Trie::add(const uint64_t prefix[2], uint bitCount) {
+  if (nodes.empty()) nodes.add(Node{{0, 0}, 0, false, {NONE, NONE}});
+
+  uint current = 0;
+  for (;;) {
+    if (nodes[current].bitCount == bitCount) {
+      nodes[current].inSet = true;
+      return;
+    }
+
+    uint direction = bitAt(prefix, nodes[current].bitCount);
+    uint childIndex = nodes[current].children[direction];
+    if (childIndex == NONE) {
+      uint leaf = nodes.size();
+      nodes.add(Node{{prefix[0], prefix[1]}, bitCount, true, {NONE, NONE}});
+      nodes[current].children[direction] = leaf;
+      return;
+    }
+
+    Node& child = nodes[childIndex];
+    uint common = commonPrefixLength(prefix, child.prefix, zc::min(bitCount, child.bitCount));
+    if (common == child.bitCount) {
+      current = childIndex;
+      continue;
+    }
+
+    // The new prefix diverges from the child's (or ends) partway through it, so insert a node for
+    // the part they share.
+    uint splitIndex = nodes.size();
+    Node split{{prefix[0] & highBits(zc::min(common, 64u)),
+                common > 64 ? prefix[1] & highBits(common - 64) : 0},
+               common,
+               common == bitCount,
+               {NONE, NONE}};
+    split.children[bitAt(child.prefix, common)] = childIndex;
+    nodes.add(split);
+    if (common < bitCount) {
+      nodes[splitIndex].children[bitAt(prefix, common)] = nodes.size();
+      nodes.add(Node{{prefix[0], prefix[1]}, bitCount, true, {NONE, NONE}});
+    }
+    nodes[current].children[direction] = splitIndex;
+    return;
+  }
+}
+
+Maybe<uint> CidrSet::Trie::longestMatch(const uint64_t address[2], uint addressBits) const {
+  if (nodes.empty()) return zc::none;
+
+  Maybe<uint> result;
+  const Node* node = &nodes[0];
+  for (;;) {
+    if (node->inSet) result = node->bitCount;
+    if (node->bitCount == addressBits) break;
+    uint childIndex = node->children[bitAt(address, node->bitCount)];
+    if (childIndex == NONE) break;
+    node = &nodes[childIndex];
+    if (!prefixMatches(address, node->prefix, node->bitCount)) break;
+  }
+  return result;
+}
+
+Maybe<uint> CidrSet::longestMatch(const struct sockaddr* addr) const {
+  uint64_t address[2];
+  if (addr->sa_family == AF_INET) {
+    loadAddress(reinterpret_cast<const byte*>(
+                    &reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr.s_addr),
+                4, address);
+    return inet4.longestMatch(address, 32);
+  } else if (addr->sa_family == AF_INET6) {
+    const byte* bytes = reinterpret_cast<const struct sockaddr_in6*>(addr)->sin6_addr.s6_addr;
+    loadAddress(bytes, 16, address);
+    Maybe<uint> result = inet6.longestMatch(address, 128);
+
+    static constexpr byte V6MAPPED[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (arrayPtr(bytes, sizeof(V6MAPPED)) == V6MAPPED) {
+      // A "v6 mapped" address is equivalent to an ipv4 address, which the ipv4 ranges match.
+      loadAddress(bytes + sizeof(V6MAPPED), 4, address);
+      ZC_IF_SOME(specificity, inet4.longestMatch(address, 32)) {
+        ZC_IF_SOME(other, result) { return zc::max(specificity, other); }
+        return specificity;
+      }
+    }
+    return result;
+  } else {
+    return zc::none;
+  }
+}
+
+bool CidrSet::matchesFamily(int family) const {
+  switch (family) {
+    case AF_INET:
+      return !inet4.nodes.empty();
+    case AF_INET6:
+      // Even ipv4 ranges can match v6 addresses in the v4-mapped range.
+      return !empty();
+    default:
+      return false;
+  }
+}
+
 }  // namespace zc
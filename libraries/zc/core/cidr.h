@@ -26,6 +26,7 @@
 
 #include "zc/core/array.h"
 #include "zc/core/common.h"
+#include "zc/core/vector.h"
 
 ZC_BEGIN_HEADER
 
@@ -60,6 +61,58 @@ private:
   CidrRange(int family, ArrayPtr<const byte> bits, uint bitCount);
 
   void zeroIrrelevantBits();
+
+  friend class CidrSet;
+};
+
+class CidrSet {
+  // A set of CidrRanges compiled into a path-compressed binary trie per address family, so that
+  // looking up an address takes time proportional to the length of the longest prefix in the set,
+  // no matter how many ranges it holds.  Matches the same addresses as checking each CidrRange in
+  // turn, including IPv4 ranges matching v4-mapped IPv6 addresses.
+
+public:
+  CidrSet() = default;
+  explicit CidrSet(ArrayPtr<const CidrRange> ranges);
+
+  void add(const CidrRange& range);
+  void addAll(ArrayPtr<const CidrRange> ranges);
+
+  Maybe<uint> longestMatch(const struct sockaddr* addr) const;
+  // Returns the greatest specificity (see CidrRange::getSpecificity()) of the ranges that match
+  // `addr`, or none if none of them do.
+
+  inline bool matches(const struct sockaddr* addr) const { return longestMatch(addr) != zc::none; }
+
+  bool matchesFamily(int family) const;
+  // True if any range in the set matchesFamily().
+
+  inline bool empty() const { return inet4.nodes.empty() && inet6.nodes.empty(); }
+
+private:
+  struct Node {
+    uint64_t prefix[2];
+    // The node's prefix, most significant bit first, with the bits past `bitCount` zero.
+    uint bitCount;
+    bool inSet;  // whether the prefix itself is one of the ranges
+    uint children[2];
+    // The nodes whose prefixes extend this one with a 0 or a 1 bit, or NONE.  Nodes with only one
+    // child that are not in the set are never created, so a child's prefix may be many bits
+    // longer than its parent's.
+  };
+
+  struct Trie {
+    Vector<Node> nodes;
+    // nodes[0], if present, is the root, with an empty prefix.
+
+    void add(const uint64_t prefix[2], uint bitCount);
+    Maybe<uint> longestMatch(const uint64_t address[2], uint addressBits) const;
+  };
+
+  static constexpr uint NONE = maxValue;
+
+  Trie inet4;
+  Trie inet6;
 };
 
 }  // namespace zc
@@ -0,0 +1,250 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "zc/core/map.h"
+#include "zc/core/mutex.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+template <typename Key, typename Value, uint shardCount = 16>
+class ConcurrentHashMap {
+  // A key/value mapping which may be shared between threads, e.g. for caches.
+  //
+  // Wrapping a HashMap in a MutexGuarded makes every thread wait for the one lock. This instead
+  // splits the keys by hash into `shardCount` shards (a power of two), each a HashMap behind its
+  // own reader/writer mutex: threads only contend when they hit the same shard, and lookups only
+  // take shared locks. Each shard has its own cache line, so locking one does not bounce its
+  // neighbors between cores.
+  //
+  // Another thread may change an entry as soon as its shard is unlocked, so no method returns a
+  // reference into the map. find() and findOrCreate() return copies (and so need `Value` to be
+  // copyable); read() and modify() instead run a callback on the entry while its shard is locked.
+  // Callbacks must not call back into the same map, since the locks are not recursive.
+  //
+  // `Key` follows the same rules as for HashMap.
+
+  static_assert(shardCount > 0 && (shardCount & (shardCount - 1)) == 0,
+                "shardCount must be a power of two");
+
+public:
+  using Entry = typename HashMap<Key, Value>::Entry;
+
+  void reserve(size_t size);
+  // Pre-allocates space for a map of the given size, assuming keys are spread evenly over shards.
+
+  size_t size() const;
+  // Total number of entries. If other threads are modifying the map, this is only approximate.
+
+  void clear();
+
+  template <typename UpdateFunc>
+  void upsert(Key key, Value value, UpdateFunc&& update);
+  void upsert(Key key, Value value);
+  // Like HashMap::upsert(). update(Value& existingValue, Value&& newValue) runs under the shard's
+  // exclusive lock.
+
+  template <typename KeyLike>
+  Maybe<Value> find(KeyLike&& key) const;
+  // Returns a copy of the value matching `key`, if any.
+
+  template <typename KeyLike, typename Func>
+  Value findOrCreate(KeyLike&& key, Func&& createEntry);
+  // Like HashMap::findOrCreate(), but returns a copy of the value. Looks up the key under a shared
+  // lock first, so hits on an existing entry do not block other readers. On a miss, createEntry()
+  // runs under the shard's exclusive lock, and at most once per key even if several threads race
+  // to create it.
+
+  template <typename KeyLike, typename Func>
+  bool read(KeyLike&& key, Func&& func) const;
+  // If `key` is present, calls func(const Value&) under the shard's shared lock and returns true.
+
+  template <typename KeyLike, typename Func>
+  bool modify(KeyLike&& key, Func&& func);
+  // If `key` is present, calls func(Value&) under the shard's exclusive lock and returns true.
+
+  template <typename KeyLike>
+  bool erase(KeyLike&& key);
+  // Erase the entry with the matching key, returning whether there was one.
+
+  template <typename Predicate>
+  size_t eraseAll(Predicate&& predicate);
+  // Erase all values for which predicate(key, value) returns true, locking one shard at a time.
+
+  template <typename Func>
+  void forEach(Func&& func) const;
+  // Calls func(const Key&, const Value&) for every entry, holding a shared lock on one shard at a
+  // time. Each shard is seen in a consistent state, but the map as a whole is not: entries in
+  // other shards may change while the callback runs.
+
+  Array<Entry> snapshot() const;
+  // Copies all entries, with the same consistency as forEach(). Requires Key and Value to be
+  // copyable.
+
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  struct alignas(CACHE_LINE_SIZE) Shard {
+    MutexGuarded<HashMap<Key, Value>> map;
+  };
+
+  Shard shards[shardCount];
+
+  static constexpr uint shardBits() {
+    uint bits = 0;
+    while ((1u << bits) < shardCount) ++bits;
+    return bits;
+  }
+
+  template <typename KeyLike>
+  inline Shard& shardFor(KeyLike& key) const {
+    if constexpr (shardCount == 1) {
+      return const_cast<Shard&>(shards[0]);
+    } else {
+      // HashMap picks buckets from the low bits of the hash, so the shard comes from the top bits
+      // of a multiplicative mix instead. Otherwise each shard would only see keys whose low bits
+      // agree.
+      uint mixed = static_cast<uint>(zc::hashCode(key)) * 0x9e3779b9u;
+      return const_cast<Shard&>(shards[mixed >> (32 - shardBits())]);
+    }
+  }
+};
+
+// =======================================================================================
+// inline implementation details
+
+template <typename Key, typename Value, uint shardCount>
+void ConcurrentHashMap<Key, Value, shardCount>::reserve(size_t size) {
+  for (auto& shard : shards) { shard.map.lockExclusive()->reserve(size / shardCount + 1); }
+}
+
+template <typename Key, typename Value, uint shardCount>
+size_t ConcurrentHashMap<Key, Value, shardCount>::size() const {
+  size_t result = 0;
+  for (auto& shard : shards) { result += shard.map.lockShared()->size(); }
+  return result;
+}
+
+template <typename Key, typename Value, uint shardCount>
+void ConcurrentHashMap<Key, Value, shardCount>::clear() {
+  for (auto& shard : shards) { shard.map.lockExclusive()->clear(); }
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename UpdateFunc>
+void ConcurrentHashMap<Key, Value, shardCount>::upsert(Key key, Value value,
+                                                       UpdateFunc&& update) {
+  auto lock = shardFor(key).map.lockExclusive();
+  lock->upsert(zc::mv(key), zc::mv(value), zc::fwd<UpdateFunc>(update));
+}
+
+template <typename Key, typename Value, uint shardCount>
+void ConcurrentHashMap<Key, Value, shardCount>::upsert(Key key, Value value) {
+  auto lock = shardFor(key).map.lockExclusive();
+  lock->upsert(zc::mv(key), zc::mv(value));
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename KeyLike>
+Maybe<Value> ConcurrentHashMap<Key, Value, shardCount>::find(KeyLike&& key) const {
+  auto lock = shardFor(key).map.lockShared();
+  ZC_IF_SOME(value, lock->find(key)) { return Value(value); }
+  return zc::none;
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename KeyLike, typename Func>
+Value ConcurrentHashMap<Key, Value, shardCount>::findOrCreate(KeyLike&& key, Func&& createEntry) {
+  auto& shard = shardFor(key);
+  {
+    auto lock = shard.map.lockShared();
+    ZC_IF_SOME(value, lock->find(key)) { return Value(value); }
+  }
+
+  // Another thread may have created the entry between the two locks; HashMap::findOrCreate()
+  // checks again.
+  auto lock = shard.map.lockExclusive();
+  return Value(lock->findOrCreate(key, zc::fwd<Func>(createEntry)));
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename KeyLike, typename Func>
+bool ConcurrentHashMap<Key, Value, shardCount>::read(KeyLike&& key, Func&& func) const {
+  auto lock = shardFor(key).map.lockShared();
+  ZC_IF_SOME(value, lock->find(key)) {
+    func(value);
+    return true;
+  }
+  return false;
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename KeyLike, typename Func>
+bool ConcurrentHashMap<Key, Value, shardCount>::modify(KeyLike&& key, Func&& func) {
+  auto lock = shardFor(key).map.lockExclusive();
+  ZC_IF_SOME(value, lock->find(key)) {
+    func(value);
+    return true;
+  }
+  return false;
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename KeyLike>
+bool ConcurrentHashMap<Key, Value, shardCount>::erase(KeyLike&& key) {
+  return shardFor(key).map.lockExclusive()->erase(key);
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename Predicate>
+size_t ConcurrentHashMap<Key, Value, shardCount>::eraseAll(Predicate&& predicate) {
+  size_t count = 0;
+  for (auto& shard : shards) { count += shard.map.lockExclusive()->eraseAll(predicate); }
+  return count;
+}
+
+template <typename Key, typename Value, uint shardCount>
+template <typename Func>
+void ConcurrentHashMap<Key, Value, shardCount>::forEach(Func&& func) const {
+  for (auto& shard : shards) {
+    auto lock = shard.map.lockShared();
+    for (auto& entry : *lock) { func(entry.key, entry.value); }
+  }
+}
+
+template <typename Key, typename Value, uint shardCount>
+Array<typename ConcurrentHashMap<Key, Value, shardCount>::Entry>
+ConcurrentHashMap<Key, Value, shardCount>::snapshot() const {
+  Vector<Entry> result;
+  for (auto& shard : shards) {
+    auto lock = shard.map.lockShared();
+    result.reserve(result.size() + lock->size());
+    for (auto& entry : *lock) { result.add(Entry{entry.key, entry.value}); }
+  }
+  return result.releaseAsArray();
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
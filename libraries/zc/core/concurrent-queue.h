@@ -0,0 +1,353 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+// Lock-free queues for passing work between threads.
+//
+// These only ever spin on a failed compare-and-swap; they never block. A consumer that finds a
+// queue empty has to decide for itself whether to retry, yield, or sleep. To sleep on an event
+// loop until a producer adds something, give the queue a QueueWaker: see CrossThreadQueueWaker in
+// zc/async/async-queue.h.
+
+#include "zc/core/array.h"
+#include "zc/core/memory.h"
+#include "zc/core/vector.h"
+
+#include <stdint.h>
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+class QueueWaker {
+  // Hook called by a queue's producers after every successful push, so that a consumer sleeping
+  // somewhere else can be woken. wake() runs on the producer's thread, concurrently with other
+  // producers, so it must be thread-safe, and it should be cheap when nobody is waiting.
+
+public:
+  virtual ~QueueWaker() noexcept(false) = default;
+
+  virtual void wake() const = 0;
+};
+
+namespace _ {  // private
+
+static constexpr size_t QUEUE_CACHE_LINE_SIZE = 64;
+// Indexes written by different threads are aligned to this, so that they don't share a cache line.
+// The alignment also rounds the queue's size up, so the last index gets a line to itself.
+
+}  // namespace _
+
+template <typename T>
+class MpmcQueue {
+  // A bounded multi-producer, multi-consumer FIFO queue, after Dmitry Vyukov's design.
+  //
+  // Each slot carries a sequence number which says whether it is ready to be written or read for
+  // the current lap around the ring, so a push or pop costs one compare-and-swap on the shared
+  // position plus one release store, and producers only contend with producers (and consumers
+  // with consumers).
+
+public:
+  explicit MpmcQueue(size_t capacity);
+  // `capacity` is rounded up to a power of two, and at least 2.
+
+  ~MpmcQueue() noexcept(false);
+  ZC_DISALLOW_COPY_AND_MOVE(MpmcQueue);
+
+  bool tryPush(T&& value);
+  // Moves `value` into the queue. Returns false, leaving `value` alone, if the queue is full.
+
+  Maybe<T> tryPop();
+  // Removes the oldest value. Returns none if the queue is empty.
+
+  size_t capacity() const { return cells.size(); }
+
+  size_t size() const;
+  // Number of values in the queue. Only a snapshot if other threads are using the queue.
+
+  bool isEmpty() const { return size() == 0; }
+
+  void setWaker(Maybe<const QueueWaker&> waker);
+  // Sets the hook called after every successful push. Set it before sharing the queue between
+  // threads.
+
+private:
+  struct Cell {
+    size_t sequence;
+    union {
+      T value;
+    };
+
+    Cell() {}
+    ~Cell() {}
+  };
+
+  Array<Cell> cells;
+  size_t mask;
+  const QueueWaker* waker = nullptr;
+
+  alignas(_::QUEUE_CACHE_LINE_SIZE) size_t enqueuePos = 0;
+  alignas(_::QUEUE_CACHE_LINE_SIZE) size_t dequeuePos = 0;
+};
+
+template <typename T>
+class WorkStealingDeque {
+  // A Chase-Lev work-stealing deque, using the memory orderings from Lê et al., "Correct and
+  // Efficient Work-Stealing for Weak Memory Models" (2013).
+  //
+  // One thread owns the deque and pushes and pops at the bottom, LIFO, without any atomic
+  // read-modify-write unless it is racing for the last item. Any other thread may steal from the
+  // top, FIFO. This is the usual per-worker queue in a work-stealing scheduler: workers take their
+  // own most recent (cache-warm) work, and idle workers take the oldest work from someone else.
+  //
+  // The deque grows as needed. Outgrown buffers are kept until the deque is destroyed, because a
+  // thief may still be reading one.
+  //
+  // `T` must be trivially copyable and no larger than a pointer, since thieves read items
+  // speculatively, before knowing whether they won them. Queue pointers or indexes, not objects.
+
+  static_assert(__is_trivially_copyable(T) && sizeof(T) <= sizeof(void*),
+                "WorkStealingDeque items must be trivially copyable and at most pointer-sized");
+
+public:
+  explicit WorkStealingDeque(size_t initialCapacity = 64);
+  ZC_DISALLOW_COPY_AND_MOVE(WorkStealingDeque);
+
+  void push(T value);
+  // Owner only. Adds `value` at the bottom.
+
+  Maybe<T> pop();
+  // Owner only. Removes the most recently pushed value. Returns none if the deque is empty.
+
+  Maybe<T> steal();
+  // Any thread. Removes the oldest value. Returns none if the deque is empty or another thread
+  // took the value first; callers looking for work should move on to another deque or retry.
+
+  size_t size() const;
+  // Only a snapshot if other threads are using the deque.
+
+  bool isEmpty() const { return size() == 0; }
+
+  void setWaker(Maybe<const QueueWaker&> waker);
+  // Sets the hook called after every push. Set it before sharing the deque between threads.
+
+private:
+  struct Buffer {
+    Array<T> items;
+    size_t mask;
+
+    explicit Buffer(size_t capacity) : items(heapArray<T>(capacity)), mask(capacity - 1) {}
+
+    T get(int64_t i) const {
+      T result;
+      __atomic_load(&items[i & mask], &result, __ATOMIC_RELAXED);
+      return result;
+    }
+    void put(int64_t i, T value) { __atomic_store(&items[i & mask], &value, __ATOMIC_RELAXED); }
+  };
+
+  Buffer* buffer;
+  Own<Buffer> ownBuffer;
+  Vector<Own<Buffer>> retired;
+  const QueueWaker* waker = nullptr;
+
+  alignas(_::QUEUE_CACHE_LINE_SIZE) int64_t top = 0;
+  alignas(_::QUEUE_CACHE_LINE_SIZE) int64_t bottom = 0;
+
+  Buffer* grow(Buffer* old, int64_t t, int64_t b);
+};
+
+// =======================================================================================
+// inline implementation details
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(size_t capacity) {
+  size_t rounded = 2;
+  while (rounded < capacity) rounded <<= 1;
+  cells = heapArray<Cell>(rounded);
+  mask = rounded - 1;
+  for (size_t i = 0; i < rounded; i++) { cells[i].sequence = i; }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue() noexcept(false) {
+  while (tryPop() != zc::none) {}
+}
+
+template <typename T>
+bool MpmcQueue<T>::tryPush(T&& value) {
+  size_t pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+  Cell* cell;
+  for (;;) {
+    cell = &cells[pos & mask];
+    size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+    if (diff == 0) {
+      // The cell is free for this lap. Claim it; on failure `pos` is reloaded.
+      if (__atomic_compare_exchange_n(&enqueuePos, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The cell still holds the value from the previous lap: the queue is full.
+      return false;
+    } else {
+      pos = __atomic_load_n(&enqueuePos, __ATOMIC_RELAXED);
+    }
+  }
+
+  ctor(cell->value, zc::mv(value));
+  __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+  if (waker != nullptr) { waker->wake(); }
+  return true;
+}
+
+template <typename T>
+Maybe<T> MpmcQueue<T>::tryPop() {
+  size_t pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+  Cell* cell;
+  for (;;) {
+    cell = &cells[pos & mask];
+    size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+    intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&dequeuePos, &pos, pos + 1, true, __ATOMIC_RELAXED,
+                                      __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // The cell has not been written for this lap: the queue is empty.
+      return zc::none;
+    } else {
+      pos = __atomic_load_n(&dequeuePos, __ATOMIC_RELAXED);
+    }
+  }
+
+  T result = zc::mv(cell->value);
+  dtor(cell->value);
+  // Hand the cell to the producer one lap ahead.
+  __atomic_store_n(&cell->sequence, pos + mask + 1, __ATOMIC_RELEASE);
+  return zc::mv(result);
+}
+
+template <typename T>
+size_t MpmcQueue<T>::size() const {
+  size_t dequeued = __atomic_load_n(&dequeuePos, __ATOMIC_ACQUIRE);
+  size_t enqueued = __atomic_load_n(&enqueuePos, __ATOMIC_ACQUIRE);
+  return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+template <typename T>
+void MpmcQueue<T>::setWaker(Maybe<const QueueWaker&> newWaker) {
+  waker = nullptr;
+  ZC_IF_SOME(w, newWaker) { waker = &w; }
+}
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t initialCapacity) {
+  size_t rounded = 2;
+  while (rounded < initialCapacity) rounded <<= 1;
+  ownBuffer = heap<Buffer>(rounded);
+  buffer = ownBuffer.get();
+}
+
+template <typename T>
+void WorkStealingDeque<T>::push(T value) {
+  int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED);
+  int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+  Buffer* buf = __atomic_load_n(&buffer, __ATOMIC_RELAXED);
+  if (b - t > static_cast<int64_t>(buf->mask)) { buf = grow(buf, t, b); }
+  buf->put(b, value);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+  if (waker != nullptr) { waker->wake(); }
+}
+
+template <typename T>
+Maybe<T> WorkStealingDeque<T>::pop() {
+  int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED) - 1;
+  Buffer* buf = __atomic_load_n(&buffer, __ATOMIC_RELAXED);
+  __atomic_store_n(&bottom, b, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  int64_t t = __atomic_load_n(&top, __ATOMIC_RELAXED);
+
+  if (t > b) {
+    // Empty.
+    __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+    return zc::none;
+  }
+
+  T result = buf->get(b);
+  if (t == b) {
+    // Last item: race the thieves for it.
+    bool won = __atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST,
+                                           __ATOMIC_RELAXED);
+    __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+    if (!won) return zc::none;
+  }
+  return result;
+}
+
+template <typename T>
+Maybe<T> WorkStealingDeque<T>::steal() {
+  int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  int64_t b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+  if (t >= b) return zc::none;
+
+  Buffer* buf = __atomic_load_n(&buffer, __ATOMIC_ACQUIRE);
+  T result = buf->get(t);
+  if (!__atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST,
+                                   __ATOMIC_RELAXED)) {
+    return zc::none;
+  }
+  return result;
+}
+
+template <typename T>
+size_t WorkStealingDeque<T>::size() const {
+  int64_t b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+  int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+  return b > t ? b - t : 0;
+}
+
+template <typename T>
+void WorkStealingDeque<T>::setWaker(Maybe<const QueueWaker&> newWaker) {
+  waker = nullptr;
+  ZC_IF_SOME(w, newWaker) { waker = &w; }
+}
+
+template <typename T>
+typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::grow(Buffer* old, int64_t t,
+                                                                  int64_t b) {
+  auto bigger = heap<Buffer>(old->items.size() * 2);
+  for (int64_t i = t; i < b; i++) { bigger->put(i, old->get(i)); }
+  Buffer* result = bigger.get();
+  retired.add(zc::mv(ownBuffer));
+  ownBuffer = zc::mv(bigger);
+  __atomic_store_n(&buffer, result, __ATOMIC_RELEASE);
+  return result;
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
@@ -331,6 +331,35 @@ static String makeDescriptionImpl(DescriptionStyle style, const char* code, int
   }
 }
 
+thread_local bool faultSpaceInUse = false;
+alignas(Exception) thread_local byte faultSpace[sizeof(Exception)];
+// A Fault builds its exception here rather than on the heap, since the exception only lives until
+// the Fault throws it. Faults nest when the recovery block of a failed check fails in turn; the
+// inner ones use the heap.
+
+template <typename... Params>
+Exception* newFaultException(Params&&... params) {
+  void* space;
+  if (faultSpaceInUse) {
+    space = operator new(sizeof(Exception));
+  } else {
+    faultSpaceInUse = true;
+    space = faultSpace;
+  }
+  Exception* result = reinterpret_cast<Exception*>(space);
+  ctor(*result, zc::fwd<Params>(params)...);
+  return result;
+}
+
+void deleteFaultException(Exception* exception) {
+  dtor(*exception);
+  if (reinterpret_cast<byte*>(exception) == faultSpace) {
+    faultSpaceInUse = false;
+  } else {
+    operator delete(exception);
+  }
+}
+
 }  // namespace
 
 void Debug::logInternal(const char* file, int line, LogSeverity severity, const char* macroArgs,
@@ -343,14 +372,14 @@ void Debug::logInternal(const char* file, int line, LogSeverity severity, const
 Debug::Fault::~Fault() noexcept(false) {
   if (exception != nullptr) {
     Exception copy = mv(*exception);
-    delete exception;
+    deleteFaultException(exception);
     throwRecoverableException(mv(copy), 1);
   }
 }
 
 void Debug::Fault::fatal() {
   Exception copy = mv(*exception);
-  delete exception;
+  deleteFaultException(exception);
   exception = nullptr;
   throwFatalException(mv(copy), 1);
   ZC_KNOWN_UNREACHABLE(abort());
@@ -358,14 +387,19 @@ void Debug::Fault::fatal() {
 
 void Debug::Fault::init(const char* file, int line, Exception::Type type, const char* condition,
                         const char* macroArgs, ArrayPtr<String> argValues) {
-  exception =
-      new Exception(type, file, line,
-                    makeDescriptionImpl(ASSERTION, condition, 0, nullptr, macroArgs, argValues));
+  exception = newFaultException(
+      type, file, line,
+      makeDescriptionImpl(ASSERTION, condition, 0, nullptr, macroArgs, argValues));
+}
+
+void Debug::Fault::init(const char* file, int line, Exception::Type type,
+                        Exception::StaticDescription description) {
+  exception = newFaultException(type, file, line, description);
 }
 
 void Debug::Fault::init(const char* file, int line, int osErrorNumber, const char* condition,
                         const char* macroArgs, ArrayPtr<String> argValues) {
-  exception = new Exception(
+  exception = newFaultException(
       typeOfErrno(osErrorNumber), file, line,
       makeDescriptionImpl(SYSCALL, condition, osErrorNumber, nullptr, macroArgs, argValues));
 }
@@ -391,7 +425,7 @@ void Debug::Fault::init(const char* file, int line, Win32Result osErrorNumber,
     message = zc::str("win32 error code: ", osErrorNumber.number);
   }
 
-  exception = new Exception(
+  exception = newFaultException(
       typeOfWin32Error(osErrorNumber.number), file, line,
       makeDescriptionImpl(SYSCALL, condition, 0, message.cStr(), macroArgs, argValues));
 }
@@ -401,6 +435,14 @@ String Debug::makeDescriptionInternal(const char* macroArgs, ArrayPtr<String> ar
   return makeDescriptionImpl(LOG, nullptr, 0, nullptr, macroArgs, argValues);
 }
 
+bool Debug::isStringLiteral(const char* macroArgs) {
+  while (isspace(*macroArgs)) ++macroArgs;
+  if (*macroArgs != '\"') return false;
+  const char* end = macroArgs + strlen(macroArgs);
+  while (end > macroArgs && isspace(end[-1])) --end;
+  return end - macroArgs >= 2 && end[-1] == '\"';
+}
+
 int Debug::getOsErrorNumber(bool nonblocking) {
   int result = errno;
 
@@ -225,9 +225,9 @@ namespace zc {
     return _zc_result;                                                          \
   }())
 
-#define ZC_EXCEPTION(type, ...)                                    \
-  ::zc::Exception(::zc::Exception::Type::type, __FILE__, __LINE__, \
-                  ::zc::_::Debug::makeDescription("" #__VA_ARGS__, __VA_ARGS__))
+#define ZC_EXCEPTION(type, ...)                                                          \
+  ::zc::_::Debug::makeException(::zc::Exception::Type::type, __FILE__, __LINE__, "" #__VA_ARGS__, \
+                                __VA_ARGS__)
 
 #else
 
@@ -338,9 +338,9 @@ namespace zc {
 
 #endif
 
-#define ZC_EXCEPTION(type, ...)                                    \
-  ::zc::Exception(::zc::Exception::Type::type, __FILE__, __LINE__, \
-                  ::zc::_::Debug::makeDescription(#__VA_ARGS__, ##__VA_ARGS__))
+#define ZC_EXCEPTION(type, ...)                                                      \
+  ::zc::_::Debug::makeException(::zc::Exception::Type::type, __FILE__, __LINE__, #__VA_ARGS__, \
+                                ##__VA_ARGS__)
 
 #endif
 
@@ -459,6 +459,9 @@ public:
     template <typename Code, typename... Params>
     Fault(const char* file, int line, Code code, const char* condition, const char* macroArgs,
           Params&&... params);
+    template <size_t n>
+    Fault(const char* file, int line, Exception::Type type, const char* condition,
+          const char* macroArgs, const char (&text)[n]);
     Fault(const char* file, int line, Exception::Type type, const char* condition,
           const char* macroArgs);
     Fault(const char* file, int line, int osErrorNumber, const char* condition,
@@ -475,6 +478,8 @@ public:
   private:
     void init(const char* file, int line, Exception::Type type, const char* condition,
               const char* macroArgs, ArrayPtr<String> argValues);
+    void init(const char* file, int line, Exception::Type type,
+              Exception::StaticDescription description);
     void init(const char* file, int line, int osErrorNumber, const char* condition,
               const char* macroArgs, ArrayPtr<String> argValues);
 #if _WIN32 || __CYGWIN__
@@ -551,6 +556,20 @@ public:
   template <typename... Params>
   static String makeDescription(const char* macroArgs, Params&&... params);
 
+  template <typename... Params>
+  static Exception makeException(Exception::Type type, const char* file, int line,
+                                 const char* macroArgs, Params&&... params);
+  template <size_t n>
+  static Exception makeException(Exception::Type type, const char* file, int line,
+                                 const char* macroArgs, const char (&text)[n]);
+  // Implements ZC_EXCEPTION(). If the only argument is a string literal, the exception refers to
+  // it rather than formatting a copy.
+
+  static bool isStringLiteral(const char* macroArgs);
+  // Returns true if `macroArgs`, the stringified arguments of a macro, is nothing but a string
+  // literal (possibly several, concatenated). Used together with a parameter of array type, this
+  // tells literals apart from char arrays that might not outlive an exception.
+
 private:
   static LogSeverity minSeverity;
 
@@ -582,6 +601,18 @@ Debug::Fault::Fault(const char* file, int line, Code code, const char* condition
   init(file, line, code, condition, macroArgs, arrayPtr(argValues, sizeof...(Params)));
 }
 
+template <size_t n>
+Debug::Fault::Fault(const char* file, int line, Exception::Type type, const char* condition,
+                    const char* macroArgs, const char (&text)[n])
+    : exception(nullptr) {
+  if (condition == nullptr && isStringLiteral(macroArgs)) {
+    init(file, line, type, Exception::StaticDescription{text});
+  } else {
+    String argValues[1] = {str(text)};
+    init(file, line, type, condition, macroArgs, argValues);
+  }
+}
+
 inline Debug::Fault::Fault(const char* file, int line, int osErrorNumber, const char* condition,
                            const char* macroArgs)
     : exception(nullptr) {
@@ -649,6 +680,22 @@ inline String Debug::makeDescription<>(const char* macroArgs) {
   return makeDescriptionInternal(macroArgs, nullptr);
 }
 
+template <typename... Params>
+Exception Debug::makeException(Exception::Type type, const char* file, int line,
+                               const char* macroArgs, Params&&... params) {
+  return Exception(type, file, line, makeDescription(macroArgs, zc::fwd<Params>(params)...));
+}
+
+template <size_t n>
+Exception Debug::makeException(Exception::Type type, const char* file, int line,
+                               const char* macroArgs, const char (&text)[n]) {
+  if (isStringLiteral(macroArgs)) {
+    return Exception(type, file, line, Exception::StaticDescription{text});
+  } else {
+    return Exception(type, file, line, makeDescription(macroArgs, text));
+  }
+}
+
 // =======================================================================================
 // Magic Asserts!
 //
@@ -0,0 +1,904 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/encoding-simd.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (__x86_64__ || __i386__) && (__GNUC__ || __clang__)
+// The SSE4 and AVX2 kernels are compiled for their instruction sets with function attributes, so
+// that the rest of the library still runs on any x86 CPU; which ones run is decided at runtime.
+#define ZC_ENCODING_X86 1
+#include <immintrin.h>
+#define ZC_TARGET_SSE4 __attribute__((target("ssse3,sse4.1")))
+#define ZC_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ZC_ENCODING_X86 0
+#endif
+
+namespace zc {
+namespace _ {  // private
+
+namespace {
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+constexpr char BASE64_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char BASE64_URL_ALPHABET[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+struct Base64Values {
+  signed char values[256];
+  // The 6-bit value of each base64 character, or -1 for any other byte.
+};
+
+constexpr Base64Values makeBase64Values() {
+  Base64Values result{};
+  for (auto& value : result.values) value = -1;
+  for (uint i = 0; i < 64; i++) result.values[byte(BASE64_ALPHABET[i])] = i;
+  return result;
+}
+
+constexpr Base64Values BASE64_VALUES = makeBase64Values();
+
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+// =======================================================================================
+// Scalar kernels
+
+template <typename T>
+size_t widenAsciiScalar(const byte* in, size_t size, T* out) {
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, in + i, sizeof(word));
+    if (word & HIGH_BITS) break;
+    for (uint j = 0; j < 8; j++) out[i + j] = in[i + j];
+  }
+  while (i < size && in[i] < 0x80) {
+    out[i] = in[i];
+    ++i;
+  }
+  return i;
+}
+
+template <typename T>
+size_t narrowAsciiScalar(const T* in, size_t size, char* out) {
+  size_t i = 0;
+  while (i < size && in[i] < 0x80) {
+    out[i] = in[i];
+    ++i;
+  }
+  return i;
+}
+
+bool validateUtf8Scalar(const byte* in, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    if (i + 8 <= size) {
+      uint64_t word;
+      memcpy(&word, in + i, sizeof(word));
+      if (!(word & HIGH_BITS)) {
+        i += 8;
+        continue;
+      }
+    }
+
+    byte c = in[i];
+    if (c < 0x80) {
+      ++i;
+      continue;
+    }
+
+    // The lead byte determines the length of the sequence and the range of its second byte, which
+    // excludes overlong sequences, surrogates and code points above U+10FFFF. The other
+    // continuation bytes can be anything from 0x80 to 0xbf.
+    size_t length;
+    byte low = 0x80;
+    byte high = 0xbf;
+    if (c < 0xc2) {
+      // A continuation byte, or the lead of an overlong 2-byte sequence.
+      return false;
+    } else if (c < 0xe0) {
+      length = 2;
+    } else if (c < 0xf0) {
+      length = 3;
+      if (c == 0xe0) low = 0xa0;
+      if (c == 0xed) high = 0x9f;
+    } else if (c < 0xf5) {
+      length = 4;
+      if (c == 0xf0) low = 0x90;
+      if (c == 0xf4) high = 0x8f;
+    } else {
+      return false;
+    }
+
+    if (size - i < length || in[i + 1] < low || in[i + 1] > high) return false;
+    for (size_t j = 2; j < length; j++) {
+      if ((in[i + j] & 0xc0) != 0x80) return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+void encodeHexScalar(const byte* in, size_t size, char* out) {
+  for (size_t i = 0; i < size; i++) {
+    out[i * 2] = HEX_DIGITS[in[i] >> 4];
+    out[i * 2 + 1] = HEX_DIGITS[in[i] & 0x0f];
+  }
+}
+
+inline int hexValue(char c) {
+  if ('0' <= c && c <= '9') return c - '0';
+  c |= 0x20;
+  if ('a' <= c && c <= 'f') return c - ('a' - 10);
+  return -1;
+}
+
+size_t decodeHexScalar(const char* in, size_t size, byte* out) {
+  for (size_t i = 0; i < size; i++) {
+    int high = hexValue(in[i * 2]);
+    int low = hexValue(in[i * 2 + 1]);
+    if ((high | low) < 0) return i;
+    out[i] = high << 4 | low;
+  }
+  return size;
+}
+
+void encodeBase64Scalar(const byte* in, size_t groups, char* out, bool url) {
+  const char* alphabet = url ? BASE64_URL_ALPHABET : BASE64_ALPHABET;
+  for (; groups > 0; groups--, in += 3, out += 4) {
+    uint32_t bits = uint32_t(in[0]) << 16 | uint32_t(in[1]) << 8 | in[2];
+    out[0] = alphabet[bits >> 18];
+    out[1] = alphabet[(bits >> 12) & 0x3f];
+    out[2] = alphabet[(bits >> 6) & 0x3f];
+    out[3] = alphabet[bits & 0x3f];
+  }
+}
+
+size_t decodeBase64Scalar(const char* in, size_t size, byte* out) {
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4, out += 3) {
+    int a = BASE64_VALUES.values[byte(in[i])];
+    int b = BASE64_VALUES.values[byte(in[i + 1])];
+    int c = BASE64_VALUES.values[byte(in[i + 2])];
+    int d = BASE64_VALUES.values[byte(in[i + 3])];
+    if ((a | b | c | d) < 0) break;
+    uint32_t bits = a << 18 | b << 12 | c << 6 | d;
+    out[0] = bits >> 16;
+    out[1] = bits >> 8;
+    out[2] = bits;
+  }
+  return i;
+}
+
+size_t spanCharSetScalar(const byte* in, size_t size, const CharSet& set) {
+  size_t i = 0;
+  while (i < size && set.contains(in[i])) ++i;
+  return i;
+}
+
+size_t spanUntilScalar(const byte* in, size_t size, byte c1, byte c2) {
+  if (c1 == c2) {
+    const void* found = memchr(in, c1, size);
+    return found == nullptr ? size : static_cast<const byte*>(found) - in;
+  }
+  size_t i = 0;
+  while (i < size && in[i] != c1 && in[i] != c2) ++i;
+  return i;
+}
+
+const EncodingKernels SCALAR_KERNELS = {
+    SimdLevel::SCALAR,
+    widenAsciiScalar<char16_t>,
+    widenAsciiScalar<char32_t>,
+    narrowAsciiScalar<char16_t>,
+    narrowAsciiScalar<char32_t>,
+    validateUtf8Scalar,
+    encodeHexScalar,
+    decodeHexScalar,
+    encodeBase64Scalar,
+    decodeBase64Scalar,
+    spanCharSetScalar,
+    spanUntilScalar,
+};
+
+#if ZC_ENCODING_X86
+
+// =======================================================================================
+// UTF-8 validation tables
+//
+// This is the algorithm of "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser and
+// Lemire, 2021). Each pair of adjacent bytes is classified by looking up the high and low nibble
+// of the first byte and the high nibble of the second in three tables, each giving a bit for
+// every kind of error the pair might be part of; the pair is an error if all three agree on one.
+// The third and fourth bytes of a sequence are checked separately, by looking two and three bytes
+// back for a lead byte.
+
+constexpr byte TOO_SHORT = 1 << 0;       // 11______ 0_______, or 11______ 11______
+constexpr byte TOO_LONG = 1 << 1;        // 0_______ 10______
+constexpr byte OVERLONG_3 = 1 << 2;      // 11100000 100_____
+constexpr byte TOO_LARGE = 1 << 3;       // 11110100 1001____, or 11110101+ 10______
+constexpr byte SURROGATE = 1 << 4;       // 11101101 101_____
+constexpr byte OVERLONG_2 = 1 << 5;      // 1100000_ 10______
+constexpr byte TOO_LARGE_1000 = 1 << 6;  // 11110101+ 1000____
+constexpr byte OVERLONG_4 = 1 << 6;      // 11110000 1000____
+constexpr byte TWO_CONTS = 1 << 7;       // 10______ 10______
+constexpr byte CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+constexpr byte LARGE = TOO_LARGE | TOO_LARGE_1000;
+
+alignas(16) constexpr byte UTF8_BYTE_1_HIGH[16] = {
+    // ASCII
+    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+    // continuation
+    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+    // 2-byte leads
+    TOO_SHORT | OVERLONG_2, TOO_SHORT,
+    // 3-byte leads
+    TOO_SHORT | OVERLONG_3 | SURROGATE,
+    // 4-byte leads and invalid bytes
+    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+alignas(16) constexpr byte UTF8_BYTE_1_LOW[16] = {
+    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+    CARRY | OVERLONG_2,
+    CARRY,
+    CARRY,
+    CARRY | TOO_LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+    CARRY | LARGE | SURROGATE,
+    CARRY | LARGE,
+    CARRY | LARGE,
+};
+
+alignas(16) constexpr byte UTF8_BYTE_2_HIGH[16] = {
+    // ASCII
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+    // 1000____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+    // 1001____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+    // 101_____
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+    // leads
+    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+alignas(16) constexpr byte UTF8_INCOMPLETE_MAX[16] = {
+    // Subtracted from the last block, this leaves a non-zero byte exactly where a sequence that
+    // needs more bytes begins.
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1,
+};
+
+alignas(16) constexpr byte HEX_DIGITS_TABLE[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+};
+
+// =======================================================================================
+// SSE4 kernels
+
+ZC_TARGET_SSE4 inline __m128i load128(const void* p) {
+  return _mm_loadu_si128(static_cast<const __m128i*>(p));
+}
+
+ZC_TARGET_SSE4 inline void store128(void* p, __m128i value) {
+  _mm_storeu_si128(static_cast<__m128i*>(p), value);
+}
+
+ZC_TARGET_SSE4 inline __m128i inRange(__m128i chars, char low, char high) {
+  // 0xff in each byte that is between `low` and `high` inclusive, which must both be ASCII.
+  return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(high + 1), chars));
+}
+
+ZC_TARGET_SSE4 size_t widenAscii16Sse4(const byte* in, size_t size, char16_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chars = load128(in + i);
+    if (_mm_movemask_epi8(chars) != 0) break;
+    store128(out + i, _mm_unpacklo_epi8(chars, zero));
+    store128(out + i + 8, _mm_unpackhi_epi8(chars, zero));
+  }
+  return i + widenAsciiScalar(in + i, size - i, out + i);
+}
+
+ZC_TARGET_SSE4 size_t widenAscii32Sse4(const byte* in, size_t size, char32_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chars = load128(in + i);
+    if (_mm_movemask_epi8(chars) != 0) break;
+    __m128i low = _mm_unpacklo_epi8(chars, zero);
+    __m128i high = _mm_unpackhi_epi8(chars, zero);
+    store128(out + i, _mm_unpacklo_epi16(low, zero));
+    store128(out + i + 4, _mm_unpackhi_epi16(low, zero));
+    store128(out + i + 8, _mm_unpacklo_epi16(high, zero));
+    store128(out + i + 12, _mm_unpackhi_epi16(high, zero));
+  }
+  return i + widenAsciiScalar(in + i, size - i, out + i);
+}
+
+ZC_TARGET_SSE4 size_t narrowAscii16Sse4(const char16_t* in, size_t size, char* out) {
+  const __m128i nonAscii = _mm_set1_epi16(-0x80);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i a = load128(in + i);
+    __m128i b = load128(in + i + 8);
+    if (!_mm_testz_si128(_mm_or_si128(a, b), nonAscii)) break;
+    store128(out + i, _mm_packus_epi16(a, b));
+  }
+  return i + narrowAsciiScalar(in + i, size - i, out + i);
+}
+
+ZC_TARGET_SSE4 size_t narrowAscii32Sse4(const char32_t* in, size_t size, char* out) {
+  const __m128i nonAscii = _mm_set1_epi32(-0x80);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i a = load128(in + i);
+    __m128i b = load128(in + i + 4);
+    __m128i c = load128(in + i + 8);
+    __m128i d = load128(in + i + 12);
+    __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+    if (!_mm_testz_si128(all, nonAscii)) break;
+    store128(out + i, _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d)));
+  }
+  return i + narrowAsciiScalar(in + i, size - i, out + i);
+}
+
+struct Utf8CheckerSse4 {
+  __m128i error;
+  __m128i prevInput;
+  __m128i prevIncomplete;
+};
+
+ZC_TARGET_SSE4 inline void checkUtf8Sse4(Utf8CheckerSse4& checker, __m128i input) {
+  if (_mm_movemask_epi8(input) == 0) {
+    // All ASCII: only a sequence left incomplete by the previous block can be wrong.
+    checker.error = _mm_or_si128(checker.error, checker.prevIncomplete);
+    checker.prevIncomplete = _mm_setzero_si128();
+  } else {
+    const __m128i nibbles = _mm_set1_epi8(0x0f);
+    __m128i prev1 = _mm_alignr_epi8(input, checker.prevInput, 15);
+    __m128i byte1High = _mm_shuffle_epi8(load128(UTF8_BYTE_1_HIGH),
+                                         _mm_and_si128(_mm_srli_epi16(prev1, 4), nibbles));
+    __m128i byte1Low = _mm_shuffle_epi8(load128(UTF8_BYTE_1_LOW), _mm_and_si128(prev1, nibbles));
+    __m128i byte2High = _mm_shuffle_epi8(load128(UTF8_BYTE_2_HIGH),
+                                         _mm_and_si128(_mm_srli_epi16(input, 4), nibbles));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    // Bytes 2 and 3 after a 3- or 4-byte lead must be continuations, which `special` reports as
+    // TWO_CONTS; anywhere else, TWO_CONTS is an error.
+    __m128i prev2 = _mm_alignr_epi8(input, checker.prevInput, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, checker.prevInput, 13);
+    __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xe0 - 0x80)));
+    __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xf0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8(char(0x80)));
+    checker.error = _mm_or_si128(checker.error, _mm_xor_si128(must23, special));
+    checker.prevIncomplete = _mm_subs_epu8(input, load128(UTF8_INCOMPLETE_MAX));
+  }
+  checker.prevInput = input;
+}
+
+ZC_TARGET_SSE4 bool validateUtf8Sse4(const byte* in, size_t size) {
+  Utf8CheckerSse4 checker = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) checkUtf8Sse4(checker, load128(in + i));
+  if (i < size) {
+    // Pad the tail with NULs, which end any sequence and are otherwise harmless.
+    byte tail[16] = {};
+    memcpy(tail, in + i, size - i);
+    checkUtf8Sse4(checker, load128(tail));
+  }
+  __m128i error = _mm_or_si128(checker.error, checker.prevIncomplete);
+  return _mm_testz_si128(error, error);
+}
+
+ZC_TARGET_SSE4 void encodeHexSse4(const byte* in, size_t size, char* out) {
+  const __m128i digits = load128(HEX_DIGITS_TABLE);
+  const __m128i nibbles = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = load128(in + i);
+    __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibbles));
+    __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibbles));
+    store128(out + i * 2, _mm_unpacklo_epi8(high, low));
+    store128(out + i * 2 + 16, _mm_unpackhi_epi8(high, low));
+  }
+  encodeHexScalar(in + i, size - i, out + i * 2);
+}
+
+ZC_TARGET_SSE4 inline bool hexValuesSse4(__m128i chars, __m128i& values) {
+  // Sets `values` to the value of each hex digit in `chars`. Returns false if any isn't one.
+  __m128i isDigit = inRange(chars, '0', '9');
+  __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  __m128i isLetter = inRange(lower, 'a', 'f');
+  values = _mm_or_si128(_mm_and_si128(isDigit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+                        _mm_and_si128(isLetter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  return _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xffff;
+}
+
+ZC_TARGET_SSE4 size_t decodeHexSse4(const char* in, size_t size, byte* out) {
+  // Each pair of digits becomes high * 16 + low in a 16-bit lane.
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i a, b;
+    if (!hexValuesSse4(load128(in + i * 2), a) || !hexValuesSse4(load128(in + i * 2 + 16), b)) {
+      break;
+    }
+    store128(out + i,
+             _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights)));
+  }
+  return i + decodeHexScalar(in + i * 2, size - i, out + i);
+}
+
+ZC_TARGET_SSE4 inline __m128i base64ShiftsSse4(bool url) {
+  // What to add to each class of 6-bit values, as numbered by base64CharsSse4(), to get their
+  // characters.
+  return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                       '0' - 52, '0' - 52, '0' - 52, '0' - 52, url ? '-' - 62 : '+' - 62,
+                       url ? '_' - 63 : '/' - 63, 'A', 0, 0);
+}
+
+ZC_TARGET_SSE4 inline __m128i base64CharsSse4(__m128i in, __m128i shifts) {
+  // Encodes the 12 bytes at the start of `in` as 16 characters. This and the 256-bit version
+  // below follow Muła and Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions".
+
+  // Put the 3 bytes of each group in the 4 bytes of a 32-bit lane as [b1, b0, b2, b1], then move
+  // each 6-bit value into its own byte with two multiplications.
+  in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m128i ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                               _mm_set1_epi32(0x04000040));
+  __m128i bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                               _mm_set1_epi32(0x01000010));
+  __m128i values = _mm_or_si128(ac, bd);
+
+  // Number the ranges A-Z (13), a-z (0), 0-9 (1 to 10), and the last two characters (11 and 12).
+  __m128i classes = _mm_subs_epu8(values, _mm_set1_epi8(51));
+  __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), values);
+  classes = _mm_or_si128(classes, _mm_and_si128(upper, _mm_set1_epi8(13)));
+  return _mm_add_epi8(values, _mm_shuffle_epi8(shifts, classes));
+}
+
+ZC_TARGET_SSE4 void encodeBase64Sse4(const byte* in, size_t groups, char* out, bool url) {
+  const __m128i shifts = base64ShiftsSse4(url);
+  // Each step encodes 4 groups, but reads 16 bytes.
+  for (; groups >= 6; groups -= 4, in += 12, out += 16) {
+    store128(out, base64CharsSse4(load128(in), shifts));
+  }
+  encodeBase64Scalar(in, groups, out, url);
+}
+
+ZC_TARGET_SSE4 inline bool base64ValuesSse4(__m128i chars, __m128i& values) {
+  // Sets `values` to the 6-bit value of each character in `chars`. Returns false if any is not
+  // a base64 character.
+  __m128i upper = inRange(chars, 'A', 'Z');
+  __m128i lower = inRange(chars, 'a', 'z');
+  __m128i digit = inRange(chars, '0', '9');
+  __m128i plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+  __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+  __m128i shift = _mm_or_si128(
+      _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                   _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+      _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                   _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')),
+                                _mm_and_si128(slash, _mm_set1_epi8(63 - '/')))));
+  values = _mm_add_epi8(chars, shift);
+  __m128i valid =
+      _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+  return _mm_movemask_epi8(valid) == 0xffff;
+}
+
+ZC_TARGET_SSE4 inline __m128i base64BytesSse4(__m128i values) {
+  // Packs the 6-bit values of each group of 4 characters into 3 bytes, at the start of the result.
+  __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(groups,
+                          _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+ZC_TARGET_SSE4 size_t decodeBase64Sse4(const char* in, size_t size, byte* out) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16, out += 12) {
+    __m128i values;
+    if (!base64ValuesSse4(load128(in + i), values)) break;
+    __m128i bytes = base64BytesSse4(values);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), bytes);
+    uint32_t last = _mm_extract_epi32(bytes, 2);
+    memcpy(out + 8, &last, sizeof(last));
+  }
+  return i + decodeBase64Scalar(in + i, size - i, out);
+}
+
+ZC_TARGET_SSE4 size_t spanCharSetSse4(const byte* in, size_t size, const CharSet& set) {
+  const __m128i rows = load128(set.rows);
+  const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i nibbles = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chars = load128(in + i);
+    __m128i row = _mm_shuffle_epi8(rows, _mm_and_si128(chars, nibbles));
+    __m128i bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(chars, 4), nibbles));
+    uint outside = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128()));
+    if (outside != 0) return i + __builtin_ctz(outside);
+  }
+  return i + spanCharSetScalar(in + i, size - i, set);
+}
+
+ZC_TARGET_SSE4 size_t spanUntilSse4(const byte* in, size_t size, byte c1, byte c2) {
+  const __m128i v1 = _mm_set1_epi8(c1);
+  const __m128i v2 = _mm_set1_epi8(c2);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chars = load128(in + i);
+    uint found = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, v1),
+                                                _mm_cmpeq_epi8(chars, v2)));
+    if (found != 0) return i + __builtin_ctz(found);
+  }
+  return i + spanUntilScalar(in + i, size - i, c1, c2);
+}
+
+const EncodingKernels SSE4_KERNELS = {
+    SimdLevel::SSE4,
+    widenAscii16Sse4,
+    widenAscii32Sse4,
+    narrowAscii16Sse4,
+    narrowAscii32Sse4,
+    validateUtf8Sse4,
+    encodeHexSse4,
+    decodeHexSse4,
+    encodeBase64Sse4,
+    decodeBase64Sse4,
+    spanCharSetSse4,
+    spanUntilSse4,
+};
+
+// =======================================================================================
+// AVX2 kernels
+//
+// Most AVX2 instructions work on two independent 128-bit lanes, so these are mostly the SSE4
+// kernels twice over, with fix-ups where data crosses lanes. Transcoding to UTF-8 and hex
+// decoding use the SSE4 kernels, which already keep up with memory.
+
+ZC_TARGET_AVX2 inline __m256i load256(const void* p) {
+  return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+}
+
+ZC_TARGET_AVX2 inline void store256(void* p, __m256i value) {
+  _mm256_storeu_si256(static_cast<__m256i*>(p), value);
+}
+
+ZC_TARGET_AVX2 inline __m256i broadcast128(const void* p) {
+  return _mm256_broadcastsi128_si256(load128(p));
+}
+
+ZC_TARGET_AVX2 inline __m256i inRange(__m256i chars, char low, char high) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars));
+}
+
+ZC_TARGET_AVX2 size_t widenAscii16Avx2(const byte* in, size_t size, char16_t* out) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chars = load256(in + i);
+    if (_mm256_movemask_epi8(chars) != 0) break;
+    store256(out + i, _mm256_cvtepu8_epi16(_mm256_castsi256_si128(chars)));
+    store256(out + i + 16, _mm256_cvtepu8_epi16(_mm256_extracti128_si256(chars, 1)));
+  }
+  return i + widenAscii16Sse4(in + i, size - i, out + i);
+}
+
+ZC_TARGET_AVX2 size_t widenAscii32Avx2(const byte* in, size_t size, char32_t* out) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chars = load256(in + i);
+    if (_mm256_movemask_epi8(chars) != 0) break;
+    __m128i low = _mm256_castsi256_si128(chars);
+    __m128i high = _mm256_extracti128_si256(chars, 1);
+    store256(out + i, _mm256_cvtepu8_epi32(low));
+    store256(out + i + 8, _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+    store256(out + i + 16, _mm256_cvtepu8_epi32(high));
+    store256(out + i + 24, _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+  }
+  return i + widenAscii32Sse4(in + i, size - i, out + i);
+}
+
+struct Utf8CheckerAvx2 {
+  __m256i error;
+  __m256i prevInput;
+  __m256i prevIncomplete;
+};
+
+ZC_TARGET_AVX2 inline __m256i prevBytes(__m256i input, __m256i prevInput, int n) {
+  // Shifts the 32 bytes of `input` right by `n`, shifting in the last bytes of `prevInput`.
+  // _mm256_alignr_epi8() works within lanes, so first line up the neighbors of each lane.
+  __m256i neighbors = _mm256_permute2x128_si256(prevInput, input, 0x21);
+  switch (n) {
+    case 1:
+      return _mm256_alignr_epi8(input, neighbors, 15);
+    case 2:
+      return _mm256_alignr_epi8(input, neighbors, 14);
+    default:
+      return _mm256_alignr_epi8(input, neighbors, 13);
+  }
+}
+
+ZC_TARGET_AVX2 inline void checkUtf8Avx2(Utf8CheckerAvx2& checker, __m256i input) {
+  // See checkUtf8Sse4().
+  if (_mm256_movemask_epi8(input) == 0) {
+    checker.error = _mm256_or_si256(checker.error, checker.prevIncomplete);
+    checker.prevIncomplete = _mm256_setzero_si256();
+  } else {
+    const __m256i nibbles = _mm256_set1_epi8(0x0f);
+    __m256i prev1 = prevBytes(input, checker.prevInput, 1);
+    __m256i byte1High = _mm256_shuffle_epi8(broadcast128(UTF8_BYTE_1_HIGH),
+                                            _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibbles));
+    __m256i byte1Low =
+        _mm256_shuffle_epi8(broadcast128(UTF8_BYTE_1_LOW), _mm256_and_si256(prev1, nibbles));
+    __m256i byte2High = _mm256_shuffle_epi8(broadcast128(UTF8_BYTE_2_HIGH),
+                                            _mm256_and_si256(_mm256_srli_epi16(input, 4), nibbles));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    __m256i prev2 = prevBytes(input, checker.prevInput, 2);
+    __m256i prev3 = prevBytes(input, checker.prevInput, 3);
+    __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xe0 - 0x80)));
+    __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xf0 - 0x80)));
+    __m256i must23 =
+        _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8(char(0x80)));
+    checker.error = _mm256_or_si256(checker.error, _mm256_xor_si256(must23, special));
+
+    // Only the high lane holds the end of the block.
+    __m256i incompleteMax =
+        _mm256_inserti128_si256(_mm256_set1_epi8(char(0xff)), load128(UTF8_INCOMPLETE_MAX), 1);
+    checker.prevIncomplete = _mm256_subs_epu8(input, incompleteMax);
+  }
+  checker.prevInput = input;
+}
+
+ZC_TARGET_AVX2 bool validateUtf8Avx2(const byte* in, size_t size) {
+  Utf8CheckerAvx2 checker = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                             _mm256_setzero_si256()};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) checkUtf8Avx2(checker, load256(in + i));
+  if (i < size) {
+    byte tail[32] = {};
+    memcpy(tail, in + i, size - i);
+    checkUtf8Avx2(checker, load256(tail));
+  }
+  __m256i error = _mm256_or_si256(checker.error, checker.prevIncomplete);
+  return _mm256_testz_si256(error, error);
+}
+
+ZC_TARGET_AVX2 void encodeHexAvx2(const byte* in, size_t size, char* out) {
+  const __m256i digits = broadcast128(HEX_DIGITS_TABLE);
+  const __m256i nibbles = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i bytes = load256(in + i);
+    __m256i high =
+        _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibbles));
+    __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, nibbles));
+    // The unpacks interleave within lanes: `first` holds bytes 0-7 and 16-23, `second` the rest.
+    __m256i first = _mm256_unpacklo_epi8(high, low);
+    __m256i second = _mm256_unpackhi_epi8(high, low);
+    store256(out + i * 2, _mm256_permute2x128_si256(first, second, 0x20));
+    store256(out + i * 2 + 32, _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  encodeHexSse4(in + i, size - i, out + i * 2);
+}
+
+ZC_TARGET_AVX2 inline __m256i base64CharsAvx2(__m256i in, __m256i shifts) {
+  // Like base64CharsSse4(), on 12 bytes at the start of each lane.
+  in = _mm256_shuffle_epi8(in, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m256i ac = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                                  _mm256_set1_epi32(0x04000040));
+  __m256i bd = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                                  _mm256_set1_epi32(0x01000010));
+  __m256i values = _mm256_or_si256(ac, bd);
+
+  __m256i classes = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+  __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), values);
+  classes = _mm256_or_si256(classes, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+  return _mm256_add_epi8(values, _mm256_shuffle_epi8(shifts, classes));
+}
+
+ZC_TARGET_AVX2 void encodeBase64Avx2(const byte* in, size_t groups, char* out, bool url) {
+  const __m256i shifts = _mm256_broadcastsi128_si256(base64ShiftsSse4(url));
+  // Each step encodes 8 groups, but reads 28 bytes.
+  for (; groups >= 10; groups -= 8, in += 24, out += 32) {
+    __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(load128(in)), load128(in + 12),
+                                            1);
+    store256(out, base64CharsAvx2(bytes, shifts));
+  }
+  encodeBase64Sse4(in, groups, out, url);
+}
+
+ZC_TARGET_AVX2 size_t decodeBase64Avx2(const char* in, size_t size, byte* out) {
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32, out += 24) {
+    // See base64ValuesSse4() and base64BytesSse4().
+    __m256i chars = load256(in + i);
+    __m256i upper = inRange(chars, 'A', 'Z');
+    __m256i lower = inRange(chars, 'a', 'z');
+    __m256i digit = inRange(chars, '0', '9');
+    __m256i plus = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('+'));
+    __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+    __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                                    _mm256_or_si256(digit, _mm256_or_si256(plus, slash)));
+    if (_mm256_movemask_epi8(valid) != -1) break;
+    __m256i shift = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                        _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+        _mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+                        _mm256_or_si256(_mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')),
+                                        _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')))));
+    __m256i values = _mm256_add_epi8(chars, shift);
+
+    __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+    __m256i bytes = _mm256_shuffle_epi8(
+        groups, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0,
+                                 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    // Move the 12 bytes of the high lane up against those of the low lane.
+    bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+    store128(out, _mm256_castsi256_si128(bytes));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm256_extracti128_si256(bytes, 1));
+  }
+  return i + decodeBase64Sse4(in + i, size - i, out);
+}
+
+ZC_TARGET_AVX2 size_t spanCharSetAvx2(const byte* in, size_t size, const CharSet& set) {
+  const __m256i rows = broadcast128(set.rows);
+  const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+                                        2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i nibbles = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chars = load256(in + i);
+    __m256i row = _mm256_shuffle_epi8(rows, _mm256_and_si256(chars, nibbles));
+    __m256i bit =
+        _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(chars, 4), nibbles));
+    uint outside = _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256()));
+    if (outside != 0) return i + __builtin_ctz(outside);
+  }
+  return i + spanCharSetSse4(in + i, size - i, set);
+}
+
+ZC_TARGET_AVX2 size_t spanUntilAvx2(const byte* in, size_t size, byte c1, byte c2) {
+  const __m256i v1 = _mm256_set1_epi8(c1);
+  const __m256i v2 = _mm256_set1_epi8(c2);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chars = load256(in + i);
+    uint found = _mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(chars, v1), _mm256_cmpeq_epi8(chars, v2)));
+    if (found != 0) return i + __builtin_ctz(found);
+  }
+  return i + spanUntilSse4(in + i, size - i, c1, c2);
+}
+
+const EncodingKernels AVX2_KERNELS = {
+    SimdLevel::AVX2,
+    widenAscii16Avx2,
+    widenAscii32Avx2,
+    narrowAscii16Sse4,
+    narrowAscii32Sse4,
+    validateUtf8Avx2,
+    encodeHexAvx2,
+    decodeHexSse4,
+    encodeBase64Avx2,
+    decodeBase64Avx2,
+    spanCharSetAvx2,
+    spanUntilAvx2,
+};
+
+#endif  // ZC_ENCODING_X86
+
+// =======================================================================================
+// Dispatch
+
+bool cpuSupports(SimdLevel level) {
+#if ZC_ENCODING_X86
+  __builtin_cpu_init();
+  switch (level) {
+    case SimdLevel::SCALAR:
+      return true;
+    case SimdLevel::SSE4:
+      return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+    case SimdLevel::AVX2:
+      return __builtin_cpu_supports("avx2");
+  }
+  ZC_UNREACHABLE;
+#else
+  return level == SimdLevel::SCALAR;
+#endif
+}
+
+const EncodingKernels& kernelsFor(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::SCALAR:
+      return SCALAR_KERNELS;
+#if ZC_ENCODING_X86
+    case SimdLevel::SSE4:
+      return SSE4_KERNELS;
+    case SimdLevel::AVX2:
+      return AVX2_KERNELS;
+#else
+    default:
+      break;
+#endif
+  }
+  ZC_UNREACHABLE;
+}
+
+SimdLevel levelFromEnvironment() {
+  SimdLevel level = SimdLevel::AVX2;
+  const char* name = getenv("ZC_ENCODING_SIMD");
+  if (name != nullptr) {
+    if (strcmp(name, "scalar") == 0) {
+      level = SimdLevel::SCALAR;
+    } else if (strcmp(name, "sse4") == 0) {
+      level = SimdLevel::SSE4;
+    }
+  }
+  while (!cpuSupports(level)) level = static_cast<SimdLevel>(static_cast<uint>(level) - 1);
+  return level;
+}
+
+const EncodingKernels* currentKernels = nullptr;
+
+}  // namespace
+
+const EncodingKernels& getEncodingKernels() {
+  const EncodingKernels* kernels = __atomic_load_n(&currentKernels, __ATOMIC_RELAXED);
+  if (ZC_UNLIKELY(kernels == nullptr)) {
+    // Threads that race here all choose the same kernels.
+    kernels = &kernelsFor(levelFromEnvironment());
+    __atomic_store_n(&currentKernels, kernels, __ATOMIC_RELAXED);
+  }
+  return *kernels;
+}
+
+bool setEncodingSimdLevel(SimdLevel level) {
+  if (!cpuSupports(level)) return false;
+  __atomic_store_n(&currentKernels, &kernelsFor(level), __ATOMIC_RELAXED);
+  return true;
+}
+
+}  // namespace _
+}  // namespace zc
@@ -0,0 +1,111 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+// Vectorized kernels behind the functions in encoding.h. This header is internal to ZC; it is
+// only exposed so that tests and benchmarks can select the kernels to run.
+
+#include "zc/core/common.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+namespace _ {  // private
+
+enum class SimdLevel {
+  SCALAR,
+  SSE4,  // SSSE3 and SSE4.1
+  AVX2,
+};
+
+struct CharSet {
+  // A set of ASCII characters, laid out so that SIMD code can test 16 or 32 bytes for membership
+  // with two table lookups: bit `c >> 4` of `rows[c & 0x0f]` is set if `c` is in the set.
+
+  byte rows[16];
+
+  constexpr bool contains(byte c) const { return c < 0x80 && (rows[c & 0x0f] >> (c >> 4)) & 1; }
+};
+
+template <typename Predicate>
+constexpr CharSet charSet(Predicate&& predicate) {
+  CharSet result{};
+  for (uint c = 0; c < 0x80; c++) {
+    if (predicate(c)) result.rows[c & 0x0f] |= 1 << (c >> 4);
+  }
+  return result;
+}
+
+struct EncodingKernels {
+  // The kernels of one instruction set. Each does as much of its job as it can do quickly and
+  // returns how far it got; the callers in encoding.cc handle whatever remains, such as non-ASCII
+  // text or invalid input, with the scalar code that defines the semantics.
+
+  SimdLevel level;
+
+  size_t (*widenAscii16)(const byte* in, size_t size, char16_t* out);
+  size_t (*widenAscii32)(const byte* in, size_t size, char32_t* out);
+  // Convert the leading run of ASCII characters in `in` to UTF-16 or UTF-32. Returns the length of
+  // the run.
+
+  size_t (*narrowAscii16)(const char16_t* in, size_t size, char* out);
+  size_t (*narrowAscii32)(const char32_t* in, size_t size, char* out);
+  // Convert the leading run of code units below 0x80 in `in` to UTF-8. Returns the length of the
+  // run.
+
+  bool (*validateUtf8)(const byte* in, size_t size);
+
+  void (*encodeHex)(const byte* in, size_t size, char* out);
+  // Writes `size * 2` lowercase hex digits.
+
+  size_t (*decodeHex)(const char* in, size_t size, byte* out);
+  // Decodes up to `size` bytes from `size * 2` hex digits, stopping at the first invalid digit or
+  // earlier. Returns the number of bytes written.
+
+  void (*encodeBase64)(const byte* in, size_t groups, char* out, bool url);
+  // Encodes `groups` whole groups of 3 bytes as 4 characters each, without padding or line
+  // breaks, using the URL-safe alphabet if `url` is true.
+
+  size_t (*decodeBase64)(const char* in, size_t size, byte* out);
+  // Decodes the leading groups of 4 characters that contain nothing but base64 characters (no
+  // whitespace or padding), possibly stopping earlier. Returns the number of characters consumed,
+  // always a multiple of 4; 3 bytes were written for every 4 of them.
+
+  size_t (*spanCharSet)(const byte* in, size_t size, const CharSet& set);
+  // Returns the length of the leading run of bytes in `set`.
+
+  size_t (*spanUntil)(const byte* in, size_t size, byte c1, byte c2);
+  // Returns the index of the first byte equal to `c1` or `c2`, or `size` if there is none.
+};
+
+const EncodingKernels& getEncodingKernels();
+// Returns the kernels to use, choosing them on first use: the best ones the CPU supports, unless
+// the environment variable ZC_ENCODING_SIMD names a lower level ("scalar", "sse4" or "avx2").
+
+bool setEncodingSimdLevel(SimdLevel level);
+// Selects the kernels of `level`, for tests and benchmarks. Returns false and changes nothing if
+// the CPU or the build doesn't support `level`. Calls already running on other threads finish with
+// the kernels they started with.
+
+}  // namespace _
+}  // namespace zc
+
+ZC_END_HEADER
@@ -22,6 +22,7 @@
 #include "zc/core/encoding.h"
 
 #include "zc/core/debug.h"
+#include "zc/core/encoding-simd.h"
 #include "zc/core/vector.h"
 
 namespace zc {
@@ -40,13 +41,36 @@ inline void addChar32(Vector<char16_t>& vec, char32_t u) {
 
 inline void addChar32(Vector<char32_t>& vec, char32_t u) { vec.add(u); }
 
+inline size_t widenAscii(const _::EncodingKernels& kernels, const byte* in, size_t size,
+                         char16_t* out) {
+  return kernels.widenAscii16(in, size, out);
+}
+
+inline size_t widenAscii(const _::EncodingKernels& kernels, const byte* in, size_t size,
+                         char32_t* out) {
+  return kernels.widenAscii32(in, size, out);
+}
+
 template <typename T>
 EncodingResult<Array<T>> encodeUtf(ArrayPtr<const char> text, bool nulTerminate) {
   Vector<T> result(text.size() + nulTerminate);
   bool hadErrors = false;
+  auto& kernels = _::getEncodingKernels();
 
   size_t i = 0;
   while (i < text.size()) {
+    if (static_cast<byte>(text[i]) < 0x80) {
+      // Convert a whole run of ASCII at once. No byte of UTF-8 becomes more than one code unit,
+      // so the run fits in the capacity reserved above.
+      size_t start = result.size();
+      result.resize(start + (text.size() - i));
+      size_t run = widenAscii(kernels, text.asBytes().begin() + i, text.size() - i,
+                              result.begin() + start);
+      result.truncate(start + run);
+      i += run;
+      continue;
+    }
+
     byte c = text[i++];
     if (c < 0x80) {
       // 0xxxxxxx -- ASCII
@@ -150,9 +174,21 @@ EncodingResult<Array<char32_t>> encodeUtf32(ArrayPtr<const char> text, bool nulT
 EncodingResult<String> decodeUtf16(ArrayPtr<const char16_t> utf16) {
   Vector<char> result(utf16.size() + 1);
   bool hadErrors = false;
+  auto& kernels = _::getEncodingKernels();
 
   size_t i = 0;
   while (i < utf16.size()) {
+    if (utf16[i] < 0x80) {
+      // Convert a whole run of ASCII at once.
+      size_t start = result.size();
+      result.resize(start + (utf16.size() - i));
+      size_t run =
+          kernels.narrowAscii16(utf16.begin() + i, utf16.size() - i, result.begin() + start);
+      result.truncate(start + run);
+      i += run;
+      continue;
+    }
+
     char16_t u = utf16[i++];
 
     if (u < 0x80) {
@@ -195,9 +231,21 @@ EncodingResult<String> decodeUtf16(ArrayPtr<const char16_t> utf16) {
 EncodingResult<String> decodeUtf32(ArrayPtr<const char32_t> utf16) {
   Vector<char> result(utf16.size() + 1);
   bool hadErrors = false;
+  auto& kernels = _::getEncodingKernels();
 
   size_t i = 0;
   while (i < utf16.size()) {
+    if (utf16[i] < 0x80) {
+      // Convert a whole run of ASCII at once.
+      size_t start = result.size();
+      result.resize(start + (utf16.size() - i));
+      size_t run =
+          kernels.narrowAscii32(utf16.begin() + i, utf16.size() - i, result.begin() + start);
+      result.truncate(start + run);
+      i += run;
+      continue;
+    }
+
     char32_t u = utf16[i++];
 
     if (u < 0x80) {
@@ -233,6 +281,10 @@ EncodingResult<String> decodeUtf32(ArrayPtr<const char32_t> utf16) {
   return {String(result.releaseAsArray()), hadErrors};
 }
 
+bool validateUtf8(ArrayPtr<const char> text) {
+  return _::getEncodingKernels().validateUtf8(text.asBytes().begin(), text.size());
+}
+
 namespace {
 
 #if __GNUC__ >= 8 && !__clang__
@@ -358,10 +410,7 @@ static Maybe<uint> tryFromOctDigit(char c) {
 
 String encodeHex(ArrayPtr<const byte> input) {
   auto result = heapString(input.size() * 2);
-  for (auto i : zc::indices(input)) {
-    result[i * 2] = HEX_DIGITS[input[i] / 16];
-    result[i * 2 + 1] = HEX_DIGITS[input[i] % 16];
-  }
+  _::getEncodingKernels().encodeHex(input.begin(), input.size(), result.begin());
   return result;
 }
 
@@ -369,7 +418,9 @@ EncodingResult<Array<byte>> decodeHex(ArrayPtr<const char> text) {
   auto result = heapArray<byte>(text.size() / 2);
   bool hadErrors = text.size() % 2;
 
-  for (auto i : zc::indices(result)) {
+  // The kernel stops at the first invalid digit, from where the loop below handles errors.
+  size_t decoded = _::getEncodingKernels().decodeHex(text.begin(), result.size(), result.begin());
+  for (size_t i = decoded; i < result.size(); i++) {
     byte b = 0;
     ZC_IF_SOME(d1, tryFromHexDigit(text[i * 2])) { b = d1 << 4; }
     else { hadErrors = true; }
@@ -381,13 +432,57 @@ EncodingResult<Array<byte>> decodeHex(ArrayPtr<const char> text) {
   return {zc::mv(result), hadErrors};
 }
 
-String encodeUriComponent(ArrayPtr<const byte> bytes) {
+namespace {
+
+// The characters that each URI encoding leaves alone.
+
+constexpr _::CharSet URI_COMPONENT_CHARS = _::charSet([](byte b) {
+  return ('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') || b == '-' ||
+         b == '_' || b == '.' || b == '!' || b == '~' || b == '*' || b == '\'' || b == '(' ||
+         b == ')';
+});
+
+constexpr _::CharSet URI_FRAGMENT_CHARS = _::charSet([](byte b) {
+  return ('?' <= b && b <= '_') ||  // covers A-Z
+         ('a' <= b && b <= '~') ||  // covers a-z
+         ('&' <= b && b <= ';') ||  // covers 0-9
+         b == '!' || b == '=' || b == '#' || b == '$';
+});
+
+constexpr _::CharSet URI_PATH_CHARS = _::charSet([](byte b) {
+  return ('@' <= b && b <= '[') ||                            // covers A-Z
+         ('a' <= b && b <= 'z') || ('0' <= b && b <= ';') ||  // covers 0-9
+         ('&' <= b && b <= '.') || b == '_' || b == '!' || b == '=' || b == ']' || b == '^' ||
+         b == '|' || b == '~' || b == '$';
+});
+
+constexpr _::CharSet URI_USER_INFO_CHARS = _::charSet([](byte b) {
+  return ('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') ||
+         ('&' <= b && b <= '.') || b == '_' || b == '!' || b == '~' || b == '$';
+});
+
+constexpr _::CharSet WWW_FORM_CHARS = _::charSet([](byte b) {
+  return ('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') || b == '-' ||
+         b == '_' || b == '.' || b == '*';
+});
+
+String encodeUri(ArrayPtr<const byte> bytes, const _::CharSet& unescaped,
+                 bool spaceAsPlus = false) {
   Vector<char> result(bytes.size() + 1);
-  for (byte b : bytes) {
-    if (('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') || b == '-' ||
-        b == '_' || b == '.' || b == '!' || b == '~' || b == '*' || b == '\'' || b == '(' ||
-        b == ')') {
-      result.add(b);
+  auto& kernels = _::getEncodingKernels();
+
+  const byte* ptr = bytes.begin();
+  const byte* end = bytes.end();
+  while (ptr < end) {
+    // Copy everything up to the next character to escape at once.
+    size_t run = kernels.spanCharSet(ptr, end - ptr, unescaped);
+    result.addAll(reinterpret_cast<const char*>(ptr), reinterpret_cast<const char*>(ptr + run));
+    ptr += run;
+    if (ptr == end) break;
+
+    byte b = *ptr++;
+    if (spaceAsPlus && b == ' ') {
+      result.add('+');
     } else {
       result.add('%');
       result.add(HEX_DIGITS_URI[b / 16]);
@@ -398,84 +493,42 @@ String encodeUriComponent(ArrayPtr<const byte> bytes) {
   return String(result.releaseAsArray());
 }
 
-String encodeUriFragment(ArrayPtr<const byte> bytes) {
-  Vector<char> result(bytes.size() + 1);
-  for (byte b : bytes) {
-    if (('?' <= b && b <= '_') ||  // covers A-Z
-        ('a' <= b && b <= '~') ||  // covers a-z
-        ('&' <= b && b <= ';') ||  // covers 0-9
-        b == '!' || b == '=' || b == '#' || b == '$') {
-      result.add(b);
-    } else {
-      result.add('%');
-      result.add(HEX_DIGITS_URI[b / 16]);
-      result.add(HEX_DIGITS_URI[b % 16]);
-    }
-  }
-  result.add('\0');
-  return String(result.releaseAsArray());
+}  // namespace
+
+String encodeUriComponent(ArrayPtr<const byte> bytes) {
+  return encodeUri(bytes, URI_COMPONENT_CHARS);
 }
 
-String encodeUriPath(ArrayPtr<const byte> bytes) {
-  Vector<char> result(bytes.size() + 1);
-  for (byte b : bytes) {
-    if (('@' <= b && b <= '[') ||                            // covers A-Z
-        ('a' <= b && b <= 'z') || ('0' <= b && b <= ';') ||  // covers 0-9
-        ('&' <= b && b <= '.') || b == '_' || b == '!' || b == '=' || b == ']' || b == '^' ||
-        b == '|' || b == '~' || b == '$') {
-      result.add(b);
-    } else {
-      result.add('%');
-      result.add(HEX_DIGITS_URI[b / 16]);
-      result.add(HEX_DIGITS_URI[b % 16]);
-    }
-  }
-  result.add('\0');
-  return String(result.releaseAsArray());
+String encodeUriFragment(ArrayPtr<const byte> bytes) {
+  return encodeUri(bytes, URI_FRAGMENT_CHARS);
 }
 
+String encodeUriPath(ArrayPtr<const byte> bytes) { return encodeUri(bytes, URI_PATH_CHARS); }
+
 String encodeUriUserInfo(ArrayPtr<const byte> bytes) {
-  Vector<char> result(bytes.size() + 1);
-  for (byte b : bytes) {
-    if (('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') ||
-        ('&' <= b && b <= '.') || b == '_' || b == '!' || b == '~' || b == '$') {
-      result.add(b);
-    } else {
-      result.add('%');
-      result.add(HEX_DIGITS_URI[b / 16]);
-      result.add(HEX_DIGITS_URI[b % 16]);
-    }
-  }
-  result.add('\0');
-  return String(result.releaseAsArray());
+  return encodeUri(bytes, URI_USER_INFO_CHARS);
 }
 
 String encodeWwwForm(ArrayPtr<const byte> bytes) {
-  Vector<char> result(bytes.size() + 1);
-  for (byte b : bytes) {
-    if (('A' <= b && b <= 'Z') || ('a' <= b && b <= 'z') || ('0' <= b && b <= '9') || b == '-' ||
-        b == '_' || b == '.' || b == '*') {
-      result.add(b);
-    } else if (b == ' ') {
-      result.add('+');
-    } else {
-      result.add('%');
-      result.add(HEX_DIGITS_URI[b / 16]);
-      result.add(HEX_DIGITS_URI[b % 16]);
-    }
-  }
-  result.add('\0');
-  return String(result.releaseAsArray());
+  return encodeUri(bytes, WWW_FORM_CHARS, /*spaceAsPlus=*/true);
 }
 
 EncodingResult<Array<byte>> decodeBinaryUriComponent(ArrayPtr<const char> text,
                                                      DecodeUriOptions options) {
   Vector<byte> result(text.size() + options.nulTerminate);
   bool hadErrors = false;
+  auto& kernels = _::getEncodingKernels();
 
   const char* ptr = text.begin();
   const char* end = text.end();
   while (ptr < end) {
+    // Copy everything up to the next escape at once.
+    const byte* run = reinterpret_cast<const byte*>(ptr);
+    size_t runSize = kernels.spanUntil(run, end - ptr, '%', options.plusToSpace ? '+' : '%');
+    result.addAll(run, run + runSize);
+    ptr += runSize;
+    if (ptr == end) break;
+
     if (*ptr == '%') {
       ++ptr;
 
@@ -705,163 +758,74 @@ EncodingResult<Array<byte>> decodeBinaryCEscape(ArrayPtr<const char> text, bool
 }
 
 // =======================================================================================
-// This code is derived from libb64 which has been placed in the public domain.
-// For details, see http://sourceforge.net/projects/libb64
-
-// -------------------------------------------------------------------
-// Encoder
+// Base64
 
 namespace {
 
-typedef enum { step_A, step_B, step_C } base64_encodestep;
+const size_t BASE64_GROUPS_PER_LINE = 18;
+// With `breakLines`, lines are 72 characters long.
 
-typedef struct {
-  base64_encodestep step;
-  char result;
-  int stepcount;
-} base64_encodestate;
-
-const int CHARS_PER_LINE = 72;
-
-void base64_init_encodestate(base64_encodestate* state_in) {
-  state_in->step = step_A;
-  state_in->result = 0;
-  state_in->stepcount = 0;
-}
-
-char base64_encode_value(char value_in) {
-  static const char* encoding = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  if (value_in > 63) return '=';
-  return encoding[(int)value_in];
-}
-
-int base64_encode_block(const char* plaintext_in, int length_in, char* code_out,
-                        base64_encodestate* state_in, bool breakLines) {
-  const char* plainchar = plaintext_in;
-  const char* const plaintextend = plaintext_in + length_in;
-  char* codechar = code_out;
-  char result;
-  char fragment;
-
-  result = state_in->result;
-
-  switch (state_in->step) {
-    while (1) {
-      ZC_FALLTHROUGH;
-      case step_A:
-        if (plainchar == plaintextend) {
-          state_in->result = result;
-          state_in->step = step_A;
-          return codechar - code_out;
-        }
-        fragment = *plainchar++;
-        result = (fragment & 0x0fc) >> 2;
-        *codechar++ = base64_encode_value(result);
-        result = (fragment & 0x003) << 4;
-        ZC_FALLTHROUGH;
-      case step_B:
-        if (plainchar == plaintextend) {
-          state_in->result = result;
-          state_in->step = step_B;
-          return codechar - code_out;
-        }
-        fragment = *plainchar++;
-        result |= (fragment & 0x0f0) >> 4;
-        *codechar++ = base64_encode_value(result);
-        result = (fragment & 0x00f) << 2;
-        ZC_FALLTHROUGH;
-      case step_C:
-        if (plainchar == plaintextend) {
-          state_in->result = result;
-          state_in->step = step_C;
-          return codechar - code_out;
-        }
-        fragment = *plainchar++;
-        result |= (fragment & 0x0c0) >> 6;
-        *codechar++ = base64_encode_value(result);
-        result = (fragment & 0x03f) >> 0;
-        *codechar++ = base64_encode_value(result);
-
-        ++(state_in->stepcount);
-        if (breakLines && state_in->stepcount == CHARS_PER_LINE / 4) {
-          *codechar++ = '\n';
-          state_in->stepcount = 0;
-        }
+String encodeBase64Impl(ArrayPtr<const byte> input, bool breakLines, bool url) {
+  // URL-safe base64 leaves out the padding of the last group.
+  size_t groups = input.size() / 3;
+  size_t tail = input.size() % 3;
+  size_t numChars = groups * 4 + (tail == 0 ? 0 : url ? tail + 1 : 4);
+  if (breakLines) {
+    // Every line ends with a newline, including a partial last one.
+    numChars += (groups + (tail > 0) + BASE64_GROUPS_PER_LINE - 1) / BASE64_GROUPS_PER_LINE;
+  }
+  auto output = heapString(numChars);
+  auto& kernels = _::getEncodingKernels();
+
+  const byte* in = input.begin();
+  char* out = output.begin();
+  size_t groupsPerCall = breakLines ? BASE64_GROUPS_PER_LINE : groups;
+  size_t groupsOnLine = 0;
+  while (groups > 0) {
+    size_t n = zc::min(groups, groupsPerCall);
+    kernels.encodeBase64(in, n, out, url);
+    in += n * 3;
+    out += n * 4;
+    groups -= n;
+    groupsOnLine = n;
+    if (breakLines && n == BASE64_GROUPS_PER_LINE) {
+      *out++ = '\n';
+      groupsOnLine = 0;
     }
   }
-  /* control should not reach here */
-  return codechar - code_out;
-}
-
-int base64_encode_blockend(char* code_out, base64_encodestate* state_in, bool breakLines) {
-  char* codechar = code_out;
 
-  switch (state_in->step) {
-    case step_B:
-      *codechar++ = base64_encode_value(state_in->result);
-      *codechar++ = '=';
-      *codechar++ = '=';
-      ++state_in->stepcount;
-      break;
-    case step_C:
-      *codechar++ = base64_encode_value(state_in->result);
-      *codechar++ = '=';
-      ++state_in->stepcount;
-      break;
-    case step_A:
-      break;
+  if (tail > 0) {
+    byte last[3] = {};
+    memcpy(last, in, tail);
+    char chars[4];
+    kernels.encodeBase64(last, 1, chars, url);
+    *out++ = chars[0];
+    *out++ = chars[1];
+    if (tail == 2) {
+      *out++ = chars[2];
+    } else if (!url) {
+      *out++ = '=';
+    }
+    if (!url) *out++ = '=';
+    ++groupsOnLine;
   }
-  if (breakLines && state_in->stepcount > 0) { *codechar++ = '\n'; }
+  if (breakLines && groupsOnLine > 0) *out++ = '\n';
 
-  return codechar - code_out;
+  ZC_ASSERT(out == output.end(), out - output.begin(), output.size());
+  return output;
 }
 
 }  // namespace
 
 String encodeBase64(ArrayPtr<const byte> input, bool breakLines) {
-  /* set up a destination buffer large enough to hold the encoded data */
-  // equivalent to ceil(input.size() / 3) * 4
-  auto numChars = (input.size() + 2) / 3 * 4;
-  if (breakLines) {
-    // Add space for newline characters.
-    uint lineCount = numChars / CHARS_PER_LINE;
-    if (numChars % CHARS_PER_LINE > 0) {
-      // Partial line.
-      ++lineCount;
-    }
-    numChars = numChars + lineCount;
-  }
-  auto output = heapString(numChars);
-  /* keep track of our encoded position */
-  char* c = output.begin();
-  /* store the number of bytes encoded by a single call */
-  int cnt = 0;
-  size_t total = 0;
-  /* we need an encoder state */
-  base64_encodestate s;
-
-  /*---------- START ENCODING ----------*/
-  /* initialise the encoder state */
-  base64_init_encodestate(&s);
-  /* gather data from the input and send it to the output */
-  cnt = base64_encode_block((const char*)input.begin(), input.size(), c, &s, breakLines);
-  c += cnt;
-  total += cnt;
-
-  /* since we have encoded the entire input string, we know that
-     there is no more input data; finalise the encoding */
-  cnt = base64_encode_blockend(c, &s, breakLines);
-  c += cnt;
-  total += cnt;
-  /*---------- STOP ENCODING  ----------*/
-
-  ZC_ASSERT(total == output.size(), total, output.size());
-
-  return output;
+  return encodeBase64Impl(input, breakLines, /*url=*/false);
 }
 
 // -------------------------------------------------------------------
 // Decoder
+//
+// This code is derived from libb64 which has been placed in the public domain.
+// For details, see http://sourceforge.net/projects/libb64
 
 namespace {
 
@@ -934,11 +898,8 @@ int base64_decode_block(const char* code_in, const int length_in, char* plaintex
           if (codechar == code_in + length_in) {
             state_in->step = step_b;
             state_in->plainchar = *plainchar;
-            // It is always an error to suspend from step B, because we don't have enough bits yet.
-            // TODO(someday): This actually breaks the streaming use case, if base64_decode_block()
-            // is
-            //   to be called multiple times. We'll fix it if we ever care to support streaming.
-            state_in->hadErrors = true;
+            // It is an error to end the input in step B, because we don't have enough bits yet, but
+            // more input may follow; see decodeBase64().
             return plainchar - plaintext_out;
           }
           fragment = (signed char)base64_decode_value(*codechar++);
@@ -953,11 +914,8 @@ int base64_decode_block(const char* code_in, const int length_in, char* plaintex
           if (codechar == code_in + length_in) {
             state_in->step = step_c;
             state_in->plainchar = *plainchar;
-            // It is an error to complete from step C if we have seen incomplete padding.
-            // TODO(someday): This actually breaks the streaming use case, if base64_decode_block()
-            // is
-            //   to be called multiple times. We'll fix it if we ever care to support streaming.
-            ERROR_IF(state_in->nPaddingBytesSeen == 1);
+            // It is an error to end the input in step C with incomplete padding, but more input
+            // may follow; see decodeBase64().
             return plainchar - plaintext_out;
           }
           fragment = (signed char)base64_decode_value(*codechar++);
@@ -996,12 +954,38 @@ int base64_decode_block(const char* code_in, const int length_in, char* plaintex
 
 EncodingResult<Array<byte>> decodeBase64(ArrayPtr<const char> input) {
   base64_decodestate state;
+  auto& kernels = _::getEncodingKernels();
 
   auto output = heapArray<byte>((input.size() * 6 + 7) / 8);
 
-  size_t n = base64_decode_block(input.begin(), input.size(),
-                                 reinterpret_cast<char*>(output.begin()), &state);
+  const char* in = input.begin();
+  const char* end = input.end();
+  byte* out = output.begin();
+  while (in < end) {
+    if (state.step == step_a) {
+      // Decode plain base64 characters in bulk. The state machine takes over at the first
+      // whitespace, padding or invalid character, and returns here at the start of a group.
+      size_t consumed = kernels.decodeBase64(in, end - in, out);
+      in += consumed;
+      out += consumed / 4 * 3;
+      if (in == end) break;
+    }
+
+    size_t chunk = state.step == step_a ? zc::min(end - in, 4) : 1;
+    out += base64_decode_block(in, chunk, reinterpret_cast<char*>(out), &state);
+    in += chunk;
+  }
+
+  // Errors the state machine can only see at the end of the input.
+  if (state.step == step_b) {
+    // A single character is not enough for a byte.
+    state.hadErrors = true;
+  } else if (state.step == step_c && state.nPaddingBytesSeen == 1) {
+    // Incomplete padding.
+    state.hadErrors = true;
+  }
 
+  size_t n = out - output.begin();
   if (n < output.size()) {
     auto copy = heapArray<byte>(n);
     memcpy(copy.begin(), output.begin(), n);
@@ -1012,21 +996,9 @@ EncodingResult<Array<byte>> decodeBase64(ArrayPtr<const char> input) {
 }
 
 String encodeBase64Url(ArrayPtr<const byte> bytes) {
-  // TODO(perf): Rewrite as single pass?
   // TODO(someday): Write decoder?
 
-  auto base64 = zc::encodeBase64(bytes);
-
-  for (char& c : base64) {
-    if (c == '+') c = '-';
-    if (c == '/') c = '_';
-  }
-
-  // Remove trailing '='s.
-  zc::ArrayPtr<const char> slice = base64;
-  while (slice.size() > 0 && slice.back() == '=') { slice = slice.first(slice.size() - 1); }
-
-  return zc::str(slice);
+  return encodeBase64Impl(bytes, /*breakLines=*/false, /*url=*/true);
 }
 
 }  // namespace zc
@@ -108,6 +108,11 @@ EncodingResult<String> decodeUtf32(ArrayPtr<const char32_t> utf32);
 //   raised on subsequent legs unless all invalid sequences were replaced with U+FFFD (which, after
 //   all, is a valid code point).
 
+bool validateUtf8(ArrayPtr<const char> text);
+// Returns true if `text` is well-formed UTF-8: no stray continuation bytes, truncated or overlong
+// sequences, surrogates, or code points above U+10FFFF. This gives the same answer as
+// `!encodeUtf16(text).hadErrors`, many times faster and without allocating.
+
 EncodingResult<Array<wchar_t>> encodeWideString(ArrayPtr<const char> text,
                                                 bool nulTerminate = false);
 EncodingResult<String> decodeWideString(ArrayPtr<const wchar_t> wide);
@@ -300,6 +305,10 @@ inline EncodingResult<Array<char16_t>> encodeUtf16(const char (&text)[s],
   return encodeUtf16(arrayPtr(text, s - 1), nulTerminate);
 }
 template <size_t s>
+inline bool validateUtf8(const char (&text)[s]) {
+  return validateUtf8(arrayPtr(text, s - 1));
+}
+template <size_t s>
 inline EncodingResult<Array<char32_t>> encodeUtf32(const char (&text)[s],
                                                    bool nulTerminate = false) {
   return encodeUtf32(arrayPtr(text, s - 1), nulTerminate);
@@ -381,6 +390,10 @@ inline EncodingResult<Array<char16_t>> encodeUtf16(const char8_t (&text)[s],
   return encodeUtf16(arrayPtr(reinterpret_cast<const char*>(text), s - 1), nulTerminate);
 }
 template <size_t s>
+inline bool validateUtf8(const char8_t (&text)[s]) {
+  return validateUtf8(arrayPtr(reinterpret_cast<const char*>(text), s - 1));
+}
+template <size_t s>
 inline EncodingResult<Array<char32_t>> encodeUtf32(const char8_t (&text)[s],
                                                    bool nulTerminate = false) {
   return encodeUtf32(arrayPtr(reinterpret_cast<const char*>(text), s - 1), nulTerminate);
@@ -44,9 +44,12 @@
 #include "zc/core/debug.h"
 #include "zc/core/exception.h"
 #include "zc/core/function.h"
+#include "zc/core/log-writer.h"
 #include "zc/core/main.h"
+#include "zc/core/map.h"
 #include "zc/core/miniposix.h"
 #include "zc/core/string.h"
+#include "zc/core/vector.h"
 #ifndef _WIN32
 #include <sys/mman.h>
 #endif
@@ -281,7 +284,10 @@ struct Subprocess {
   zc::AutoCloseFd out;
 };
 
-String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
+Maybe<Array<String>> symbolizeWithLlvm(ArrayPtr<void* const> trace) {
+  // Runs llvm-symbolizer, returning its output for each address of `trace`: the function and
+  // source location (several of each if calls were inlined), followed by an empty line.
+
   const char* llvmSymbolizer = getenv("LLVM_SYMBOLIZER");
   if (llvmSymbolizer == nullptr) { llvmSymbolizer = "llvm-symbolizer"; }
 
@@ -314,7 +320,7 @@ String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
         // Ignore EPIPE, which means the process exited early. We'll deal with it below, presumably.
         if (errno != EPIPE) {
           ZC_LOG(ERROR, "write error", strerror(errno));
-          return nullptr;
+          return zc::none;
         }
       }
       subprocess.in = nullptr;
@@ -324,14 +330,23 @@ String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
       auto out = fdopen(subprocess.out.release(), "r");
       if (!out) {
         ZC_LOG(ERROR, "fdopen error", strerror(errno));
-        return nullptr;
+        return zc::none;
       }
       ZC_DEFER(fclose(out));
 
-      zc::String lines[256];
-      size_t i = 0;
+      auto frames = heapArrayBuilder<String>(trace.size());
+      Vector<char> frame;
+      bool atLineStart = true;
       for (char line[512]{}; fgets(line, sizeof(line), out) != nullptr;) {
-        if (i < zc::size(lines)) { lines[i++] = zc::str(line); }
+        size_t size = strlen(line);
+        bool endsFrame = atLineStart && line[0] == '\n';
+        atLineStart = size > 0 && line[size - 1] == '\n';
+        if (frames.isFull()) continue;
+        frame.addAll(arrayPtr(line, size));
+        if (endsFrame) {
+          frames.add(heapString(frame.asPtr()));
+          frame.clear();
+        }
       }
       int status = subprocess.wait();
       if (WIFEXITED(status)) {
@@ -351,15 +366,22 @@ String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
           } else {
             ZC_LOG(ERROR, "bad exit code", WEXITSTATUS(status));
           }
-          return nullptr;
+          return zc::none;
         }
       } else {
         ZC_LOG(ERROR, "bad exit status", status);
-        return nullptr;
+        return zc::none;
+      }
+      if (!frames.isFull()) {
+        ZC_LOG(ERROR, "llvm-symbolizer output doesn't match the addresses given to it");
+        return zc::none;
       }
-      return zc::str("\n", zc::strArray(zc::arrayPtr(lines, i), ""));
+      return frames.finish();
+    }
+    else {
+      ZC_LOG(ERROR, "error starting llvm-symbolizer");
+      return zc::none;
     }
-    else { return zc::str("\nerror starting llvm-symbolizer"); }
   } catch (...) {
     auto exception = getCaughtExceptionAsKj();
 
@@ -367,8 +389,98 @@ String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
     // trace stringification recursively!
     ZC_LOG(ERROR, "caught exception while trying to stringify stack trace",
            exception.getDescription());
-    return nullptr;
+    return zc::none;
+  }
+}
+
+String symbolizeInProcess(void* addr) {
+  // Names the function containing `addr` from the dynamic symbol table, in the same layout as
+  // llvm-symbolizer's output. This finds no source locations, and only names functions that are
+  // exported dynamically (link with -rdynamic to export them all), but it needs no subprocess.
+
+  Dl_info info;
+  if (!dladdr(addr, &info)) return heapString("??\n??\n\n");
+  if (info.dli_sname == nullptr || info.dli_saddr == nullptr) {
+    return zc::str("??\n", info.dli_fname, "\n\n");
+  }
+
+  int status = -1;
+#if __GNUC__
+  char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+  ZC_DEFER(free(demangled));
+#else
+  const char* demangled = nullptr;
+#endif
+  uintptr_t offset =
+      reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_saddr);
+  return zc::str(status == 0 ? demangled : info.dli_sname, "+0x", zc::hex(offset), "\n",
+                 info.dli_fname, "\n\n");
+}
+
+class SymbolCache {
+  // Symbolized frames by address. Exceptions thrown repeatedly from the same places share most of
+  // their frames, so each address only needs to be symbolized once.
+
+public:
+  Maybe<String> find(void* addr) {
+    if (!tryLock()) return zc::none;
+    ZC_DEFER(unlock());
+    return frames.find(addr).map([](String& frame) { return heapString(frame); });
+  }
+
+  void insert(void* addr, StringPtr frame) {
+    if (!tryLock()) return;
+    ZC_DEFER(unlock());
+    if (frames.size() >= MAX_FRAMES) frames.clear();
+    frames.upsert(addr, heapString(frame));
+  }
+
+private:
+  static constexpr size_t MAX_FRAMES = 4096;
+
+  bool locked = false;
+  // Only ever tried, never waited on: this may run in a signal handler that interrupted the thread
+  // holding the lock, in which case the cache is skipped.
+
+  HashMap<void*, String> frames;
+
+  bool tryLock() { return !__atomic_exchange_n(&locked, true, __ATOMIC_ACQUIRE); }
+  void unlock() { __atomic_store_n(&locked, false, __ATOMIC_RELEASE); }
+};
+
+SymbolCache& getSymbolCache() {
+  // Leaked so that it keeps working while static destructors run.
+  static SymbolCache* cache = lsanIgnoreObjectAndReturn(new SymbolCache);
+  return *cache;
+}
+
+String stringifyStackTraceWithLlvm(ArrayPtr<void* const> trace) {
+  auto& cache = getSymbolCache();
+
+  ZC_STACK_ARRAY(String, frames, trace.size(), 32, 256);
+  ZC_STACK_ARRAY(void*, missing, trace.size(), 32, 256);
+  size_t missingCount = 0;
+  for (auto i : zc::indices(trace)) {
+    ZC_IF_SOME(frame, cache.find(trace[i])) { frames[i] = zc::mv(frame); }
+    else { missing[missingCount++] = trace[i]; }
+  }
+
+  if (missingCount > 0) {
+    auto addrs = missing.first(missingCount);
+    Array<String> symbolized;
+    ZC_IF_SOME(s, symbolizeWithLlvm(addrs)) { symbolized = zc::mv(s); }
+    else { symbolized = ZC_MAP(addr, addrs) { return symbolizeInProcess(addr); }; }
+
+    size_t j = 0;
+    for (auto i : zc::indices(trace)) {
+      if (frames[i] == nullptr) {
+        cache.insert(trace[i], symbolized[j]);
+        frames[i] = zc::mv(symbolized[j++]);
+      }
+    }
   }
+
+  return zc::str("\n", zc::strArray(frames, ""));
 }
 
 }  // namespace
@@ -940,7 +1052,8 @@ Exception::Exception(Type type, const char* file, int line, String description)
     : file(trimSourceFilename(file).cStr()),
       line(line),
       type(type),
-      description(mv(description)),
+      ownDescription(mv(description)),
+      description(ownDescription),
       traceCount(0) {}
 
 Exception::Exception(Type type, String file, int line, String description) noexcept
@@ -948,20 +1061,34 @@ Exception::Exception(Type type, String file, int line, String description) noexc
       file(trimSourceFilename(ownFile).cStr()),
       line(line),
       type(type),
-      description(mv(description)),
+      ownDescription(mv(description)),
+      description(ownDescription),
+      traceCount(0) {}
+
+Exception::Exception(Type type, const char* file, int line, StaticDescription description) noexcept
+    : file(trimSourceFilename(file).cStr()),
+      line(line),
+      type(type),
+      description(description.text),
       traceCount(0) {}
 
 Exception::Exception(const Exception& other) noexcept
     : file(other.file),
       line(other.line),
       type(other.type),
-      description(heapString(other.description)),
+      description(other.description),
       traceCount(other.traceCount) {
   if (file == other.ownFile.cStr()) {
     ownFile = heapString(other.ownFile);
     file = ownFile.cStr();
   }
 
+  if (other.ownDescription.begin() != nullptr &&
+      description.begin() == other.ownDescription.begin()) {
+    ownDescription = heapString(other.ownDescription);
+    description = ownDescription;
+  }
+
   if (other.remoteTrace != nullptr) { remoteTrace = zc::str(other.remoteTrace); }
 
   memcpy(trace, other.trace, sizeof(trace[0]) * traceCount);
@@ -1280,6 +1407,8 @@ public:
 
   void logMessage(LogSeverity severity, const char* file, int line, int contextDepth,
                   String&& text) override {
+    if (_::writeToInstalledLogWriter(severity, file, line, contextDepth, text)) return;
+
     text =
         str(zc::repeat('_', contextDepth), file, ":", line, ": ", severity, ": ", mv(text), '\n');
 
@@ -1359,14 +1488,39 @@ ExceptionCallback& getExceptionCallback() {
   return scoped != nullptr ? *scoped : *defaultCallback;
 }
 
+namespace {
+
+uint untracedExceptionTypes = 0;
+// Bit N is set if exceptions of type N skip capturing a stack trace when thrown.
+
+}  // namespace
+
+void setStackTraceEnabled(Exception::Type type, bool enabled) {
+  uint bit = 1u << static_cast<uint>(type);
+  if (enabled) {
+    __atomic_fetch_and(&untracedExceptionTypes, ~bit, __ATOMIC_RELAXED);
+  } else {
+    __atomic_fetch_or(&untracedExceptionTypes, bit, __ATOMIC_RELAXED);
+  }
+}
+
+bool isStackTraceEnabled(Exception::Type type) {
+  return (__atomic_load_n(&untracedExceptionTypes, __ATOMIC_RELAXED) &
+          (1u << static_cast<uint>(type))) == 0;
+}
+
 void throwFatalException(zc::Exception&& exception, uint ignoreCount) {
-  if (ignoreCount != (uint)zc::maxValue) exception.extendTrace(ignoreCount + 1);
+  if (ignoreCount != (uint)zc::maxValue && isStackTraceEnabled(exception.getType())) {
+    exception.extendTrace(ignoreCount + 1);
+  }
   getExceptionCallback().onFatalException(zc::mv(exception));
   abort();
 }
 
 void throwRecoverableException(zc::Exception&& exception, uint ignoreCount) {
-  if (ignoreCount != (uint)zc::maxValue) exception.extendTrace(ignoreCount + 1);
+  if (ignoreCount != (uint)zc::maxValue && isStackTraceEnabled(exception.getType())) {
+    exception.extendTrace(ignoreCount + 1);
+  }
   getExceptionCallback().onRecoverableException(zc::mv(exception));
 }
 
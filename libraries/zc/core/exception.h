@@ -70,8 +70,16 @@ public:
     // - Update Cap'n Proto's RPC protocol's Exception.Type enum.
   };
 
+  struct StaticDescription {
+    StringPtr text;
+  };
+  // A description that outlives every exception, typically a string literal, which the exception
+  // refers to instead of copying. ZC_EXCEPTION() and ZC_FAIL_*() use this when their only
+  // argument is a string literal, so that throwing such an exception doesn't format anything.
+
   Exception(Type type, const char* file, int line, String description = nullptr) noexcept;
   Exception(Type type, String file, int line, String description = nullptr) noexcept;
+  Exception(Type type, const char* file, int line, StaticDescription description) noexcept;
   Exception(const Exception& other) noexcept;
   Exception(Exception&& other) = default;
   ~Exception() noexcept;
@@ -82,7 +90,10 @@ public:
   StringPtr getDescription() const { return description; }
   ArrayPtr<void* const> getStackTrace() const { return arrayPtr(trace, traceCount); }
 
-  void setDescription(zc::String&& desc) { description = zc::mv(desc); }
+  void setDescription(zc::String&& desc) {
+    ownDescription = zc::mv(desc);
+    description = ownDescription;
+  }
 
   StringPtr getRemoteTrace() const { return remoteTrace; }
   void setRemoteTrace(zc::String&& value) { remoteTrace = zc::mv(value); }
@@ -161,7 +172,8 @@ private:
   const char* file;
   int line;
   Type type;
-  String description;
+  String ownDescription;
+  StringPtr description;
   Maybe<Own<Context>> context;
   String remoteTrace;
   void* trace[32];
@@ -293,6 +305,13 @@ private:
 ExceptionCallback& getExceptionCallback();
 // Returns the current exception callback.
 
+void setStackTraceEnabled(Exception::Type type, bool enabled);
+bool isStackTraceEnabled(Exception::Type type);
+// Controls whether throwing an exception of the given type captures a stack trace. All types are
+// traced by default. Servers that see DISCONNECTED or OVERLOADED exceptions as routine control flow
+// (e.g. on every dropped connection) can turn tracing off for those types, since unwinding the
+// stack is most of the cost of throwing. Process-wide; safe to call from any thread.
+
 ZC_NOINLINE ZC_NORETURN(void throwFatalException(zc::Exception&& exception, uint ignoreCount = 0));
 // Invoke the exception callback to throw the given fatal exception.  If the exception callback
 // returns, abort.
@@ -21,77 +21,179 @@
 
 #include "zc/core/glob-filter.h"
 
+#include <algorithm>
+
 namespace zc {
 
-GlobFilter::GlobFilter(const char* pattern) : pattern(heapString(pattern)) {}
-GlobFilter::GlobFilter(ArrayPtr<const char> pattern) : pattern(heapString(pattern)) {}
+namespace {
 
-bool GlobFilter::matches(StringPtr name) {
-  // Get out your computer science books. We're implementing a non-deterministic finite automaton.
-  //
-  // Our NDFA has one "state" corresponding to each character in the pattern.
-  //
-  // As you may recall, an NDFA can be transformed into a DFA where every state in the DFA
-  // represents some combination of states in the NDFA. Therefore, we actually have to store a
-  // list of states here. (Actually, what we really want is a set of states, but because our
-  // patterns are mostly non-cyclic a list of states should work fine and be a bit more efficient.)
+inline bool isSeparator(char c) { return c == '/' || c == '\\'; }
 
-  // Our state list starts out pointing only at the start of the pattern.
-  states.resize(0);
-  states.add(0);
+}  // namespace
 
-  Vector<uint> scratch;
+GlobSet::GlobSet(ArrayPtr<const StringPtr> patterns, size_t maxStates)
+    : maxStates(zc::max(maxStates, 2)) {
+  size_t positionCount = patterns.size();
+  for (auto& pattern : patterns) positionCount += pattern.size();
 
-  // Iterate through each character in the name.
-  for (char c : name) {
-    // Pull the current set of states off to the side, so that we can populate `states` with the
-    // new set of states.
-    Vector<uint> oldStates = zc::mv(states);
-    states = zc::mv(scratch);
-    states.resize(0);
+  auto charsBuilder = heapArrayBuilder<char>(positionCount);
+  auto ownersBuilder = heapArrayBuilder<uint>(positionCount);
+  auto endsBuilder = heapArrayBuilder<bool>(positionCount);
+  auto startsBuilder = heapArrayBuilder<uint>(patterns.size());
+  for (uint i : indices(patterns)) {
+    startsBuilder.add(charsBuilder.size());
+    for (char c : patterns[i]) {
+      charsBuilder.add(c);
+      ownersBuilder.add(i);
+      endsBuilder.add(false);
+    }
+    charsBuilder.add('\0');
+    ownersBuilder.add(i);
+    endsBuilder.add(true);
+  }
+  chars = charsBuilder.finish();
+  owners = ownersBuilder.finish();
+  ends = endsBuilder.finish();
+  starts = startsBuilder.finish();
+  inNext = heapArray<bool>(positionCount, false);
 
-    // The pattern can omit a leading path. So if we're at a '/' then enter the state machine at
-    // the beginning on the next char.
-    if (c == '/' || c == '\\') { states.add(0); }
+  // Give each byte that some pattern spells out a class of its own, and the separators too, since
+  // they restart every pattern.  All other bytes are alike, and share class 0.
+  Vector<byte> classBytes;
+  memset(byteClasses, 0, sizeof(byteClasses));
+  classBytes.add(0);
+  auto assign = [&](byte c) {
+    if (byteClasses[c] == 0) {
+      byteClasses[c] = classBytes.size();
+      classBytes.add(c);
+    }
+  };
+  assign('/');
+  assign('\\');
+  for (uint pos : indices(chars)) {
+    if (!ends[pos] && chars[pos] != '*' && chars[pos] != '?') assign(chars[pos]);
+  }
+  for (uint c : zeroTo(256)) {
+    if (byteClasses[c] == 0) {
+      classBytes[0] = c;
+      break;
+    }
+  }
+  representatives = classBytes.releaseAsArray();
 
-    // Process each state.
-    for (uint state : oldStates) { applyState(c, state); }
+  reset();
+}
+
+void GlobSet::reset() {
+  transitions.clear();
+  sets.clear();
+  stateIds.clear();
+  acceptOffsets.clear();
+  acceptPatterns.clear();
+  acceptOffsets.add(0);
+
+  next.clear();
+  for (uint start : starts) addToNext(start);
+  closeNext();
+  internNext();
+}
+
+void GlobSet::addToNext(uint position) {
+  if (!inNext[position]) {
+    inNext[position] = true;
+    next.add(position);
+  }
+}
+
+void GlobSet::closeNext() {
+  // A position at a '*' may also skip it right away.
+  for (size_t i = 0; i < next.size(); i++) {
+    uint pos = next[i];
+    if (!ends[pos] && chars[pos] == '*') addToNext(pos + 1);
+  }
+  for (uint pos : next) inNext[pos] = false;
+  std::sort(next.begin(), next.end());
+}
 
-    // Store the previous state vector for reuse.
-    scratch = zc::mv(oldStates);
+uint GlobSet::internNext() {
+  ZC_IF_SOME(existing, stateIds.find(next.asPtr().asBytes())) {
+    next.clear();
+    return existing;
   }
 
-  // If any one state is at the end of the pattern (or at a wildcard just before the end of the
-  // pattern), we have a match.
-  for (uint state : states) {
-    while (state < pattern.size() && pattern[state] == '*') { ++state; }
-    if (state == pattern.size()) { return true; }
+  uint id = sets.size();
+  auto& stored = sets.add(heapArray(next.asPtr()));
+  next.clear();
+  stateIds.insert(stored.asBytes(), id);
+  for (uint pos : stored) {
+    if (ends[pos]) acceptPatterns.add(owners[pos]);
+  }
+  acceptOffsets.add(acceptPatterns.size());
+  transitions.resize(transitions.size() + representatives.size());
+  for (uint& transition : transitions.slice(id * representatives.size(), transitions.size())) {
+    transition = UNKNOWN;
   }
-  return false;
+  return id;
 }
 
-void GlobFilter::applyState(char c, int state) {
-  if (state < pattern.size()) {
-    switch (pattern[state]) {
+uint GlobSet::computeTransition(uint state, uint byteClass) {
+  char c = representatives[byteClass];
+
+  // The pattern can omit a leading path, so a separator restarts every pattern.
+  if (isSeparator(c)) {
+    for (uint start : starts) addToNext(start);
+  }
+
+  for (uint pos : sets[state]) {
+    if (ends[pos]) continue;
+    switch (chars[pos]) {
       case '*':
-        // At a '*', we both re-add the current state and attempt to match the *next* state.
-        if (c != '/' && c != '\\') {  // '*' doesn't match '/'.
-          states.add(state);
-        }
-        applyState(c, state + 1);
+        // '*' doesn't match '/'.  The position after the '*' is in the set too, and takes care of
+        // matching the rest of the pattern.
+        if (!isSeparator(c)) addToNext(pos);
         break;
-
       case '?':
         // A '?' matches one character (never a '/').
-        if (c != '/' && c != '\\') { states.add(state + 1); }
+        if (!isSeparator(c)) addToNext(pos + 1);
         break;
-
       default:
         // Any other character matches only itself.
-        if (c == pattern[state]) { states.add(state + 1); }
+        if (c == chars[pos]) addToNext(pos + 1);
         break;
     }
   }
+
+  closeNext();
+
+  if (sets.size() >= maxStates && stateIds.find(next.asPtr().asBytes()) == zc::none) {
+    // The automaton is full.  Start over with just the initial state and the new one; the next
+    // names will rebuild the states they need.
+    auto saved = heapArray(next.asPtr());
+    reset();
+    next.addAll(saved);
+    return internNext();
+  }
+
+  uint target = internNext();
+  transitions[state * representatives.size() + byteClass] = target;
+  return target;
+}
+
+ArrayPtr<const uint> GlobSet::matching(ArrayPtr<const char> name) {
+  uint classCount = representatives.size();
+  uint state = 0;
+  for (char c : name) {
+    uint byteClass = byteClasses[byte(c)];
+    uint target = transitions[state * classCount + byteClass];
+    state = target != UNKNOWN ? target : computeTransition(state, byteClass);
+  }
+  return acceptPatterns.slice(acceptOffsets[state], acceptOffsets[state + 1]);
 }
 
+GlobFilter::GlobFilter(const char* pattern) : GlobFilter(StringPtr(pattern).asArray()) {}
+GlobFilter::GlobFilter(ArrayPtr<const char> pattern)
+    : pattern(heapString(pattern)), set(ArrayPtr<const StringPtr>({this->pattern})) {}
+
+bool GlobFilter::matches(StringPtr name) { return set.matchesAny(name); }
+
 }  // namespace zc
@@ -21,11 +21,91 @@
 
 #pragma once
 
+#include <zc/core/map.h>
 #include <zc/core/string.h>
 #include <zc/core/vector.h>
 
 namespace zc {
 
+class GlobSet {
+  // A set of glob patterns, with the syntax and semantics of GlobFilter, matched together by a
+  // deterministic automaton over classes of bytes.  Matching a name takes one table lookup per
+  // character and reports every pattern that matches at once.
+  //
+  // The automaton is built lazily, as names need its states: a set of patterns such as "*a*" and
+  // "*b*" needs a state for every combination of patterns that may have matched so far, so the
+  // full automaton for hundreds of patterns would be far too big, but the names actually matched
+  // only ever visit a few of its states.  Once those are built, matching doesn't allocate.  If the
+  // automaton reaches `maxStates` states, it is discarded and built again from scratch.
+  //
+  // Since matching updates the automaton, a GlobSet must not be used by several threads at once.
+
+public:
+  static constexpr size_t DEFAULT_MAX_STATES = 4096;
+
+  explicit GlobSet(ArrayPtr<const StringPtr> patterns, size_t maxStates = DEFAULT_MAX_STATES);
+
+  ArrayPtr<const uint> matching(ArrayPtr<const char> name) ZC_LIFETIMEBOUND;
+  // Returns the indexes of the patterns that match `name`, in increasing order.  The result is
+  // only valid until the next call.
+
+  inline bool matchesAny(ArrayPtr<const char> name) { return matching(name).size() > 0; }
+
+  inline size_t stateCount() const { return sets.size(); }
+  inline size_t byteClassCount() const { return representatives.size(); }
+
+private:
+  // The nondeterministic automaton has one position per pattern character, plus one past the end
+  // of each pattern.  Each deterministic state stands for the set of positions that the name read
+  // so far could have reached.
+
+  Array<char> chars;
+  Array<uint> owners;  // the pattern that each position belongs to
+  Array<bool> ends;    // whether each position is the one past the end of its pattern
+  Array<uint> starts;  // the first position of each pattern
+
+  byte byteClasses[256];
+  // Bytes that no pattern tells apart share a class, and the table has one column per class.
+  Array<byte> representatives;
+  // A byte of each class.
+
+  size_t maxStates;
+
+  Vector<uint> transitions;
+  // transitions[state * byteClassCount() + byteClasses[c]] is the state after reading `c` in
+  // `state`, or UNKNOWN if it hasn't been needed yet.  The initial state is 0.
+
+  Vector<Array<uint>> sets;
+  // The sorted positions of each state.
+  HashMap<ArrayPtr<const byte>, uint> stateIds;
+  // Finds states by their positions.  Keys point into `sets`.
+
+  Vector<uint> acceptOffsets;
+  Vector<uint> acceptPatterns;
+  // The patterns that match when the name ends in state `s` are
+  // acceptPatterns[acceptOffsets[s]] through acceptPatterns[acceptOffsets[s + 1] - 1].
+
+  Vector<uint> next;
+  Array<bool> inNext;
+  // Scratch space for computing transitions.
+
+  static constexpr uint UNKNOWN = maxValue;
+
+  void reset();
+  // Discards all states but the initial one.
+
+  uint computeTransition(uint state, uint byteClass);
+
+  void addToNext(uint position);
+  void closeNext();
+  // Adds the positions implied by those in `next`, and sorts them, so that equal sets compare
+  // equal.
+
+  uint internNext();
+  // Returns the state whose positions are those in `next`, adding it if it's new, and leaves
+  // `next` empty.
+};
+
 class GlobFilter {
   // Implements glob filters for the --filter flag.
 
@@ -37,9 +117,7 @@ public:
 
 private:
   String pattern;
-  Vector<uint> states;
-
-  void applyState(char c, int state);
+  GlobSet set;
 };
 
 }  // namespace zc
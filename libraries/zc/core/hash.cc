@@ -22,44 +22,111 @@
 #include "zc/core/hash.h"
 
 namespace zc {
+
 namespace _ {  // private
 
-uint HashCoder::operator*(ArrayPtr<const byte> s) const {
-  // murmur2 adapted from libc++ source code.
-  //
-  // TODO(perf): Use CityHash or FarmHash on 64-bit machines? They seem optimized for x86-64; what
-  //   about ARM? Ask Vlad for advice.
-
-  constexpr uint m = 0x5bd1e995;
-  constexpr uint r = 24;
-  uint h = s.size();
-  const byte* data = s.begin();
-  uint len = s.size();
-  for (; len >= 4; data += 4, len -= 4) {
-    uint k;
-    memcpy(&k, data, sizeof(k));
-    k *= m;
-    k ^= k >> r;
-    k *= m;
-    h *= m;
-    h ^= k;
-  }
-  switch (len) {
-    case 3:
-      h ^= data[2] << 16;
-      ZC_FALLTHROUGH;
-    case 2:
-      h ^= data[1] << 8;
-      ZC_FALLTHROUGH;
-    case 1:
-      h ^= data[0];
-      h *= m;
+uint64_t hashSeed = 0x243f6a8885a308d3ull;
+// Any fixed value works until setHashSeed() is called; these are the first digits of pi.
+
+}  // namespace _
+
+void setHashSeed(uint64_t seed) { __atomic_store_n(&_::hashSeed, seed, __ATOMIC_RELAXED); }
+
+namespace {
+
+// wyhash, final version 4, by Wang Yi: https://github.com/wangyi-fudan/wyhash
+// Released into the public domain (The Unlicense).
+
+constexpr uint64_t SECRET[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+inline void multiply128(uint64_t& a, uint64_t& b) {
+  // Replaces a and b with the low and high halves of their 128-bit product.
+#if __SIZEOF_INT128__
+  __uint128_t product = __uint128_t(a) * b;
+  a = uint64_t(product);
+  b = uint64_t(product >> 64);
+#else
+  uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t carry = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  carry += lo < t;
+  a = lo;
+  b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+#endif
+}
+
+inline uint64_t mix(uint64_t a, uint64_t b) {
+  multiply128(a, b);
+  return a ^ b;
+}
+
+inline uint64_t read64(const byte* p) {
+  uint64_t result;
+  memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint64_t read32(const byte* p) {
+  uint32_t result;
+  memcpy(&result, p, sizeof(result));
+  return result;
+}
+
+inline uint64_t read1to3(const byte* p, size_t size) {
+  return (uint64_t(p[0]) << 16) | (uint64_t(p[size >> 1]) << 8) | p[size - 1];
+}
+
+}  // namespace
+
+uint64_t hash64(ArrayPtr<const byte> data, uint64_t seed) {
+  const byte* p = data.begin();
+  size_t size = data.size();
+  seed ^= mix(seed ^ SECRET[0], SECRET[1]);
+
+  uint64_t a, b;
+  if (ZC_LIKELY(size <= 16)) {
+    if (ZC_LIKELY(size >= 4)) {
+      // Two pairs of overlapping 4-byte reads cover anything from 4 to 16 bytes.
+      size_t offset = (size >> 3) << 2;
+      a = (read32(p) << 32) | read32(p + offset);
+      b = (read32(p + size - 4) << 32) | read32(p + size - 4 - offset);
+    } else if (ZC_LIKELY(size > 0)) {
+      a = read1to3(p, size);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t remaining = size;
+    if (ZC_UNLIKELY(remaining > 48)) {
+      // Three independent lanes, so the multiplies can overlap.
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = mix(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+        seed1 = mix(read64(p + 16) ^ SECRET[2], read64(p + 24) ^ seed1);
+        seed2 = mix(read64(p + 32) ^ SECRET[3], read64(p + 40) ^ seed2);
+        p += 48;
+        remaining -= 48;
+      } while (ZC_LIKELY(remaining > 48));
+      seed ^= seed1 ^ seed2;
+    }
+    while (ZC_UNLIKELY(remaining > 16)) {
+      seed = mix(read64(p) ^ SECRET[1], read64(p + 8) ^ seed);
+      p += 16;
+      remaining -= 16;
+    }
+    // The last 16 bytes, which may overlap bytes already consumed.
+    a = read64(p + remaining - 16);
+    b = read64(p + remaining - 8);
   }
-  h ^= h >> 13;
-  h *= m;
-  h ^= h >> 15;
-  return h;
+
+  a ^= SECRET[1];
+  b ^= seed;
+  multiply128(a, b);
+  return mix(a ^ SECRET[0] ^ size, b ^ SECRET[1]);
 }
 
-}  // namespace _
 }  // namespace zc
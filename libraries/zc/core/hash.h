@@ -28,8 +28,32 @@
 ZC_BEGIN_HEADER
 
 namespace zc {
+
+uint64_t hash64(ArrayPtr<const byte> data, uint64_t seed);
+inline uint64_t hash64(ArrayPtr<const byte> data);
+// A fast, high-quality 64-bit hash of a byte string, in the wyhash family: it consumes 48 bytes per
+// round in three independent 64x64->128-bit multiply lanes, and reads short inputs with a couple
+// of overlapping loads instead of a byte loop. This is what hashCode() uses for strings and byte
+// arrays, folded to 32 bits.
+//
+// The one-argument version uses the process-wide seed (see setHashSeed()).
+//
+// NOT SUITABLE FOR CRYPTOGRAPHY.
+
+void setHashSeed(uint64_t seed);
+// Sets the process-wide seed for hashing strings and byte arrays. A program that puts untrusted
+// input into hash tables, such as a server indexing request headers, should call this at startup
+// with a random value, so that attackers can't precompute keys that all land in the same bucket.
+//
+// Changing the seed changes the hashCode() of every string, so it must be done before any hash
+// tables have been filled.
+
+inline uint64_t getHashSeed();
+
 namespace _ {  // private
 
+extern uint64_t hashSeed;
+
 inline uint intHash32(uint32_t i);
 inline uint intHash64(uint64_t i);
 
@@ -46,7 +70,7 @@ struct HashCoder {
   // different.  Declaring `operator*` with `HashCoder` as the left operand cannot conflict with
   // anything.
 
-  uint operator*(ArrayPtr<const byte> s) const;
+  inline uint operator*(ArrayPtr<const byte> s) const;
   inline uint operator*(ArrayPtr<byte> s) const { return operator*(s.asConst()); }
 
   inline uint operator*(ArrayPtr<const char> s) const { return operator*(s.asBytes()); }
@@ -56,6 +80,7 @@ struct HashCoder {
   inline uint operator*(const String& s) const { return operator*(s.asBytes()); }
   inline uint operator*(const StringPtr& s) const { return operator*(s.asBytes()); }
   inline uint operator*(const ConstString& s) const { return operator*(s.asBytes()); }
+  inline uint operator*(const SmallString& s) const { return operator*(s.asBytes()); }
 
   inline uint operator*(decltype(nullptr)) const { return 0; }
   inline uint operator*(bool b) const { return b; }
@@ -185,7 +210,7 @@ template <typename T, typename>
 inline uint HashCoder::operator*(ArrayPtr<T> arr) const {
   // Hash each array element to create a string of hashes, then murmur2 over those.
   //
-  // TODO(perf): Choose a more-modern hash. (See hash.c++.)
+  // TODO(perf): Feed the element hashes to hash64() instead, without needing a buffer for them.
 
   constexpr uint m = 0x5bd1e995;
   constexpr uint r = 24;
@@ -215,6 +240,11 @@ inline uint HashCoder::operator*(T e) const {
   return operator*(static_cast<__underlying_type(T)>(e));
 }
 
+inline uint HashCoder::operator*(ArrayPtr<const byte> s) const {
+  uint64_t h = hash64(s);
+  return uint(h ^ (h >> 32));
+}
+
 inline uint intHash32(uint32_t i) {
   // Basic 32-bit integer hash function.
   //
@@ -275,6 +305,13 @@ inline uint intHash64(uint64_t i) {
 }
 
 }  // namespace _
+
+inline uint64_t hash64(ArrayPtr<const byte> data) {
+  return hash64(data, __atomic_load_n(&_::hashSeed, __ATOMIC_RELAXED));
+}
+
+inline uint64_t getHashSeed() { return __atomic_load_n(&_::hashSeed, __ATOMIC_RELAXED); }
+
 }  // namespace zc
 
 ZC_END_HEADER
@@ -0,0 +1,410 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32 || __CYGWIN__
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/lock-profiler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "zc/core/debug.h"
+#include "zc/core/io.h"
+#include "zc/core/miniposix.h"
+#include "zc/core/thread-record.h"
+#include "zc/core/vector.h"
+
+namespace zc {
+
+namespace _ {  // private
+
+bool lockProfilingEnabled = false;
+
+}  // namespace _
+
+namespace {
+
+// The profiler must not itself lock a zc::Mutex, since it runs inside Mutex::lock() and unlock().
+// Each thread records into its own table: only that thread writes to it, so it needs no
+// read-modify-write atomics, and the fields are written with relaxed atomic stores only so that
+// getLockProfile() can read them from another thread at any time.
+
+constexpr uint SLOT_COUNT = 256;
+// Distinct (mutex, site, mode) combinations each thread can record. Further ones are counted as
+// dropped.
+
+constexpr uint MAX_HELD = 16;
+// Locks a thread can hold at once and still have their hold time measured.
+
+constexpr uint HISTOGRAM_SIZE = LockProfileEntry::WAIT_HISTOGRAM_SIZE;
+
+struct Slot {
+  const void* mutex;
+  // Null while the slot is free. Stored with release semantics after the rest of the key, so
+  // that readers who see it non-null also see the key.
+
+  LockSourceLocation location;
+  bool exclusive;
+
+  uint64_t acquisitions;
+  uint64_t contentions;
+  uint64_t timeouts;
+  uint64_t waitNs;
+  uint64_t maxWaitNs;
+  uint64_t holds;
+  uint64_t holdNs;
+  uint64_t maxHoldNs;
+  uint64_t waitHistogram[HISTOGRAM_SIZE];
+};
+
+struct HeldLock {
+  const void* mutex;
+  bool exclusive;
+  Slot* slot;
+  TimePoint since = origin<TimePoint>();
+};
+
+struct ThreadTable {
+  ThreadTable* next;
+  bool inUse;
+  // See ThreadRecordList. A thread that exits releases its table to the next new thread, which
+  // keeps adding to the same statistics.
+
+  uint generation;
+  // resetLockProfile() generation the slots were recorded in, or 0 while the owner is clearing
+  // them. Readers ignore tables from older generations.
+
+  uint64_t dropped;
+  Slot slots[SLOT_COUNT];
+
+  // Only accessed by the owning thread.
+  uint heldSession;
+  uint heldCount;
+  HeldLock held[MAX_HELD];
+};
+
+_::ThreadRecordList<ThreadTable> tables;
+uint generation = 1;
+uint session = 0;
+bool exitHandlerRegistered = false;
+
+void forgetHeldLocks(ThreadTable& table) { table.heldCount = 0; }
+
+thread_local _::ThreadRecordHolder<ThreadTable, tables, forgetHeldLocks> threadTable;
+
+template <typename T>
+inline T load(const T& field) {
+  return __atomic_load_n(&field, __ATOMIC_RELAXED);
+}
+template <typename T>
+inline void store(T& field, T value) {
+  __atomic_store_n(&field, value, __ATOMIC_RELAXED);
+}
+inline void add(uint64_t& counter, uint64_t amount) { store(counter, load(counter) + amount); }
+inline void raise(uint64_t& max, uint64_t value) {
+  if (value > load(max)) store(max, value);
+}
+
+inline bool sameLocation(const SourceLocation& a, const SourceLocation& b) { return a == b; }
+inline bool sameLocation(NoopSourceLocation, NoopSourceLocation) { return true; }
+inline uintptr_t hashLocation(const SourceLocation& l) {
+  return reinterpret_cast<uintptr_t>(l.fileName) ^ (uintptr_t(l.lineNumber) << 16) ^
+         l.columnNumber;
+}
+inline uintptr_t hashLocation(NoopSourceLocation) { return 0; }
+inline bool locationBefore(const SourceLocation& a, const SourceLocation& b) {
+  if (a.fileName != b.fileName) return a.fileName < b.fileName;
+  if (a.lineNumber != b.lineNumber) return a.lineNumber < b.lineNumber;
+  if (a.columnNumber != b.columnNumber) return a.columnNumber < b.columnNumber;
+  return a.function < b.function;
+}
+inline bool locationBefore(NoopSourceLocation, NoopSourceLocation) { return false; }
+
+uint histogramBucket(uint64_t ns) {
+  uint64_t us = ns / 1000;
+  if (us == 0) return 0;
+  return zc::min(uint(64 - __builtin_clzll(us)), HISTOGRAM_SIZE - 1);
+}
+
+ThreadTable* getTable() {
+  // Returns null for locks taken by thread-local destructors after the thread's table has been
+  // released. Those go unrecorded.
+  ThreadTable* tablePtr = threadTable.get();
+  if (tablePtr == nullptr) return nullptr;
+  ThreadTable& table = *tablePtr;
+
+  uint current = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+  if (load(table.generation) != current) {
+    // resetLockProfile() was called since this table was last written, or it is new. Readers
+    // skip the table while we clear it, though one that already started reading may see a mix.
+    store(table.generation, 0u);
+    memset(static_cast<void*>(table.slots), 0, sizeof(table.slots));
+    store(table.dropped, uint64_t(0));
+    table.heldCount = 0;
+    __atomic_store_n(&table.generation, current, __ATOMIC_RELEASE);
+  }
+  return &table;
+}
+
+Slot* findSlot(ThreadTable& table, const void* mutex, bool exclusive,
+               const LockSourceLocation& location) {
+  uintptr_t hash = (reinterpret_cast<uintptr_t>(mutex) >> 4) ^ hashLocation(location) ^ exclusive;
+  hash *= 0x9e3779b97f4a7c15ull;
+  uint start = hash >> (sizeof(uintptr_t) * 8 - 8);
+  static_assert(SLOT_COUNT == 256, "adjust the shift above");
+
+  for (uint i = 0; i < SLOT_COUNT; i++) {
+    Slot& slot = table.slots[(start + i) % SLOT_COUNT];
+    if (slot.mutex == nullptr) {
+      slot.location = location;
+      slot.exclusive = exclusive;
+      __atomic_store_n(&slot.mutex, mutex, __ATOMIC_RELEASE);
+      return &slot;
+    }
+    if (slot.mutex == mutex && slot.exclusive == exclusive &&
+        sameLocation(slot.location, location)) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+bool sameKey(const LockProfileEntry& a, const LockProfileEntry& b) {
+  return a.mutex == b.mutex && a.exclusive == b.exclusive && sameLocation(a.location, b.location);
+}
+
+bool keyBefore(const LockProfileEntry& a, const LockProfileEntry& b) {
+  if (a.mutex != b.mutex) return a.mutex < b.mutex;
+  if (a.exclusive != b.exclusive) return a.exclusive;
+  return locationBefore(a.location, b.location);
+}
+
+uint64_t countDropped() {
+  uint current = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+  uint64_t result = 0;
+  for (auto table = tables.first(); table != nullptr; table = table->next) {
+    if (__atomic_load_n(&table->generation, __ATOMIC_ACQUIRE) == current) {
+      result += load(table->dropped);
+    }
+  }
+  return result;
+}
+
+void writeLockProfileAtExit() {
+  ZC_IF_SOME(exception, runCatchingExceptions([]() {
+               FdOutputStream(STDERR_FILENO).write(dumpLockProfile().asBytes());
+             })) {
+    // Nothing sensible to do while exiting.
+    (void)exception;
+  }
+}
+
+}  // namespace
+
+namespace _ {  // private
+
+void profileLockAcquired(const void* mutex, bool exclusive, const LockSourceLocation& location,
+                         Maybe<TimePoint> waitStart, bool acquired) {
+  ThreadTable* tablePtr = getTable();
+  if (tablePtr == nullptr) return;
+  ThreadTable& table = *tablePtr;
+  TimePoint now = systemPreciseMonotonicClock().now();
+
+  Slot* slot = findSlot(table, mutex, exclusive, location);
+  if (slot == nullptr) {
+    add(table.dropped, 1);
+    return;
+  }
+
+  ZC_IF_SOME(start, waitStart) {
+    uint64_t ns = (now - start) / NANOSECONDS;
+    add(slot->contentions, 1);
+    add(slot->waitNs, ns);
+    raise(slot->maxWaitNs, ns);
+    add(slot->waitHistogram[histogramBucket(ns)], 1);
+  }
+
+  if (!acquired) {
+    add(slot->timeouts, 1);
+    return;
+  }
+  add(slot->acquisitions, 1);
+
+  // Locks still held from before profiling was last stopped will never be matched by a release.
+  uint currentSession = __atomic_load_n(&session, __ATOMIC_RELAXED);
+  if (table.heldSession != currentSession) {
+    table.heldSession = currentSession;
+    table.heldCount = 0;
+  }
+  if (table.heldCount < MAX_HELD) { table.held[table.heldCount++] = {mutex, exclusive, slot, now}; }
+}
+
+void profileLockReleased(const void* mutex, bool exclusive) {
+  ThreadTable* tablePtr = threadTable.record;
+  if (tablePtr == nullptr || tablePtr->heldCount == 0) return;
+  ThreadTable& table = *tablePtr;
+
+  // Locks are usually released in the reverse order they were taken, so search from the top.
+  for (uint i = table.heldCount; i-- > 0;) {
+    HeldLock& held = table.held[i];
+    if (held.mutex == mutex && held.exclusive == exclusive) {
+      if (table.heldSession == __atomic_load_n(&session, __ATOMIC_RELAXED) &&
+          table.generation == __atomic_load_n(&generation, __ATOMIC_RELAXED)) {
+        uint64_t ns = (systemPreciseMonotonicClock().now() - held.since) / NANOSECONDS;
+        add(held.slot->holds, 1);
+        add(held.slot->holdNs, ns);
+        raise(held.slot->maxHoldNs, ns);
+      }
+      for (; i + 1 < table.heldCount; i++) { table.held[i] = table.held[i + 1]; }
+      --table.heldCount;
+      return;
+    }
+  }
+}
+
+}  // namespace _
+
+void startLockProfiling() {
+  __atomic_add_fetch(&session, 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&_::lockProfilingEnabled, true, __ATOMIC_RELAXED);
+}
+
+void stopLockProfiling() { __atomic_store_n(&_::lockProfilingEnabled, false, __ATOMIC_RELAXED); }
+
+void resetLockProfile() { __atomic_add_fetch(&generation, 1, __ATOMIC_RELEASE); }
+
+Array<LockProfileEntry> getLockProfile() {
+  uint current = __atomic_load_n(&generation, __ATOMIC_ACQUIRE);
+
+  Vector<LockProfileEntry> entries;
+  for (auto table = tables.first(); table != nullptr; table = table->next) {
+    if (__atomic_load_n(&table->generation, __ATOMIC_ACQUIRE) != current) continue;
+
+    for (auto& slot : table->slots) {
+      const void* mutex = __atomic_load_n(&slot.mutex, __ATOMIC_ACQUIRE);
+      if (mutex == nullptr) continue;
+
+      LockProfileEntry entry{};
+      entry.mutex = mutex;
+      entry.location = slot.location;
+      entry.exclusive = slot.exclusive;
+      entry.acquisitions = load(slot.acquisitions);
+      entry.contentions = load(slot.contentions);
+      entry.timeouts = load(slot.timeouts);
+      entry.totalWait = load(slot.waitNs) * NANOSECONDS;
+      entry.maxWait = load(slot.maxWaitNs) * NANOSECONDS;
+      entry.holds = load(slot.holds);
+      entry.totalHold = load(slot.holdNs) * NANOSECONDS;
+      entry.maxHold = load(slot.maxHoldNs) * NANOSECONDS;
+      for (uint i : zeroTo(HISTOGRAM_SIZE)) {
+        entry.waitHistogram[i] = load(slot.waitHistogram[i]);
+      }
+      entries.add(entry);
+    }
+  }
+
+  // Merge the threads' entries for the same mutex and site.
+  std::sort(entries.begin(), entries.end(), keyBefore);
+  Vector<LockProfileEntry> merged(entries.size());
+  for (auto& entry : entries) {
+    if (merged.size() > 0 && sameKey(merged.back(), entry)) {
+      auto& into = merged.back();
+      into.acquisitions += entry.acquisitions;
+      into.contentions += entry.contentions;
+      into.timeouts += entry.timeouts;
+      into.totalWait += entry.totalWait;
+      into.maxWait = zc::max(into.maxWait, entry.maxWait);
+      into.holds += entry.holds;
+      into.totalHold += entry.totalHold;
+      into.maxHold = zc::max(into.maxHold, entry.maxHold);
+      for (uint i : zeroTo(HISTOGRAM_SIZE)) { into.waitHistogram[i] += entry.waitHistogram[i]; }
+    } else {
+      merged.add(entry);
+    }
+  }
+
+  std::sort(merged.begin(), merged.end(), [](const LockProfileEntry& a, const LockProfileEntry& b) {
+    if (a.totalWait != b.totalWait) return a.totalWait > b.totalWait;
+    if (a.contentions != b.contentions) return a.contentions > b.contentions;
+    return a.acquisitions > b.acquisitions;
+  });
+  return merged.releaseAsArray();
+}
+
+String dumpLockProfile() {
+  auto profile = getLockProfile();
+
+  Vector<String> lines;
+  lines.add(str("lock profile: ", profile.size(), " entries, sorted by total wait"));
+  uint64_t dropped = countDropped();
+  if (dropped > 0) {
+    lines.add(str("  (", dropped, " acquisitions not recorded: too many sites on one thread)"));
+  }
+
+  for (auto& entry : profile) {
+    auto where = str(entry.location);
+    lines.add(str("mutex ", entry.mutex, entry.exclusive ? " exclusive" : " shared",
+                  where.size() > 0 ? " at " : "", where));
+
+    uint64_t attempts = entry.acquisitions + entry.timeouts;
+    lines.add(str("  acquired ", entry.acquisitions, ", contended ", entry.contentions, " (",
+                  attempts == 0 ? 0 : entry.contentions * 100 / attempts, "%), timed out ",
+                  entry.timeouts));
+    if (entry.contentions > 0) {
+      lines.add(str("  wait: total ", entry.totalWait, ", mean ",
+                    entry.totalWait / entry.contentions, ", max ", entry.maxWait));
+
+      Vector<String> buckets;
+      for (uint i : zeroTo(HISTOGRAM_SIZE)) {
+        if (entry.waitHistogram[i] == 0) continue;
+        if (i == 0) {
+          buckets.add(str("<1μs: ", entry.waitHistogram[i]));
+        } else if (i == HISTOGRAM_SIZE - 1) {
+          buckets.add(str(">=", (uint64_t(1) << (i - 1)) * MICROSECONDS, ": ",
+                          entry.waitHistogram[i]));
+        } else {
+          buckets.add(str((uint64_t(1) << (i - 1)) * MICROSECONDS, "-",
+                          (uint64_t(1) << i) * MICROSECONDS, ": ", entry.waitHistogram[i]));
+        }
+      }
+      lines.add(str("  wait histogram: ", strArray(buckets, ", ")));
+    }
+    if (entry.holds > 0) {
+      lines.add(str("  hold: total ", entry.totalHold, ", mean ", entry.totalHold / entry.holds,
+                    ", max ", entry.maxHold));
+    }
+  }
+
+  lines.add(String());
+  return strArray(lines, "\n");
+}
+
+void dumpLockProfileAtExit() {
+  if (!__atomic_exchange_n(&exitHandlerRegistered, true, __ATOMIC_RELAXED)) {
+    atexit(&writeLockProfileAtExit);
+  }
+}
+
+}  // namespace zc
@@ -0,0 +1,132 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "zc/core/array.h"
+#include "zc/core/mutex.h"
+#include "zc/core/string.h"
+#include "zc/core/time.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+// =======================================================================================
+// Lock contention profiler
+//
+// Records, for each mutex and each place it is locked from, how often it was locked, how often
+// and how long callers had to wait for it, and how long it was held. Use it to find which
+// MutexGuarded<T> instances are behind tail latency under load:
+//
+//     zc::startLockProfiling();
+//     runTheWorkload();
+//     ZC_LOG(WARNING, zc::dumpLockProfile());
+//
+// Profiling is off by default and costs one relaxed atomic load per lock and unlock while off.
+// While on, each thread records into its own fixed-size table, without locks or atomic
+// read-modify-writes, so profiling does not itself add contention. Tables of threads that have
+// exited are kept (and reused by new threads), so their statistics still appear in the profile.
+//
+// Acquisition sites are only known when the library is built with ZC_SAVE_LOCK_LOCATIONS (CMake
+// option ZOM_SAVE_LOCK_LOCATIONS), which makes every lock call pass its caller's SourceLocation.
+// Otherwise all acquisitions of a mutex are counted together.
+
+struct LockProfileEntry {
+  // Statistics for acquiring one mutex, in one mode, from one site.
+
+  const void* mutex;
+  // Address of the mutex. The same address may belong to different mutexes over time.
+
+  LockSourceLocation location;
+  // Where the lock was taken. Empty unless built with ZC_SAVE_LOCK_LOCATIONS.
+
+  bool exclusive;
+
+  uint64_t acquisitions;
+  uint64_t contentions;
+  // How many of the acquisitions could not take the lock straight away.
+
+  uint64_t timeouts;
+  // Attempts with a timeout that gave up. These count as contentions, but not as acquisitions.
+
+  Duration totalWait;
+  Duration maxWait;
+  // Time from the first failed attempt to take the lock until it was acquired (or timed out).
+
+  uint64_t holds;
+  Duration totalHold;
+  Duration maxHold;
+  // Time from acquiring the lock to releasing it. `holds` may be less than `acquisitions`: a lock
+  // taken before profiling started, or re-acquired at the end of Locked<T>::wait(), is not timed.
+
+  static constexpr uint WAIT_HISTOGRAM_SIZE = 24;
+  uint64_t waitHistogram[WAIT_HISTOGRAM_SIZE];
+  // Contended waits by duration: bucket 0 counts waits under 1μs, bucket i counts waits of
+  // [2^(i-1), 2^i) μs, and the last bucket also counts everything longer.
+};
+
+void startLockProfiling();
+void stopLockProfiling();
+// Starts and stops recording. Statistics accumulate across stop and start; use
+// resetLockProfile() to discard them.
+
+inline bool isLockProfiling();
+
+void resetLockProfile();
+// Discards everything recorded so far, on all threads.
+
+Array<LockProfileEntry> getLockProfile();
+// Returns the statistics recorded so far, merged across threads, sorted by total wait time,
+// longest first. Other threads may be recording while this runs, in which case each entry is a
+// recent snapshot but entries may not all be from exactly the same moment.
+
+String dumpLockProfile();
+// Formats getLockProfile() as a human-readable report.
+
+void dumpLockProfileAtExit();
+// Arranges for dumpLockProfile() to be written to stderr when the process exits normally.
+
+// =======================================================================================
+// inline implementation details
+
+namespace _ {  // private
+
+extern bool lockProfilingEnabled;
+
+void profileLockAcquired(const void* mutex, bool exclusive, const LockSourceLocation& location,
+                         Maybe<TimePoint> waitStart, bool acquired);
+// Called by Mutex::lock() while profiling. `waitStart` is null if the lock was free straight away.
+
+void profileLockReleased(const void* mutex, bool exclusive);
+// Called by Mutex::unlock() while profiling.
+
+}  // namespace _
+
+inline bool isLockProfiling() {
+  return __atomic_load_n(&_::lockProfilingEnabled, __ATOMIC_RELAXED);
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
@@ -0,0 +1,515 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/log-writer.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "zc/core/debug.h"
+#include "zc/core/miniposix.h"
+
+#if _WIN32
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <limits.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/uio.h>
+#endif
+
+namespace zc {
+
+namespace _ {  // private
+
+struct LogRing {
+  // One logging thread's buffer: a single-producer, single-consumer ring of records, each an
+  // 8-byte header holding the size of the text that follows, padded to a multiple of 8 bytes. A
+  // record never wraps around the end of the buffer; a header of WRAP instead says to continue at
+  // the start.
+
+  LogRing(uint64_t writerId, uint64_t serial, size_t size)
+      : writerId(writerId), serial(serial), data(heapArray<byte>(size)) {}
+
+  const uint64_t writerId;
+  const uint64_t serial;
+  // Unique per ring, so that flush() can tell a ring from a later one at the same address.
+
+  uint refcount = 2;
+  // One reference for the writer and one for the thread that logs into the ring. Whichever lets
+  // go last frees the ring.
+
+  Array<byte> data;
+
+  uint64_t queued = 0;
+  uint64_t dropped = 0;
+  uint64_t rateLimited = 0;
+  uint64_t truncated = 0;
+  // Written only by the logging thread.
+
+  alignas(64) uint64_t head = 0;
+  // Total bytes the logging thread has produced. Only the logging thread writes it.
+
+  alignas(64) uint64_t tail = 0;
+  // Total bytes the writing thread has consumed. Only the writing thread writes it.
+
+  void release() {
+    if (__atomic_sub_fetch(&refcount, 1, __ATOMIC_ACQ_REL) == 0) delete this;
+  }
+};
+
+struct LogRateLimitSite {
+  uint64_t key = 0;
+  uint64_t second = 0;
+  uint32_t count = 0;
+};
+
+}  // namespace _
+
+namespace {
+
+#if _WIN32
+struct iovec {
+  void* iov_base;
+  size_t iov_len;
+};
+#endif
+
+constexpr size_t RECORD_HEADER_SIZE = 8;
+constexpr uint32_t WRAP = 0xffffffff;
+constexpr size_t MIN_BUFFER_SIZE = 1024;
+constexpr size_t RATE_LIMIT_SITES = 1024;
+constexpr size_t WRITE_BATCH = 512;
+constexpr Duration IDLE_TIMEOUT = 100 * MILLISECONDS;
+// The writing thread checks for lines this often even if no one wakes it.
+
+uint64_t nextWriterId = 0;
+uint64_t nextRingSerial = 0;
+
+AsyncLogWriter* installedWriter = nullptr;
+
+uint installedWriterUsers = 0;
+// Number of threads inside writeToInstalledLogWriter() that may have loaded `installedWriter`.
+// uninstall() waits for it to drop to zero, so it only ever waits for threads logging right now.
+// A count in the writer itself would not do: a thread could load the pointer, and then bump the
+// count of a writer that has already been destroyed.
+
+struct ThreadLogRing {
+  _::LogRing* ring = nullptr;
+  bool exited = false;
+
+  ~ThreadLogRing() noexcept(false) {
+    if (ring != nullptr) ring->release();
+    ring = nullptr;
+    exited = true;
+  }
+};
+
+thread_local ThreadLogRing threadLogRing;
+
+inline size_t alignRecord(size_t size) { return (size + 7) & ~size_t(7); }
+
+inline uint64_t load(const uint64_t& counter) {
+  return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
+inline void add(uint64_t& counter, uint64_t amount) {
+  // Counters each have a single writer, so they need no read-modify-write.
+  __atomic_store_n(&counter, __atomic_load_n(&counter, __ATOMIC_RELAXED) + amount,
+                   __ATOMIC_RELAXED);
+}
+
+void addStats(AsyncLogWriter::Stats& stats, const _::LogRing& ring) {
+  stats.linesQueued += load(ring.queued);
+  stats.linesDropped += load(ring.dropped);
+  stats.linesRateLimited += load(ring.rateLimited);
+  stats.linesTruncated += load(ring.truncated);
+}
+
+}  // namespace
+
+AsyncLogWriter::AsyncLogWriter(Options options)
+    : options(options),
+      id(__atomic_add_fetch(&nextWriterId, 1, __ATOMIC_RELAXED)),
+      bufferSize(MIN_BUFFER_SIZE) {
+  while (bufferSize < options.threadBufferSize) bufferSize *= 2;
+  if (options.maxLinesPerSecondPerSite > 0) {
+    rateLimitSites = heapArray<_::LogRateLimitSite>(RATE_LIMIT_SITES);
+  }
+  memset(&shared.getWithoutLock().reaped, 0, sizeof(Stats));
+  thread = heap<Thread>([this]() { run(); });
+}
+
+AsyncLogWriter::~AsyncLogWriter() noexcept(false) {
+  uninstall();
+  shared.lockExclusive()->stopping = true;
+  ZC_DEFER(for (auto ring : shared.getWithoutLock().rings) ring->release());
+
+  // Joins once everything queued so far is written.
+  thread = nullptr;
+}
+
+void AsyncLogWriter::install() {
+  AsyncLogWriter* expected = nullptr;
+  ZC_REQUIRE(__atomic_compare_exchange_n(&installedWriter, &expected, this, false,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED),
+             "another AsyncLogWriter is already installed");
+}
+
+void AsyncLogWriter::uninstall() {
+  AsyncLogWriter* expected = this;
+  if (__atomic_compare_exchange_n(&installedWriter, &expected, nullptr, false, __ATOMIC_SEQ_CST,
+                                  __ATOMIC_RELAXED)) {
+    // Threads that arrive from now on see no writer, so this only waits for those already in.
+    while (__atomic_load_n(&installedWriterUsers, __ATOMIC_SEQ_CST) != 0) {
+#if _WIN32
+      Sleep(0);
+#else
+      sched_yield();
+#endif
+    }
+  }
+}
+
+_::LogRing* AsyncLogWriter::getThreadRing() {
+  auto& local = threadLogRing;
+  if (ZC_LIKELY(local.ring != nullptr && local.ring->writerId == id)) return local.ring;
+  if (local.exited) return nullptr;
+
+  // First line from this thread, or the thread last logged through a different writer.
+  if (local.ring != nullptr) local.ring->release();
+  local.ring = nullptr;
+  auto ring = new _::LogRing(id, __atomic_add_fetch(&nextRingSerial, 1, __ATOMIC_RELAXED),
+                             bufferSize);
+  shared.lockExclusive()->rings.add(ring);
+  local.ring = ring;
+  return ring;
+}
+
+bool AsyncLogWriter::isRateLimited(const char* file, int line) {
+  // `file` is normally a string literal, so its address identifies it.
+  uint64_t key =
+      (reinterpret_cast<uintptr_t>(file) ^ uint64_t(uint(line)) << 40) * 0x9e3779b97f4a7c15ull;
+  auto& site = rateLimitSites[key >> 54];
+  static_assert(RATE_LIMIT_SITES == 1 << 10, "index above takes the top 10 bits");
+  uint64_t second = (systemCoarseMonotonicClock().now() - origin<TimePoint>()) / SECONDS;
+
+  // Races between threads may let a few extra lines through; that's fine.
+  if (__atomic_load_n(&site.key, __ATOMIC_RELAXED) != key ||
+      __atomic_load_n(&site.second, __ATOMIC_RELAXED) != second) {
+    __atomic_store_n(&site.key, key, __ATOMIC_RELAXED);
+    __atomic_store_n(&site.second, second, __ATOMIC_RELAXED);
+    __atomic_store_n(&site.count, 0, __ATOMIC_RELAXED);
+  }
+  return __atomic_fetch_add(&site.count, 1, __ATOMIC_RELAXED) >= options.maxLinesPerSecondPerSite;
+}
+
+bool AsyncLogWriter::write(LogSeverity severity, const char* file, int line, int contextDepth,
+                           StringPtr text) {
+  _::LogRing* ring = getThreadRing();
+  if (ring == nullptr) return false;
+
+  if (options.maxLinesPerSecondPerSite > 0 && isRateLimited(file, line)) {
+    add(ring->rateLimited, 1);
+    return true;
+  }
+
+  auto lineText = toCharSequence(line);
+  StringPtr severityText = toCharSequence(severity);
+  auto fileText = arrayPtr(file, zc::min(strlen(file), size_t(uint16_t(zc::maxValue))));
+  size_t depth = zc::max(contextDepth, 0);
+
+  size_t overhead = options.format == Format::TEXT
+                        ? depth + fileText.size() + lineText.size() + severityText.size() + 6
+                        : sizeof(LogRecordHeader) + fileText.size();
+  size_t maxPayload = bufferSize / 2 - RECORD_HEADER_SIZE;
+  if (overhead > maxPayload) {
+    add(ring->dropped, 1);
+    return true;
+  }
+  ArrayPtr<const char> textBytes = text;
+  if (textBytes.size() > maxPayload - overhead) {
+    textBytes = textBytes.first(maxPayload - overhead);
+    add(ring->truncated, 1);
+  }
+  size_t payloadSize = overhead + textBytes.size();
+
+  // Reserve space, or drop the line if there isn't enough.
+  uint64_t head = ring->head;
+  size_t pos = head & (bufferSize - 1);
+  size_t recordSize = alignRecord(RECORD_HEADER_SIZE + payloadSize);
+  size_t skip = bufferSize - pos < recordSize ? bufferSize - pos : 0;
+  if (head + skip + recordSize - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > bufferSize) {
+    add(ring->dropped, 1);
+    return true;
+  }
+
+  byte* data = ring->data.begin();
+  if (skip > 0) {
+    memcpy(data + pos, &WRAP, sizeof(WRAP));
+    pos = 0;
+  }
+  uint32_t size32 = payloadSize;
+  memcpy(data + pos, &size32, sizeof(size32));
+  char* out = reinterpret_cast<char*>(data + pos + RECORD_HEADER_SIZE);
+
+  if (options.format == Format::TEXT) {
+    memset(out, '_', depth);
+    _::fill(out + depth, fileText, ":"_zc, lineText, ": "_zc, severityText, ": "_zc, textBytes,
+            "\n"_zc);
+  } else {
+    LogRecordHeader header;
+    header.size = payloadSize;
+    header.severity = static_cast<uint8_t>(severity);
+    header.reserved = 0;
+    header.fileSize = fileText.size();
+    header.line = line;
+    header.contextDepth = depth;
+    header.time = (systemFastCalendarClock().now() - UNIX_EPOCH) / NANOSECONDS;
+    memcpy(out, &header, sizeof(header));
+    _::fill(out + sizeof(header), fileText, textBytes);
+  }
+
+  __atomic_store_n(&ring->head, head + skip + recordSize, __ATOMIC_RELEASE);
+  add(ring->queued, 1);
+
+  // Pairs with the fence in run(): either the writing thread sees the new head, or we see that
+  // it is going to sleep.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&sleeping, __ATOMIC_RELAXED)) wake();
+  return true;
+}
+
+void AsyncLogWriter::wake() { ++shared.lockExclusive()->wakeups; }
+
+void AsyncLogWriter::flush() {
+  struct Target {
+    _::LogRing* ring;
+    uint64_t serial;
+    uint64_t head;
+  };
+  Vector<Target> targets;
+  {
+    auto lock = shared.lockExclusive();
+    for (auto ring : lock->rings) {
+      targets.add(Target{ring, ring->serial, __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)});
+    }
+  }
+
+  auto isDone = [&](const Shared& state) {
+    for (auto& target : targets) {
+      for (auto ring : state.rings) {
+        // A ring that is gone was freed empty.
+        if (ring == target.ring && ring->serial == target.serial &&
+            __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) < target.head) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  for (;;) {
+    uint64_t passes;
+    {
+      auto lock = shared.lockExclusive();
+      if (isDone(*lock)) return;
+      passes = lock->passes;
+      ++lock->wakeups;
+    }
+    shared.when([&](const Shared& state) { return state.passes != passes; }, [](Shared&) {},
+                IDLE_TIMEOUT);
+  }
+}
+
+AsyncLogWriter::Stats AsyncLogWriter::getStats() const {
+  auto lock = shared.lockExclusive();
+  Stats result = lock->reaped;
+  for (auto ring : lock->rings) addStats(result, *ring);
+  result.linesWritten = load(linesWritten);
+  result.bytesWritten = load(bytesWritten);
+  result.writeCalls = load(writeCalls);
+  result.writeErrors = load(writeErrors);
+  return result;
+}
+
+void AsyncLogWriter::run() {
+  uint64_t seenWakeups = 0;
+  for (;;) {
+    bool wrote = drain();
+    {
+      auto lock = shared.lockExclusive();
+      ++lock->passes;
+      reap(*lock);
+      if (lock->stopping && !wrote) return;
+    }
+    if (wrote) continue;
+
+    __atomic_store_n(&sleeping, true, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    bool pending = false;
+    for (auto ring : drainRings) {
+      pending = pending || __atomic_load_n(&ring->head, __ATOMIC_RELAXED) != ring->tail;
+    }
+    if (!pending) {
+      shared.when(
+          [&](const Shared& state) { return state.wakeups != seenWakeups || state.stopping; },
+          [&](Shared& state) { seenWakeups = state.wakeups; }, IDLE_TIMEOUT);
+    }
+    __atomic_store_n(&sleeping, false, __ATOMIC_RELAXED);
+  }
+}
+
+bool AsyncLogWriter::drain() {
+  {
+    auto lock = shared.lockExclusive();
+    drainRings.clear();
+    drainRings.addAll(lock->rings);
+  }
+
+  bool wrote = false;
+  ZC_STACK_ARRAY(uint64_t, newTails, drainRings.size(), 16, 256);
+  for (;;) {
+    struct iovec iov[WRITE_BATCH];
+    size_t count = 0;
+    for (auto i : zc::indices(drainRings)) {
+      auto ring = drainRings[i];
+      const byte* data = ring->data.begin();
+      uint64_t tail = ring->tail;
+      uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+      while (tail != head && count < WRITE_BATCH) {
+        size_t pos = tail & (bufferSize - 1);
+        uint32_t size;
+        memcpy(&size, data + pos, sizeof(size));
+        if (size == WRAP) {
+          tail += bufferSize - pos;
+          continue;
+        }
+        iov[count].iov_base = const_cast<byte*>(data + pos + RECORD_HEADER_SIZE);
+        iov[count].iov_len = size;
+        ++count;
+        tail += alignRecord(RECORD_HEADER_SIZE + size);
+      }
+      newTails[i] = tail;
+    }
+
+    // Write the batch, resuming after partial writes.
+    auto pending = arrayPtr(iov, count);
+    while (pending.size() > 0) {
+#if _WIN32
+      miniposix::ssize_t n = miniposix::write(options.fd, pending[0].iov_base, pending[0].iov_len);
+#else
+      ssize_t n = ::writev(options.fd, pending.begin(), zc::min(pending.size(), size_t(IOV_MAX)));
+#endif
+      if (n < 0) {
+        int error = errno;
+        if (error == EINTR) continue;
+#if !_WIN32
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+          struct pollfd pfd = {options.fd, POLLOUT, 0};
+          ::poll(&pfd, 1, -1);
+          continue;
+        }
+#endif
+        add(writeErrors, 1);
+        break;
+      }
+
+      add(writeCalls, 1);
+      add(bytesWritten, n);
+      size_t written = n;
+      size_t lines = 0;
+      while (lines < pending.size() && written >= pending[lines].iov_len) {
+        written -= pending[lines++].iov_len;
+      }
+      add(linesWritten, lines);
+      pending = pending.slice(lines);
+      if (written > 0) {
+        pending[0].iov_base = reinterpret_cast<byte*>(pending[0].iov_base) + written;
+        pending[0].iov_len -= written;
+      }
+    }
+    wrote = wrote || count > 0;
+
+    for (auto i : zc::indices(drainRings)) {
+      __atomic_store_n(&drainRings[i]->tail, newTails[i], __ATOMIC_RELEASE);
+    }
+    if (count < WRITE_BATCH) return wrote;
+  }
+}
+
+void AsyncLogWriter::reap(Shared& state) {
+  // Frees the rings of threads that have exited, once they are empty.
+  for (size_t i = 0; i < state.rings.size();) {
+    auto ring = state.rings[i];
+    if (__atomic_load_n(&ring->refcount, __ATOMIC_ACQUIRE) == 1 &&
+        __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail) {
+      addStats(state.reaped, *ring);
+      state.rings[i] = state.rings.back();
+      state.rings.removeLast();
+      ring->release();
+    } else {
+      ++i;
+    }
+  }
+}
+
+Maybe<LogRecord> readLogRecord(ArrayPtr<const byte>& input) {
+  LogRecordHeader header;
+  if (input.size() < sizeof(header)) return zc::none;
+  memcpy(&header, input.begin(), sizeof(header));
+  if (header.size < sizeof(header) + header.fileSize || header.size > input.size()) {
+    return zc::none;
+  }
+
+  auto body = input.slice(sizeof(header), header.size).asChars();
+  input = input.slice(header.size);
+  return LogRecord{
+      .severity = static_cast<LogSeverity>(header.severity),
+      .file = body.first(header.fileSize),
+      .line = header.line,
+      .contextDepth = header.contextDepth,
+      .time = UNIX_EPOCH + header.time * NANOSECONDS,
+      .text = body.slice(header.fileSize),
+  };
+}
+
+namespace _ {  // private
+
+bool writeToInstalledLogWriter(LogSeverity severity, const char* file, int line, int contextDepth,
+                               StringPtr text) {
+  if (__atomic_load_n(&installedWriter, __ATOMIC_RELAXED) == nullptr) return false;
+
+  // Either uninstall() sees our count, or we see that the writer is gone.
+  __atomic_add_fetch(&installedWriterUsers, 1, __ATOMIC_SEQ_CST);
+  ZC_DEFER(__atomic_sub_fetch(&installedWriterUsers, 1, __ATOMIC_RELEASE));
+  AsyncLogWriter* writer = __atomic_load_n(&installedWriter, __ATOMIC_SEQ_CST);
+  return writer != nullptr && writer->write(severity, file, line, contextDepth, text);
+}
+
+}  // namespace _
+}  // namespace zc
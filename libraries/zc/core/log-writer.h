@@ -0,0 +1,221 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "zc/core/array.h"
+#include "zc/core/exception.h"
+#include "zc/core/memory.h"
+#include "zc/core/mutex.h"
+#include "zc/core/string.h"
+#include "zc/core/thread.h"
+#include "zc/core/time.h"
+#include "zc/core/vector.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+// =======================================================================================
+// Asynchronous log writer
+//
+// Without one, the root ExceptionCallback writes each ZC_LOG() line to stderr with a write()
+// syscall on the logging thread, which then blocks whenever the pipe behind stderr is full. With
+// an AsyncLogWriter installed, each thread instead formats its lines into a ring buffer of its
+// own, without locks, allocation or syscalls, and a dedicated thread drains all of the buffers,
+// writing each batch with a single writev():
+//
+//     zc::AsyncLogWriter logWriter({});
+//     logWriter.install();
+//
+// When a thread's buffer is full, its new lines are dropped and counted rather than making the
+// thread wait. Lines from one thread are written in order; lines from different threads are only
+// roughly ordered.
+//
+// Only what reaches the root callback goes through the writer: an ExceptionCallback installed on
+// the stack that overrides logMessage() (as tests often do) still sees every line first.
+
+namespace _ {  // private
+
+struct LogRing;
+struct LogRateLimitSite;
+
+}  // namespace _
+
+class AsyncLogWriter {
+public:
+  enum class Format {
+    TEXT,
+    // Lines exactly as the root ExceptionCallback writes them: "file:line: severity: text\n".
+
+    BINARY
+    // A sequence of records, each a LogRecordHeader followed by the file name and the text, which
+    // readLogRecord() parses.
+  };
+
+  struct Options {
+    int fd = 2;
+    // Where to write; stderr by default. The writer doesn't close it.
+
+    Format format = Format::TEXT;
+
+    size_t threadBufferSize = 64 * 1024;
+    // Size of each logging thread's ring buffer, rounded up to a power of two. A line longer than
+    // half of it has its text truncated.
+
+    uint maxLinesPerSecondPerSite = 0;
+    // If nonzero, lines logged from the same file and line beyond this many per second are
+    // dropped, and counted in Stats::linesRateLimited. The limit is approximate.
+  };
+
+  explicit AsyncLogWriter(Options options);
+  ~AsyncLogWriter() noexcept(false);
+  // Uninstalls the writer if it is installed, writes out everything queued, and joins the
+  // writing thread.
+
+  ZC_DISALLOW_COPY_AND_MOVE(AsyncLogWriter);
+
+  void install();
+  void uninstall();
+  // Installs this writer as the one the root ExceptionCallback uses, for all threads, or stops
+  // using it. Only one writer can be installed at a time. uninstall() waits for threads that are
+  // logging through the writer at the time to finish.
+
+  bool write(LogSeverity severity, const char* file, int line, int contextDepth, StringPtr text);
+  // Queues one line, formatted like ExceptionCallback::logMessage() would. Returns false if the
+  // calling thread can no longer use the writer because it is exiting, in which case the caller
+  // should write the line itself. Lines that are dropped still return true.
+
+  void flush();
+  // Waits until every line queued before the call, by any thread, has been written.
+
+  struct Stats {
+    uint64_t linesQueued;
+    uint64_t linesDropped;
+    // Lines discarded because the logging thread's buffer was full.
+    uint64_t linesRateLimited;
+    uint64_t linesTruncated;
+    // Lines that were queued with their text cut short.
+
+    uint64_t linesWritten;
+    uint64_t bytesWritten;
+    uint64_t writeCalls;
+    // writev() calls, each writing a batch of lines.
+    uint64_t writeErrors;
+    // Failed writes. Lines in a failed batch are discarded, and counted neither as written nor
+    // as dropped.
+  };
+
+  Stats getStats() const;
+
+private:
+  struct Shared {
+    Vector<_::LogRing*> rings;
+    // Every ring this writer still holds a reference to. The list is only changed when a thread
+    // logs for the first time and when the writing thread frees the rings of exited threads.
+
+    Stats reaped;
+    // Counters of rings that have been freed.
+
+    uint64_t wakeups = 0;
+    uint64_t passes = 0;
+    bool stopping = false;
+  };
+
+  Options options;
+  uint64_t id;
+  // Unique per writer, so a thread can tell whether its ring belongs to this writer.
+
+  size_t bufferSize;
+  Array<_::LogRateLimitSite> rateLimitSites;
+
+  MutexGuarded<Shared> shared;
+
+  bool sleeping = false;
+  // Set by the writing thread while it waits for lines. Logging threads only wake it then.
+
+  uint64_t linesWritten = 0;
+  uint64_t bytesWritten = 0;
+  uint64_t writeCalls = 0;
+  uint64_t writeErrors = 0;
+  // Written only by the writing thread, with relaxed atomic stores.
+
+  Vector<_::LogRing*> drainRings;
+  // Scratch copy of `shared.rings` for the writing thread.
+
+  Own<Thread> thread;
+
+  _::LogRing* getThreadRing();
+  bool isRateLimited(const char* file, int line);
+  void wake();
+
+  void run();
+  bool drain();
+  void reap(Shared& state);
+};
+
+struct LogRecordHeader {
+  // Starts each record in AsyncLogWriter's BINARY format. Fields are in native byte order.
+
+  uint32_t size;
+  // Of the whole record, including this header.
+
+  uint8_t severity;
+  // A LogSeverity.
+
+  uint8_t reserved;
+  uint16_t fileSize;
+  int32_t line;
+  int32_t contextDepth;
+
+  int64_t time;
+  // Nanoseconds since the Unix epoch.
+
+  // Followed by `fileSize` bytes of file name, then the text, without a trailing newline.
+};
+
+struct LogRecord {
+  LogSeverity severity;
+  ArrayPtr<const char> file;
+  int line;
+  int contextDepth;
+  Date time;
+  ArrayPtr<const char> text;
+};
+
+Maybe<LogRecord> readLogRecord(ArrayPtr<const byte>& input);
+// Parses the BINARY record at the start of `input` and advances `input` past it. The returned
+// record points into the input. Returns none, leaving `input` alone, if `input` doesn't start with
+// a whole record.
+
+namespace _ {  // private
+
+bool writeToInstalledLogWriter(LogSeverity severity, const char* file, int line, int contextDepth,
+                               StringPtr text);
+// Called by the root ExceptionCallback. Returns false if no writer is installed, or the installed
+// one can't be used from this thread.
+
+}  // namespace _
+}  // namespace zc
+
+ZC_END_HEADER
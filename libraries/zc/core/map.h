@@ -28,7 +28,7 @@ ZC_BEGIN_HEADER
 
 namespace zc {
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index = HashIndex>
 class HashMap {
   // A key/value mapping backed by hashing.
   //
@@ -37,6 +37,9 @@ class HashMap {
   // than `Key` as long as the other type is also hashable (producing the same hash codes) and
   // there is an `operator==` implementation with `Key` on the left and that other type on the
   // right. For example, if the key type is `String`, you can pass `StringPtr` to `find()`.
+  //
+  // `Index` is the hash index template; pass `SwissHashIndex` for large maps that run at high
+  // load factors (see table.h).
 
 public:
   void reserve(size_t size);
@@ -133,15 +136,17 @@ private:
     }
   };
 
-  zc::Table<Entry, HashIndex<Callbacks>> table;
+  zc::Table<Entry, Index<Callbacks>> table;
 };
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index = TreeIndex>
 class TreeMap {
   // A key/value mapping backed by a B-tree.
   //
   // `Key` must support `operator<` and `operator==` against other Keys, and against any type
   // which you might want to pass to find() (with `Key` always on the left of the comparison).
+  //
+  // For integer or enum keys, `Index` may be `IntTreeIndex`, which keeps the keys inside the tree.
 
 public:
   void reserve(size_t size);
@@ -249,7 +254,7 @@ private:
     }
   };
 
-  zc::Table<Entry, TreeIndex<Callbacks>> table;
+  zc::Table<Entry, Index<Callbacks>> table;
 };
 
 namespace _ {  // private
@@ -290,9 +295,10 @@ public:
 
 }  // namespace _
 
-template <typename Element>
-class HashSet : public Table<Element, HashIndex<_::HashSetCallbacks>> {
-  // A simple hashtable-based set, using zc::hashCode() and operator==().
+template <typename Element, template <typename> class Index = HashIndex>
+class HashSet : public Table<Element, Index<_::HashSetCallbacks>> {
+  // A simple hashtable-based set, using zc::hashCode() and operator==(). As with HashMap, `Index`
+  // may be `SwissHashIndex`.
 
 public:
   // Everything is inherited.
@@ -303,9 +309,10 @@ public:
   }
 };
 
-template <typename Element>
-class TreeSet : public Table<Element, TreeIndex<_::TreeSetCallbacks>> {
-  // A simple b-tree-based set, using operator<() and operator==().
+template <typename Element, template <typename> class Index = TreeIndex>
+class TreeSet : public Table<Element, Index<_::TreeSetCallbacks>> {
+  // A simple b-tree-based set, using operator<() and operator==(). As with TreeMap, `Index` may be
+  // `IntTreeIndex`.
 
 public:
   // Everything is inherited.
@@ -314,264 +321,270 @@ public:
 // =======================================================================================
 // inline implementation details
 
-template <typename Key, typename Value>
-void HashMap<Key, Value>::reserve(size_t size) {
+template <typename Key, typename Value, template <typename> class Index>
+void HashMap<Key, Value, Index>::reserve(size_t size) {
   table.reserve(size);
 }
 
-template <typename Key, typename Value>
-size_t HashMap<Key, Value>::size() const {
+template <typename Key, typename Value, template <typename> class Index>
+size_t HashMap<Key, Value, Index>::size() const {
   return table.size();
 }
-template <typename Key, typename Value>
-size_t HashMap<Key, Value>::capacity() const {
+template <typename Key, typename Value, template <typename> class Index>
+size_t HashMap<Key, Value, Index>::capacity() const {
   return table.capacity();
 }
-template <typename Key, typename Value>
-void HashMap<Key, Value>::clear() {
+template <typename Key, typename Value, template <typename> class Index>
+void HashMap<Key, Value, Index>::clear() {
   return table.clear();
 }
 
-template <typename Key, typename Value>
-typename HashMap<Key, Value>::Entry* HashMap<Key, Value>::begin() {
+template <typename Key, typename Value, template <typename> class Index>
+typename HashMap<Key, Value, Index>::Entry* HashMap<Key, Value, Index>::begin() {
   return table.begin();
 }
-template <typename Key, typename Value>
-typename HashMap<Key, Value>::Entry* HashMap<Key, Value>::end() {
+template <typename Key, typename Value, template <typename> class Index>
+typename HashMap<Key, Value, Index>::Entry* HashMap<Key, Value, Index>::end() {
   return table.end();
 }
-template <typename Key, typename Value>
-const typename HashMap<Key, Value>::Entry* HashMap<Key, Value>::begin() const {
+template <typename Key, typename Value, template <typename> class Index>
+const typename HashMap<Key, Value, Index>::Entry* HashMap<Key, Value, Index>::begin() const {
   return table.begin();
 }
-template <typename Key, typename Value>
-const typename HashMap<Key, Value>::Entry* HashMap<Key, Value>::end() const {
+template <typename Key, typename Value, template <typename> class Index>
+const typename HashMap<Key, Value, Index>::Entry* HashMap<Key, Value, Index>::end() const {
   return table.end();
 }
 
-template <typename Key, typename Value>
-typename HashMap<Key, Value>::Entry& HashMap<Key, Value>::insert(Key key, Value value) {
+template <typename Key, typename Value, template <typename> class Index>
+typename HashMap<Key, Value, Index>::Entry& HashMap<Key, Value, Index>::insert(Key key,
+                                                                             Value value) {
   return table.insert(Entry{zc::mv(key), zc::mv(value)});
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename Collection>
-void HashMap<Key, Value>::insertAll(Collection&& collection) {
+void HashMap<Key, Value, Index>::insertAll(Collection&& collection) {
   return table.insertAll(zc::fwd<Collection>(collection));
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename UpdateFunc>
-typename HashMap<Key, Value>::Entry& HashMap<Key, Value>::upsert(Key key, Value value,
-                                                                 UpdateFunc&& update) {
+typename HashMap<Key, Value, Index>::Entry& HashMap<Key, Value, Index>::upsert(
+    Key key, Value value, UpdateFunc&& update) {
   return table.upsert(Entry{zc::mv(key), zc::mv(value)},
                       [&](Entry& existingEntry, Entry&& newEntry) {
                         update(existingEntry.value, zc::mv(newEntry.value));
                       });
 }
 
-template <typename Key, typename Value>
-typename HashMap<Key, Value>::Entry& HashMap<Key, Value>::upsert(Key key, Value value) {
+template <typename Key, typename Value, template <typename> class Index>
+typename HashMap<Key, Value, Index>::Entry& HashMap<Key, Value, Index>::upsert(Key key,
+                                                                             Value value) {
   return table.upsert(Entry{zc::mv(key), zc::mv(value)},
                       [&](Entry& existingEntry, Entry&& newEntry) {
                         existingEntry.value = zc::mv(newEntry.value);
                       });
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<Value&> HashMap<Key, Value>::find(KeyLike&& key) {
+zc::Maybe<Value&> HashMap<Key, Value, Index>::find(KeyLike&& key) {
   return table.find(key).map([](Entry& e) -> Value& { return e.value; });
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<const Value&> HashMap<Key, Value>::find(KeyLike&& key) const {
+zc::Maybe<const Value&> HashMap<Key, Value, Index>::find(KeyLike&& key) const {
   return table.find(key).map([](const Entry& e) -> const Value& { return e.value; });
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike, typename Func>
-Value& HashMap<Key, Value>::findOrCreate(KeyLike&& key, Func&& createEntry) {
+Value& HashMap<Key, Value, Index>::findOrCreate(KeyLike&& key, Func&& createEntry) {
   return table.findOrCreate(key, zc::fwd<Func>(createEntry)).value;
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<typename HashMap<Key, Value>::Entry&> HashMap<Key, Value>::findEntry(KeyLike&& key) {
+zc::Maybe<typename HashMap<Key, Value, Index>::Entry&> HashMap<Key, Value, Index>::findEntry(
+    KeyLike&& key) {
   return table.find(zc::fwd<KeyLike>(key));
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<const typename HashMap<Key, Value>::Entry&> HashMap<Key, Value>::findEntry(
+zc::Maybe<const typename HashMap<Key, Value, Index>::Entry&> HashMap<Key, Value, Index>::findEntry(
     KeyLike&& key) const {
   return table.find(zc::fwd<KeyLike>(key));
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike, typename Func>
-typename HashMap<Key, Value>::Entry& HashMap<Key, Value>::findOrCreateEntry(KeyLike&& key,
-                                                                            Func&& createEntry) {
+typename HashMap<Key, Value, Index>::Entry& HashMap<Key, Value, Index>::findOrCreateEntry(
+    KeyLike&& key, Func&& createEntry) {
   return table.findOrCreate(zc::fwd<KeyLike>(key), zc::fwd<Func>(createEntry));
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-bool HashMap<Key, Value>::erase(KeyLike&& key) {
+bool HashMap<Key, Value, Index>::erase(KeyLike&& key) {
   return table.eraseMatch(key);
 }
 
-template <typename Key, typename Value>
-void HashMap<Key, Value>::erase(Entry& entry) {
+template <typename Key, typename Value, template <typename> class Index>
+void HashMap<Key, Value, Index>::erase(Entry& entry) {
   table.erase(entry);
 }
 
-template <typename Key, typename Value>
-typename HashMap<Key, Value>::Entry HashMap<Key, Value>::release(Entry& entry) {
+template <typename Key, typename Value, template <typename> class Index>
+typename HashMap<Key, Value, Index>::Entry HashMap<Key, Value, Index>::release(Entry& entry) {
   return table.release(entry);
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename Predicate, typename>
-size_t HashMap<Key, Value>::eraseAll(Predicate&& predicate) {
+size_t HashMap<Key, Value, Index>::eraseAll(Predicate&& predicate) {
   return table.eraseAll([&](Entry& entry) { return predicate(entry.key, entry.value); });
 }
 
 // -----------------------------------------------------------------------------
 
-template <typename Key, typename Value>
-void TreeMap<Key, Value>::reserve(size_t size) {
+template <typename Key, typename Value, template <typename> class Index>
+void TreeMap<Key, Value, Index>::reserve(size_t size) {
   table.reserve(size);
 }
 
-template <typename Key, typename Value>
-size_t TreeMap<Key, Value>::size() const {
+template <typename Key, typename Value, template <typename> class Index>
+size_t TreeMap<Key, Value, Index>::size() const {
   return table.size();
 }
-template <typename Key, typename Value>
-size_t TreeMap<Key, Value>::capacity() const {
+template <typename Key, typename Value, template <typename> class Index>
+size_t TreeMap<Key, Value, Index>::capacity() const {
   return table.capacity();
 }
-template <typename Key, typename Value>
-void TreeMap<Key, Value>::clear() {
+template <typename Key, typename Value, template <typename> class Index>
+void TreeMap<Key, Value, Index>::clear() {
   return table.clear();
 }
 
-template <typename Key, typename Value>
-auto TreeMap<Key, Value>::begin() {
+template <typename Key, typename Value, template <typename> class Index>
+auto TreeMap<Key, Value, Index>::begin() {
   return table.ordered().begin();
 }
-template <typename Key, typename Value>
-auto TreeMap<Key, Value>::end() {
+template <typename Key, typename Value, template <typename> class Index>
+auto TreeMap<Key, Value, Index>::end() {
   return table.ordered().end();
 }
-template <typename Key, typename Value>
-auto TreeMap<Key, Value>::begin() const {
+template <typename Key, typename Value, template <typename> class Index>
+auto TreeMap<Key, Value, Index>::begin() const {
   return table.ordered().begin();
 }
-template <typename Key, typename Value>
-auto TreeMap<Key, Value>::end() const {
+template <typename Key, typename Value, template <typename> class Index>
+auto TreeMap<Key, Value, Index>::end() const {
   return table.ordered().end();
 }
 
-template <typename Key, typename Value>
-typename TreeMap<Key, Value>::Entry& TreeMap<Key, Value>::insert(Key key, Value value) {
+template <typename Key, typename Value, template <typename> class Index>
+typename TreeMap<Key, Value, Index>::Entry& TreeMap<Key, Value, Index>::insert(Key key,
+                                                                             Value value) {
   return table.insert(Entry{zc::mv(key), zc::mv(value)});
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename Collection>
-void TreeMap<Key, Value>::insertAll(Collection&& collection) {
+void TreeMap<Key, Value, Index>::insertAll(Collection&& collection) {
   return table.insertAll(zc::fwd<Collection>(collection));
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename UpdateFunc>
-typename TreeMap<Key, Value>::Entry& TreeMap<Key, Value>::upsert(Key key, Value value,
-                                                                 UpdateFunc&& update) {
+typename TreeMap<Key, Value, Index>::Entry& TreeMap<Key, Value, Index>::upsert(
+    Key key, Value value, UpdateFunc&& update) {
   return table.upsert(Entry{zc::mv(key), zc::mv(value)},
                       [&](Entry& existingEntry, Entry&& newEntry) {
                         update(existingEntry.value, zc::mv(newEntry.value));
                       });
 }
 
-template <typename Key, typename Value>
-typename TreeMap<Key, Value>::Entry& TreeMap<Key, Value>::upsert(Key key, Value value) {
+template <typename Key, typename Value, template <typename> class Index>
+typename TreeMap<Key, Value, Index>::Entry& TreeMap<Key, Value, Index>::upsert(Key key,
+                                                                             Value value) {
   return table.upsert(Entry{zc::mv(key), zc::mv(value)},
                       [&](Entry& existingEntry, Entry&& newEntry) {
                         existingEntry.value = zc::mv(newEntry.value);
                       });
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<Value&> TreeMap<Key, Value>::find(KeyLike&& key) {
+zc::Maybe<Value&> TreeMap<Key, Value, Index>::find(KeyLike&& key) {
   return table.find(key).map([](Entry& e) -> Value& { return e.value; });
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<const Value&> TreeMap<Key, Value>::find(KeyLike&& key) const {
+zc::Maybe<const Value&> TreeMap<Key, Value, Index>::find(KeyLike&& key) const {
   return table.find(key).map([](const Entry& e) -> const Value& { return e.value; });
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike, typename Func>
-Value& TreeMap<Key, Value>::findOrCreate(KeyLike&& key, Func&& createEntry) {
+Value& TreeMap<Key, Value, Index>::findOrCreate(KeyLike&& key, Func&& createEntry) {
   return table.findOrCreate(key, zc::fwd<Func>(createEntry)).value;
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<typename TreeMap<Key, Value>::Entry&> TreeMap<Key, Value>::findEntry(KeyLike&& key) {
+zc::Maybe<typename TreeMap<Key, Value, Index>::Entry&> TreeMap<Key, Value, Index>::findEntry(
+    KeyLike&& key) {
   return table.find(zc::fwd<KeyLike>(key));
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-zc::Maybe<const typename TreeMap<Key, Value>::Entry&> TreeMap<Key, Value>::findEntry(
+zc::Maybe<const typename TreeMap<Key, Value, Index>::Entry&> TreeMap<Key, Value, Index>::findEntry(
     KeyLike&& key) const {
   return table.find(zc::fwd<KeyLike>(key));
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike, typename Func>
-typename TreeMap<Key, Value>::Entry& TreeMap<Key, Value>::findOrCreateEntry(KeyLike&& key,
-                                                                            Func&& createEntry) {
+typename TreeMap<Key, Value, Index>::Entry& TreeMap<Key, Value, Index>::findOrCreateEntry(
+    KeyLike&& key, Func&& createEntry) {
   return table.findOrCreate(zc::fwd<KeyLike>(key), zc::fwd<Func>(createEntry));
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename K1, typename K2>
-auto TreeMap<Key, Value>::range(K1&& k1, K2&& k2) {
+auto TreeMap<Key, Value, Index>::range(K1&& k1, K2&& k2) {
   return table.range(zc::fwd<K1>(k1), zc::fwd<K2>(k2));
 }
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename K1, typename K2>
-auto TreeMap<Key, Value>::range(K1&& k1, K2&& k2) const {
+auto TreeMap<Key, Value, Index>::range(K1&& k1, K2&& k2) const {
   return table.range(zc::fwd<K1>(k1), zc::fwd<K2>(k2));
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename KeyLike>
-bool TreeMap<Key, Value>::erase(KeyLike&& key) {
+bool TreeMap<Key, Value, Index>::erase(KeyLike&& key) {
   return table.eraseMatch(key);
 }
 
-template <typename Key, typename Value>
-void TreeMap<Key, Value>::erase(Entry& entry) {
+template <typename Key, typename Value, template <typename> class Index>
+void TreeMap<Key, Value, Index>::erase(Entry& entry) {
   table.erase(entry);
 }
 
-template <typename Key, typename Value>
-typename TreeMap<Key, Value>::Entry TreeMap<Key, Value>::release(Entry& entry) {
+template <typename Key, typename Value, template <typename> class Index>
+typename TreeMap<Key, Value, Index>::Entry TreeMap<Key, Value, Index>::release(Entry& entry) {
   return table.release(entry);
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename Predicate, typename>
-size_t TreeMap<Key, Value>::eraseAll(Predicate&& predicate) {
+size_t TreeMap<Key, Value, Index>::eraseAll(Predicate&& predicate) {
   return table.eraseAll([&](Entry& entry) { return predicate(entry.key, entry.value); });
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, template <typename> class Index>
 template <typename K1, typename K2>
-size_t TreeMap<Key, Value>::eraseRange(K1&& k1, K2&& k2) {
+size_t TreeMap<Key, Value, Index>::eraseRange(K1&& k1, K2&& k2) {
   return table.eraseRange(zc::fwd<K1>(k1), zc::fwd<K2>(k2));
 }
 
@@ -651,10 +651,61 @@ private:
 
 namespace _ {  // private
 
+// Memory for heap<T>() and heapArray<T>() comes from the HeapAllocator (see allocator.h). Until a
+// different allocator is selected, that's operator new, which we call inline.
+
+extern uint heapAllocatorState;
+static constexpr uint HEAP_ALLOCATOR_UNDECIDED = 0;
+static constexpr uint HEAP_ALLOCATOR_SYSTEM = 1;
+static constexpr uint HEAP_ALLOCATOR_CUSTOM = 2;
+
+void* heapAllocateSlow(size_t size);
+void heapDeallocateSlow(void* pointer, size_t size);
+
+inline void* heapAllocate(size_t size) {
+  if (ZC_LIKELY(__atomic_load_n(&heapAllocatorState, __ATOMIC_RELAXED) == HEAP_ALLOCATOR_SYSTEM)) {
+    return operator new(size);
+  }
+  return heapAllocateSlow(size);
+}
+
+inline void heapDeallocate(void* pointer, size_t size) {
+  // `size` must be the size that was passed to heapAllocate().
+  if (ZC_LIKELY(__atomic_load_n(&heapAllocatorState, __ATOMIC_RELAXED) == HEAP_ALLOCATOR_SYSTEM)) {
+    operator delete(pointer);
+  } else {
+    heapDeallocateSlow(pointer, size);
+  }
+}
+
+template <typename T, typename = void>
+struct HasClassOperatorNew_ {
+  static constexpr bool value = false;
+};
+template <typename T>
+struct HasClassOperatorNew_<T, decltype(void(T::operator new(sizeof(T))))> {
+  static constexpr bool value = true;
+};
+
+template <typename T>
+constexpr bool useHeapAllocator() {
+  // Types with their own operator new, or that need more alignment than allocators generally
+  // provide, are allocated with `new` as before.
+  return !HasClassOperatorNew_<T>::value && alignof(T) <= alignof(std::max_align_t);
+}
+
 template <typename T>
 class HeapDisposer final : public Disposer {
 public:
-  virtual void disposeImpl(void* pointer) const override { delete reinterpret_cast<T*>(pointer); }
+  virtual void disposeImpl(void* pointer) const override {
+    T* object = reinterpret_cast<T*>(pointer);
+    if constexpr (useHeapAllocator<T>()) {
+      ZC_DEFER(heapDeallocate(const_cast<RemoveConst<T>*>(object), sizeof(T)));
+      object->~T();
+    } else {
+      delete object;
+    }
+  }
 
   static const HeapDisposer instance;
 };
@@ -682,14 +733,39 @@ static constexpr CustomDisposer<T, F> CUSTOM_DISPOSER_INSTANCE{};
 
 }  // namespace _
 
+namespace _ {  // private
+
+template <typename T>
+struct HeapAllocation {
+  // Frees the memory for a T if its constructor throws.
+  void* pointer = heapAllocate(sizeof(T));
+  ~HeapAllocation() noexcept {
+    if (pointer != nullptr) heapDeallocate(pointer, sizeof(T));
+  }
+};
+
+template <typename T, typename... Params>
+T* heapNew(Params&&... params) {
+  if constexpr (useHeapAllocator<T>()) {
+    HeapAllocation<T> memory;
+    T* result = new (_::PlacementNew(), memory.pointer) T(zc::fwd<Params>(params)...);
+    memory.pointer = nullptr;
+    return result;
+  } else {
+    return new T(zc::fwd<Params>(params)...);
+  }
+}
+
+}  // namespace _
+
 template <typename T, typename... Params>
 Own<T> heap(Params&&... params) {
   // heap<T>(...) allocates a T on the heap, forwarding the parameters to its constructor.  The
-  // exact heap implementation is unspecified -- for now it is operator new, but you should not
-  // assume this.  (Since we know the object size at delete time, we could actually implement an
-  // allocator that is more efficient than operator new.)
+  // memory comes from the HeapAllocator, which is operator new unless another one was selected at
+  // startup (see allocator.h). Since the object's size is known when it is freed, an allocator can
+  // be more efficient than operator new.
 
-  return Own<T>(new T(zc::fwd<Params>(params)...), _::HeapDisposer<T>::instance);
+  return Own<T>(_::heapNew<T>(zc::fwd<Params>(params)...), _::HeapDisposer<T>::instance);
 }
 
 template <typename T>
@@ -700,7 +776,7 @@ Own<Decay<T>> heap(T&& orig) {
   // one argument and the purpose is to copy it.
 
   typedef Decay<T> T2;
-  return Own<T2>(new T2(zc::fwd<T>(orig)), _::HeapDisposer<T2>::instance);
+  return Own<T2>(_::heapNew<T2>(zc::fwd<T>(orig)), _::HeapDisposer<T2>::instance);
 }
 
 template <auto F, typename T>
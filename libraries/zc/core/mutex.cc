@@ -24,6 +24,7 @@
 #endif
 
 #include "zc/core/debug.h"
+#include "zc/core/lock-profiler.h"
 #include "zc/core/mutex.h"
 
 #if !_WIN32 && !__CYGWIN__
@@ -88,6 +89,7 @@ namespace _ {  // private
 #if ZC_USE_FUTEX
 constexpr uint Mutex::EXCLUSIVE_HELD;
 constexpr uint Mutex::EXCLUSIVE_REQUESTED;
+constexpr uint Mutex::SHARED_BLOCKED;
 constexpr uint Mutex::SHARED_COUNT_MASK;
 #endif
 
@@ -154,13 +156,110 @@ struct timespec toAbsoluteTimespec(TimePoint time) {
 // =======================================================================================
 // Futex-based implementation (Linux-only)
 
-Mutex::Mutex() : futex(0) {}
+namespace {
+
+static constexpr uint MAX_SPINS = 40;
+// Most rounds lock() spins for before sleeping on the futex. A futex sleep and wakeup costs a few
+// microseconds of syscalls and context switches, so spinning pays off when the holder is likely
+// to release the lock sooner than that, i.e. when critical sections are short.
+
+static constexpr uint MAX_BACKOFF = 16;
+// Each spin round pauses twice as long as the last, up to this many pause instructions, so that
+// spinning threads don't keep pulling the lock's cache line away from the holder.
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+bool canSpin() {
+  // Spinning only helps if the lock holder is running on another CPU at the same time.
+  static const bool result = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return result;
+}
+
+}  // namespace
+
+Mutex::Mutex(MutexPolicy policy) : futex(0), policy(policy) {}
 Mutex::~Mutex() {
   // This will crash anyway, might as well crash with a nice error message.
   ZC_ASSERT(futex == 0, "Mutex destroyed while locked.") { break; }
 }
 
-bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLocationArg location) {
+template <typename Func>
+bool Mutex::spin(Func&& tryAcquire) {
+  // Spins with exponential backoff until tryAcquire() returns true, giving up after a number of
+  // rounds that adapts to how long this mutex has taken to come free before (as in glibc's
+  // PTHREAD_MUTEX_ADAPTIVE_NP). Returns whether the lock was acquired.
+
+  if (!canSpin()) return false;
+
+  uint estimate = __atomic_load_n(&spinEstimate, __ATOMIC_RELAXED);
+  uint limit = zc::min(MAX_SPINS, estimate * 2 + 10);
+  uint backoff = 1;
+  for (uint rounds = 0; rounds < limit; rounds++) {
+    for (uint i = 0; i < backoff; i++) { cpuRelax(); }
+    backoff = zc::min(backoff * 2, MAX_BACKOFF);
+
+    if (tryAcquire()) {
+      __atomic_store_n(&spinEstimate, estimate + (int(rounds) - int(estimate)) / 8,
+                       __ATOMIC_RELAXED);
+      return true;
+    }
+  }
+
+  __atomic_store_n(&spinEstimate, estimate + (int(limit) - int(estimate)) / 8, __ATOMIC_RELAXED);
+  return false;
+}
+
+void Mutex::readersDrained(uint state) {
+  // Called after a reader has decremented the count to `state`, for the case where it was the
+  // last reader and a writer is waiting.
+
+  while ((state & ~SHARED_BLOCKED) == EXCLUSIVE_REQUESTED) {
+    if (__atomic_compare_exchange_n(&futex, &state, 0, false, __ATOMIC_RELAXED,
+                                    __ATOMIC_RELAXED)) {
+      // Only writers are waiting, unless readers were blocked behind them. Wake one writer: the
+      // others stay asleep, and the one we wake takes the lock with EXCLUSIVE_REQUESTED set so
+      // that it in turn wakes the next. Blocked readers all need to re-check the state, though.
+      syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE, state & SHARED_BLOCKED ? INT_MAX : 1,
+              nullptr, nullptr, 0);
+      return;
+    }
+    // On failure, `state` has been reloaded. Keep trying as long as the lock is still free, since
+    // a reader may have just set SHARED_BLOCKED and gone to sleep.
+  }
+}
+
+bool Mutex::tryLock(Exclusivity exclusivity) {
+  switch (exclusivity) {
+    case EXCLUSIVE: {
+      uint state = 0;
+      return __atomic_compare_exchange_n(&futex, &state, EXCLUSIVE_HELD, false, __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED);
+    }
+    case SHARED: {
+      // Same rules as lock(): with PREFER_WRITERS, a waiting writer also keeps new readers out.
+      uint blockers =
+          EXCLUSIVE_HELD | (policy == MutexPolicy::PREFER_WRITERS ? EXCLUSIVE_REQUESTED : 0);
+      uint state = __atomic_load_n(&futex, __ATOMIC_RELAXED);
+      while ((state & blockers) == 0) {
+        if (__atomic_compare_exchange_n(&futex, &state, state + 1, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  ZC_UNREACHABLE;
+}
+
+bool Mutex::lockImpl(Exclusivity exclusivity, Maybe<Duration> timeout,
+                     LockSourceLocationArg location) {
   BlockedOnReason blockReason = BlockedOnMutexAcquisition{*this, location};
   ZC_DEFER(setCurrentThreadIsNoLongerWaiting());
 
@@ -169,15 +268,35 @@ bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLoc
   ZC_IF_SOME(s, spec) { specp = &s; }
 
   switch (exclusivity) {
-    case EXCLUSIVE:
+    case EXCLUSIVE: {
+      // unlock() only wakes one exclusive waiter, and clears EXCLUSIVE_REQUESTED as it does. Once
+      // we have slept we can't tell whether other writers are still asleep, so we then take the
+      // lock with EXCLUSIVE_REQUESTED set, so that our own unlock() wakes the next writer.
+      uint acquiredState = EXCLUSIVE_HELD;
+      bool spun = false;
+
       for (;;) {
         uint state = 0;
-        if (ZC_LIKELY(__atomic_compare_exchange_n(&futex, &state, EXCLUSIVE_HELD, false,
+        if (ZC_LIKELY(__atomic_compare_exchange_n(&futex, &state, acquiredState, false,
                                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))) {
           // Acquired.
           break;
         }
 
+        if (!spun) {
+          // Before sleeping, spin for a while in case the holder is about to release the lock.
+          spun = true;
+          if (spin([&]() {
+                uint expected = 0;
+                return __atomic_load_n(&futex, __ATOMIC_RELAXED) == 0 &&
+                       __atomic_compare_exchange_n(&futex, &expected, EXCLUSIVE_HELD, false,
+                                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+              })) {
+            break;
+          }
+          continue;
+        }
+
         // The mutex is contended.  Set the exclusive-requested bit and wait.
         if ((state & EXCLUSIVE_REQUESTED) == 0) {
           if (!__atomic_compare_exchange_n(&futex, &state, state | EXCLUSIVE_REQUESTED, false,
@@ -200,17 +319,74 @@ bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLoc
             return false;
           }
         }
+        acquiredState = EXCLUSIVE_HELD | EXCLUSIVE_REQUESTED;
       }
 #if ZC_CONTENTION_WARNING_THRESHOLD
       printContendedReader = false;
 #endif
       break;
+    }
     case SHARED: {
 #if ZC_CONTENTION_WARNING_THRESHOLD
       zc::Maybe<zc::TimePoint> contentionWaitStart;
 #endif
 
-      uint state = __atomic_add_fetch(&futex, 1, __ATOMIC_ACQUIRE);
+      uint state;
+      if (policy == MutexPolicy::PREFER_WRITERS) {
+        // If readers hold the lock and a writer is waiting for them, don't join them, or the
+        // writer could wait forever. Wait for the writer to get its turn instead. (If a writer
+        // holds the lock, we do get counted, and so go before any other writers that are waiting.)
+        state = __atomic_load_n(&futex, __ATOMIC_RELAXED);
+        for (;;) {
+          if ((state & (EXCLUSIVE_HELD | EXCLUSIVE_REQUESTED)) == EXCLUSIVE_REQUESTED) {
+            if ((state & SHARED_BLOCKED) == 0) {
+              if (!__atomic_compare_exchange_n(&futex, &state, state | SHARED_BLOCKED, false,
+                                               __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                continue;
+              }
+              state |= SHARED_BLOCKED;
+            }
+
+            setCurrentThreadIsWaitingFor(&blockReason);
+            auto result = syscall(SYS_futex, &futex, FUTEX_WAIT_PRIVATE, state, specp, nullptr, 0);
+            if (result < 0 && errno == ETIMEDOUT) {
+              // We were never counted, so the only thing to undo is SHARED_BLOCKED, which would
+              // otherwise make the next unlock wake everyone. We can't tell whether other readers
+              // are still blocked, so if we clear it, we wake all waiters to re-check: blocked
+              // readers set it again, and anyone else just goes back to sleep. Timeouts are rare
+              // enough that this costs less than leaving it set.
+              setCurrentThreadIsNoLongerWaiting();
+              state = __atomic_load_n(&futex, __ATOMIC_RELAXED);
+              while (state & SHARED_BLOCKED) {
+                if (__atomic_compare_exchange_n(&futex, &state, state & ~SHARED_BLOCKED, false,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                  syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+                  break;
+                }
+              }
+              return false;
+            }
+            state = __atomic_load_n(&futex, __ATOMIC_RELAXED);
+          } else if (__atomic_compare_exchange_n(&futex, &state, state + 1, false,
+                                                 __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            state += 1;
+            break;
+          }
+        }
+      } else {
+        state = __atomic_add_fetch(&futex, 1, __ATOMIC_ACQUIRE);
+      }
+
+      if (ZC_UNLIKELY(state & EXCLUSIVE_HELD)) {
+        // We are counted, so we hold the lock as soon as the writer releases it. Spin for a while
+        // in case that is soon.
+        if (spin([&]() {
+              state = __atomic_load_n(&futex, __ATOMIC_ACQUIRE);
+              return (state & EXCLUSIVE_HELD) == 0;
+            })) {
+          break;
+        }
+      }
 
       for (;;) {
         if (ZC_LIKELY((state & EXCLUSIVE_HELD) == 0)) {
@@ -240,14 +416,7 @@ bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLoc
 
             // We may have unlocked since we timed out. So act like we just unlocked the mutex
             // and maybe send a wait signal if needed. See Mutex::unlock SHARED case.
-            if (ZC_UNLIKELY(state == EXCLUSIVE_REQUESTED)) {
-              if (__atomic_compare_exchange_n(&futex, &state, 0, false, __ATOMIC_RELAXED,
-                                              __ATOMIC_RELAXED)) {
-                // Wake all exclusive waiters.  We have to wake all of them because one of them will
-                // grab the lock while the others will re-establish the exclusive-requested bit.
-                syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
-              }
-            }
+            readersDrained(state);
             return false;
           }
         }
@@ -273,7 +442,7 @@ bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLoc
   return true;
 }
 
-void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
+void Mutex::unlockImpl(Exclusivity exclusivity, Waiter* waiterToSkip) {
   switch (exclusivity) {
     case EXCLUSIVE: {
       ZC_DASSERT(futex & EXCLUSIVE_HELD, "Unlocked a mutex that wasn't locked.");
@@ -338,15 +507,18 @@ void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
 #endif
 
       // Didn't wake any waiters, so wake normally.
-      uint oldState =
-          __atomic_fetch_and(&futex, ~(EXCLUSIVE_HELD | EXCLUSIVE_REQUESTED), __ATOMIC_RELEASE);
+      uint oldState = __atomic_fetch_and(
+          &futex, ~(EXCLUSIVE_HELD | EXCLUSIVE_REQUESTED | SHARED_BLOCKED), __ATOMIC_RELEASE);
 
       if (ZC_UNLIKELY(oldState & ~EXCLUSIVE_HELD)) {
         // Other threads are waiting.  If there are any shared waiters, they now collectively hold
-        // the lock, and we must wake them up.  If there are any exclusive waiters, we must wake
-        // them up even if readers are waiting so that at the very least they may re-establish the
-        // EXCLUSIVE_REQUESTED bit that we just removed.
-        syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        // the lock, and we must wake them up, along with any exclusive waiters so that at the very
+        // least they may re-establish the EXCLUSIVE_REQUESTED bit that we just removed. If only
+        // exclusive waiters are asleep, waking one is enough: it takes the lock with
+        // EXCLUSIVE_REQUESTED set, and so wakes the next when it unlocks. Waking them all would
+        // just have them fight over the lock and all but one go back to sleep.
+        syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE,
+                oldState & (SHARED_COUNT_MASK | SHARED_BLOCKED) ? INT_MAX : 1, nullptr, nullptr, 0);
 
 #ifdef ZC_CONTENTION_WARNING_THRESHOLD
         if (readerCount >= ZC_CONTENTION_WARNING_THRESHOLD) {
@@ -364,14 +536,7 @@ void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
 
       // The only case where anyone is waiting is if EXCLUSIVE_REQUESTED is set, and the only time
       // it makes sense to wake up that waiter is if the shared count has reached zero.
-      if (ZC_UNLIKELY(state == EXCLUSIVE_REQUESTED)) {
-        if (__atomic_compare_exchange_n(&futex, &state, 0, false, __ATOMIC_RELAXED,
-                                        __ATOMIC_RELAXED)) {
-          // Wake all exclusive waiters.  We have to wake all of them because one of them will
-          // grab the lock while the others will re-establish the exclusive-requested bit.
-          syscall(SYS_futex, &futex, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
-        }
-      }
+      if (ZC_UNLIKELY((state & ~SHARED_BLOCKED) == EXCLUSIVE_REQUESTED)) { readersDrained(state); }
       break;
     }
   }
@@ -574,13 +739,23 @@ void Once::reset() {
 #define coercedInitOnce (*reinterpret_cast<INIT_ONCE*>(&initOnce))
 #define coercedCondvar(var) (*reinterpret_cast<CONDITION_VARIABLE*>(&var))
 
-Mutex::Mutex() {
+Mutex::Mutex(MutexPolicy) {
   static_assert(sizeof(SRWLOCK) == sizeof(srwLock), "SRWLOCK is not a pointer?");
   InitializeSRWLock(&coercedSrwLock);
 }
 Mutex::~Mutex() {}
 
-bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, NoopSourceLocation) {
+bool Mutex::tryLock(Exclusivity exclusivity) {
+  switch (exclusivity) {
+    case EXCLUSIVE:
+      return TryAcquireSRWLockExclusive(&coercedSrwLock);
+    case SHARED:
+      return TryAcquireSRWLockShared(&coercedSrwLock);
+  }
+  ZC_UNREACHABLE;
+}
+
+bool Mutex::lockImpl(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLocationArg) {
   if (timeout != zc::none) {
     ZC_UNIMPLEMENTED("Locking a mutex with a timeout is only supported on Linux.");
   }
@@ -626,7 +801,7 @@ void Mutex::wakeReadyWaiter(Waiter* waiterToSkip) {
   }
 }
 
-void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
+void Mutex::unlockImpl(Exclusivity exclusivity, Waiter* waiterToSkip) {
   switch (exclusivity) {
     case EXCLUSIVE: {
       ZC_DEFER(ReleaseSRWLockExclusive(&coercedSrwLock));
@@ -650,7 +825,7 @@ void Mutex::assertLockedByCaller(Exclusivity exclusivity) const {
   // held for debug purposes anyway, we just don't bother.
 }
 
-void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, NoopSourceLocation) {
+void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, LockSourceLocationArg) {
   // Add waiter to list.
   Waiter waiter{zc::none, waitersTail, predicate, zc::none, 0};
   static_assert(sizeof(waiter.condvar) == sizeof(CONDITION_VARIABLE),
@@ -757,7 +932,7 @@ Once::Once(bool startInitialized) {
 }
 Once::~Once() {}
 
-void Once::runOnce(Initializer& init, NoopSourceLocation) {
+void Once::runOnce(Initializer& init, LockSourceLocationArg) {
   BOOL needInit;
   while (!InitOnceBeginInitialize(&coercedInitOnce, 0, &needInit, nullptr)) {
     // Init was occurring in another thread, but then failed with an exception. Retry.
@@ -796,7 +971,7 @@ void Once::reset() { InitOnceInitialize(&coercedInitOnce); }
     if (pthreadError != 0) { ZC_LOG(ERROR, #code, strerror(pthreadError)); } \
   }
 
-Mutex::Mutex() : mutex(PTHREAD_RWLOCK_INITIALIZER) {
+Mutex::Mutex(MutexPolicy) : mutex(PTHREAD_RWLOCK_INITIALIZER) {
 #if defined(__ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__) && \
     __ENVIRONMENT_MAC_OS_X_VERSION_MIN_REQUIRED__ < 1070
   // In older versions of MacOS, mutexes initialized statically cannot be destroyed,
@@ -806,7 +981,17 @@ Mutex::Mutex() : mutex(PTHREAD_RWLOCK_INITIALIZER) {
 }
 Mutex::~Mutex() { ZC_PTHREAD_CLEANUP(pthread_rwlock_destroy(&mutex)); }
 
-bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, NoopSourceLocation) {
+bool Mutex::tryLock(Exclusivity exclusivity) {
+  switch (exclusivity) {
+    case EXCLUSIVE:
+      return pthread_rwlock_trywrlock(&mutex) == 0;
+    case SHARED:
+      return pthread_rwlock_tryrdlock(&mutex) == 0;
+  }
+  ZC_UNREACHABLE;
+}
+
+bool Mutex::lockImpl(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLocationArg) {
   if (timeout != zc::none) {
     ZC_UNIMPLEMENTED("Locking a mutex with a timeout is only supported on Linux.");
   }
@@ -821,7 +1006,7 @@ bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, NoopSourceLoc
   return true;
 }
 
-void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
+void Mutex::unlockImpl(Exclusivity exclusivity, Waiter* waiterToSkip) {
   ZC_DEFER(ZC_PTHREAD_CALL(pthread_rwlock_unlock(&mutex)));
 
   if (exclusivity == EXCLUSIVE) {
@@ -876,7 +1061,7 @@ void Mutex::assertLockedByCaller(Exclusivity exclusivity) const {
   }
 }
 
-void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, NoopSourceLocation) {
+void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, LockSourceLocationArg location) {
   // Add waiter to list.
   Waiter waiter{zc::none,
                 waitersTail,
@@ -899,7 +1084,7 @@ void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, NoopSourceLocati
   // currently.
   bool currentlyLocked = true;
   ZC_DEFER({
-    if (!currentlyLocked) lock(EXCLUSIVE, zc::none, NoopSourceLocation{});
+    if (!currentlyLocked) lock(EXCLUSIVE, zc::none, location);
     removeWaiter(waiter);
 
     // Destroy pthread objects.
@@ -965,7 +1150,7 @@ void Mutex::wait(Predicate& predicate, Maybe<Duration> timeout, NoopSourceLocati
     // because we've already been signaled.
     ZC_PTHREAD_CALL(pthread_mutex_unlock(&waiter.stupidMutex));
 
-    lock(EXCLUSIVE, zc::none, NoopSourceLocation{});
+    lock(EXCLUSIVE, zc::none, location);
     currentlyLocked = true;
 
     ZC_IF_SOME(exception, waiter.exception) {
@@ -1008,7 +1193,7 @@ Once::Once(bool startInitialized)
 }
 Once::~Once() { ZC_PTHREAD_CLEANUP(pthread_mutex_destroy(&mutex)); }
 
-void Once::runOnce(Initializer& init, NoopSourceLocation) {
+void Once::runOnce(Initializer& init, LockSourceLocationArg) {
   ZC_PTHREAD_CALL(pthread_mutex_lock(&mutex));
   ZC_DEFER(ZC_PTHREAD_CALL(pthread_mutex_unlock(&mutex)));
 
@@ -1029,5 +1214,28 @@ void Once::reset() {
 
 #endif
 
+// =======================================================================================
+// Lock profiler hooks (see lock-profiler.h)
+
+bool Mutex::lock(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLocationArg location) {
+  if (ZC_LIKELY(!isLockProfiling())) return lockImpl(exclusivity, timeout, location);
+
+  // Only take the time before waiting when the lock is actually contended, so that uncontended
+  // acquisitions cost one clock read (for the hold time) rather than two.
+  if (tryLock(exclusivity)) {
+    _::profileLockAcquired(this, exclusivity == EXCLUSIVE, location, zc::none, true);
+    return true;
+  }
+  TimePoint start = systemPreciseMonotonicClock().now();
+  bool acquired = lockImpl(exclusivity, timeout, location);
+  _::profileLockAcquired(this, exclusivity == EXCLUSIVE, location, start, acquired);
+  return acquired;
+}
+
+void Mutex::unlock(Exclusivity exclusivity, Waiter* waiterToSkip) {
+  if (ZC_UNLIKELY(isLockProfiling())) _::profileLockReleased(this, exclusivity == EXCLUSIVE);
+  unlockImpl(exclusivity, waiterToSkip);
+}
+
 }  // namespace _
 }  // namespace zc
@@ -49,8 +49,30 @@ namespace zc {
 
 class Exception;
 
+#if ZC_SAVE_LOCK_LOCATIONS
+// Every lock call records where it came from, for the lock profiler (see lock-profiler.h).
+using LockSourceLocation = SourceLocation;
+using LockSourceLocationArg = const SourceLocation&;
+#else
 using LockSourceLocation = NoopSourceLocation;
 using LockSourceLocationArg = NoopSourceLocation;
+#endif
+
+enum class MutexPolicy : uint8_t {
+  // Who goes first when both readers and writers are waiting for a MutexGuarded.
+
+  PREFER_READERS,
+  // New readers may join the readers already holding the lock even if a writer is waiting. This
+  // gives the best read throughput, but a steady stream of overlapping readers can keep writers
+  // out indefinitely.
+
+  PREFER_WRITERS
+  // Once a writer is waiting, new readers wait for it too, so writers get in as soon as the
+  // current readers finish. Use this when writes must not starve, e.g. a cache that is read
+  // constantly but must still be refreshed.
+  //
+  // Only implemented on Linux. Elsewhere, the platform's reader/writer lock decides.
+};
 
 // =======================================================================================
 // Private details -- public interfaces follow below.
@@ -62,7 +84,7 @@ class Mutex {
   struct Waiter;
 
 public:
-  Mutex();
+  explicit Mutex(MutexPolicy policy = MutexPolicy::PREFER_READERS);
   ~Mutex();
   ZC_DISALLOW_COPY_AND_MOVE(Mutex);
 
@@ -104,18 +126,32 @@ private:
 #if ZC_USE_FUTEX
   uint futex;
   // bit 31 (msb) = set if exclusive lock held
-  // bit 30 (msb) = set if threads are waiting for exclusive lock
-  // bits 0-29 = count of readers; If an exclusive lock is held, this is the count of threads
+  // bit 30 = set if threads are waiting for exclusive lock
+  // bit 29 = set if threads are waiting for a read lock without being counted below (only with
+  //   MutexPolicy::PREFER_WRITERS, while a writer waits for the current readers to finish)
+  // bits 0-28 = count of readers; If an exclusive lock is held, this is the count of threads
   //   waiting for a read lock, otherwise it is the count of threads that currently hold a read
   //   lock.
 
+  uint16_t spinEstimate = 0;
+  // Running average of how long lock() had to spin before a contended lock came free. Sets how
+  // long to spin next time before going to sleep. Updated without synchronization; it is only a
+  // hint.
+
+  MutexPolicy policy;
+
 #ifdef ZC_CONTENTION_WARNING_THRESHOLD
   bool printContendedReader = false;
 #endif
 
   static constexpr uint EXCLUSIVE_HELD = 1u << 31;
   static constexpr uint EXCLUSIVE_REQUESTED = 1u << 30;
-  static constexpr uint SHARED_COUNT_MASK = EXCLUSIVE_REQUESTED - 1;
+  static constexpr uint SHARED_BLOCKED = 1u << 29;
+  static constexpr uint SHARED_COUNT_MASK = SHARED_BLOCKED - 1;
+
+  template <typename Func>
+  bool spin(Func&& tryAcquire);
+  void readersDrained(uint state);
 
 #elif _WIN32 || __CYGWIN__
   uintptr_t srwLock;  // Actually an SRWLOCK, but don't want to #include <windows.h> in header.
@@ -148,6 +184,11 @@ private:
   zc::Maybe<Waiter&>* waitersTail = &waitersHead;
   // linked list of waiters; can only modify under lock
 
+  bool tryLock(Exclusivity exclusivity);
+  bool lockImpl(Exclusivity exclusivity, Maybe<Duration> timeout, LockSourceLocationArg location);
+  void unlockImpl(Exclusivity exclusivity, Waiter* waiterToSkip);
+  // The platform-specific parts of lock() and unlock(), which wrap them for the lock profiler.
+
   inline void addWaiter(Waiter& waiter);
   inline void removeWaiter(Waiter& waiter);
   bool checkPredicate(Waiter& waiter);
@@ -319,6 +360,11 @@ public:
   explicit MutexGuarded(Params&&... params);
   // Initialize the mutex-bounded object by passing the given parameters to its constructor.
 
+  template <typename... Params>
+  explicit MutexGuarded(MutexPolicy policy, Params&&... params);
+  // Like the above, but choosing whether waiting readers or writers go first. The default is
+  // MutexPolicy::PREFER_READERS.
+
   Locked<T> lockExclusive(LockSourceLocationArg location = {}) const;
   // Exclusively locks the object and returns it.  The returned `Locked<T>` can be passed by
   // move, similar to `Own<T>`.
@@ -516,6 +562,11 @@ template <typename T>
 template <typename... Params>
 inline MutexGuarded<T>::MutexGuarded(Params&&... params) : value(zc::fwd<Params>(params)...) {}
 
+template <typename T>
+template <typename... Params>
+inline MutexGuarded<T>::MutexGuarded(MutexPolicy policy, Params&&... params)
+    : mutex(policy), value(zc::fwd<Params>(params)...) {}
+
 template <typename T>
 inline Locked<T> MutexGuarded<T>::lockExclusive(LockSourceLocationArg location) const {
   mutex.lock(_::Mutex::EXCLUSIVE, zc::none, location);
@@ -0,0 +1,275 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32 || __CYGWIN__
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/rcu.h"
+
+#include <stdint.h>
+
+#include "zc/core/debug.h"
+#include "zc/core/thread-record.h"
+
+#if _WIN32 || __CYGWIN__
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace zc {
+
+namespace {
+
+// Each thread that reads has a ThreadRecord, on a global list that the thread advancing the epoch
+// scans. `epoch` is 0 while the thread is not reading (and is not online), and otherwise the
+// global epoch as of when it started reading, or of its last quiescent point.
+//
+// A version retired while the global epoch is E may still be in use by threads that announced
+// E or earlier, but not by threads that announce E + 1 or later, since they read the global
+// epoch after the version was unlinked. The epoch only advances from E to E + 1 once every
+// thread that is reading has announced E, so once it reaches E + 2 nobody can be using the
+// version any more.
+
+struct alignas(64) ThreadRecord {
+  // Aligned so that threads announcing their epochs don't write to each other's cache lines.
+
+  uint64_t epoch;
+  // Written by the owning thread, read by threads advancing the global epoch.
+
+  ThreadRecord* next;
+  bool inUse;
+  // See ThreadRecordList.
+
+  // Only accessed by the owning thread.
+  uint nesting;
+  bool online;
+  uint quiescentCount;
+};
+
+struct Retired {
+  Retired* next;
+  uint64_t epoch;
+  Own<const void> version;
+};
+
+uint64_t globalEpoch = 1;
+_::ThreadRecordList<ThreadRecord> records;
+
+Retired* retired = nullptr;
+// Versions waiting to be destroyed, as a lock-free stack.
+
+uint64_t retiredCount = 0;
+
+bool reclaiming = false;
+// Set while a thread is destroying retired versions, so that only one does at a time.
+
+constexpr uint RECLAIM_INTERVAL = 64;
+// While versions are waiting to be destroyed, an online thread tries to destroy them every this
+// many quiescent points. Each try scans every thread's record.
+
+void goOffline(ThreadRecord& record) {
+  record.nesting = 0;
+  record.online = false;
+  __atomic_store_n(&record.epoch, uint64_t(0), __ATOMIC_RELEASE);
+}
+
+thread_local _::ThreadRecordHolder<ThreadRecord, records, goOffline> threadRecord;
+
+inline ThreadRecord& getRecord() {
+  ThreadRecord* record = threadRecord.get();
+  if (ZC_UNLIKELY(record == nullptr)) {
+    // Reading from a thread-local destructor after the thread released its record. The record
+    // claimed here is never released, which only costs one record.
+    record = threadRecord.record = &records.claim();
+  }
+  return *record;
+}
+
+void announce(ThreadRecord& record) {
+  // Starts reading: announce the current epoch before loading any pointers. The fence orders the
+  // store before those loads, and pairs with the one in tryAdvance(): either the thread advancing
+  // the epoch sees our announcement, or we see the new pointers that were published before it
+  // looked.
+  __atomic_store_n(&record.epoch, __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST),
+                   __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+bool tryAdvance() {
+  // Advances the global epoch if every thread that is reading has caught up with it.
+  uint64_t epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  for (auto record = records.first(); record != nullptr; record = record->next) {
+    uint64_t announced = __atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST);
+    if (announced != 0 && announced != epoch) return false;
+  }
+  __atomic_compare_exchange_n(&globalEpoch, &epoch, epoch + 1, false, __ATOMIC_SEQ_CST,
+                              __ATOMIC_SEQ_CST);
+  return true;
+}
+
+void reclaim() {
+  // Destroys the retired versions that are old enough, and puts the rest back. The caller must
+  // have set `reclaiming`.
+
+  tryAdvance();
+  uint64_t epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+
+  Retired* list = __atomic_exchange_n(&retired, nullptr, __ATOMIC_ACQUIRE);
+  Retired* keep = nullptr;
+  Retired** keepTail = &keep;
+  uint64_t destroyed = 0;
+  while (list != nullptr) {
+    Retired* item = list;
+    list = item->next;
+    if (item->epoch + 2 <= epoch) {
+      delete item;
+      ++destroyed;
+    } else {
+      *keepTail = item;
+      keepTail = &item->next;
+    }
+  }
+
+  if (keep != nullptr) {
+    *keepTail = __atomic_load_n(&retired, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&retired, keepTail, keep, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {}
+  }
+  __atomic_sub_fetch(&retiredCount, destroyed, __ATOMIC_RELAXED);
+}
+
+bool tryReclaim() {
+  // Reclaims unless another thread already is. Returns whether it did.
+  if (__atomic_load_n(&reclaiming, __ATOMIC_RELAXED) ||
+      __atomic_exchange_n(&reclaiming, true, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  ZC_DEFER(__atomic_store_n(&reclaiming, false, __ATOMIC_RELEASE));
+  reclaim();
+  return true;
+}
+
+void backOff(uint attempt) {
+  if (attempt < 100) {
+#if _WIN32 || __CYGWIN__
+    Sleep(0);
+#else
+    sched_yield();
+#endif
+  } else {
+#if _WIN32 || __CYGWIN__
+    Sleep(1);
+#else
+    usleep(1000);
+#endif
+  }
+}
+
+}  // namespace
+
+namespace _ {  // private
+
+void rcuReadLock() {
+  ThreadRecord& record = getRecord();
+  if (record.nesting++ == 0 && !record.online) announce(record);
+}
+
+void rcuReadUnlock() {
+  ThreadRecord& record = getRecord();
+  ZC_DASSERT(record.nesting > 0, "RcuPtr released more often than taken");
+  if (--record.nesting == 0 && !record.online) {
+    __atomic_store_n(&record.epoch, uint64_t(0), __ATOMIC_RELEASE);
+  }
+}
+
+void rcuRetire(Own<const void> version) {
+  auto item = new Retired{nullptr, __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST),
+                          zc::mv(version)};
+  item->next = __atomic_load_n(&retired, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&retired, &item->next, item, true, __ATOMIC_RELEASE,
+                                      __ATOMIC_RELAXED)) {}
+  __atomic_add_fetch(&retiredCount, 1, __ATOMIC_RELAXED);
+
+  // Most versions retired by earlier writes are probably old enough by now.
+  tryReclaim();
+}
+
+}  // namespace _
+
+void rcuSynchronize() {
+  ThreadRecord& record = getRecord();
+  ZC_REQUIRE(record.nesting == 0, "rcuSynchronize() called while holding an RcuPtr");
+
+  // Don't wait for ourselves.
+  bool wasOnline = record.online;
+  if (wasOnline) rcuThreadOffline();
+  ZC_DEFER(if (wasOnline) rcuThreadOnline());
+
+  uint64_t target = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) + 2;
+  for (uint attempt = 0; __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST) < target; attempt++) {
+    if (!tryAdvance()) backOff(attempt);
+  }
+
+  // Another thread may be reclaiming right now; once it is done, the next pass will find
+  // everything retired before we were called old enough.
+  for (uint attempt = 0; !tryReclaim(); attempt++) { backOff(attempt); }
+}
+
+void rcuThreadOnline() {
+  ThreadRecord& record = getRecord();
+  if (record.online) return;
+  record.online = true;
+  if (record.nesting == 0) announce(record);
+}
+
+void rcuThreadOffline() {
+  ThreadRecord& record = getRecord();
+  if (!record.online) return;
+  record.online = false;
+  if (record.nesting == 0) __atomic_store_n(&record.epoch, uint64_t(0), __ATOMIC_RELEASE);
+}
+
+void rcuQuiescentState() {
+  ThreadRecord* recordPtr = threadRecord.record;
+  if (recordPtr == nullptr) return;
+  ThreadRecord& record = *recordPtr;
+  if (!record.online || record.nesting > 0) return;
+
+  // A plain store is enough here: anything we read from now on is read after the load of the
+  // global epoch, so is at least as new as the epoch we announce.
+  uint64_t epoch = __atomic_load_n(&globalEpoch, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&record.epoch, __ATOMIC_RELAXED) != epoch) {
+    __atomic_store_n(&record.epoch, epoch, __ATOMIC_RELEASE);
+  } else if (__atomic_load_n(&retiredCount, __ATOMIC_RELAXED) > 0 &&
+             ++record.quiescentCount % RECLAIM_INTERVAL == 0) {
+    // Versions are waiting, perhaps only for threads that have caught up since the last writer
+    // tried to destroy them.
+    tryReclaim();
+  }
+}
+
+}  // namespace zc
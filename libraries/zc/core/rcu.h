@@ -0,0 +1,211 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+
+#include "zc/core/memory.h"
+#include "zc/core/mutex.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+
+// =======================================================================================
+// Read-copy-update
+//
+// Rcu<T> holds read-mostly data shared between threads, such as a routing table or a
+// configuration. Readers get the current version without taking a lock or touching a refcount;
+// writers replace the whole version, and the old one is destroyed once no reader can still be
+// looking at it.
+//
+// This is epoch-based reclamation. There is a global epoch, and each thread announces the epoch
+// it last saw while it is reading. A retired version is destroyed once the global epoch has
+// advanced twice since it was retired, which can only happen after every thread that was reading
+// at the time has stopped. Reads are wait-free and only write to the reading thread's own cache
+// line, so they scale with the number of cores.
+//
+// Threads that run an EventLoop take part more cheaply: each turn of the loop is a quiescent
+// point, at which the thread announces that it holds no references from before. Reads from event
+// callbacks then need no stores or fences at all. The thread only counts as reading while the loop
+// is running events, so it does not hold reclamation back while the loop sleeps waiting for
+// events, or while the thread is doing anything else.
+//
+// Retired versions are destroyed by whichever thread next finds that enough time has passed:
+// a writer publishing another version, an event loop thread between turns, or rcuSynchronize().
+// Their destructors may therefore run on any thread.
+
+template <typename T>
+class RcuPtr;
+
+template <typename T>
+class Rcu {
+  // A T that can be read from any thread without locking, and replaced as a whole.
+
+public:
+  template <typename... Params>
+  explicit Rcu(Params&&... params);
+  // Constructs the first version of the value from the given parameters.
+
+  ~Rcu() noexcept(false) = default;
+  // Destroys the current version at once. There must be no RcuPtr left pointing at it.
+
+  ZC_DISALLOW_COPY_AND_MOVE(Rcu);
+
+  RcuPtr<T> read() const;
+  // Returns the current version. It stays valid, and unchanged, for as long as the RcuPtr lives,
+  // even if a new version is published meanwhile. Holding an RcuPtr delays the destruction of all
+  // retired versions, of every Rcu, so keep it short: in particular, don't hold one while
+  // blocking.
+  //
+  // Like MutexGuarded, this is `const` because it is safe to call from multiple threads.
+
+  void publish(Own<const T> version) const;
+  // Makes `version` the current version. Readers that already have the previous one keep it;
+  // it is destroyed once they are done.
+
+  template <typename Func>
+  void update(Func&& func) const;
+  // Copies the current version, calls `func(T& copy)`, and publishes the copy. Updates are
+  // serialized with each other and with publish(), so concurrent updates are not lost. Requires T
+  // to be copyable.
+
+private:
+  mutable const T* current;
+  // Read with atomic loads. Points at `*latest`.
+
+  MutexGuarded<Own<const T>> latest;
+  // Owns the current version, and serializes writers.
+
+  void publishLocked(Locked<Own<const T>>& lock, Own<const T> version) const;
+};
+
+template <typename T>
+class RcuPtr {
+  // A version of the value in an Rcu<T>, as returned by Rcu<T>::read(). Like Locked<T>, it can be
+  // moved but not copied, and must be destroyed on the thread that created it.
+
+public:
+  ZC_DISALLOW_COPY(RcuPtr);
+  inline RcuPtr() : ptr(nullptr) {}
+  inline RcuPtr(RcuPtr&& other) : ptr(other.ptr) { other.ptr = nullptr; }
+  inline ~RcuPtr() { release(); }
+
+  inline RcuPtr& operator=(RcuPtr&& other) {
+    release();
+    ptr = other.ptr;
+    other.ptr = nullptr;
+    return *this;
+  }
+
+  inline void release();
+
+  inline const T* operator->() const { return ptr; }
+  inline const T& operator*() const { return *ptr; }
+  inline const T* get() const { return ptr; }
+  inline operator const T*() const { return ptr; }
+
+private:
+  const T* ptr;
+
+  inline explicit RcuPtr(const T* ptr) : ptr(ptr) {}
+
+  template <typename U>
+  friend class Rcu;
+};
+
+void rcuSynchronize();
+// Waits until every thread that might still be reading a version retired before this call has
+// stopped, then destroys those versions. Must not be called while the calling thread holds an
+// RcuPtr, or it would wait for itself.
+
+void rcuThreadOnline();
+void rcuThreadOffline();
+void rcuQuiescentState();
+// For event loops. EventLoop calls these itself; other code should only need them if it
+// implements its own loop.
+//
+// An online thread is treated as reading at all times, except at quiescent points, where it
+// announces that it holds no references obtained before that point. Reads on an online thread
+// are therefore free, but the thread holds reclamation back until its next quiescent point, so
+// it should go offline before blocking. Going online or offline twice in a row does nothing.
+
+// =======================================================================================
+// inline implementation details
+
+namespace _ {  // private
+
+void rcuReadLock();
+void rcuReadUnlock();
+// Enter and leave a read-side critical section. These nest.
+
+void rcuRetire(Own<const void> version);
+// Destroys `version` once no thread can still be reading it.
+
+}  // namespace _
+
+template <typename T>
+template <typename... Params>
+inline Rcu<T>::Rcu(Params&&... params) : latest(heap<T>(zc::fwd<Params>(params)...)) {
+  current = latest.getWithoutLock().get();
+}
+
+template <typename T>
+RcuPtr<T> Rcu<T>::read() const {
+  _::rcuReadLock();
+  return RcuPtr<T>(__atomic_load_n(&current, __ATOMIC_SEQ_CST));
+}
+
+template <typename T>
+void Rcu<T>::publish(Own<const T> version) const {
+  auto lock = latest.lockExclusive();
+  publishLocked(lock, zc::mv(version));
+}
+
+template <typename T>
+template <typename Func>
+void Rcu<T>::update(Func&& func) const {
+  auto lock = latest.lockExclusive();
+  auto copy = heap<T>(**lock);
+  func(*copy);
+  publishLocked(lock, zc::mv(copy));
+}
+
+template <typename T>
+void Rcu<T>::publishLocked(Locked<Own<const T>>& lock, Own<const T> version) const {
+  ZC_IREQUIRE(version.get() != nullptr, "can't publish a null version");
+  Own<const T> old = zc::mv(*lock);
+  *lock = zc::mv(version);
+  __atomic_store_n(&current, lock->get(), __ATOMIC_SEQ_CST);
+  lock.release();
+  _::rcuRetire(zc::mv(old));
+}
+
+template <typename T>
+inline void RcuPtr<T>::release() {
+  if (ptr != nullptr) {
+    ptr = nullptr;
+    _::rcuReadUnlock();
+  }
+}
+
+}  // namespace zc
+
+ZC_END_HEADER
@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <charconv>
+
 #include "zc/core/debug.h"
 #if !defined(_WIN32)
 #include <string.h>
@@ -35,83 +37,76 @@
 namespace zc {
 
 namespace {
-bool isHex(const char* s) {
-  if (*s == '-') s++;
-  return s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
-}
 
-long long parseSigned(const StringPtr& s, long long min, long long max) {
-  ZC_REQUIRE(s != nullptr, "String does not contain valid number", s) { return 0; }
-  char* endPtr;
-  errno = 0;
-  auto value = strtoll(s.begin(), &endPtr, isHex(s.cStr()) ? 16 : 10);
-  ZC_REQUIRE(endPtr == s.end(), "String does not contain valid number", s) { return 0; }
-  ZC_REQUIRE(errno != ERANGE, "Value out-of-range", s) { return 0; }
-  ZC_REQUIRE(value >= min && value <= max, "Value out-of-range", value, min, max) { return 0; }
-  return value;
+enum class ParseStatus { OK, INVALID, OUT_OF_RANGE };
+
+inline bool isSpace(char c) {
+  // What isspace() matches in the "C" locale, which is all strtol() and strtod() skip in practice.
+  return c == ' ' || ('\t' <= c && c <= '\r');
 }
 
-Maybe<long long> tryParseSigned(const StringPtr& s, long long min, long long max) {
-  if (s == nullptr) { return zc::none; }  // String does not contain valid number.
-  char* endPtr;
-  errno = 0;
-  auto value = strtoll(s.begin(), &endPtr, isHex(s.cStr()) ? 16 : 10);
-  if (endPtr != s.end() || errno == ERANGE || value < min || max < value) { return zc::none; }
-  return value;
+const char* skipSpaces(ArrayPtr<const char> text) {
+  const char* p = text.begin();
+  while (p < text.end() && isSpace(*p)) ++p;
+  return p;
 }
 
-unsigned long long parseUnsigned(const StringPtr& s, unsigned long long max) {
-  ZC_REQUIRE(s != nullptr, "String does not contain valid number", s) { return 0; }
-  char* endPtr;
-  errno = 0;
-  auto value = strtoull(s.begin(), &endPtr, isHex(s.cStr()) ? 16 : 10);
-  ZC_REQUIRE(endPtr == s.end(), "String does not contain valid number", s) { return 0; }
-  ZC_REQUIRE(errno != ERANGE, "Value out-of-range", s) { return 0; }
-  ZC_REQUIRE(value <= max, "Value out-of-range", value, max) { return 0; }
-  // strtoull("-1") does not fail with ERANGE
-  ZC_REQUIRE(s[0] != '-', "Value out-of-range", s) { return 0; }
-  return value;
-}
-
-Maybe<unsigned long long> tryParseUnsigned(const StringPtr& s, unsigned long long max) {
-  if (s == nullptr) { return zc::none; }  // String does not contain valid number.
-  char* endPtr;
-  errno = 0;
-  auto value = strtoull(s.begin(), &endPtr, isHex(s.cStr()) ? 16 : 10);
-  if (endPtr != s.end() || errno == ERANGE || max < value || s[0] == '-') { return zc::none; }
-  return value;
+inline bool isHexPrefix(const char* p, const char* end) {
+  return end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X');
 }
 
 template <typename T>
-T parseInteger(const StringPtr& s) {
-  if (static_cast<T>(minValue) < 0) {
-    long long min = static_cast<T>(minValue);
-    long long max = static_cast<T>(maxValue);
-    return static_cast<T>(parseSigned(s, min, max));
-  } else {
-    unsigned long long max = static_cast<T>(maxValue);
-    return static_cast<T>(parseUnsigned(s, max));
+ParseStatus parseInteger(ArrayPtr<const char> text, T& result) {
+  // Accepts what strtoll() and strtoull() do with base 0, except that a leading "0" does not mean
+  // octal: leading whitespace, an optional sign, then either decimal digits or "0x" and hex
+  // digits. All of the text must be consumed.
+  const char* p = skipSpaces(text);
+  const char* end = text.end();
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+  int base = 10;
+  if (isHexPrefix(p, end)) {
+    base = 16;
+    p += 2;
   }
-}
 
-template <typename T>
-Maybe<T> tryParseInteger(const StringPtr& s) {
+  unsigned long long magnitude;
+  auto parsed = std::from_chars(p, end, magnitude, base);
+  if (parsed.ptr == p || parsed.ptr != end) return ParseStatus::INVALID;
+  if (parsed.ec == std::errc::result_out_of_range) return ParseStatus::OUT_OF_RANGE;
+
   if (static_cast<T>(minValue) < 0) {
-    long long min = static_cast<T>(minValue);
-    long long max = static_cast<T>(maxValue);
-    return static_cast<Maybe<T>>(tryParseSigned(s, min, max));
+    unsigned long long max = static_cast<T>(maxValue);
+    // The magnitude of the most negative value is one more than the most positive value.
+    if (magnitude > max + negative) return ParseStatus::OUT_OF_RANGE;
+    result = static_cast<T>(negative ? 0 - magnitude : magnitude);
   } else {
+    // Like strtoull(), but without wrapping around: "-1" is out of range, and so is "-0".
     unsigned long long max = static_cast<T>(maxValue);
-    return static_cast<Maybe<T>>(tryParseUnsigned(s, max));
+    if (negative || magnitude > max) return ParseStatus::OUT_OF_RANGE;
+    result = static_cast<T>(magnitude);
   }
+  return ParseStatus::OK;
 }
 
 }  // namespace
 
-#define PARSE_AS_INTEGER(T)         \
-  template <>                       \
-  T StringPtr::parseAs<T>() const { \
-    return parseInteger<T>(*this);  \
+#define PARSE_AS_INTEGER(T)                                                                   \
+  template <>                                                                                 \
+  T parseAs<T>(ArrayPtr<const char> text) {                                                   \
+    T result = 0;                                                                             \
+    auto status = parseInteger(text, result);                                                 \
+    ZC_REQUIRE(status != ParseStatus::INVALID, "String does not contain valid number", text) { \
+      return 0;                                                                               \
+    }                                                                                         \
+    ZC_REQUIRE(status != ParseStatus::OUT_OF_RANGE, "Value out-of-range", text) { return 0; }  \
+    return result;                                                                            \
+  }                                                                                           \
+  template <>                                                                                 \
+  Maybe<T> tryParseAs<T>(ArrayPtr<const char> text) {                                         \
+    T result = 0;                                                                             \
+    if (parseInteger(text, result) != ParseStatus::OK) return zc::none;                       \
+    return result;                                                                            \
   }
 PARSE_AS_INTEGER(char);
 PARSE_AS_INTEGER(signed char);
@@ -126,24 +121,6 @@ PARSE_AS_INTEGER(long long);
 PARSE_AS_INTEGER(unsigned long long);
 #undef PARSE_AS_INTEGER
 
-#define TRY_PARSE_AS_INTEGER(T)               \
-  template <>                                 \
-  Maybe<T> StringPtr::tryParseAs<T>() const { \
-    return tryParseInteger<T>(*this);         \
-  }
-TRY_PARSE_AS_INTEGER(char);
-TRY_PARSE_AS_INTEGER(signed char);
-TRY_PARSE_AS_INTEGER(unsigned char);
-TRY_PARSE_AS_INTEGER(short);
-TRY_PARSE_AS_INTEGER(unsigned short);
-TRY_PARSE_AS_INTEGER(int);
-TRY_PARSE_AS_INTEGER(unsigned int);
-TRY_PARSE_AS_INTEGER(long);
-TRY_PARSE_AS_INTEGER(unsigned long);
-TRY_PARSE_AS_INTEGER(long long);
-TRY_PARSE_AS_INTEGER(unsigned long long);
-#undef TRY_PARSE_AS_INTEGER
-
 String heapString(size_t size) {
   char* buffer = _::HeapArrayDisposer::allocate<char>(size + 1);
   buffer[size] = '\0';
@@ -157,6 +134,83 @@ String heapString(const char* value, size_t size) {
   return String(buffer, size, _::HeapArrayDisposer::instance);
 }
 
+namespace {
+
+class SharedStringDisposer final : public ArrayDisposer {
+  // Disposes of the reference-counted buffers made by sharedString(). The characters are preceded
+  // by a Header in the same allocation.
+
+public:
+  static const SharedStringDisposer instance;
+
+  struct Header {
+    uint refcount;
+  };
+
+  static inline Header& header(const char* chars) {
+    return *reinterpret_cast<Header*>(const_cast<char*>(chars) - sizeof(Header));
+  }
+
+protected:
+  void disposeImpl(void* firstElement, size_t elementSize, size_t elementCount, size_t capacity,
+                   void (*destroyElement)(void*)) const override {
+    Header& h = header(reinterpret_cast<const char*>(firstElement));
+    if (__atomic_sub_fetch(&h.refcount, 1, __ATOMIC_ACQ_REL) == 0) { operator delete(&h); }
+  }
+};
+
+const SharedStringDisposer SharedStringDisposer::instance = SharedStringDisposer();
+
+}  // namespace
+
+ConstString sharedString(StringPtr value) {
+  using Header = SharedStringDisposer::Header;
+  Header* header = reinterpret_cast<Header*>(operator new(sizeof(Header) + value.size() + 1));
+  header->refcount = 1;
+  char* chars = reinterpret_cast<char*>(header + 1);
+  if (value.size() != 0u) { memcpy(chars, value.begin(), value.size()); }
+  chars[value.size()] = '\0';
+  return ConstString(chars, value.size(), SharedStringDisposer::instance);
+}
+
+ConstString ConstString::share() {
+  if (content == nullptr) return nullptr;
+
+  auto disposer = content.getDisposer();
+  if (disposer == &NullArrayDisposer::instance) {
+    // A literal, or at least something whose owner outlives us all.
+    return ConstString(content.begin(), size(), NullArrayDisposer::instance);
+  }
+  if (disposer != &SharedStringDisposer::instance) *this = sharedString(*this);
+
+  __atomic_add_fetch(&SharedStringDisposer::header(content.begin()).refcount, 1, __ATOMIC_RELAXED);
+  return ConstString(content.begin(), size(), SharedStringDisposer::instance);
+}
+
+SmallString::SmallString(StringPtr value) : SmallString(ofSize(value.size())) {
+  if (value.size() != 0u) { memcpy(begin(), value.begin(), value.size()); }
+}
+
+SmallString::SmallString(String&& value) : inlineSize(HEAP) {
+  ctor(heapChars, value.releaseArray());
+  if (heapChars == nullptr) {
+    // A null String has no buffer at all.
+    clear();
+  }
+}
+
+SmallString SmallString::ofSize(size_t size) {
+  SmallString result;
+  if (size <= INLINE_CAPACITY) {
+    result.inlineSize = size;
+    result.inlineChars[size] = '\0';
+  } else {
+    ctor(result.heapChars, heapString(size).releaseArray());
+    result.inlineSize = HEAP;
+  }
+  return result;
+}
+
 template <typename T>
 static CappedArray<char, sizeof(T) * 2 + 1> hexImpl(T i) {
   // We don't use sprintf() because it's not async-signal-safe (for strPreallocated()).
@@ -249,6 +303,159 @@ CappedArray<char, sizeof(const void*) * 2 + 1> Stringifier::operator*(const void
 
 namespace {
 
+// In practice, doubles should never need more than 24 bytes and floats
+// should never need more than 14 (including null terminators), but we
+// overestimate to be safe.
+static const int kDoubleToBufferSize = 32;
+static const int kFloatToBufferSize = 24;
+
+#if __cpp_lib_to_chars >= 201611L
+// std::to_chars() produces the shortest digits that parse back to the same value (libstdc++ and
+// MSVC implement it with Ryu), and std::from_chars() rounds correctly, taking the Eisel-Lemire
+// fast path for all but a few inputs. Neither depends on the C locale, allocates, or needs a NUL
+// terminator.
+
+template <size_t size, typename T>
+CappedArray<char, size> formatFloat(T value, int minPrecision) {
+  // Lays out the shortest round-trip digits the way printf("%.*g") would with `minPrecision`, or
+  // more if more digits are needed: plain decimal notation for decimal exponents from -4 up to
+  // the precision, scientific notation otherwise. The exponent has no "+" and at least two digits,
+  // e.g. "1e15" or "1e-05".
+  CappedArray<char, size> result;
+  char* out = result.begin();
+  auto append = [&](StringPtr text) {
+    memcpy(out, text.begin(), text.size());
+    out += text.size();
+  };
+
+  if (isNaN(value)) {
+    append("nan");
+  } else if (value == inf()) {
+    append("inf");
+  } else if (value == -inf()) {
+    append("-inf");
+  } else {
+    // Something like "-1.2345e+17".
+    char scientific[32];
+    auto printed = std::to_chars(scientific, scientific + sizeof(scientific), value,
+                                 std::chars_format::scientific);
+    ZC_DASSERT(printed.ec == std::errc());
+
+    const char* p = scientific;
+    if (*p == '-') *out++ = *p++;
+    char digits[20];
+    int digitCount = 0;
+    for (; *p != 'e'; ++p) {
+      if (*p != '.') digits[digitCount++] = *p;
+    }
+    ++p;
+    bool negativeExponent = *p++ == '-';
+    int exponent = 0;
+    for (; p < printed.ptr; ++p) exponent = exponent * 10 + (*p - '0');
+    if (negativeExponent) exponent = -exponent;
+
+    auto appendDigits = [&](int from, int to) {
+      for (int i = from; i < to; i++) *out++ = digits[i];
+    };
+    if (exponent >= -4 && exponent < zc::max(minPrecision, digitCount)) {
+      if (exponent < 0) {
+        append("0.");
+        for (int i = exponent + 1; i < 0; i++) *out++ = '0';
+        appendDigits(0, digitCount);
+      } else {
+        int integerDigits = exponent + 1;
+        appendDigits(0, zc::min(integerDigits, digitCount));
+        for (int i = digitCount; i < integerDigits; i++) *out++ = '0';
+        if (digitCount > integerDigits) {
+          *out++ = '.';
+          appendDigits(integerDigits, digitCount);
+        }
+      }
+    } else {
+      *out++ = digits[0];
+      if (digitCount > 1) {
+        *out++ = '.';
+        appendDigits(1, digitCount);
+      }
+      *out++ = 'e';
+      if (exponent < 0) {
+        *out++ = '-';
+        exponent = -exponent;
+      }
+      if (exponent < 10) *out++ = '0';
+      out = std::to_chars(out, result.begin() + size, exponent).ptr;
+    }
+  }
+
+  result.setSize(out - result.begin());
+  return result;
+}
+
+inline bool isHexDigit(char c) {
+  return ('0' <= c && c <= '9') || ('a' <= (c | 0x20) && (c | 0x20) <= 'f');
+}
+
+bool overflowsToInfinity(const char* p, const char* end, std::chars_format format) {
+  // std::from_chars() reports a value that is out of range without producing anything, whereas
+  // strtod() returns infinity on overflow and zero on underflow. Tell the two apart by where the
+  // first significant digit lies relative to the radix point, adjusted by the exponent.
+  bool hex = format == std::chars_format::hex;
+  char exponentMark = hex ? 'p' : 'e';
+  long long magnitude = 0;
+  bool seenPoint = false;
+  bool seenDigit = false;
+  for (; p < end && (*p | 0x20) != exponentMark; ++p) {
+    if (*p == '.') {
+      seenPoint = true;
+    } else if (seenDigit || *p != '0') {
+      seenDigit = true;
+      if (!seenPoint) ++magnitude;
+    } else if (seenPoint) {
+      --magnitude;
+    }
+  }
+
+  long long exponent = 0;
+  if (p < end) {
+    ++p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '+' || *p == '-')) ++p;
+    for (; p < end && exponent < 1000000000; ++p) exponent = exponent * 10 + (*p - '0');
+    if (negative) exponent = -exponent;
+  }
+  return (hex ? magnitude * 4 : magnitude) + exponent > 0;
+}
+
+template <typename T>
+ParseStatus parseFloat(ArrayPtr<const char> text, T& result) {
+  // Accepts what strtod() does in the "C" locale: leading whitespace, an optional sign, then a
+  // decimal or "0x"-prefixed hex number, "inf", "infinity", or "nan", ignoring case.
+  const char* p = skipSpaces(text);
+  const char* end = text.end();
+  bool negative = false;
+  if (p < end && (*p == '+' || *p == '-')) negative = *p++ == '-';
+
+  // std::from_chars() accepts a "-" of its own, and wants hex without the "0x".
+  if (p < end && *p == '-') return ParseStatus::INVALID;
+  auto format = std::chars_format::general;
+  if (isHexPrefix(p, end) && (isHexDigit(p[2]) || p[2] == '.')) {
+    format = std::chars_format::hex;
+    p += 2;
+  }
+
+  T value;
+  auto parsed = std::from_chars(p, end, value, format);
+  if (parsed.ptr == p || parsed.ptr != end) return ParseStatus::INVALID;
+  if (parsed.ec == std::errc::result_out_of_range) {
+    value = overflowsToInfinity(p, end, format) ? T(inf()) : T(0);
+  }
+  result = negative ? -value : value;
+  return ParseStatus::OK;
+}
+
+#else  // __cpp_lib_to_chars
+// Without floating-point <charconv>, fall back to printf() and strtod().
+
 // ----------------------------------------------------------------------
 // DoubleToBuffer()
 // FloatToBuffer()
@@ -323,12 +530,6 @@ inline bool IsNaN(double value) {
   return value != value;
 }
 
-// In practice, doubles should never need more than 24 bytes and floats
-// should never need more than 14 (including null terminators), but we
-// overestimate to be safe.
-static const int kDoubleToBufferSize = 32;
-static const int kFloatToBufferSize = 24;
-
 static inline bool IsValidFloatChar(char c) {
   return ('0' <= c && c <= '9') || c == 'e' || c == 'E' || c == '+' || c == '-';
 }
@@ -560,26 +761,25 @@ double NoLocaleStrtod(const char* text, char** original_endptr) {
 // End of code copied from Protobuf
 // ----------------------------------------------------------------------
 
-}  // namespace
-
-CappedArray<char, kFloatToBufferSize> Stringifier::operator*(float f) const {
-  CappedArray<char, kFloatToBufferSize> result;
-  result.setSize(strlen(FloatToBuffer(f, result.begin())));
-  return result;
-}
-
-CappedArray<char, kDoubleToBufferSize> Stringifier::operator*(double f) const {
-  CappedArray<char, kDoubleToBufferSize> result;
-  result.setSize(strlen(DoubleToBuffer(f, result.begin())));
+template <size_t size, typename T>
+CappedArray<char, size> formatFloat(T value, int minPrecision) {
+  CappedArray<char, size> result;
+  if constexpr (sizeof(T) == sizeof(float)) {
+    FloatToBuffer(value, result.begin());
+  } else {
+    DoubleToBuffer(value, result.begin());
+  }
+  result.setSize(strlen(result.begin()));
   return result;
 }
 
-double parseDouble(const StringPtr& s) {
-  ZC_REQUIRE(s != nullptr, "String does not contain valid number", s) { return 0; }
+template <typename T>
+ParseStatus parseFloat(ArrayPtr<const char> text, T& result) {
+  if (text.size() == 0) return ParseStatus::INVALID;
+  auto terminated = heapString(text);
   char* endPtr;
-  errno = 0;
-  auto value = _::NoLocaleStrtod(s.begin(), &endPtr);
-  ZC_REQUIRE(endPtr == s.end(), "String does not contain valid floating number", s) { return 0; }
+  double value = NoLocaleStrtod(terminated.begin(), &endPtr);
+  if (endPtr != terminated.end()) return ParseStatus::INVALID;
 #if _WIN32 || __CYGWIN__ || __BIONIC__
   // When Windows' strtod() parses "nan", it returns a value with the sign bit set. But, our
   // preferred canonical value for NaN does not have the sign bit set, and all other platforms
@@ -592,46 +792,46 @@ double parseDouble(const StringPtr& s) {
   //
   // Bionic (Android) failed the unit test and so I added it to the list without investigating
   // further.
-  if (isNaN(value)) {
-    // NaN
-    return zc::nan();
-  }
+  if (isNaN(value)) { value = zc::nan(); }
 #endif
-  return value;
+  result = value;
+  return ParseStatus::OK;
 }
 
-Maybe<double> tryParseDouble(const StringPtr& s) {
-  if (s == nullptr) { return zc::none; }
-  char* endPtr;
-  errno = 0;
-  auto value = _::NoLocaleStrtod(s.begin(), &endPtr);
-  if (endPtr != s.end()) { return zc::none; }
-#if _WIN32 || __CYGWIN__ || __BIONIC__
-  if (isNaN(value)) { return zc::nan(); }
-#endif
-  return value;
-}
+#endif  // __cpp_lib_to_chars, else
 
-}  // namespace _
+}  // namespace
 
-template <>
-double StringPtr::parseAs<double>() const {
-  return _::parseDouble(*this);
-}
-template <>
-float StringPtr::parseAs<float>() const {
-  return _::parseDouble(*this);
+CappedArray<char, kFloatToBufferSize> Stringifier::operator*(float f) const {
+  return formatFloat<kFloatToBufferSize>(f, FLT_DIG);
 }
 
-template <>
-Maybe<double> StringPtr::tryParseAs<double>() const {
-  return _::tryParseDouble(*this);
-}
-template <>
-Maybe<float> StringPtr::tryParseAs<float>() const {
-  return _::tryParseDouble(*this);
+CappedArray<char, kDoubleToBufferSize> Stringifier::operator*(double f) const {
+  return formatFloat<kDoubleToBufferSize>(f, DBL_DIG);
 }
 
+}  // namespace _
+
+#define PARSE_AS_FLOAT(T)                                                                     \
+  template <>                                                                                 \
+  T parseAs<T>(ArrayPtr<const char> text) {                                                   \
+    T result = 0;                                                                             \
+    ZC_REQUIRE(_::parseFloat(text, result) == ParseStatus::OK,                                \
+               "String does not contain valid floating number", text) {                       \
+      return 0;                                                                               \
+    }                                                                                         \
+    return result;                                                                            \
+  }                                                                                           \
+  template <>                                                                                 \
+  Maybe<T> tryParseAs<T>(ArrayPtr<const char> text) {                                         \
+    T result = 0;                                                                             \
+    if (_::parseFloat(text, result) != ParseStatus::OK) return zc::none;                      \
+    return result;                                                                            \
+  }
+PARSE_AS_FLOAT(float);
+PARSE_AS_FLOAT(double);
+#undef PARSE_AS_FLOAT
+
 Maybe<size_t> StringPtr::find(const StringPtr& other) const {
   if (other.size() == 0) { return size_t(0); }
   if (size() == 0) { return zc::none; }
@@ -34,6 +34,7 @@ class StringPtr;
 class LiteralStringConst;
 class String;
 class ConstString;
+class SmallString;
 
 class StringTree;  // string-tree.h
 }  // namespace zc
@@ -64,6 +65,76 @@ namespace zc {
 #define ZC_COMPILER_SUPPORTS_STL_STRING_INTEROP 1
 #endif
 
+// =======================================================================================
+// Number parsing
+
+template <typename T>
+T parseAs(ArrayPtr<const char> text);
+// Parses `text` as a number of type T, which must be a built-in integer or floating-point type,
+// with the same syntax as StringPtr::parseAs(). The text does not need to be NUL-terminated, so
+// this works on a slice of a larger buffer, and the result never depends on the C locale.
+//
+// Floating-point text is converted with correct rounding, using std::from_chars() where the
+// standard library implements it for floating-point types.
+
+template <typename T>
+Maybe<T> tryParseAs(ArrayPtr<const char> text);
+// Same as parseAs(), but returns none instead of throwing.
+
+template <>
+char parseAs<char>(ArrayPtr<const char> text);
+template <>
+signed char parseAs<signed char>(ArrayPtr<const char> text);
+template <>
+unsigned char parseAs<unsigned char>(ArrayPtr<const char> text);
+template <>
+short parseAs<short>(ArrayPtr<const char> text);
+template <>
+unsigned short parseAs<unsigned short>(ArrayPtr<const char> text);
+template <>
+int parseAs<int>(ArrayPtr<const char> text);
+template <>
+unsigned parseAs<unsigned>(ArrayPtr<const char> text);
+template <>
+long parseAs<long>(ArrayPtr<const char> text);
+template <>
+unsigned long parseAs<unsigned long>(ArrayPtr<const char> text);
+template <>
+long long parseAs<long long>(ArrayPtr<const char> text);
+template <>
+unsigned long long parseAs<unsigned long long>(ArrayPtr<const char> text);
+template <>
+float parseAs<float>(ArrayPtr<const char> text);
+template <>
+double parseAs<double>(ArrayPtr<const char> text);
+
+template <>
+Maybe<char> tryParseAs<char>(ArrayPtr<const char> text);
+template <>
+Maybe<signed char> tryParseAs<signed char>(ArrayPtr<const char> text);
+template <>
+Maybe<unsigned char> tryParseAs<unsigned char>(ArrayPtr<const char> text);
+template <>
+Maybe<short> tryParseAs<short>(ArrayPtr<const char> text);
+template <>
+Maybe<unsigned short> tryParseAs<unsigned short>(ArrayPtr<const char> text);
+template <>
+Maybe<int> tryParseAs<int>(ArrayPtr<const char> text);
+template <>
+Maybe<unsigned> tryParseAs<unsigned>(ArrayPtr<const char> text);
+template <>
+Maybe<long> tryParseAs<long>(ArrayPtr<const char> text);
+template <>
+Maybe<unsigned long> tryParseAs<unsigned long>(ArrayPtr<const char> text);
+template <>
+Maybe<long long> tryParseAs<long long>(ArrayPtr<const char> text);
+template <>
+Maybe<unsigned long long> tryParseAs<unsigned long long>(ArrayPtr<const char> text);
+template <>
+Maybe<float> tryParseAs<float>(ArrayPtr<const char> text);
+template <>
+Maybe<double> tryParseAs<double>(ArrayPtr<const char> text);
+
 // =======================================================================================
 // StringPtr -- A NUL-terminated ArrayPtr<const char> containing UTF-8 text.
 //
@@ -85,6 +156,7 @@ public:
   inline constexpr StringPtr(String&& value ZC_LIFETIMEBOUND) : StringPtr(value) {}
   inline constexpr StringPtr(const String& value ZC_LIFETIMEBOUND);
   inline constexpr StringPtr(const ConstString& value ZC_LIFETIMEBOUND);
+  inline StringPtr(const SmallString& value ZC_LIFETIMEBOUND);
   StringPtr& operator=(String&& value) = delete;
   inline StringPtr& operator=(decltype(nullptr)) {
     content = ArrayPtr<const char>("", 1);
@@ -169,14 +241,18 @@ public:
   bool contains(const StringPtr& other) const { return find(other) != zc::none; }
 
   template <typename T>
-  T parseAs() const;
+  T parseAs() const {
+    return zc::parseAs<T>(asArray());
+  }
   // Parse string as template number type.
   // Integer numbers prefixed by "0x" and "0X" are parsed in base 16 (like strtoi with base 0).
   // Integer numbers prefixed by "0" are parsed in base 10 (unlike strtoi with base 0).
   // Overflowed integer numbers throw exception.
   // Overflowed floating numbers return inf.
   template <typename T>
-  Maybe<T> tryParseAs() const;
+  Maybe<T> tryParseAs() const {
+    return zc::tryParseAs<T>(asArray());
+  }
   // Same as parseAs, but rather than throwing an exception we return NULL.
 
   template <typename... Attachments>
@@ -201,60 +277,6 @@ private:
   friend class SourceLocation;
 };
 
-template <>
-char StringPtr::parseAs<char>() const;
-template <>
-signed char StringPtr::parseAs<signed char>() const;
-template <>
-unsigned char StringPtr::parseAs<unsigned char>() const;
-template <>
-short StringPtr::parseAs<short>() const;
-template <>
-unsigned short StringPtr::parseAs<unsigned short>() const;
-template <>
-int StringPtr::parseAs<int>() const;
-template <>
-unsigned StringPtr::parseAs<unsigned>() const;
-template <>
-long StringPtr::parseAs<long>() const;
-template <>
-unsigned long StringPtr::parseAs<unsigned long>() const;
-template <>
-long long StringPtr::parseAs<long long>() const;
-template <>
-unsigned long long StringPtr::parseAs<unsigned long long>() const;
-template <>
-float StringPtr::parseAs<float>() const;
-template <>
-double StringPtr::parseAs<double>() const;
-
-template <>
-Maybe<char> StringPtr::tryParseAs<char>() const;
-template <>
-Maybe<signed char> StringPtr::tryParseAs<signed char>() const;
-template <>
-Maybe<unsigned char> StringPtr::tryParseAs<unsigned char>() const;
-template <>
-Maybe<short> StringPtr::tryParseAs<short>() const;
-template <>
-Maybe<unsigned short> StringPtr::tryParseAs<unsigned short>() const;
-template <>
-Maybe<int> StringPtr::tryParseAs<int>() const;
-template <>
-Maybe<unsigned> StringPtr::tryParseAs<unsigned>() const;
-template <>
-Maybe<long> StringPtr::tryParseAs<long>() const;
-template <>
-Maybe<unsigned long> StringPtr::tryParseAs<unsigned long>() const;
-template <>
-Maybe<long long> StringPtr::tryParseAs<long long>() const;
-template <>
-Maybe<unsigned long long> StringPtr::tryParseAs<unsigned long long>() const;
-template <>
-Maybe<float> StringPtr::tryParseAs<float>() const;
-template <>
-Maybe<double> StringPtr::tryParseAs<double>() const;
-
 class LiteralStringConst : public StringPtr {
 public:
   inline operator ConstString() const;
@@ -428,6 +450,14 @@ public:
   // Disowns the backing array (which includes the NUL terminator) and returns it. The ConstString
   // value is clobbered (as if moved away).
 
+  ConstString share();
+  // Returns another ConstString with the same content, sharing this one's buffer instead of
+  // copying it. Unless the buffer is already reference-counted (because it came from
+  // sharedString() or an earlier share()), or isn't owned at all (as for a `_zcc` literal), the
+  // first call moves the content into a reference-counted buffer; after that, sharing only adds a
+  // reference. The buffer is immutable and its refcount atomic, so the copies may be passed to
+  // other threads.
+
   inline constexpr const char* cStr() const ZC_LIFETIMEBOUND;
 
   inline constexpr size_t size() const;
@@ -521,6 +551,149 @@ String heapString(const String& value);
 String heapString(ArrayPtr<const char> value);
 // Allocates a copy of the given value on the heap.
 
+ConstString sharedString(StringPtr value);
+// Copies `value` into a reference-counted buffer, so that ConstString::share() on the result
+// never copies again. Use for values that are created once and then handed to many owners, such
+// as header values copied from request to request.
+
+// =======================================================================================
+// SmallString -- A String that keeps short content inline.
+//
+// Content of up to INLINE_CAPACITY bytes is stored inside the SmallString itself, so creating,
+// copying into, or destroying one doesn't touch the heap. Longer content lives in a heap
+// Array<char>, just like a String's. Use it for values that are numerous and usually short, such
+// as identifiers, map keys, or header values.
+//
+// Unlike String, moving a SmallString moves short content to a new address. So a StringPtr into a
+// SmallString is invalidated when the SmallString is moved, not just when it is destroyed. Don't
+// use SmallString where pointers into a string must survive the string being moved into a
+// container.
+
+class SmallString {
+public:
+  static constexpr size_t INLINE_CAPACITY = 23;
+
+  inline SmallString() : inlineSize(0) { inlineChars[0] = '\0'; }
+  inline SmallString(decltype(nullptr)) : SmallString() {}
+  explicit SmallString(StringPtr value);
+  // Copies `value`, allocating only if it doesn't fit inline.
+  explicit SmallString(String&& value);
+  // Takes over the buffer of `value` without copying.
+  inline SmallString(SmallString&& other) noexcept : inlineSize(0) { moveFrom(other); }
+  inline ~SmallString() noexcept { clear(); }
+  ZC_DISALLOW_COPY(SmallString);
+
+  inline SmallString& operator=(SmallString&& other) {
+    if (this != &other) {
+      clear();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  static SmallString ofSize(size_t size);
+  // Like heapString(size_t): returns a string of the given size whose content is uninitialized,
+  // but which is NUL-terminated. Only allocates if `size` is over INLINE_CAPACITY.
+
+  inline bool isInline() const { return inlineSize != HEAP; }
+  // Whether the content is stored inline, rather than on the heap.
+
+  inline ArrayPtr<char> asArray() ZC_LIFETIMEBOUND { return arrayPtr(begin(), size()); }
+  inline ArrayPtr<const char> asArray() const ZC_LIFETIMEBOUND {
+    return arrayPtr(begin(), size());
+  }
+  inline ArrayPtr<byte> asBytes() ZC_LIFETIMEBOUND { return asArray().asBytes(); }
+  inline ArrayPtr<const byte> asBytes() const ZC_LIFETIMEBOUND { return asArray().asBytes(); }
+  // Result does not include NUL terminator.
+
+  inline StringPtr asPtr() const ZC_LIFETIMEBOUND { return StringPtr(*this); }
+
+  inline const char* cStr() const ZC_LIFETIMEBOUND { return begin(); }
+
+  inline size_t size() const { return isInline() ? inlineSize : heapChars.size() - 1; }
+  // Result does not include NUL terminator.
+
+  inline char operator[](size_t index) const { return begin()[index]; }
+  inline char& operator[](size_t index) ZC_LIFETIMEBOUND { return begin()[index]; }
+
+  inline char* begin() ZC_LIFETIMEBOUND { return isInline() ? inlineChars : heapChars.begin(); }
+  inline char* end() ZC_LIFETIMEBOUND { return begin() + size(); }
+  inline const char* begin() const ZC_LIFETIMEBOUND {
+    return isInline() ? inlineChars : heapChars.begin();
+  }
+  inline const char* end() const ZC_LIFETIMEBOUND { return begin() + size(); }
+
+  inline bool operator==(decltype(nullptr)) const { return size() == 0; }
+
+  inline bool operator==(const StringPtr& other) const { return asPtr() == other; }
+  inline bool operator<(const StringPtr& other) const { return asPtr() < other; }
+  inline bool operator>(const StringPtr& other) const { return asPtr() > other; }
+  inline bool operator<=(const StringPtr& other) const { return asPtr() <= other; }
+  inline bool operator>=(const StringPtr& other) const { return asPtr() >= other; }
+
+  inline bool operator==(const String& other) const { return asPtr() == StringPtr(other); }
+  inline bool operator==(const ConstString& other) const { return asPtr() == StringPtr(other); }
+  inline bool operator==(const SmallString& other) const { return asPtr() == other.asPtr(); }
+  inline bool operator<(const SmallString& other) const { return asPtr() < other.asPtr(); }
+  inline bool operator>(const SmallString& other) const { return asPtr() > other.asPtr(); }
+  inline bool operator<=(const SmallString& other) const { return asPtr() <= other.asPtr(); }
+  inline bool operator>=(const SmallString& other) const { return asPtr() >= other.asPtr(); }
+  // As with String, the overloads for specific string types avoid ambiguous comparisons in C++20.
+
+  inline bool startsWith(const StringPtr& other) const { return asArray().startsWith(other); }
+  inline bool endsWith(const StringPtr& other) const { return asArray().endsWith(other); }
+
+  Maybe<size_t> find(const StringPtr& other) const { return asPtr().find(other); }
+  bool contains(const StringPtr& other) const { return asPtr().contains(other); }
+
+  inline StringPtr slice(size_t start) const ZC_LIFETIMEBOUND { return asPtr().slice(start); }
+  inline ArrayPtr<const char> slice(size_t start, size_t end) const ZC_LIFETIMEBOUND {
+    return asPtr().slice(start, end);
+  }
+
+  inline Maybe<size_t> findFirst(char c) const { return asArray().findFirst(c); }
+  inline Maybe<size_t> findLast(char c) const { return asArray().findLast(c); }
+
+  template <typename T>
+  T parseAs() const {
+    return asPtr().parseAs<T>();
+  }
+  template <typename T>
+  Maybe<T> tryParseAs() const {
+    return asPtr().tryParseAs<T>();
+  }
+
+private:
+  static constexpr byte HEAP = 0xff;
+
+  union {
+    char inlineChars[INLINE_CAPACITY + 1];
+    Array<char> heapChars;
+    // Includes the NUL terminator.
+  };
+
+  byte inlineSize;
+  // Size of the inline content, or HEAP if the content is in `heapChars`.
+
+  inline void clear() {
+    if (!isInline()) dtor(heapChars);
+    inlineSize = 0;
+    inlineChars[0] = '\0';
+  }
+
+  inline void moveFrom(SmallString& other) {
+    // Requires that this string is empty and inline.
+    if (other.isInline()) {
+      memcpy(inlineChars, other.inlineChars, other.inlineSize + 1);
+      inlineSize = other.inlineSize;
+    } else {
+      ctor(heapChars, zc::mv(other.heapChars));
+      inlineSize = HEAP;
+    }
+    other.clear();
+  }
+};
+
 // =======================================================================================
 // Magic str() function which transforms parameters to text and concatenates them into one big
 // String.
@@ -564,6 +737,14 @@ String concat(Params&&... params) {
 
 inline String concat(String&& arr) { return zc::mv(arr); }
 
+template <typename... Params>
+SmallString smallConcat(Params&&... params) {
+  // Like concat(), but for smallStr().
+  SmallString result = SmallString::ofSize(sum({params.size()...}));
+  fill(result.begin(), zc::fwd<Params>(params)...);
+  return result;
+}
+
 template <typename First, typename... Rest>
 char* fillLimited(char* __restrict__ target, char* limit, const First& first, Rest&&... rest) {
   auto i = first.begin();
@@ -629,6 +810,9 @@ struct Stringifier {
   }
   inline ArrayPtr<const char> operator*(const StringPtr& s) const { return s.asArray(); }
   inline ArrayPtr<const char> operator*(const ConstString& s) const { return s.asArray(); }
+  inline ArrayPtr<const char> operator*(const SmallString& s) const ZC_LIFETIMEBOUND {
+    return s.asArray();
+  }
 
   inline Range<char> operator*(const Range<char>& r) const { return r; }
   inline Repeat<char> operator*(const Repeat<char>& r) const { return r; }
@@ -700,6 +884,15 @@ String str(Params&&... params) {
 inline String str(String&& s) { return mv(s); }
 // Overload to prevent redundant allocation.
 
+template <typename... Params>
+SmallString smallStr(Params&&... params) {
+  // Like str(), but returns a SmallString, so that no allocation is needed if the result is short.
+  //
+  //     SmallString key = smallStr("user:", id);
+
+  return _::smallConcat(toCharSequence(zc::fwd<Params>(params))...);
+}
+
 template <typename T>
 _::Delimited<T> delimited(T&& arr, zc::StringPtr delim);
 // Use to stringify an array.
@@ -781,6 +974,7 @@ inline constexpr StringPtr::StringPtr(const String& value)
     : content(value.cStr(), value.size() + 1) {}
 inline constexpr StringPtr::StringPtr(const ConstString& value)
     : content(value.cStr(), value.size() + 1) {}
+inline StringPtr::StringPtr(const SmallString& value) : content(value.cStr(), value.size() + 1) {}
 
 inline constexpr StringPtr::operator ArrayPtr<const char>() const {
   return ArrayPtr<const char>(content.begin(), content.size() - 1);
@@ -107,6 +107,41 @@ zc::Array<HashBucket> rehash(zc::ArrayPtr<const HashBucket> oldBuckets, size_t t
   return newBuckets;
 }
 
+size_t swissRehash(Array<byte>& ctrl, Array<SwissSlot>& slots, size_t targetSize) {
+  ZC_REQUIRE(targetSize < (1 << 30), "hash table has reached maximum size");
+
+  // Keep the load factor at most 7/8 and the slot count a power of two, so that triangular
+  // probing visits every group.
+  size_t size = SWISS_GROUP_SIZE;
+  while (size * 7 < targetSize * 8) { size *= 2; }
+  if (size < slots.size()) { size = slots.size(); }
+
+  auto newCtrl = zc::heapArray<byte>(size);
+  memset(newCtrl.begin(), SWISS_EMPTY, size);
+  auto newSlots = zc::heapArray<SwissSlot>(size);
+  size_t mask = size / SWISS_GROUP_SIZE - 1;
+
+  size_t entryCount = 0;
+  for (size_t i = 0; i < ctrl.size(); i++) {
+    if (ctrl[i] & 0x80) { continue; }
+    ++entryCount;
+    uint hash = slots[i].hash;
+    for (size_t group = hash & mask, step = 0;; group = (group + ++step) & mask) {
+      uint free = SwissGroup(newCtrl.begin() + group * SWISS_GROUP_SIZE).matchEmpty();
+      if (free != 0) {
+        size_t j = group * SWISS_GROUP_SIZE + lowestBit(free);
+        newCtrl[j] = swissTag(hash);
+        newSlots[j] = slots[i];
+        break;
+      }
+    }
+  }
+
+  ctrl = zc::mv(newCtrl);
+  slots = zc::mv(newSlots);
+  return entryCount;
+}
+
 // =======================================================================================
 // BTree
 
@@ -207,6 +242,18 @@ void BTreeImpl::logInconsistency() const {
       zc::getStackTrace());
 }
 
+void logIntTreeInconsistency() {
+  ZC_LOG(ERROR,
+         "IntTreeIndex could not find the row being removed. This can happen if you modify a "
+         "row's key after inserting it into a zc::Table. This is a serious bug which will lead "
+         "to undefined behavior.\nstack: ",
+         zc::getStackTrace());
+}
+
+void failIntTreeVerify(const char* problem) {
+  ZC_FAIL_ASSERT("IntTreeIndex is inconsistent", problem);
+}
+
 void BTreeImpl::reserve(size_t size) {
   ZC_REQUIRE(size < (1u << 31), "b-tree has reached maximum size");
 
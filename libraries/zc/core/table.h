@@ -31,6 +31,27 @@
 #include <intrin0.h>
 #endif
 
+#ifndef ZC_SWISS_TABLE_SSE2
+// SwissHashIndex compares control bytes with SSE2 when available. Define as 0 to force the scalar
+// implementation.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ZC_SWISS_TABLE_SSE2 1
+#else
+#define ZC_SWISS_TABLE_SSE2 0
+#endif
+#endif
+
+#if ZC_SWISS_TABLE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if __AVX2__ || __SSE4_2__
+// IntTreeIndex compares 64-bit keys with _mm256_cmpgt_epi64 / _mm_cmpgt_epi64.
+#include <immintrin.h>
+#endif
+
+#include <stdint.h>
+
 #if ZC_DEBUG_TABLE_IMPL
 #include "zc/core/debug.h"
 #define ZC_TABLE_IREQUIRE ZC_REQUIRE
@@ -344,6 +365,18 @@ class HashIndex;
 // If your `Callbacks` type has dynamic state, you may pass its constructor parameters as the
 // constructor parameters to `HashIndex`.
 
+template <typename Callbacks>
+class SwissHashIndex;
+// A drop-in alternative to HashIndex, with the same `Callbacks` interface, laid out like Abseil's
+// "Swiss tables".
+//
+// Slots are grouped sixteen at a time. Each slot has a one-byte control code in a separate array,
+// holding 7 bits of the hash when the slot is occupied, so a lookup compares a whole group's
+// control bytes in one go (with SSE2 where available) and only touches the slots whose tag
+// matches. This keeps lookups to about one cache line of metadata even at load factors up to 7/8,
+// where HashIndex's linear probing would walk long runs of buckets. Prefer it for large, busy
+// tables; HashIndex uses less memory per slot and is fine for small ones.
+
 template <typename Callbacks>
 class TreeIndex;
 // A Table index based on a B-tree.
@@ -369,6 +402,20 @@ class TreeIndex;
 //     // Returns true if the row "matches" the search params.
 //   };
 
+template <typename Callbacks, uint leafKeys, uint parentKeys>
+class SizedIntTreeIndex;
+template <typename Callbacks>
+using IntTreeIndex = SizedIntTreeIndex<Callbacks, 16, 16>;
+// A B-tree index, like TreeIndex, specialized for keys that are integers or enums. `Callbacks`
+// only needs `keyForRow()`; rows are ordered by their key, and keys must be unique.
+//
+// TreeIndex stores only row numbers and calls `isBefore()` on the table's rows at every step of
+// a search. IntTreeIndex instead copies each key into the tree as an int64_t, so a search only
+// reads its own nodes: each node is scanned for the first key not less than the target with a
+// handful of vector compares (AVX2 or SSE4.2 when the build enables them, branch-free scalar code
+// otherwise). Use SizedIntTreeIndex to choose the number of keys per leaf and per parent node;
+// both must be multiples of 4.
+
 // =======================================================================================
 // inline implementation details
 
@@ -1012,6 +1059,243 @@ private:
   }
 };
 
+// -----------------------------------------------------------------------------
+// Swiss hash table index
+
+namespace _ {  // private
+
+struct SwissSlot {
+  uint hash;
+  uint pos;
+};
+
+constexpr uint SWISS_GROUP_SIZE = 16;
+constexpr byte SWISS_EMPTY = 0x80;
+constexpr byte SWISS_DELETED = 0xfe;
+// Control bytes of occupied slots hold the top 7 bits of the hash, so only the free states have
+// the high bit set.
+
+inline byte swissTag(uint hash) { return hash >> 25; }
+
+inline uint lowestBit(uint mask) {
+  // Index of the lowest set bit. Undefined for mask = 0.
+#if _MSC_VER && !defined(__clang__)
+  unsigned long i;
+  _BitScanForward(&i, mask);
+  return i;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+class SwissGroup {
+  // The control bytes of one group of slots. Each match method returns a bitmask with bit i set
+  // if slot i of the group matches.
+
+public:
+#if ZC_SWISS_TABLE_SSE2
+  inline explicit SwissGroup(const byte* ctrl)
+      : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+  inline uint match(byte tag) const {
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(static_cast<char>(tag))));
+  }
+  inline uint matchEmpty() const { return match(SWISS_EMPTY); }
+  inline uint matchFree() const { return _mm_movemask_epi8(ctrl); }
+
+private:
+  __m128i ctrl;
+#else
+  // Eight control bytes per word, tested with the usual bit tricks.
+  inline explicit SwissGroup(const byte* ctrl) {
+    memcpy(words, ctrl, sizeof(words));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    words[0] = __builtin_bswap64(words[0]);
+    words[1] = __builtin_bswap64(words[1]);
+#endif
+  }
+
+  inline uint match(byte tag) const {
+    uint64_t pattern = LSBS * tag;
+    return toMask(zeroBytes(words[0] ^ pattern), zeroBytes(words[1] ^ pattern));
+  }
+  inline uint matchEmpty() const {
+    // EMPTY is the only free state with bit 1 clear.
+    return toMask(words[0] & ~(words[0] << 6) & MSBS, words[1] & ~(words[1] << 6) & MSBS);
+  }
+  inline uint matchFree() const { return toMask(words[0] & MSBS, words[1] & MSBS); }
+
+private:
+  static constexpr uint64_t LSBS = 0x0101010101010101ull;
+  static constexpr uint64_t MSBS = 0x8080808080808080ull;
+
+  uint64_t words[2];
+
+  static inline uint64_t zeroBytes(uint64_t x) {
+    // Sets the high bit of exactly the bytes of `x` that are zero.
+    return ~(((x & ~MSBS) + ~MSBS) | x | ~MSBS);
+  }
+  static inline uint toMask(uint64_t lo, uint64_t hi) { return gather(lo) | gather(hi) << 8; }
+  static inline uint gather(uint64_t highBits) {
+    // Packs the high bit of each byte into the low byte, without carries between them.
+    return ((highBits >> 7) * 0x0102040810204080ull) >> 56;
+  }
+#endif
+};
+
+size_t swissRehash(Array<byte>& ctrl, Array<SwissSlot>& slots, size_t targetSize);
+// Rebuilds the table with room for at least `targetSize` entries, dropping deleted slots. Never
+// shrinks it. Returns the number of entries.
+
+}  // namespace _
+
+template <typename Callbacks>
+class SwissHashIndex {
+public:
+  SwissHashIndex() = default;
+  template <typename... Params>
+  SwissHashIndex(Params&&... params) : cb(zc::fwd<Params>(params)...) {}
+
+  size_t capacity() {
+    // This method is for testing.
+    return slots.size();
+  }
+
+  void reserve(size_t size) {
+    if (slots.size() * 7 < size * 8) { rehash(size); }
+  }
+
+  void clear() {
+    usedCount = 0;
+    if (ctrl.size() > 0) memset(ctrl.begin(), _::SWISS_EMPTY, ctrl.size());
+  }
+
+  template <typename Row>
+  decltype(auto) keyForRow(Row&& row) const {
+    return cb.keyForRow(zc::fwd<Row>(row));
+  }
+
+  template <typename Row, typename... Params>
+  zc::Maybe<size_t> insert(zc::ArrayPtr<Row> table, size_t pos, Params&&... params) {
+    if (slots.size() * 7 < (usedCount + 1) * 8) {
+      // Occupied plus deleted slots would pass 7/8 of the table. Rehash to twice the live size, so
+      // that at least as many insertions again can happen before the next rehash. If there were a
+      // lot of erasures, this may not grow the table at all.
+      rehash((table.size() + 1) * 2);
+    }
+
+    uint hashCode = cb.hashCode(params...);
+    byte tag = _::swissTag(hashCode);
+    size_t freeSlot = slots.size();
+    for (Probe probe(hashCode, groupMask());; probe.next()) {
+      _::SwissGroup group(ctrl.begin() + probe.offset());
+      for (uint mask = group.match(tag); mask != 0; mask &= mask - 1) {
+        auto& slot = slots[probe.offset() + _::lowestBit(mask)];
+        if (slot.hash == hashCode && cb.matches(table[slot.pos], params...)) {
+          // duplicate row
+          return size_t(slot.pos);
+        }
+      }
+      if (freeSlot == slots.size()) {
+        // Remember the first free slot, but keep searching for duplicates until the probe
+        // sequence ends.
+        uint free = group.matchFree();
+        if (free != 0) { freeSlot = probe.offset() + _::lowestBit(free); }
+      }
+      if (group.matchEmpty() != 0) { break; }
+    }
+
+    if (ctrl[freeSlot] == _::SWISS_EMPTY) { ++usedCount; }
+    ctrl[freeSlot] = tag;
+    slots[freeSlot] = {hashCode, uint(pos)};
+    return zc::none;
+  }
+
+  template <typename Row, typename... Params>
+  void erase(zc::ArrayPtr<Row> table, size_t pos, Params&&... params) {
+    ZC_IF_SOME(i, findPos(pos, cb.hashCode(params...))) {
+      // A group that still has an empty slot never made any probe sequence continue past it, so
+      // the slot can go back to empty rather than leaving a tombstone.
+      _::SwissGroup group(ctrl.begin() + i / _::SWISS_GROUP_SIZE * _::SWISS_GROUP_SIZE);
+      if (group.matchEmpty() != 0) {
+        --usedCount;
+        ctrl[i] = _::SWISS_EMPTY;
+      } else {
+        ctrl[i] = _::SWISS_DELETED;
+      }
+    }
+  }
+
+  template <typename Row, typename... Params>
+  void move(zc::ArrayPtr<Row> table, size_t oldPos, size_t newPos, Params&&... params) {
+    ZC_IF_SOME(i, findPos(oldPos, cb.hashCode(params...))) { slots[i].pos = uint(newPos); }
+  }
+
+  template <typename Row, typename... Params>
+  Maybe<size_t> find(zc::ArrayPtr<Row> table, Params&&... params) const {
+    if (slots.size() == 0) return zc::none;
+
+    uint hashCode = cb.hashCode(params...);
+    byte tag = _::swissTag(hashCode);
+    for (Probe probe(hashCode, groupMask());; probe.next()) {
+      _::SwissGroup group(ctrl.begin() + probe.offset());
+      for (uint mask = group.match(tag); mask != 0; mask &= mask - 1) {
+        auto& slot = slots[probe.offset() + _::lowestBit(mask)];
+        if (slot.hash == hashCode && cb.matches(table[slot.pos], params...)) {
+          // found
+          return size_t(slot.pos);
+        }
+      }
+      if (group.matchEmpty() != 0) {
+        // not found.
+        return zc::none;
+      }
+    }
+  }
+
+  // No begin() nor end() because hash tables are not usefully ordered.
+
+private:
+  Callbacks cb;
+  size_t usedCount = 0;  // occupied plus deleted slots
+  Array<byte> ctrl;
+  Array<_::SwissSlot> slots;
+
+  class Probe {
+    // Visits groups in triangular-number order starting from the one picked by the low bits of
+    // the hash. With a power-of-two group count this reaches every group.
+  public:
+    inline Probe(uint hash, size_t mask) : group(hash & mask), mask(mask) {}
+    inline size_t offset() const { return group * _::SWISS_GROUP_SIZE; }
+    inline void next() { group = (group + ++step) & mask; }
+
+  private:
+    size_t group;
+    size_t mask;
+    size_t step = 0;
+  };
+
+  size_t groupMask() const { return slots.size() / _::SWISS_GROUP_SIZE - 1; }
+
+  Maybe<size_t> findPos(size_t pos, uint hashCode) {
+    byte tag = _::swissTag(hashCode);
+    for (Probe probe(hashCode, groupMask());; probe.next()) {
+      _::SwissGroup group(ctrl.begin() + probe.offset());
+      for (uint mask = group.match(tag); mask != 0; mask &= mask - 1) {
+        size_t i = probe.offset() + _::lowestBit(mask);
+        if (slots[i].pos == pos) { return i; }
+      }
+      if (group.matchEmpty() != 0) {
+        // can't find the slot, something is very wrong
+        _::logHashTableInconsistency();
+        return zc::none;
+      }
+    }
+  }
+
+  void rehash(size_t targetSize) { usedCount = _::swissRehash(ctrl, slots, targetSize); }
+};
+
 // -----------------------------------------------------------------------------
 // BTree index
 
@@ -1521,6 +1805,616 @@ private:
   }
 };
 
+// -----------------------------------------------------------------------------
+// Integer-keyed B-tree index
+
+namespace _ {  // private
+
+template <typename T>
+inline int64_t intTreeKey(T key) {
+  // Maps an integer (or enum) key to an int64_t with the same ordering.
+  if constexpr (__is_enum(T)) {
+    return intTreeKey(static_cast<__underlying_type(T)>(key));
+  } else {
+    static_assert(isIntegral<Decay<T>>() && sizeof(T) <= sizeof(int64_t),
+                  "IntTreeIndex keys must be integers or enums");
+    if constexpr (T(-1) < T(0) || sizeof(T) < sizeof(int64_t)) {
+      return static_cast<int64_t>(key);
+    } else {
+      // Unsigned 64-bit: flip the sign bit so that signed comparison gives unsigned ordering.
+      return static_cast<int64_t>(static_cast<uint64_t>(key) ^ (uint64_t(1) << 63));
+    }
+  }
+}
+
+template <uint n>
+inline uint countKeysBefore(const int64_t* keys, int64_t key) {
+  // Counts the elements of keys[0..n) that are less than `key`. Unused trailing slots hold
+  // INT64_MAX, so the count never includes them.
+#if __AVX2__
+  static_assert(n % 4 == 0);
+  __m256i k = _mm256_set1_epi64x(key);
+  uint count = 0;
+  for (uint i = 0; i < n; i += 4) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+    count += popCount(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v))));
+  }
+  return count;
+#elif __SSE4_2__
+  static_assert(n % 2 == 0);
+  __m128i k = _mm_set1_epi64x(key);
+  uint count = 0;
+  for (uint i = 0; i < n; i += 2) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+    count += popCount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, v))));
+  }
+  return count;
+#else
+  // Branch-free, so the compiler is free to vectorize it.
+  uint count = 0;
+  for (uint i = 0; i < n; i++) { count += keys[i] < key; }
+  return count;
+#endif
+}
+
+void logIntTreeInconsistency();
+ZC_NORETURN(void failIntTreeVerify(const char* problem));
+
+}  // namespace _
+
+template <typename Callbacks, uint leafKeys, uint parentKeys>
+class SizedIntTreeIndex {
+  static_assert(leafKeys >= 4 && leafKeys % 4 == 0, "leaf size must be a multiple of 4");
+  static_assert(parentKeys >= 4 && parentKeys % 4 == 0, "parent size must be a multiple of 4");
+
+  struct Leaf;
+
+public:
+  SizedIntTreeIndex() = default;
+  template <typename... Params>
+  SizedIntTreeIndex(Params&&... params) : cb(zc::fwd<Params>(params)...) {}
+
+  class Iterator {
+  public:
+    Iterator() = default;
+    Iterator(const Leaf* leaves, uint leaf, uint pos) : leaves(leaves), leaf(leaf), pos(pos) {}
+
+    size_t operator*() const {
+      ZC_TABLE_IREQUIRE(pos < leaves[leaf].size, "tried to dereference end() iterator");
+      return leaves[leaf].rows[pos];
+    }
+
+    inline Iterator& operator++() {
+      const Leaf& current = leaves[leaf];
+      ZC_TABLE_IREQUIRE(pos < current.size, "B-tree iterator overflow");
+      if (++pos == current.size && current.next != NONE) {
+        leaf = current.next;
+        pos = 0;
+      }
+      return *this;
+    }
+    inline Iterator operator++(int) {
+      Iterator other = *this;
+      ++*this;
+      return other;
+    }
+
+    inline Iterator& operator--() {
+      if (pos == 0) {
+        leaf = leaves[leaf].prev;
+        ZC_TABLE_IREQUIRE(leaf != NONE, "B-tree iterator underflow");
+        pos = leaves[leaf].size - 1;
+      } else {
+        --pos;
+      }
+      return *this;
+    }
+    inline Iterator operator--(int) {
+      Iterator other = *this;
+      --*this;
+      return other;
+    }
+
+    inline bool operator==(const Iterator& other) const {
+      return leaf == other.leaf && pos == other.pos;
+    }
+
+  private:
+    const Leaf* leaves = nullptr;
+    uint leaf = 0;
+    uint pos = 0;
+  };
+
+  template <typename Row>
+  void verify(zc::ArrayPtr<Row> table) {
+    if (root == NONE) {
+      if (table.size() != 0) { _::failIntTreeVerify("empty tree for non-empty table"); }
+      return;
+    }
+    if (verifyNode(table, root, height, INT64_MIN, INT64_MAX) != table.size()) {
+      _::failIntTreeVerify("tree size does not match table size");
+    }
+  }
+
+  void reserve(size_t size) {
+    leaves.reserve(size / (leafKeys / 2) + 1);
+    parents.reserve(size / (leafKeys / 2) / (parentKeys / 2) + 1);
+  }
+
+  void clear() {
+    leaves.clear();
+    parents.clear();
+    freeLeaves.clear();
+    freeParents.clear();
+    root = NONE;
+    height = 0;
+    firstLeaf = NONE;
+    lastLeaf = NONE;
+  }
+
+  inline Iterator begin() const {
+    if (root == NONE) return Iterator();
+    return Iterator(leaves.begin(), firstLeaf, 0);
+  }
+  inline Iterator end() const {
+    if (root == NONE) return Iterator();
+    return Iterator(leaves.begin(), lastLeaf, leaves[lastLeaf].size);
+  }
+
+  template <typename Row>
+  decltype(auto) keyForRow(Row&& row) const {
+    return cb.keyForRow(zc::fwd<Row>(row));
+  }
+
+  template <typename Row, typename Key>
+  zc::Maybe<size_t> insert(zc::ArrayPtr<Row> table, size_t pos, Key&& searchKey) {
+    int64_t key = toTreeKey<Row>(searchKey);
+    if (root == NONE) {
+      root = firstLeaf = lastLeaf = newLeaf();
+      height = 0;
+    }
+
+    PathEntry path[MAX_HEIGHT];
+    uint node = descend(key, path);
+    Leaf* leaf = &leaves[node];
+    uint i = _::countKeysBefore<leafKeys>(leaf->keys, key);
+    if (i < leaf->size && leaf->keys[i] == key) { return size_t(leaf->rows[i]); }
+
+    if (leaf->size < leafKeys) {
+      leaf->insert(i, key, pos);
+      return zc::none;
+    }
+
+    // Split the full leaf in half, put the new row on the correct side, and pass the first key of
+    // the right half up as the separator.
+    uint right = newLeaf();
+    leaf = &leaves[node];
+    Leaf& rightLeaf = leaves[right];
+    constexpr uint mid = leafKeys / 2;
+    for (uint j = mid; j < leafKeys; j++) {
+      rightLeaf.keys[j - mid] = leaf->keys[j];
+      rightLeaf.rows[j - mid] = leaf->rows[j];
+      leaf->keys[j] = INT64_MAX;
+    }
+    rightLeaf.size = leafKeys - mid;
+    leaf->size = mid;
+
+    rightLeaf.next = leaf->next;
+    rightLeaf.prev = node;
+    if (leaf->next == NONE) {
+      lastLeaf = right;
+    } else {
+      leaves[leaf->next].prev = right;
+    }
+    leaf->next = right;
+
+    if (i <= mid) {
+      leaf->insert(i, key, pos);
+    } else {
+      rightLeaf.insert(i - mid, key, pos);
+    }
+    insertIntoParent(path, height, rightLeaf.keys[0], right);
+    return zc::none;
+  }
+
+  template <typename Row, typename Key>
+  void erase(zc::ArrayPtr<Row> table, size_t pos, Key&& searchKey) {
+    PathEntry path[MAX_HEIGHT];
+    uint node;
+    ZC_IF_SOME(i, findInLeaf(toTreeKey<Row>(searchKey), pos, path, node)) {
+      leaves[node].erase(i);
+      rebalanceLeaf(path, node);
+    }
+  }
+
+  template <typename Row, typename Key>
+  void move(zc::ArrayPtr<Row> table, size_t oldPos, size_t newPos, Key&& searchKey) {
+    PathEntry path[MAX_HEIGHT];
+    uint node;
+    ZC_IF_SOME(i, findInLeaf(toTreeKey<Row>(searchKey), oldPos, path, node)) {
+      leaves[node].rows[i] = newPos;
+    }
+  }
+
+  template <typename Row, typename Key>
+  Maybe<size_t> find(zc::ArrayPtr<Row> table, Key&& searchKey) const {
+    if (root == NONE) return zc::none;
+    int64_t key = toTreeKey<Row>(searchKey);
+    const Leaf& leaf = leaves[descend(key)];
+    uint i = _::countKeysBefore<leafKeys>(leaf.keys, key);
+    if (i < leaf.size && leaf.keys[i] == key) { return size_t(leaf.rows[i]); }
+    return zc::none;
+  }
+
+  template <typename Row, typename Key>
+  Iterator seek(zc::ArrayPtr<Row> table, Key&& searchKey) const {
+    if (root == NONE) return Iterator();
+    int64_t key = toTreeKey<Row>(searchKey);
+    uint node = descend(key);
+    const Leaf& leaf = leaves[node];
+    uint i = _::countKeysBefore<leafKeys>(leaf.keys, key);
+    if (i == leaf.size && leaf.next != NONE) { return Iterator(leaves.begin(), leaf.next, 0); }
+    return Iterator(leaves.begin(), node, i);
+  }
+
+private:
+  static constexpr uint NONE = maxValue;
+  static constexpr uint MAX_HEIGHT = 32;
+  static constexpr uint MIN_LEAF_KEYS = leafKeys / 2;
+  static constexpr uint MIN_PARENT_KEYS = parentKeys / 2;
+
+  struct Leaf {
+    // Keys are kept inline, next to the rows they index, so searching a leaf never touches the
+    // table. Slots past `size` hold INT64_MAX.
+    int64_t keys[leafKeys];
+    uint rows[leafKeys];
+    uint size;
+    uint next;
+    uint prev;
+
+    void insert(uint i, int64_t key, size_t row) {
+      for (uint j = size; j > i; j--) {
+        keys[j] = keys[j - 1];
+        rows[j] = rows[j - 1];
+      }
+      keys[i] = key;
+      rows[i] = row;
+      ++size;
+    }
+
+    void erase(uint i) {
+      --size;
+      for (uint j = i; j < size; j++) {
+        keys[j] = keys[j + 1];
+        rows[j] = rows[j + 1];
+      }
+      keys[size] = INT64_MAX;
+    }
+  };
+
+  struct Parent {
+    // keys[i] separates children[i], whose keys are all less than it, from children[i + 1], whose
+    // keys are all greater or equal. Slots past `size` hold INT64_MAX.
+    int64_t keys[parentKeys];
+    uint children[parentKeys + 1];
+    uint size;
+
+    inline uint childFor(int64_t key) const {
+      // Index of the child that would contain `key`: the number of separators <= key.
+      if (key == INT64_MAX) return size;
+      return _::countKeysBefore<parentKeys>(keys, key + 1);
+    }
+
+    void insert(uint i, int64_t key, uint rightChild) {
+      for (uint j = size; j > i; j--) {
+        keys[j] = keys[j - 1];
+        children[j + 1] = children[j];
+      }
+      keys[i] = key;
+      children[i + 1] = rightChild;
+      ++size;
+    }
+
+    void erase(uint i) {
+      // Removes keys[i] and children[i + 1].
+      --size;
+      for (uint j = i; j < size; j++) {
+        keys[j] = keys[j + 1];
+        children[j + 1] = children[j + 2];
+      }
+      keys[size] = INT64_MAX;
+    }
+  };
+
+  struct PathEntry {
+    uint node;
+    uint child;
+  };
+
+  Callbacks cb;
+  Vector<Leaf> leaves;
+  Vector<Parent> parents;
+  Vector<uint> freeLeaves;
+  Vector<uint> freeParents;
+  uint root = NONE;
+  uint height = 0;  // number of parent levels above the leaves
+  uint firstLeaf = NONE;
+  uint lastLeaf = NONE;
+
+  uint newLeaf() {
+    uint result;
+    if (freeLeaves.size() > 0) {
+      result = freeLeaves.back();
+      freeLeaves.removeLast();
+    } else {
+      result = leaves.size();
+      leaves.add();
+    }
+    Leaf& leaf = leaves[result];
+    for (auto& key : leaf.keys) { key = INT64_MAX; }
+    leaf.size = 0;
+    leaf.next = NONE;
+    leaf.prev = NONE;
+    return result;
+  }
+
+  uint newParent() {
+    uint result;
+    if (freeParents.size() > 0) {
+      result = freeParents.back();
+      freeParents.removeLast();
+    } else {
+      result = parents.size();
+      parents.add();
+    }
+    Parent& parent = parents[result];
+    for (auto& key : parent.keys) { key = INT64_MAX; }
+    parent.size = 0;
+    return result;
+  }
+
+  template <typename Row, typename Key>
+  int64_t toTreeKey(Key& key) const {
+    // Converts a search key to the rows' key type first, so that, say, looking up a uint64_t in a
+    // tree of uint keys compares values rather than bit patterns.
+    using RowKey = Decay<decltype(cb.keyForRow(instance<Row&>()))>;
+    return _::intTreeKey(static_cast<RowKey>(key));
+  }
+
+  uint descend(int64_t key, PathEntry* path = nullptr) const {
+    uint node = root;
+    for (uint level = 0; level < height; level++) {
+      const Parent& parent = parents[node];
+      uint child = parent.childFor(key);
+      if (path != nullptr) { path[level] = {node, child}; }
+      node = parent.children[child];
+    }
+    return node;
+  }
+
+  Maybe<uint> findInLeaf(int64_t key, size_t pos, PathEntry* path, uint& node) {
+    // Finds the slot holding `key`, which must belong to row `pos`, and the leaf it is in.
+    if (root != NONE) {
+      node = descend(key, path);
+      const Leaf& leaf = leaves[node];
+      uint i = _::countKeysBefore<leafKeys>(leaf.keys, key);
+      if (i < leaf.size && leaf.keys[i] == key && leaf.rows[i] == pos) { return i; }
+    }
+    _::logIntTreeInconsistency();
+    return zc::none;
+  }
+
+  void insertIntoParent(PathEntry* path, uint level, int64_t key, uint rightChild) {
+    // `level` is the number of parents above the node that was split.
+    if (level == 0) {
+      uint newRoot = newParent();
+      Parent& parent = parents[newRoot];
+      parent.keys[0] = key;
+      parent.children[0] = root;
+      parent.children[1] = rightChild;
+      parent.size = 1;
+      root = newRoot;
+      ++height;
+      ZC_TABLE_IREQUIRE(height < MAX_HEIGHT, "b-tree has reached maximum height");
+      return;
+    }
+
+    PathEntry entry = path[level - 1];
+    if (parents[entry.node].size < parentKeys) {
+      parents[entry.node].insert(entry.child, key, rightChild);
+      return;
+    }
+
+    // Split the full parent. Lay out its keys and children with the new ones included, keep the
+    // lower half, move the upper half to a new node, and pass the middle key up.
+    int64_t keys[parentKeys + 1];
+    uint children[parentKeys + 2];
+    {
+      const Parent& parent = parents[entry.node];
+      for (uint j = 0, k = 0; j <= parentKeys; j++) {
+        keys[j] = j == entry.child ? key : parent.keys[k++];
+      }
+      for (uint j = 0, k = 0; j <= parentKeys + 1; j++) {
+        children[j] = j == entry.child + 1 ? rightChild : parent.children[k++];
+      }
+    }
+
+    uint right = newParent();
+    Parent& parent = parents[entry.node];
+    Parent& rightParent = parents[right];
+    constexpr uint mid = (parentKeys + 1) / 2;
+    for (uint j = 0; j < parentKeys; j++) { parent.keys[j] = j < mid ? keys[j] : INT64_MAX; }
+    for (uint j = 0; j <= mid; j++) { parent.children[j] = children[j]; }
+    parent.size = mid;
+    for (uint j = mid + 1; j <= parentKeys; j++) { rightParent.keys[j - mid - 1] = keys[j]; }
+    for (uint j = mid + 1; j <= parentKeys + 1; j++) {
+      rightParent.children[j - mid - 1] = children[j];
+    }
+    rightParent.size = parentKeys - mid;
+
+    insertIntoParent(path, level - 1, keys[mid], right);
+  }
+
+  void rebalanceLeaf(PathEntry* path, uint node) {
+    // A root leaf may shrink all the way to empty; it stays allocated for begin() and end().
+    if (height == 0 || leaves[node].size >= MIN_LEAF_KEYS) return;
+
+    PathEntry entry = path[height - 1];
+    Parent& parent = parents[entry.node];
+    Leaf& leaf = leaves[node];
+
+    if (entry.child < parent.size) {
+      Leaf& right = leaves[parent.children[entry.child + 1]];
+      if (right.size > MIN_LEAF_KEYS) {
+        // Borrow the right sibling's first row.
+        leaf.insert(leaf.size, right.keys[0], right.rows[0]);
+        right.erase(0);
+        parent.keys[entry.child] = right.keys[0];
+        return;
+      }
+    }
+    if (entry.child > 0) {
+      Leaf& left = leaves[parent.children[entry.child - 1]];
+      if (left.size > MIN_LEAF_KEYS) {
+        // Borrow the left sibling's last row.
+        leaf.insert(0, left.keys[left.size - 1], left.rows[left.size - 1]);
+        left.erase(left.size - 1);
+        parent.keys[entry.child - 1] = leaf.keys[0];
+        return;
+      }
+    }
+
+    // Neither sibling can spare a row, so merge with one of them.
+    if (entry.child < parent.size) {
+      mergeLeaves(node, parent.children[entry.child + 1]);
+      parent.erase(entry.child);
+    } else {
+      mergeLeaves(parent.children[entry.child - 1], node);
+      parent.erase(entry.child - 1);
+    }
+    rebalanceParent(path, height - 1);
+  }
+
+  void mergeLeaves(uint leftIndex, uint rightIndex) {
+    // Appends the right leaf to the left one and frees it.
+    Leaf& left = leaves[leftIndex];
+    Leaf& right = leaves[rightIndex];
+    for (uint j = 0; j < right.size; j++) { left.insert(left.size, right.keys[j], right.rows[j]); }
+    left.next = right.next;
+    if (right.next == NONE) {
+      lastLeaf = leftIndex;
+    } else {
+      leaves[right.next].prev = leftIndex;
+    }
+    freeLeaves.add(rightIndex);
+  }
+
+  void rebalanceParent(PathEntry* path, uint level) {
+    // `level` indexes `path`; 0 is the root.
+    uint node = path[level].node;
+    if (level == 0) {
+      if (parents[node].size == 0) {
+        // The root has a single child left; it becomes the root.
+        root = parents[node].children[0];
+        freeParents.add(node);
+        --height;
+      }
+      return;
+    }
+    if (parents[node].size >= MIN_PARENT_KEYS) return;
+
+    PathEntry entry = path[level - 1];
+    Parent& grandparent = parents[entry.node];
+    Parent& parent = parents[node];
+
+    if (entry.child < grandparent.size) {
+      Parent& right = parents[grandparent.children[entry.child + 1]];
+      if (right.size > MIN_PARENT_KEYS) {
+        // Rotate the right sibling's first child over, through the grandparent.
+        parent.keys[parent.size] = grandparent.keys[entry.child];
+        parent.children[parent.size + 1] = right.children[0];
+        ++parent.size;
+        grandparent.keys[entry.child] = right.keys[0];
+        right.children[0] = right.children[1];
+        right.erase(0);
+        return;
+      }
+    }
+    if (entry.child > 0) {
+      Parent& left = parents[grandparent.children[entry.child - 1]];
+      if (left.size > MIN_PARENT_KEYS) {
+        // Rotate the left sibling's last child over, through the grandparent.
+        for (uint j = parent.size; j > 0; j--) { parent.keys[j] = parent.keys[j - 1]; }
+        for (uint j = parent.size + 1; j > 0; j--) { parent.children[j] = parent.children[j - 1]; }
+        parent.keys[0] = grandparent.keys[entry.child - 1];
+        parent.children[0] = left.children[left.size];
+        ++parent.size;
+        grandparent.keys[entry.child - 1] = left.keys[left.size - 1];
+        left.keys[--left.size] = INT64_MAX;
+        return;
+      }
+    }
+
+    if (entry.child < grandparent.size) {
+      mergeParents(node, grandparent.keys[entry.child], grandparent.children[entry.child + 1]);
+      grandparent.erase(entry.child);
+    } else {
+      mergeParents(grandparent.children[entry.child - 1], grandparent.keys[entry.child - 1], node);
+      grandparent.erase(entry.child - 1);
+    }
+    rebalanceParent(path, level - 1);
+  }
+
+  void mergeParents(uint leftIndex, int64_t separator, uint rightIndex) {
+    // Appends the separator and the right parent's contents to the left parent and frees it.
+    Parent& left = parents[leftIndex];
+    Parent& right = parents[rightIndex];
+    left.keys[left.size] = separator;
+    for (uint j = 0; j < right.size; j++) { left.keys[left.size + 1 + j] = right.keys[j]; }
+    for (uint j = 0; j <= right.size; j++) { left.children[left.size + 1 + j] = right.children[j]; }
+    left.size += 1 + right.size;
+    freeParents.add(rightIndex);
+  }
+
+  template <typename Row>
+  size_t verifyNode(zc::ArrayPtr<Row> table, uint node, uint level, int64_t min, int64_t max) {
+    // Checks that every key under `node` is in [min, max) and returns how many rows it holds.
+    bool isRoot = node == root;
+    if (level == 0) {
+      const Leaf& leaf = leaves[node];
+      if (!isRoot && leaf.size < MIN_LEAF_KEYS) { _::failIntTreeVerify("leaf underflow"); }
+      for (uint i = 0; i < leafKeys; i++) {
+        if (i >= leaf.size) {
+          if (leaf.keys[i] != INT64_MAX) { _::failIntTreeVerify("leaf padding clobbered"); }
+          continue;
+        }
+        if (leaf.keys[i] < min || (leaf.keys[i] >= max && max != INT64_MAX)) {
+          _::failIntTreeVerify("leaf key out of range");
+        }
+        if (i > 0 && leaf.keys[i - 1] >= leaf.keys[i]) { _::failIntTreeVerify("leaf not sorted"); }
+        if (leaf.rows[i] >= table.size() ||
+            _::intTreeKey(cb.keyForRow(table[leaf.rows[i]])) != leaf.keys[i]) {
+          _::failIntTreeVerify("leaf key does not match row");
+        }
+      }
+      return leaf.size;
+    }
+
+    const Parent& parent = parents[node];
+    if (!isRoot && parent.size < MIN_PARENT_KEYS) { _::failIntTreeVerify("parent underflow"); }
+    size_t total = 0;
+    for (uint i = 0; i <= parent.size; i++) {
+      int64_t low = i == 0 ? min : parent.keys[i - 1];
+      int64_t high = i == parent.size ? max : parent.keys[i];
+      if (i < parent.size && i > 0 && parent.keys[i - 1] >= parent.keys[i]) {
+        _::failIntTreeVerify("parent not sorted");
+      }
+      total += verifyNode(table, parent.children[i], level - 1, low, high);
+    }
+    return total;
+  }
+};
+
 // -----------------------------------------------------------------------------
 // Insertion order index
 
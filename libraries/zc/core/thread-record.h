@@ -0,0 +1,107 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+// Per-thread records that other threads can scan. This header is internal to ZC.
+
+#include "zc/core/common.h"
+
+ZC_BEGIN_HEADER
+
+namespace zc {
+namespace _ {  // private
+
+template <typename Record>
+class ThreadRecordList {
+  // A list of per-thread records, such as counters, that any thread can walk without a lock. Each
+  // thread claims a record the first time it needs one and releases it when it exits, after which
+  // the next new thread reuses it. Records are never freed, so the list only ever grows at the
+  // head, and a record's `next` does not change once it is on the list.
+  //
+  // `Record` must have members `Record* next` and `bool inUse`, and its other members should be
+  // zero when value-initialized. Declare the list as a global, and each thread's handle on its
+  // record as a `thread_local ThreadRecordHolder`.
+
+public:
+  Record* first() const { return __atomic_load_n(&head, __ATOMIC_ACQUIRE); }
+  // The most recently added record. Follow `next` from here to visit every record, including the
+  // ones no thread owns at the moment.
+
+  Record& claim() {
+    for (Record* record = first(); record != nullptr; record = record->next) {
+      bool expected = false;
+      if (!__atomic_load_n(&record->inUse, __ATOMIC_RELAXED) &&
+          __atomic_compare_exchange_n(&record->inUse, &expected, true, false, __ATOMIC_ACQUIRE,
+                                      __ATOMIC_RELAXED)) {
+        return *record;
+      }
+    }
+
+    // Plain operator new, so that the size-class allocator can keep its thread caches here too.
+    auto record = new Record();
+    record->inUse = true;
+    record->next = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&head, &record->next, record, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {}
+    return *record;
+  }
+
+  static void release(Record& record) {
+    __atomic_store_n(&record.inUse, false, __ATOMIC_RELEASE);
+  }
+
+private:
+  Record* head = nullptr;
+};
+
+template <typename Record, ThreadRecordList<Record>& list, void (*onExit)(Record&) = nullptr>
+struct ThreadRecordHolder {
+  // Claims the thread's record from `list` on first use, and releases it when the thread exits,
+  // after calling `onExit` on it.
+
+  Record* record = nullptr;
+
+  bool exited = false;
+  // Set once the thread has released its record. Code that runs later during thread exit, such as
+  // other thread-locals' destructors, gets no record.
+
+  Record* get() {
+    if (ZC_UNLIKELY(record == nullptr)) {
+      if (exited) return nullptr;
+      record = &list.claim();
+    }
+    return record;
+  }
+
+  ~ThreadRecordHolder() noexcept {
+    if (record != nullptr) {
+      if constexpr (onExit != nullptr) onExit(*record);
+      ThreadRecordList<Record>::release(*record);
+      record = nullptr;
+    }
+    exited = true;
+  }
+};
+
+}  // namespace _
+}  // namespace zc
+
+ZC_END_HEADER
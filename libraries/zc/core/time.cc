@@ -33,6 +33,15 @@
 #include <time.h>
 #endif
 
+#if __linux__ && __x86_64__ && (__GNUC__ || __clang__)
+#define ZC_TSC_CLOCK 1
+#include <cpuid.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <x86intrin.h>
+#endif
+
 namespace zc {
 
 const Clock& nullClock() {
@@ -179,6 +188,9 @@ const MonotonicClock& systemPreciseMonotonicClock() {
   return clock;
 }
 
+const MonotonicClock& systemFastMonotonicClock() { return systemPreciseMonotonicClock(); }
+const Clock& systemFastCalendarClock() { return systemPreciseCalendarClock(); }
+
 #else
 
 namespace {
@@ -258,6 +270,300 @@ const MonotonicClock& systemPreciseMonotonicClock() {
   return clock;
 }
 
+#if ZC_TSC_CLOCK
+
+namespace {
+
+class TscClock {
+  // Reads CLOCK_MONOTONIC and CLOCK_REALTIME by scaling the timestamp counter.
+  //
+  // The current calibration lives in a seqlock: a writer makes `sequence` odd, updates the
+  // fields, then makes it even again, and readers retry if they saw it odd or changing. Readers
+  // never write shared memory, so the clock costs no cache-line traffic between threads.
+
+public:
+  TscClock() : enabled(isTscReliable()) {
+    if (enabled) {
+      Sample anchor = sample();
+      anchorTsc = anchor.tsc;
+      anchorNs = anchor.monotonicNs;
+      params.calendarOffsetNs = anchor.calendarNs - anchor.monotonicNs;
+    }
+  }
+
+  static TscClock& instance() {
+    static TscClock clock;
+    return clock;
+  }
+
+  const bool enabled;
+
+  struct Reading {
+    int64_t monotonicNs;
+    int64_t calendarOffsetNs;
+  };
+
+  Reading read() {
+    for (;;) {
+      Params params = load();
+      if (ZC_UNLIKELY(params.mult == 0)) {
+        // Not calibrated yet, or starting over. `ns` is then the latest time we may already have
+        // returned, and we don't go below it.
+        struct timespec monotonic;
+        clock_gettime(CLOCK_MONOTONIC, &monotonic);
+        int64_t sinceAnchor = toNs(monotonic) - __atomic_load_n(&anchorNs, __ATOMIC_RELAXED);
+        if (sinceAnchor >= MIN_CALIBRATION_NS && tryCalibrate(params)) continue;
+        return {zc::max(toNs(monotonic), params.ns), params.calendarOffsetNs};
+      }
+
+      uint64_t tsc = __rdtsc();
+      int64_t ticks = tsc - params.tsc;
+      if (ZC_UNLIKELY(ticks < 0)) {
+        // Another core's counter may lag a hair behind the one that took the calibration sample.
+        // Much more than that means the counter was reset, so start over.
+        if (uint64_t(-ticks) > params.period / (PERIOD_NS / MAX_SKEW_NS) &&
+            tryCalibrate(params)) {
+          continue;
+        }
+        ticks = 0;
+      }
+      if (ZC_UNLIKELY(uint64_t(ticks) >= params.period)) {
+        if (tryCalibrate(params)) continue;
+        // Another thread is recalibrating. Don't run past the end of the period: calibrate()
+        // assumes nothing later was returned.
+        ticks = params.period;
+      }
+      return {extrapolate(params, ticks), params.calendarOffsetNs};
+    }
+  }
+
+private:
+  static constexpr int64_t MIN_CALIBRATION_NS = 10'000'000;
+  // How long to measure the counter's rate before trusting it. Until then, reads take the precise
+  // clock.
+
+  static constexpr int64_t PERIOD_NS = 1'000'000'000;
+  // How often to recalibrate.
+
+  static constexpr int64_t MAX_SLEW_NS = 10'000'000;
+  // Largest error to absorb by slewing over one period (1%). An error beyond this, with the clock
+  // behind, is corrected by stepping forward instead.
+
+  static constexpr int64_t MAX_ERROR_NS = 1'000'000'000;
+  // An error beyond this means the counter and the kernel disagree about something big, such as a
+  // suspend, so we start over.
+
+  static constexpr int64_t MAX_SKEW_NS = 1'000'000;
+  // How far behind the calibration sample a core's counter may read before we take it to have
+  // been reset.
+
+  struct Params {
+    uint64_t tsc;
+    int64_t ns;
+    // Monotonic time at `tsc`.
+
+    uint64_t mult;
+    // Nanoseconds per tick, as 32.32 fixed point, or zero if not calibrated yet.
+
+    uint64_t period;
+    // Ticks after `tsc` at which to recalibrate.
+
+    int64_t calendarOffsetNs;
+    // Calendar time minus monotonic time.
+
+    uint sequence;
+    // The seqlock's sequence number when these were loaded.
+  };
+
+  struct Sample {
+    uint64_t tsc;
+    int64_t monotonicNs;
+    int64_t calendarNs;
+  };
+
+  uint sequence = 0;
+  Params params = {};
+
+  bool calibrating = false;
+  uint64_t anchorTsc = 0;
+  int64_t anchorNs = 0;
+  // First sample, or the last one before we started over. The counter's rate is measured from here,
+  // so the measurement grows more precise with time. Protected by `calibrating`.
+
+  int64_t lastSampleNs = 0;
+  // Precise monotonic time of the sample the current parameters were computed from. Protected by
+  // `calibrating`.
+
+  Params load() const {
+    for (;;) {
+      uint seq = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+      Params result;
+      result.tsc = __atomic_load_n(&params.tsc, __ATOMIC_RELAXED);
+      result.ns = __atomic_load_n(&params.ns, __ATOMIC_RELAXED);
+      result.mult = __atomic_load_n(&params.mult, __ATOMIC_RELAXED);
+      result.period = __atomic_load_n(&params.period, __ATOMIC_RELAXED);
+      result.calendarOffsetNs = __atomic_load_n(&params.calendarOffsetNs, __ATOMIC_RELAXED);
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      result.sequence = seq;
+      if ((seq & 1) == 0 && __atomic_load_n(&sequence, __ATOMIC_RELAXED) == seq) return result;
+    }
+  }
+
+  void store(const Params& newParams) {
+    __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&params.tsc, newParams.tsc, __ATOMIC_RELAXED);
+    __atomic_store_n(&params.ns, newParams.ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&params.mult, newParams.mult, __ATOMIC_RELAXED);
+    __atomic_store_n(&params.period, newParams.period, __ATOMIC_RELAXED);
+    __atomic_store_n(&params.calendarOffsetNs, newParams.calendarOffsetNs, __ATOMIC_RELAXED);
+    __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELEASE);
+  }
+
+  static int64_t extrapolate(const Params& params, uint64_t ticks) {
+    return params.ns + int64_t((unsigned __int128)ticks * params.mult >> 32);
+  }
+
+  static int64_t toNs(const struct timespec& ts) {
+    return int64_t(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+  }
+
+  static Sample sample() {
+    // Reads the clocks between two reads of the counter, keeping the tightest of a few tries.
+    Sample best;
+    uint64_t bestWidth = zc::maxValue;
+    for (uint i ZC_UNUSED : zc::zeroTo(4)) {
+      struct timespec monotonic, calendar;
+      uint64_t before = __rdtsc();
+      clock_gettime(CLOCK_MONOTONIC, &monotonic);
+      clock_gettime(CLOCK_REALTIME, &calendar);
+      uint64_t after = __rdtsc();
+      if (after - before < bestWidth) {
+        bestWidth = after - before;
+        best = {before + (after - before) / 2, toNs(monotonic), toNs(calendar)};
+      }
+    }
+    return best;
+  }
+
+  bool tryCalibrate(const Params& old) {
+    // Returns true if the parameters changed, either here or on another thread.
+    if (__atomic_exchange_n(&calibrating, true, __ATOMIC_ACQUIRE)) return false;
+    ZC_DEFER(__atomic_store_n(&calibrating, false, __ATOMIC_RELEASE));
+    if (__atomic_load_n(&sequence, __ATOMIC_RELAXED) != old.sequence) return true;
+    calibrate(old, sample());
+    return true;
+  }
+
+  void calibrate(const Params& old, const Sample& now) {
+    if (int64_t(now.tsc - old.tsc) < 0 || int64_t(now.tsc - anchorTsc) < 0) {
+      // The counter was reset, so we can't tell where the current calibration puts `now`. The
+      // clock runs at most MAX_SLEW_NS per PERIOD_NS faster than the precise clock, plus whatever
+      // error the rate has, so bound what it returned since by twice that.
+      int64_t floor = old.ns;
+      if (old.mult != 0) {
+        int64_t sinceSample = now.monotonicNs - lastSampleNs;
+        floor = zc::min(old.ns + sinceSample + sinceSample / (PERIOD_NS / MAX_SLEW_NS / 2),
+                        extrapolate(old, old.period));
+      }
+      restart(now, floor);
+      return;
+    }
+
+    int64_t elapsedNs = now.monotonicNs - anchorNs;
+    uint64_t elapsedTicks = now.tsc - anchorTsc;
+    if (elapsedNs <= 0 || elapsedTicks == 0) return;
+
+    // Where the current calibration puts `now`, to continue from. While starting over, that's no
+    // earlier than the floor.
+    int64_t base = zc::max(now.monotonicNs, old.ns);
+    int64_t error = 0;
+    if (old.mult != 0) {
+      base = extrapolate(old, now.tsc - old.tsc);
+      error = now.monotonicNs - base;
+    }
+
+    if (error > MAX_ERROR_NS || error < -MAX_ERROR_NS) {
+      // Readers returned at most the end of the old period. If that's ahead of the precise clock,
+      // the clock stands still until the precise clock catches up.
+      restart(now, extrapolate(old, zc::min(now.tsc - old.tsc, old.period)));
+      return;
+    }
+
+    uint64_t mult = ((unsigned __int128)elapsedNs << 32) / elapsedTicks;
+    uint64_t period = (unsigned __int128)elapsedTicks * PERIOD_NS / elapsedNs;
+    if (error > MAX_SLEW_NS) {
+      base = now.monotonicNs;
+    } else {
+      // Run fast or slow enough to make up the error by the next calibration.
+      mult = (unsigned __int128)mult * (PERIOD_NS + zc::max(error, -MAX_SLEW_NS)) / PERIOD_NS;
+    }
+    lastSampleNs = now.monotonicNs;
+    store({now.tsc, base, mult, zc::max(period, uint64_t(1)), now.calendarNs - now.monotonicNs,
+           0});
+  }
+
+  void restart(const Sample& now, int64_t floor) {
+    // Starts measuring the counter's rate over, reading the precise clock meanwhile, but never
+    // returning less than `floor`.
+    anchorTsc = now.tsc;
+    __atomic_store_n(&anchorNs, now.monotonicNs, __ATOMIC_RELAXED);
+    lastSampleNs = now.monotonicNs;
+    store({now.tsc, zc::max(floor, now.monotonicNs), 0, 0, now.calendarNs - now.monotonicNs, 0});
+  }
+
+  static bool isTscReliable() {
+    // The counter must tick at a constant rate through frequency changes and idle states...
+    uint eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8))) return false;
+
+    // ...and the kernel must trust it, which means it's synchronized across cores. If the kernel
+    // has fallen back to another clocksource, so do we.
+    int fd = ::open("/sys/devices/system/clocksource/clocksource0/current_clocksource",
+                  O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    ZC_DEFER(::close(fd));
+    char buffer[16];
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    return n == 4 && memcmp(buffer, "tsc\n", 4) == 0;
+  }
+};
+
+class TscMonotonicClock final : public MonotonicClock {
+public:
+  TimePoint now() const override {
+    return origin<TimePoint>() + TscClock::instance().read().monotonicNs * NANOSECONDS;
+  }
+};
+
+class TscCalendarClock final : public Clock {
+public:
+  Date now() const override {
+    auto reading = TscClock::instance().read();
+    return UNIX_EPOCH + (reading.monotonicNs + reading.calendarOffsetNs) * NANOSECONDS;
+  }
+};
+
+}  // namespace
+
+const MonotonicClock& systemFastMonotonicClock() {
+  static constexpr TscMonotonicClock clock;
+  return TscClock::instance().enabled ? static_cast<const MonotonicClock&>(clock)
+                                      : systemPreciseMonotonicClock();
+}
+const Clock& systemFastCalendarClock() {
+  static constexpr TscCalendarClock clock;
+  return TscClock::instance().enabled ? static_cast<const Clock&>(clock)
+                                      : systemPreciseCalendarClock();
+}
+
+#else
+
+const MonotonicClock& systemFastMonotonicClock() { return systemPreciseMonotonicClock(); }
+const Clock& systemFastCalendarClock() { return systemPreciseCalendarClock(); }
+
+#endif  // ZC_TSC_CLOCK
+
 #endif
 
 CappedArray<char, _::TIME_STR_LEN> ZC_STRINGIFY(TimePoint t) {
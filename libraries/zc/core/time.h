@@ -115,6 +115,21 @@ const MonotonicClock& systemPreciseMonotonicClock();
 // The "coarse" version has precision around 1-10ms, while the "precise" version has precision
 // better than 1us. The "precise" version may be slightly slower, though on modern hardware and
 // a reasonable operating system the difference is usually negligible.
+
+const MonotonicClock& systemFastMonotonicClock();
+const Clock& systemFastCalendarClock();
+// Clocks for hot paths, such as log timestamps, that read the time often but can tolerate an error
+// of a few microseconds. The event loop's Timer does not use these; it tracks
+// systemPreciseMonotonicClock().
+//
+// On x86-64 Linux, when the kernel itself keeps time with the CPU's timestamp counter, these read
+// the counter directly and scale it by a rate calibrated against the precise clocks, which takes a
+// few nanoseconds rather than a call into the vDSO. They recalibrate about once a second. The
+// monotonic clock slews toward systemPreciseMonotonicClock() rather than stepping back, so it never
+// goes backwards. If it finds itself far ahead, such as after the system resumes from suspend or
+// the counter is reset, it stands still, for a second or two at most, until the precise clock
+// catches up. The calendar clock picks up changes to the system time at the next recalibration.
+// On other platforms, these are the precise clocks.
 }  // namespace zc
 
 ZC_END_HEADER
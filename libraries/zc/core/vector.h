@@ -118,6 +118,13 @@ public:
     if (size > builder.capacity()) { grow(size); }
   }
 
+  inline void shrinkToFit() {
+    // Reallocates the backing array to hold exactly size() elements. Growth doubles the capacity,
+    // so a Vector that is kept around after being filled may be holding up to twice the memory it
+    // needs; together with reserve(), this gives the caller full control over the capacity.
+    if (!builder.isFull()) { setCapacity(size()); }
+  }
+
 private:
   ArrayBuilder<T> builder;
 
@@ -137,6 +144,227 @@ inline auto ZC_STRINGIFY(const Vector<T>& v) -> decltype(toCharSequence(v.asPtr(
   return toCharSequence(v.asPtr());
 }
 
+template <typename T, size_t N>
+class InlineVector {
+  // Like Vector, but with room for N elements inside the object itself, so that it only allocates
+  // once it grows past N elements. Use it for collections that are usually tiny and are created
+  // often, such as a member of a per-request object: a Vector would pay for a heap allocation (and
+  // usually a reallocation from releaseAsArray()) even to hold a single element.
+  //
+  // Unlike with Vector, moving an InlineVector moves the elements themselves while they are
+  // inline, so pointers to elements are invalidated by a move, and T must be movable.
+
+  static_assert(N > 0, "use Vector<T> instead");
+
+public:
+  inline InlineVector() {}
+  inline explicit InlineVector(size_t capacity) { reserve(capacity); }
+  inline InlineVector(Array<T>&& array) : heap(zc::mv(array)) {}
+  inline InlineVector(InlineVector&& other) { moveFrom(other); }
+  inline ~InlineVector() noexcept(false) { truncateInline(0); }
+  ZC_DISALLOW_COPY(InlineVector);
+
+  inline InlineVector& operator=(InlineVector&& other) {
+    if (this != &other) {
+      *this = nullptr;
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  inline operator ArrayPtr<T>() ZC_LIFETIMEBOUND { return asPtr(); }
+  inline operator ArrayPtr<const T>() const ZC_LIFETIMEBOUND { return asPtr(); }
+  inline ArrayPtr<T> asPtr() ZC_LIFETIMEBOUND { return arrayPtr(begin(), size()); }
+  inline ArrayPtr<const T> asPtr() const ZC_LIFETIMEBOUND { return arrayPtr(begin(), size()); }
+
+  inline bool isInline() const { return heap.capacity() == 0; }
+  // Whether the elements are stored inside the object, rather than on the heap.
+
+  inline size_t size() const { return isInline() ? inlineSize : heap.size(); }
+  inline bool empty() const { return size() == 0; }
+  inline size_t capacity() const { return isInline() ? N : heap.capacity(); }
+  inline T& operator[](size_t index) ZC_LIFETIMEBOUND { return begin()[index]; }
+  inline const T& operator[](size_t index) const ZC_LIFETIMEBOUND { return begin()[index]; }
+
+  inline const T* begin() const ZC_LIFETIMEBOUND { return isInline() ? items : heap.begin(); }
+  inline const T* end() const ZC_LIFETIMEBOUND { return begin() + size(); }
+  inline const T& front() const ZC_LIFETIMEBOUND { return *begin(); }
+  inline const T& back() const ZC_LIFETIMEBOUND { return *(end() - 1); }
+  inline T* begin() ZC_LIFETIMEBOUND { return isInline() ? items : heap.begin(); }
+  inline T* end() ZC_LIFETIMEBOUND { return begin() + size(); }
+  inline T& front() ZC_LIFETIMEBOUND { return *begin(); }
+  inline T& back() ZC_LIFETIMEBOUND { return *(end() - 1); }
+
+  inline Array<T> releaseAsArray() {
+    // Inline elements are moved into a new array of exactly the right size, which is a single
+    // allocation where a Vector would typically have needed two.
+    if (isInline()) {
+      if (inlineSize == 0) return nullptr;
+      auto result = heapArrayBuilder<T>(inlineSize);
+      result.template addAll<T*, true>(items, items + inlineSize);
+      truncateInline(0);
+      return result.finish();
+    }
+    if (!heap.isFull()) { setCapacity(heap.size()); }
+    return heap.finish();
+  }
+
+  template <typename U>
+  inline bool operator==(const U& other) const {
+    return asPtr() == other;
+  }
+
+  inline ArrayPtr<T> slice(size_t start, size_t end) ZC_LIFETIMEBOUND {
+    return asPtr().slice(start, end);
+  }
+  inline ArrayPtr<const T> slice(size_t start, size_t end) const ZC_LIFETIMEBOUND {
+    return asPtr().slice(start, end);
+  }
+
+  inline ArrayPtr<T> first(size_t count) ZC_LIFETIMEBOUND { return slice(0, count); }
+  inline ArrayPtr<const T> first(size_t count) const ZC_LIFETIMEBOUND { return slice(0, count); }
+
+  template <typename... Params>
+  inline T& add(Params&&... params) ZC_LIFETIMEBOUND {
+    if (isInline()) {
+      if (inlineSize < N) {
+        ctor(items[inlineSize], zc::fwd<Params>(params)...);
+        return items[inlineSize++];
+      }
+      setCapacity(N * 2);
+    } else if (heap.isFull()) {
+      setCapacity(heap.capacity() * 2);
+    }
+    return heap.add(zc::fwd<Params>(params)...);
+  }
+
+  template <typename Iterator>
+  inline void addAll(Iterator begin, Iterator end) {
+    reserve(size() + (end - begin));
+    if (isInline()) {
+      for (; begin != end; ++begin) {
+        ctor(items[inlineSize], *begin);
+        ++inlineSize;
+      }
+    } else {
+      heap.addAll(begin, end);
+    }
+  }
+
+  template <typename Container>
+  inline void addAll(Container&& container) {
+    addAll(container.begin(), container.end());
+  }
+
+  inline void removeLast() {
+    if (isInline()) {
+      ZC_IREQUIRE(inlineSize > 0, "No elements present to remove.");
+      zc::dtor(items[--inlineSize]);
+    } else {
+      heap.removeLast();
+    }
+  }
+
+  inline void resize(size_t size) {
+    reserve(size);
+    if (isInline()) {
+      if (size < inlineSize) {
+        truncateInline(size);
+      } else {
+        if (!ZC_HAS_TRIVIAL_CONSTRUCTOR(T)) {
+          // Count each element as it's constructed, so that the destructor cleans up if one throws.
+          for (; inlineSize < size; ++inlineSize) { zc::ctor(items[inlineSize]); }
+        }
+        inlineSize = size;
+      }
+    } else {
+      heap.resize(size);
+    }
+  }
+
+  inline void operator=(decltype(nullptr)) {
+    truncateInline(0);
+    heap = nullptr;
+  }
+
+  inline void clear() {
+    truncateInline(0);
+    heap.clear();
+  }
+
+  inline void truncate(size_t size) {
+    if (isInline()) {
+      ZC_IREQUIRE(size <= inlineSize, "can't use truncate() to expand");
+      truncateInline(size);
+    } else {
+      heap.truncate(size);
+    }
+  }
+
+  inline void reserve(size_t size) {
+    if (size > capacity()) { setCapacity(zc::max(size, capacity() * 2)); }
+  }
+
+  inline void shrinkToFit() {
+    // Moves the elements back inline if they fit, or otherwise reallocates the heap array to hold
+    // exactly size() elements.
+    if (isInline()) return;
+    if (heap.size() <= N) {
+      moveInline();
+    } else if (!heap.isFull()) {
+      setCapacity(heap.size());
+    }
+  }
+
+private:
+  ArrayBuilder<T> heap;
+  // Holds the elements once they have outgrown the inline storage; null while they are inline.
+
+  size_t inlineSize = 0;
+
+  union {
+    T items[N];
+  };
+  // The first `inlineSize` elements are constructed, as long as `heap` is null.
+
+  inline void truncateInline(size_t size) {
+    while (inlineSize > size) { zc::dtor(items[--inlineSize]); }
+  }
+
+  void setCapacity(size_t newCapacity) {
+    // Moves the elements to a new heap array of the given capacity, which must fit them.
+    ArrayBuilder<T> newHeap = heapArrayBuilder<T>(newCapacity);
+    newHeap.template addAll<T*, true>(begin(), end());
+    truncateInline(0);
+    heap = zc::mv(newHeap);
+  }
+
+  void moveInline() {
+    // Moves the elements from the heap back into the inline storage, which must fit them.
+    ArrayBuilder<T> old = zc::mv(heap);
+    for (T& element : old) {
+      ctor(items[inlineSize], zc::mv(element));
+      ++inlineSize;
+    }
+  }
+
+  void moveFrom(InlineVector& other) {
+    if (other.isInline()) {
+      for (; inlineSize < other.inlineSize; ++inlineSize) {
+        ctor(items[inlineSize], zc::mv(other.items[inlineSize]));
+      }
+      other.truncateInline(0);
+    } else {
+      heap = zc::mv(other.heap);
+    }
+  }
+};
+
+template <typename T, size_t N>
+inline auto ZC_STRINGIFY(const InlineVector<T, N>& v) -> decltype(toCharSequence(v.asPtr())) {
+  return toCharSequence(v.asPtr());
+}
+
 }  // namespace zc
 
 ZC_END_HEADER
@@ -30,6 +30,7 @@
 #include "zc/core/debug.h"
 #include "zc/core/encoding.h"
 #include "zc/core/exception.h"
+#include "zc/core/hash.h"
 #include "zc/core/string.h"
 #include "zc/http/url.h"
 #include "zc/parse/char.h"
@@ -548,12 +549,20 @@ namespace {
 
 struct HeaderNameHash {
   size_t operator()(zc::StringPtr s) const {
-    size_t result = 5381;
-    for (byte b : s.asBytes()) {
-      // Masking bit 0x20 makes our hash case-insensitive while conveniently avoiding any
-      // collisions that would matter for header names.
-      result = ((result << 5) + result) ^ (b & ~0x20);
-    }
+    // Masking bit 0x20 makes our hash case-insensitive while conveniently avoiding any collisions
+    // that would matter for header names. Hashing with zc::hash64() means the process's hash seed
+    // applies, so clients can't pick header names that collide. Names are folded a chunk at a
+    // time, and most fit in one.
+    constexpr size_t CHUNK_SIZE = 64;
+    byte folded[CHUNK_SIZE];
+    uint64_t result = zc::getHashSeed();
+    auto bytes = s.asBytes();
+    do {
+      size_t n = zc::min(bytes.size(), CHUNK_SIZE);
+      for (size_t i = 0; i < n; i++) { folded[i] = bytes[i] & ~0x20; }
+      result = zc::hash64(zc::arrayPtr(folded, n), result);
+      bytes = bytes.slice(n);
+    } while (bytes.size() > 0);
     return result;
   }
 
@@ -1196,7 +1205,7 @@ HttpRanges tryParseHttpRangeHeader(zc::ArrayPtr<const char> value, uint64_t cont
   if (*(p++) != '=') return HttpUnsatisfiableRange{};
 
   auto fullRange = false;
-  zc::Vector<HttpByteRange> satisfiableRanges;
+  zc::InlineVector<HttpByteRange, 2> satisfiableRanges;
   do {
     ZC_IF_SOME(range, consumeRangeSpec(p, contentLength)) {
       // Don't record more ranges if we've already recorded a full range
@@ -2028,6 +2037,16 @@ static_assert(!fastCaseCmp<'n', 'O', 'o', 'B', '1'>("FooB1"), "");
 static_assert(!fastCaseCmp<'f', 'O', 'o', 'B'>("FooB1"), "");
 static_assert(!fastCaseCmp<'f', 'O', 'o', 'B', '1', 'a'>("FooB1"), "");
 
+static zc::Maybe<uint64_t> parseContentLength(zc::StringPtr value) {
+  // Content-Length is 1*DIGIT. zc::tryParseAs() would also accept whitespace, a sign or "0x", so
+  // check the digits here and leave it to reject only values that overflow.
+  if (value.size() == 0) return zc::none;
+  for (char c : value) {
+    if (c < '0' || c > '9') return zc::none;
+  }
+  return zc::tryParseAs<uint64_t>(value);
+}
+
 zc::Own<zc::AsyncInputStream> HttpInputStreamImpl::getEntityBody(
     RequestOrResponse type, zc::OneOf<HttpMethod, HttpConnectMethod> method, uint statusCode,
     const zc::HttpHeaders& headers) {
@@ -2047,7 +2066,7 @@ zc::Own<zc::AsyncInputStream> HttpInputStreamImpl::getEntityBody(
       // Body elided.
       zc::Maybe<uint64_t> length;
       ZC_IF_SOME(cl, headers.get(HttpHeaderId::CONTENT_LENGTH)) {
-        length = strtoull(cl.cStr(), nullptr, 10);
+        length = parseContentLength(cl);
       }
       else if (headers.get(HttpHeaderId::TRANSFER_ENCODING) == zc::none) {
         // HACK: Neither Content-Length nor Transfer-Encoding header in response to HEAD
@@ -2095,12 +2114,11 @@ zc::Own<zc::AsyncInputStream> HttpInputStreamImpl::getEntityBody(
   ZC_IF_SOME(cl, headers.get(HttpHeaderId::CONTENT_LENGTH)) {
     // NOTE: By spec, multiple Content-Length values are allowed as long as they are the same, e.g.
     //   "Content-Length: 5, 5, 5". Hopefully no one actually does that...
-    char* end;
-    uint64_t length = strtoull(cl.cStr(), &end, 10);
-    if (end > cl.begin() && *end == '\0') {
+    ZC_IF_SOME(length, parseContentLength(cl)) {
       // #5
       return zc::heap<HttpFixedLengthEntityReader>(*this, length);
-    } else {
+    }
+    else {
       // #4 (bad content-length)
       ZC_FAIL_REQUIRE("invalid Content-Length header value", cl);
     }
@@ -473,9 +473,11 @@ private:
     zc::StringPtr name;
     zc::StringPtr value;
   };
-  zc::Vector<Header> unindexedHeaders;
+  zc::InlineVector<Header, 4> unindexedHeaders;
+  // Most messages carry only a few headers that the table doesn't know about, so these are kept
+  // inline to save an allocation per message.
 
-  zc::Vector<zc::Array<char>> ownedStrings;
+  zc::InlineVector<zc::Array<char>, 2> ownedStrings;
 
   void addNoCheck(zc::StringPtr name, zc::StringPtr value);
 
@@ -1285,6 +1285,55 @@ ZC_TEST("NetworkFilter") {
   }
 }
 
+ZC_TEST("NetworkFilter picks the most specific of many ranges") {
+  _::NetworkFilter base;
+
+  // A /16 for each of 10.0-255, with a /24 carved out of each even one.
+  Vector<String> allow;
+  Vector<String> deny;
+  for (uint i : zeroTo(256)) {
+    allow.add(str("10.", i, ".0.0/16"));
+    if (i % 2 == 0) deny.add(str("10.", i, ".7.0/24"));
+  }
+  allow.add(str("10.4.7.128/25"));
+  allow.add(str("10.6.7.0/24"));
+  allow.add(str("2001:db8::/32"));
+  allow.add(str("2001:db8:1:2::/64"));
+  deny.add(str("2001:db8:1::/48"));
+
+  auto allowPtrs = ZC_MAP(rule, allow) -> StringPtr { return rule; };
+  auto denyPtrs = ZC_MAP(rule, deny) -> StringPtr { return rule; };
+  _::NetworkFilter filter(allowPtrs, denyPtrs, base);
+
+  ZC_EXPECT(allowed4(filter, "10.1.7.1"));
+  ZC_EXPECT(allowed4(filter, "10.255.7.1"));
+  ZC_EXPECT(!allowed4(filter, "10.2.7.1"));
+  ZC_EXPECT(allowed4(filter, "10.2.8.1"));
+  ZC_EXPECT(!allowed4(filter, "11.0.0.1"));
+
+  // The more specific rule wins, and a deny wins a tie.
+  ZC_EXPECT(allowed4(filter, "10.4.7.200"));
+  ZC_EXPECT(!allowed4(filter, "10.4.7.100"));
+  ZC_EXPECT(!allowed4(filter, "10.6.7.1"));
+
+  ZC_EXPECT(allowed6(filter, "2001:db8::1"));
+  ZC_EXPECT(!allowed6(filter, "2001:db8:1::1"));
+  ZC_EXPECT(allowed6(filter, "2001:db8:1:2::1"));
+  ZC_EXPECT(!allowed6(filter, "2001:db9::1"));
+
+  // IPv4 rules apply to v4-mapped IPv6 addresses.
+  ZC_EXPECT(allowed6(filter, "::ffff:10.1.2.3"));
+  ZC_EXPECT(!allowed6(filter, "::ffff:10.2.7.1"));
+  ZC_EXPECT(allowed6(filter, "::ffff:10.4.7.200"));
+
+  // An address must also pass the filter it was restricted from.
+  _::NetworkFilter outer({"10.0.0.0/8"}, {"10.5.0.0/16"}, filter);
+  ZC_EXPECT(allowed4(outer, "10.1.1.1"));
+  ZC_EXPECT(!allowed4(outer, "10.5.1.1"));
+  ZC_EXPECT(!allowed4(outer, "10.2.7.1"));
+  ZC_EXPECT(allowed4(outer, "10.4.7.200"));
+}
+
 ZC_TEST("Network::restrictPeers()") {
   auto ioContext = setupAsyncIo();
   auto& w = ioContext.waitScope;
@@ -22,6 +22,7 @@
 #include "zc/async/async-queue.h"
 
 #include <zc/async/async-io.h>
+#include <zc/core/thread.h>
 #include <zc/core/vector.h>
 #include <zc/ztest/test.h>
 
@@ -133,5 +134,54 @@ ZC_TEST("ProducerConsumerQueue with rejectAll()") {
   }
 }
 
+ZC_TEST("CrossThreadQueueWaker") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  MpmcQueue<uint> queue(16);
+  CrossThreadQueueWaker waker;
+  queue.setWaker(waker);
+
+  // Nothing has been pushed, so the waiter sleeps until something is.
+  auto promise = waker.wait([&]() { return !queue.isEmpty(); });
+  ZC_EXPECT(!promise.poll(waitScope));
+  ZC_EXPECT(queue.tryPush(1));
+  ZC_EXPECT(promise.poll(waitScope));
+  promise.wait(waitScope);
+
+  // Something is already there, so wait() is ready at once.
+  ZC_EXPECT(waker.wait([&]() { return !queue.isEmpty(); }).poll(waitScope));
+  ZC_EXPECT(ZC_ASSERT_NONNULL(queue.tryPop()) == 1);
+}
+
+ZC_TEST("CrossThreadQueueWaker with a producer thread") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  constexpr uint ITEMS = 10000;
+  MpmcQueue<uint> queue(ITEMS);
+  CrossThreadQueueWaker waker;
+  queue.setWaker(waker);
+
+  uint64_t sum = 0;
+  {
+    Thread producer([&]() {
+      for (uint i : zc::zeroTo(ITEMS)) { ZC_ASSERT(queue.tryPush(i + 1)); }
+    });
+
+    uint received = 0;
+    while (received < ITEMS) {
+      ZC_IF_SOME(value, queue.tryPop()) {
+        sum += value;
+        ++received;
+      } else {
+        waker.wait([&]() { return !queue.isEmpty(); }).wait(waitScope);
+      }
+    }
+  }
+
+  ZC_EXPECT(sum == uint64_t(ITEMS) * (ITEMS + 1) / 2);
+}
+
 }  // namespace
 }  // namespace zc
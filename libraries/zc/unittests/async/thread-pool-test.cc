@@ -0,0 +1,186 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/async/thread-pool.h"
+
+#include <zc/core/string.h>
+#include <zc/core/vector.h>
+#include <zc/ztest/test.h>
+
+#include <stdint.h>
+
+namespace zc {
+namespace {
+
+ZC_TEST("ThreadPool submit") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(4);
+  ZC_EXPECT(pool.getThreadCount() == 4);
+
+  Vector<Promise<uint>> promises;
+  for (uint i : zeroTo(100)) {
+    promises.add(pool.submit([i]() { return i * i; }));
+  }
+  for (uint i : zeroTo(100)) { ZC_EXPECT(promises[i].wait(waitScope) == i * i); }
+
+  // Void results, and promises that run on the worker's event loop.
+  bool ran = false;
+  pool.submit([&ran]() { ran = true; }).wait(waitScope);
+  ZC_EXPECT(ran);
+  auto str = pool.submit([]() { return evalLater([]() { return zc::str("later"); }); });
+  ZC_EXPECT(str.wait(waitScope) == "later");
+
+  // Exceptions reject the promise.
+  ZC_EXPECT_THROW_MESSAGE("task failed", pool.submit([]() -> int {
+    ZC_FAIL_REQUIRE("task failed");
+  }).wait(waitScope));
+  ZC_EXPECT_THROW_MESSAGE("async failure", pool.submit([]() -> Promise<void> {
+    return ZC_EXCEPTION(FAILED, "async failure");
+  }).wait(waitScope));
+}
+
+ZC_TEST("ThreadPool executors") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(ThreadPool::Options{.threadCount = 2, .pinThreads = true});
+
+  // Each worker's executor runs calls on that worker.
+  auto first = pool.getExecutor(0).executeAsync([]() { return &getCurrentThreadExecutor(); });
+  auto second = pool.getExecutor(1).executeAsync([]() { return &getCurrentThreadExecutor(); });
+  ZC_EXPECT(first.wait(waitScope) == &pool.getExecutor(0));
+  ZC_EXPECT(second.wait(waitScope) == &pool.getExecutor(1));
+}
+
+ZC_TEST("ThreadPool parallelFor") {
+  ThreadPool pool(4);
+
+  constexpr uint COUNT = 10000;
+  auto hits = heapArray<uint>(COUNT);
+  for (auto& hit : hits) hit = 0;
+  pool.parallelFor(zeroTo(COUNT), 7,
+                   [&](uint i) { __atomic_add_fetch(&hits[i], 1, __ATOMIC_RELAXED); });
+  for (uint i : zeroTo(COUNT)) { ZC_ASSERT(hits[i] == 1, i); }
+
+  // Ranges need not start at zero, and may be empty.
+  int sum = 0;
+  pool.parallelFor(range(-50, 50), 1,
+                   [&](int i) { __atomic_add_fetch(&sum, i, __ATOMIC_RELAXED); });
+  ZC_EXPECT(sum == -50);
+  pool.parallelFor(zeroTo(0u), 1, [](uint) { ZC_FAIL_EXPECT("should not be called"); });
+
+  // The first exception is rethrown, and stops chunks that haven't started.
+  uint calls = 0;
+  ZC_EXPECT_THROW_MESSAGE("chunk failed", pool.parallelFor(zeroTo(COUNT), 1, [&](uint i) {
+    __atomic_add_fetch(&calls, 1, __ATOMIC_RELAXED);
+    if (i == 10) ZC_FAIL_REQUIRE("chunk failed");
+  }));
+  ZC_EXPECT(calls < COUNT, calls);
+}
+
+ZC_TEST("ThreadPool parallelFor nested in the pool") {
+  EventLoop loop;
+  WaitScope waitScope(loop);
+  ThreadPool pool(2);
+
+  // Tasks on every worker run parallelFor() at once, so workers block on each other's jobs.
+  uint total = 0;
+  Vector<Promise<void>> promises;
+  for (uint task : zeroTo(8)) {
+    promises.add(pool.submit([&pool, &total, task]() {
+      pool.parallelFor(zeroTo(100u), 3, [&](uint i) {
+        pool.parallelFor(zeroTo(10u), 2, [&](uint j) {
+          __atomic_add_fetch(&total, task + i + j, __ATOMIC_RELAXED);
+        });
+      });
+    }));
+  }
+  joinPromises(promises.releaseAsArray()).wait(waitScope);
+
+  uint expected = 0;
+  for (uint task : zeroTo(8)) {
+    for (uint i : zeroTo(100)) {
+      for (uint j : zeroTo(10)) { expected += task + i + j; }
+    }
+  }
+  ZC_EXPECT(total == expected);
+}
+
+ZC_TEST("ThreadPool parallelReduce") {
+  ThreadPool pool(4);
+
+  uint64_t sum = pool.parallelReduce(
+      zeroTo(100000u), 100, uint64_t(0), [](uint i) -> uint64_t { return i; },
+      [](uint64_t a, uint64_t b) { return a + b; });
+  ZC_EXPECT(sum == uint64_t(99999) * 100000 / 2);
+
+  // Chunks are combined in order, so non-commutative combinations work, and rounding is the same
+  // every time.
+  struct Span {
+    uint begin = 0;
+    uint end = 0;
+  };
+  auto joined = pool.parallelReduce(
+      zeroTo(1000u), 7, Span(), [](uint i) { return Span{i, i + 1}; },
+      [](Span a, Span b) {
+        if (a.begin == a.end) return b;
+        if (b.begin == b.end) return a;
+        ZC_ASSERT(a.end == b.begin, "combined out of order", a.end, b.begin);
+        return Span{a.begin, b.end};
+      });
+  ZC_EXPECT(joined.begin == 0 && joined.end == 1000);
+
+  auto addInverses = [&]() {
+    return pool.parallelReduce(
+        range(1, 100000), 16, 0.0, [](int i) { return 1.0 / i; },
+        [](double a, double b) { return a + b; });
+  };
+  double expected = addInverses();
+  for (uint i ZC_UNUSED : zeroTo(20)) { ZC_ASSERT(addInverses() == expected); }
+}
+
+uint64_t collatzSteps(uint64_t n) {
+  uint64_t steps = 0;
+  while (n != 1) {
+    n = n % 2 == 0 ? n / 2 : 3 * n + 1;
+    ++steps;
+  }
+  return steps;
+}
+
+constexpr uint BENCHMARK_COUNT = 2000000;
+
+ZC_TEST("benchmark: serial loop") {
+  uint64_t total = 0;
+  for (uint i : range(1u, BENCHMARK_COUNT)) { total += collatzSteps(i); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: ThreadPool parallelReduce") {
+  ThreadPool pool;
+  uint64_t total = pool.parallelReduce(
+      range(1u, BENCHMARK_COUNT), 4096, uint64_t(0), [](uint i) { return collatzSteps(i); },
+      [](uint64_t a, uint64_t b) { return a + b; });
+  ZC_EXPECT(total > 0);
+}
+
+}  // namespace
+}  // namespace zc
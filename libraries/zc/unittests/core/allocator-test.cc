@@ -0,0 +1,204 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/allocator.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/thread.h"
+#include "zc/core/vector.h"
+
+namespace zc {
+namespace {
+
+ZC_TEST("SizeClassAllocator size classes") {
+  using A = SizeClassAllocator;
+  ZC_EXPECT(A::sizeClassOf(0) == 0);
+  ZC_EXPECT(A::sizeClassOf(1) == 0);
+  ZC_EXPECT(A::sizeClassOf(16) == 0);
+  ZC_EXPECT(A::sizeClassOf(17) == 1);
+  ZC_EXPECT(A::sizeClassOf(129) == 8);
+  ZC_EXPECT(A::sizeOfClass(8) == 160);
+  ZC_EXPECT(A::sizeClassOf(A::MAX_SMALL_SIZE) == A::SIZE_CLASS_COUNT - 1);
+  ZC_EXPECT(A::sizeOfClass(A::SIZE_CLASS_COUNT - 1) == A::MAX_SMALL_SIZE);
+
+  // Every size gets the smallest class that fits it.
+  for (size_t size = 1; size <= A::MAX_SMALL_SIZE; size++) {
+    uint sizeClass = A::sizeClassOf(size);
+    ZC_ASSERT(A::sizeOfClass(sizeClass) >= size, size);
+    ZC_ASSERT(sizeClass == 0 || A::sizeOfClass(sizeClass - 1) < size, size);
+  }
+}
+
+uint64_t inUse(const SizeClassAllocator::Stats& stats, size_t size) {
+  return stats.sizeClasses[SizeClassAllocator::sizeClassOf(size)].objectsInUse;
+}
+
+ZC_TEST("SizeClassAllocator allocates and reuses slots") {
+  auto& allocator = SizeClassAllocator::instance;
+  auto before = allocator.getStats();
+
+  constexpr uint COUNT = 1000;
+  void* pointers[COUNT];
+  for (uint i : zeroTo(COUNT)) {
+    pointers[i] = allocator.allocate(48);
+    ZC_ASSERT(reinterpret_cast<uintptr_t>(pointers[i]) % 16 == 0);
+    memset(pointers[i], i, 48);
+  }
+  for (uint i : zeroTo(COUNT)) {
+    for (byte b : arrayPtr(reinterpret_cast<byte*>(pointers[i]), 48)) ZC_ASSERT(b == byte(i));
+  }
+
+  auto during = allocator.getStats();
+  ZC_EXPECT(inUse(during, 48) - inUse(before, 48) == COUNT);
+  ZC_EXPECT(during.sizeClasses[SizeClassAllocator::sizeClassOf(48)].bytesInUse >= COUNT * 48);
+
+  for (uint i : zeroTo(COUNT)) allocator.deallocate(pointers[i], 48);
+  auto after = allocator.getStats();
+  ZC_EXPECT(inUse(after, 48) == inUse(before, 48));
+  ZC_EXPECT(after.cacheHits > before.cacheHits);
+  ZC_EXPECT(after.cacheMisses > before.cacheMisses);
+  ZC_EXPECT(after.cacheHitRate() > 0.9, after.cacheHitRate());
+
+  // Freed slots are used again.
+  void* again = allocator.allocate(40);
+  bool reused = false;
+  for (void* pointer : pointers) reused = reused || pointer == again;
+  ZC_EXPECT(reused);
+  allocator.deallocate(again, 40);
+
+  // Large requests go to operator new.
+  void* large = allocator.allocate(SizeClassAllocator::MAX_SMALL_SIZE + 1);
+  ZC_EXPECT(allocator.getStats().largeBytesInUse - after.largeBytesInUse ==
+            SizeClassAllocator::MAX_SMALL_SIZE + 1);
+  allocator.deallocate(large, SizeClassAllocator::MAX_SMALL_SIZE + 1);
+
+  allocator.flushThreadCache();
+}
+
+ZC_TEST("SizeClassAllocator frees across threads") {
+  auto& allocator = SizeClassAllocator::instance;
+  constexpr uint THREADS = 4;
+  constexpr uint COUNT = 5000;
+  auto before = allocator.getStats();
+
+  // Each thread allocates objects that the next one frees, and exits with a full cache.
+  Vector<void*> allocated[THREADS];
+  for (uint round : zeroTo(THREADS + 1)) {
+    Thread thread([&]() {
+      if (round > 0) {
+        for (void* pointer : allocated[round - 1]) allocator.deallocate(pointer, 200);
+      }
+      if (round < THREADS) {
+        for (uint i : zeroTo(COUNT)) {
+          allocated[round].add(allocator.allocate(200));
+          memset(allocated[round].back(), round, 200);
+          if (i % 3 == 0) {
+            allocator.deallocate(allocated[round].back(), 200);
+            allocated[round].removeLast();
+          }
+        }
+      }
+    });
+  }
+
+  auto after = allocator.getStats();
+  ZC_EXPECT(inUse(after, 200) == inUse(before, 200));
+  ZC_EXPECT(after.sizeClasses[SizeClassAllocator::sizeClassOf(200)].bytesCached > 0);
+}
+
+ZC_TEST("heap allocator selection") {
+  // This process has allocated plenty by now, so the allocator can no longer change.
+  auto& allocator = getHeapAllocator();
+  setHeapAllocator(allocator);
+
+  HeapAllocator& other = &allocator == &SystemHeapAllocator::instance
+                             ? static_cast<HeapAllocator&>(SizeClassAllocator::instance)
+                             : SystemHeapAllocator::instance;
+  ZC_EXPECT_THROW_MESSAGE("must be called before anything is allocated", setHeapAllocator(other));
+}
+
+struct WithOwnOperatorNew {
+  static uint allocations;
+  uint64_t value = 123;
+
+  static void* operator new(size_t size) {
+    ++allocations;
+    return ::operator new(size);
+  }
+  static void operator delete(void* pointer) { ::operator delete(pointer); }
+};
+uint WithOwnOperatorNew::allocations = 0;
+
+struct alignas(64) OverAligned {
+  byte data[64];
+};
+
+ZC_TEST("heap<T>() honors class operator new and alignment") {
+  auto own = heap<WithOwnOperatorNew>();
+  ZC_EXPECT(WithOwnOperatorNew::allocations == 1);
+  ZC_EXPECT(own->value == 123);
+
+  for (uint i ZC_UNUSED : zeroTo(10)) {
+    auto aligned = heap<OverAligned>();
+    ZC_EXPECT(reinterpret_cast<uintptr_t>(aligned.get()) % 64 == 0);
+  }
+}
+
+ZC_TEST("heap<T>() frees memory when the constructor throws") {
+  struct Throws {
+    Throws() { ZC_FAIL_REQUIRE("constructor failed"); }
+  };
+  ZC_EXPECT_THROW_MESSAGE("constructor failed", heap<Throws>());
+}
+
+constexpr uint BENCHMARK_THREADS = 4;
+constexpr uint BENCHMARK_ROUNDS = 20000;
+constexpr uint BENCHMARK_LIVE = 64;
+
+template <typename Allocate, typename Deallocate>
+void allocationBenchmark(Allocate&& allocate, Deallocate&& deallocate) {
+  // Like a promise chain: a few objects of a few sizes live at a time.
+  auto threads = heapArrayBuilder<Own<Thread>>(BENCHMARK_THREADS);
+  for (uint t ZC_UNUSED : zeroTo(BENCHMARK_THREADS)) {
+    threads.add(heap<Thread>([&]() {
+      void* live[BENCHMARK_LIVE];
+      for (uint round ZC_UNUSED : zeroTo(BENCHMARK_ROUNDS)) {
+        for (uint i : zeroTo(BENCHMARK_LIVE)) live[i] = allocate(32 + (i % 4) * 48);
+        for (uint i : zeroTo(BENCHMARK_LIVE)) deallocate(live[i], 32 + (i % 4) * 48);
+      }
+    }));
+  }
+}
+
+ZC_TEST("benchmark: operator new") {
+  allocationBenchmark([](size_t size) { return operator new(size); },
+                      [](void* pointer, size_t size) { operator delete(pointer); });
+}
+
+ZC_TEST("benchmark: SizeClassAllocator") {
+  auto& allocator = SizeClassAllocator::instance;
+  allocationBenchmark([&](size_t size) { return allocator.allocate(size); },
+                      [&](void* pointer, size_t size) { allocator.deallocate(pointer, size); });
+}
+
+}  // namespace
+}  // namespace zc
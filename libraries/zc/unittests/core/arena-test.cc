@@ -25,6 +25,7 @@
 #include <zc/ztest/gtest.h>
 
 #include "zc/core/debug.h"
+#include "zc/core/thread.h"
 
 namespace zc {
 namespace {
@@ -302,5 +303,138 @@ TEST(Arena, Strings) {
   EXPECT_EQ(quux.end() + 1, corge.begin());
 }
 
+TEST(Arena, Reset) {
+  TestObject::count = 0;
+  TestObject::throwAt = -1;
+  Arena arena(256);
+
+  for (uint round = 0; round < 4; round++) {
+    for (uint i = 0; i < 100; i++) { arena.allocate<TestObject>(); }
+    arena.allocateArray<byte>(1000);
+    EXPECT_EQ(100, TestObject::count);
+
+    if (round == 0) {
+      EXPECT_GT(arena.getStats().chunkCount, 1u);
+    } else if (round >= 2) {
+      // By now, the kept chunk has grown big enough for a whole round.
+      EXPECT_EQ(1u, arena.getStats().chunkCount);
+    }
+
+    arena.reset();
+    EXPECT_EQ(0, TestObject::count);
+
+    auto stats = arena.getStats();
+    EXPECT_EQ(1u, stats.chunkCount);
+    EXPECT_EQ(0u, stats.bytesUsed);
+    EXPECT_EQ(0u, stats.bytesWasted);
+  }
+}
+
+TEST(Arena, ResetScratch) {
+  union {
+    byte scratch[256];
+    uint64_t align;
+  };
+  Arena arena(arrayPtr(scratch, sizeof(scratch)));
+
+  byte* first = arena.allocateArray<byte>(16).begin();
+  arena.reset();
+  EXPECT_EQ(first, arena.allocateArray<byte>(16).begin());
+  EXPECT_EQ(0u, arena.getStats().chunkCount);
+
+  // Once the arena has outgrown the scratch space, the heap chunk is the one that's kept.
+  arena.allocateArray<byte>(1000);
+  arena.reset();
+  byte* reused = arena.allocateArray<byte>(16).begin();
+  EXPECT_TRUE(reused < scratch || reused >= scratch + sizeof(scratch));
+  EXPECT_EQ(1u, arena.getStats().chunkCount);
+}
+
+TEST(Arena, MaxChunkSize) {
+  Arena arena(1024, 4096);
+
+  for (uint i = 0; i < 100; i++) { arena.allocateArray<byte>(1000); }
+  auto stats = arena.getStats();
+  EXPECT_EQ(100000u, stats.bytesUsed);
+  EXPECT_LE(stats.bytesReserved, stats.chunkCount * 4096);
+
+  // An allocation bigger than the limit gets its own chunk and doesn't disturb the current one.
+  byte& before = arena.allocate<byte>();
+  ArrayPtr<byte> big = arena.allocateArray<byte>(10000);
+  byte& after = arena.allocate<byte>();
+  EXPECT_EQ(&before + 1, &after);
+  memset(big.begin(), 0xbe, big.size());
+
+  // And it is not the chunk that reset() keeps.
+  arena.reset();
+  EXPECT_EQ(1u, arena.getStats().chunkCount);
+  EXPECT_LE(arena.getStats().bytesReserved, 4096u);
+}
+
+TEST(Arena, Stats) {
+  // Like MultiSegment, this assumes that ChunkHeader is three pointers.
+  constexpr size_t header = sizeof(void*) * 3;
+  Arena arena(header + 16);
+
+  arena.allocate<uint64_t>();
+  arena.allocate<uint64_t>();
+  auto stats = arena.getStats();
+  EXPECT_EQ(1u, stats.chunkCount);
+  EXPECT_EQ(16u, stats.bytesUsed);
+  EXPECT_EQ(0u, stats.bytesWasted);
+
+  // The first chunk is full, so this starts a second one, twice as big...
+  arena.allocate<uint8_t>();
+  // ...which then can't fit this, wasting the rest of the second chunk.
+  arena.allocateArray<byte>(header + 32);
+
+  stats = arena.getStats();
+  EXPECT_EQ(3u, stats.chunkCount);
+  EXPECT_EQ(16u + 1u + header + 32u, stats.bytesUsed);
+  EXPECT_EQ(header + 31u, stats.bytesWasted);
+  EXPECT_EQ(7 * (header + 16), stats.bytesReserved);
+}
+
+TEST(ConcurrentArena, Threads) {
+  ConcurrentArena arena(1024);
+  constexpr uint THREADS = 8;
+  constexpr uint COUNT = 10000;
+
+  ArrayPtr<uint32_t> results[THREADS][COUNT / 100];
+  {
+    Array<Own<Thread>> threads = heapArray<Own<Thread>>(THREADS);
+    for (uint t = 0; t < THREADS; t++) {
+      threads[t] = heap<Thread>([&, t]() {
+        for (uint i = 0; i < COUNT; i++) {
+          uint32_t& value = arena.allocate<uint32_t>(t * COUNT + i);
+          if (i % 100 == 0) {
+            // Now and then, something too big for a region.
+            auto array = arena.allocateArray<uint32_t>(i == 0 ? 1000 : 10);
+            for (auto& element : array) { element = value; }
+            results[t][i / 100] = array;
+          }
+        }
+      });
+    }
+  }
+
+  // No two allocations overlapped.
+  for (uint t = 0; t < THREADS; t++) {
+    for (uint j = 0; j < COUNT / 100; j++) {
+      for (uint32_t value : results[t][j]) { ASSERT_EQ(t * COUNT + j * 100, value); }
+    }
+  }
+
+  auto stats = arena.getStats();
+  EXPECT_GE(stats.bytesUsed, THREADS * (COUNT * 4 + 1000 * 4));
+  EXPECT_GE(stats.bytesReserved, stats.bytesUsed);
+
+  arena.reset();
+  stats = arena.getStats();
+  EXPECT_EQ(0u, stats.bytesUsed);
+  EXPECT_LE(stats.chunkCount, THREADS);
+  EXPECT_EQ("foo", arena.copyString("foo"));
+}
+
 }  // namespace
 }  // namespace zc
@@ -0,0 +1,217 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32
+// Request Vista-level APIs.
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/cidr.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/string.h"
+
+#if _WIN32
+#include <ws2tcpip.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+namespace zc {
+namespace {
+
+union SocketAddress {
+  struct sockaddr addr;
+  struct sockaddr_in addr4;
+  struct sockaddr_in6 addr6;
+};
+
+SocketAddress parseAddress(StringPtr text) {
+  SocketAddress result;
+  memset(&result, 0, sizeof(result));
+  if (text.findFirst(':') == zc::none) {
+    result.addr4.sin_family = AF_INET;
+    ZC_ASSERT(inet_pton(AF_INET, text.cStr(), &result.addr4.sin_addr) > 0, text);
+  } else {
+    result.addr6.sin6_family = AF_INET6;
+    ZC_ASSERT(inet_pton(AF_INET6, text.cStr(), &result.addr6.sin6_addr) > 0, text);
+  }
+  return result;
+}
+
+Maybe<uint> linearLongestMatch(ArrayPtr<const CidrRange> ranges, const struct sockaddr* addr) {
+  // What CidrSet::longestMatch() replaces.
+  Maybe<uint> result;
+  for (auto& range : ranges) {
+    if (range.matches(addr)) {
+      ZC_IF_SOME(specificity, result) {
+        result = zc::max(specificity, range.getSpecificity());
+      } else {
+        result = range.getSpecificity();
+      }
+    }
+  }
+  return result;
+}
+
+ZC_TEST("CidrSet") {
+  CidrRange ranges[] = {"10.0.0.0/8"_zc,  "10.1.0.0/16"_zc, "10.1.2.3/32"_zc,
+                        "192.168.0.0/16"_zc, "fc00::/7"_zc,   "2001:db8::/32"_zc,
+                        "2001:db8:1::/48"_zc};
+  CidrSet set(ranges);
+
+  auto match = [&](StringPtr text) {
+    auto address = parseAddress(text);
+    return set.longestMatch(&address.addr);
+  };
+
+  ZC_EXPECT(match("10.9.9.9") == uint(8));
+  ZC_EXPECT(match("10.1.9.9") == uint(16));
+  ZC_EXPECT(match("10.1.2.3") == uint(32));
+  ZC_EXPECT(match("10.1.2.4") == uint(16));
+  ZC_EXPECT(match("11.0.0.0") == zc::none);
+  ZC_EXPECT(match("192.168.255.1") == uint(16));
+  ZC_EXPECT(match("fd12::1") == uint(7));
+  ZC_EXPECT(match("2001:db8:1:2::3") == uint(48));
+  ZC_EXPECT(match("2001:db8:2::3") == uint(32));
+  ZC_EXPECT(match("2001:db9::") == zc::none);
+
+  // IPv4 ranges match v4-mapped IPv6 addresses, and only those.
+  ZC_EXPECT(match("::ffff:10.1.2.3") == uint(32));
+  ZC_EXPECT(match("::10.1.2.3") == zc::none);
+
+  ZC_EXPECT(set.matchesFamily(AF_INET));
+  ZC_EXPECT(set.matchesFamily(AF_INET6));
+  ZC_EXPECT(!CidrSet().matchesFamily(AF_INET6));
+  ZC_EXPECT(!CidrSet(arrayPtr(ranges + 4, 3)).matchesFamily(AF_INET));
+
+  // A zero-length range matches the whole family.
+  CidrSet everything;
+  everything.add(CidrRange::inet4({0, 0, 0, 0}, 0));
+  auto address = parseAddress("1.2.3.4");
+  ZC_EXPECT(everything.longestMatch(&address.addr) == uint(0));
+  address = parseAddress("::1");
+  ZC_EXPECT(everything.longestMatch(&address.addr) == zc::none);
+}
+
+struct Random {
+  uint64_t state = 12345;
+  uint64_t next() {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return state >> 16;
+  }
+};
+
+SocketAddress randomAddress(Random& random, ArrayPtr<const CidrRange> nearRanges) {
+  // An address that shares a prefix of random length with one of the ranges, so that lookups
+  // go deep into the trie.
+  auto text = nearRanges[random.next() % nearRanges.size()].toString();
+  auto address = parseAddress(heapString(text.first(ZC_ASSERT_NONNULL(text.findFirst('/')))));
+  byte* bytes;
+  uint size;
+  if (address.addr.sa_family == AF_INET) {
+    bytes = reinterpret_cast<byte*>(&address.addr4.sin_addr);
+    size = 4;
+  } else {
+    bytes = address.addr6.sin6_addr.s6_addr;
+    size = 16;
+    if (random.next() % 8 == 0) {
+      // Try a v4-mapped address too.
+      memset(bytes, 0, 10);
+      bytes[10] = bytes[11] = 0xff;
+    }
+  }
+  uint keep = random.next() % (size * 8 + 1);
+  for (uint bit = keep; bit < size * 8; bit++) {
+    if (random.next() % 2) bytes[bit / 8] ^= 0x80 >> (bit % 8);
+  }
+  return address;
+}
+
+Array<CidrRange> randomRanges(Random& random, uint count) {
+  auto builder = heapArrayBuilder<CidrRange>(count);
+  for (uint i : zeroTo(count)) {
+    byte bits[16];
+    for (byte& b : bits) b = random.next() % 4 == 0 ? 10 : random.next();
+    if (i % 2 == 0) {
+      builder.add(CidrRange::inet4(arrayPtr(bits, 4), random.next() % 33));
+    } else {
+      uint16_t words[8];
+      for (uint j : zeroTo(8)) words[j] = bits[j * 2] << 8 | bits[j * 2 + 1];
+      builder.add(CidrRange::inet6(words, {}, random.next() % 129));
+    }
+  }
+  return builder.finish();
+}
+
+ZC_TEST("CidrSet agrees with checking each CidrRange") {
+  Random random;
+  for (uint count : {1, 2, 10, 100, 1000}) {
+    auto ranges = randomRanges(random, count);
+    CidrSet set(ranges);
+    for (uint i ZC_UNUSED : zeroTo(2000)) {
+      auto address = randomAddress(random, ranges);
+      ZC_ASSERT(set.longestMatch(&address.addr) == linearLongestMatch(ranges, &address.addr),
+                count);
+    }
+  }
+}
+
+constexpr uint BENCHMARK_RANGES = 1000;
+constexpr uint BENCHMARK_LOOKUPS = 200000;
+
+constexpr uint BENCHMARK_ADDRESSES = 1000;
+
+template <typename Func>
+void cidrBenchmark(Func&& func) {
+  Random random;
+  auto ranges = randomRanges(random, BENCHMARK_RANGES);
+  auto addresses = heapArray<SocketAddress>(BENCHMARK_ADDRESSES);
+  for (auto& address : addresses) address = randomAddress(random, ranges);
+
+  uint matched = 0;
+  for (uint i : zeroTo(BENCHMARK_LOOKUPS)) {
+    matched += func(ranges, &addresses[i % BENCHMARK_ADDRESSES].addr);
+  }
+  ZC_EXPECT(matched > 0);
+}
+
+ZC_TEST("benchmark: 1000 CidrRanges, checked one by one") {
+  cidrBenchmark([](ArrayPtr<const CidrRange> ranges, const struct sockaddr* addr) {
+    return linearLongestMatch(ranges, addr) != zc::none;
+  });
+}
+
+ZC_TEST("benchmark: CidrSet of 1000 ranges") {
+  Maybe<CidrSet> set;
+  cidrBenchmark([&](ArrayPtr<const CidrRange> ranges, const struct sockaddr* addr) {
+    ZC_IF_SOME(s, set) { return s.matches(addr); }
+    return set.emplace(ranges).matches(addr);
+  });
+}
+
+}  // namespace
+}  // namespace zc
@@ -0,0 +1,170 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/concurrent-map.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/thread.h"
+
+namespace zc {
+namespace _ {
+namespace {
+
+ZC_TEST("ConcurrentHashMap") {
+  ConcurrentHashMap<String, int> map;
+
+  map.upsert(zc::str("foo"), 123);
+  map.upsert(zc::str("bar"), 456);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("foo"_zc)) == 123);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("bar"_zc)) == 456);
+  ZC_EXPECT(map.find("baz"_zc) == zc::none);
+  ZC_EXPECT(map.size() == 2);
+
+  map.upsert(zc::str("foo"), 1, [](int& existing, int&& value) { existing += value; });
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("foo"_zc)) == 124);
+  map.upsert(zc::str("foo"), 321);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("foo"_zc)) == 321);
+
+  ZC_EXPECT(map.modify("bar"_zc, [](int& value) { value = 654; }));
+  ZC_EXPECT(!map.modify("baz"_zc, [](int& value) { ZC_FAIL_EXPECT("should not be called"); }));
+  int seen = 0;
+  ZC_EXPECT(map.read("bar"_zc, [&](const int& value) { seen = value; }));
+  ZC_EXPECT(seen == 654);
+
+  ZC_EXPECT(map.findOrCreate("baz"_zc, []() {
+    return ConcurrentHashMap<String, int>::Entry{zc::str("baz"), 789};
+  }) == 789);
+  ZC_EXPECT(map.findOrCreate("baz"_zc, []() -> ConcurrentHashMap<String, int>::Entry {
+    ZC_FAIL_ASSERT("should not be called");
+  }) == 789);
+
+  ZC_EXPECT(map.erase("foo"_zc));
+  ZC_EXPECT(!map.erase("foo"_zc));
+  ZC_EXPECT(map.size() == 2);
+
+  map.clear();
+  ZC_EXPECT(map.size() == 0);
+  ZC_EXPECT(map.find("bar"_zc) == zc::none);
+}
+
+ZC_TEST("ConcurrentHashMap snapshot and eraseAll") {
+  ConcurrentHashMap<uint, uint, 4> map;
+  map.reserve(1000);
+  for (uint i : zc::zeroTo(1000)) { map.upsert(i, i * 2); }
+
+  auto entries = map.snapshot();
+  ZC_ASSERT(entries.size() == 1000);
+  uint64_t keySum = 0;
+  for (auto& entry : entries) {
+    ZC_EXPECT(entry.value == entry.key * 2);
+    keySum += entry.key;
+  }
+  ZC_EXPECT(keySum == 999 * 1000 / 2);
+
+  uint visited = 0;
+  map.forEach([&](uint key, uint value) { ++visited; });
+  ZC_EXPECT(visited == 1000);
+
+  ZC_EXPECT(map.eraseAll([](uint key, uint value) { return key % 3 == 0; }) == 334);
+  ZC_EXPECT(map.size() == 666);
+  ZC_EXPECT(map.find(3u) == zc::none);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find(4u)) == 8);
+}
+
+ZC_TEST("ConcurrentHashMap from many threads") {
+  ConcurrentHashMap<uint, uint> map;
+  constexpr uint THREADS = 8;
+  constexpr uint KEYS = 2000;
+  MutexGuarded<uint> creations(0);
+
+  {
+    auto threads = zc::heapArrayBuilder<zc::Own<zc::Thread>>(THREADS);
+    for (uint t : zc::zeroTo(THREADS)) {
+      threads.add(zc::heap<zc::Thread>([&map, &creations, t]() {
+        for (uint i : zc::zeroTo(KEYS)) {
+          // Every thread asks for every key, but each entry must only be created once.
+          uint key = (i + t * 97) % KEYS;
+          uint value = map.findOrCreate(key, [&]() {
+            ++*creations.lockExclusive();
+            return ConcurrentHashMap<uint, uint>::Entry{key, key + 1};
+          });
+          ZC_ASSERT(value == key + 1);
+          map.upsert(KEYS + t * KEYS + i, t, [](uint&, uint&&) { ZC_FAIL_ASSERT("duplicate"); });
+        }
+      }));
+    }
+  }
+
+  ZC_EXPECT(*creations.lockShared() == KEYS);
+  ZC_EXPECT(map.size() == KEYS + THREADS * KEYS);
+}
+
+template <typename Func>
+void runOnThreads(uint threadCount, Func func) {
+  auto threads = zc::heapArrayBuilder<zc::Own<zc::Thread>>(threadCount);
+  for (uint t : zc::zeroTo(threadCount)) {
+    threads.add(zc::heap<zc::Thread>([&func, t]() { func(t); }));
+  }
+}
+
+constexpr uint BENCHMARK_THREADS = 8;
+constexpr uint BENCHMARK_KEYS = 10000;
+constexpr uint BENCHMARK_OPS = 200000;
+
+uint benchmarkKey(uint thread, uint i) { return (i * 7919 + thread * 104729) % BENCHMARK_KEYS; }
+
+ZC_TEST("benchmark: MutexGuarded<HashMap> shared by threads") {
+  MutexGuarded<HashMap<uint, uint>> map;
+  for (uint i : zc::zeroTo(BENCHMARK_KEYS)) { map.lockExclusive()->insert(i, i); }
+
+  // Mostly reads, with one write in sixteen, as in a cache.
+  runOnThreads(BENCHMARK_THREADS, [&](uint t) {
+    for (uint i : zc::zeroTo(BENCHMARK_OPS)) {
+      uint key = benchmarkKey(t, i);
+      if (i % 16 == 0) {
+        map.lockExclusive()->upsert(key, i);
+      } else {
+        ZC_ASSERT(map.lockShared()->find(key) != zc::none);
+      }
+    }
+  });
+}
+
+ZC_TEST("benchmark: ConcurrentHashMap shared by threads") {
+  ConcurrentHashMap<uint, uint> map;
+  for (uint i : zc::zeroTo(BENCHMARK_KEYS)) { map.upsert(i, i); }
+
+  runOnThreads(BENCHMARK_THREADS, [&](uint t) {
+    for (uint i : zc::zeroTo(BENCHMARK_OPS)) {
+      uint key = benchmarkKey(t, i);
+      if (i % 16 == 0) {
+        map.upsert(key, i);
+      } else {
+        ZC_ASSERT(map.find(key) != zc::none);
+      }
+    }
+  });
+}
+
+}  // namespace
+}  // namespace _
+}  // namespace zc
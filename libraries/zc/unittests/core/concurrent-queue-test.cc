@@ -0,0 +1,308 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#if _WIN32
+#include "zc/core/win32-api-version.h"
+#endif
+
+#include "zc/core/concurrent-queue.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/mutex.h"
+#include "zc/core/string.h"
+#include "zc/core/thread.h"
+#include "zc/core/time.h"
+
+#if _WIN32
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <sched.h>
+#endif
+
+namespace zc {
+namespace {
+
+void yieldThread() {
+#if _WIN32
+  Sleep(0);
+#else
+  sched_yield();
+#endif
+}
+
+template <typename Func>
+void runOnThreads(uint threadCount, Func&& func) {
+  auto threads = heapArrayBuilder<Own<Thread>>(threadCount);
+  for (uint t : zeroTo(threadCount)) {
+    threads.add(heap<Thread>([&func, t]() { func(t); }));
+  }
+}
+
+ZC_TEST("MpmcQueue") {
+  MpmcQueue<String> queue(3);
+  ZC_EXPECT(queue.capacity() == 4);
+  ZC_EXPECT(queue.isEmpty());
+  ZC_EXPECT(queue.tryPop() == zc::none);
+
+  for (uint i : zeroTo(4)) { ZC_EXPECT(queue.tryPush(str(i))); }
+  auto extra = str("extra");
+  ZC_EXPECT(!queue.tryPush(zc::mv(extra)));
+  ZC_EXPECT(extra == "extra");
+  ZC_EXPECT(queue.size() == 4);
+
+  // Go around the ring a few times.
+  for (uint i : zeroTo(20)) {
+    ZC_EXPECT(ZC_ASSERT_NONNULL(queue.tryPop()) == str(i));
+    ZC_EXPECT(queue.tryPush(str(i + 4)));
+  }
+
+  // Values left in the queue are destroyed with it.
+}
+
+ZC_TEST("MpmcQueue from many threads") {
+  constexpr uint PRODUCERS = 4;
+  constexpr uint CONSUMERS = 4;
+  constexpr uint PER_PRODUCER = 20000;
+  MpmcQueue<uint> queue(64);
+
+  MutexGuarded<Vector<uint>> received;
+  uint remaining = PRODUCERS * PER_PRODUCER;
+  runOnThreads(PRODUCERS + CONSUMERS, [&](uint t) {
+    if (t < PRODUCERS) {
+      for (uint i : zeroTo(PER_PRODUCER)) {
+        uint value = t * PER_PRODUCER + i;
+        while (!queue.tryPush(zc::mv(value))) { yieldThread(); }
+      }
+    } else {
+      Vector<uint> mine;
+      while (__atomic_load_n(&remaining, __ATOMIC_RELAXED) > 0) {
+        ZC_IF_SOME(value, queue.tryPop()) {
+          mine.add(value);
+          __atomic_sub_fetch(&remaining, 1, __ATOMIC_RELAXED);
+        } else {
+          yieldThread();
+        }
+      }
+      received.lockExclusive()->addAll(mine);
+    }
+  });
+
+  // Every value arrives exactly once.
+  auto lock = received.lockExclusive();
+  ZC_ASSERT(lock->size() == PRODUCERS * PER_PRODUCER);
+  auto seen = heapArray<bool>(PRODUCERS * PER_PRODUCER);
+  for (auto& b : seen) b = false;
+  for (uint value : *lock) {
+    ZC_ASSERT(!seen[value], value);
+    seen[value] = true;
+  }
+}
+
+ZC_TEST("WorkStealingDeque") {
+  WorkStealingDeque<uint> deque(2);
+  ZC_EXPECT(deque.pop() == zc::none);
+  ZC_EXPECT(deque.steal() == zc::none);
+
+  // Grows past its initial capacity.
+  for (uint i : zeroTo(100)) { deque.push(i); }
+  ZC_EXPECT(deque.size() == 100);
+
+  // The owner pops LIFO; thieves steal FIFO.
+  ZC_EXPECT(ZC_ASSERT_NONNULL(deque.pop()) == 99);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(deque.steal()) == 0);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(deque.steal()) == 1);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(deque.pop()) == 98);
+  ZC_EXPECT(deque.size() == 96);
+
+  while (deque.pop() != zc::none) {}
+  ZC_EXPECT(deque.isEmpty());
+  ZC_EXPECT(deque.steal() == zc::none);
+}
+
+ZC_TEST("WorkStealingDeque with thieves") {
+  constexpr uint THIEVES = 3;
+  constexpr uint ITEMS = 100000;
+  WorkStealingDeque<uint> deque(16);
+
+  auto taken = heapArray<uint>(ITEMS);
+  for (auto& count : taken) count = 0;
+  uint remaining = ITEMS;
+  auto take = [&](uint value) {
+    __atomic_add_fetch(&taken[value], 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&remaining, 1, __ATOMIC_RELAXED);
+  };
+
+  runOnThreads(THIEVES + 1, [&](uint t) {
+    if (t == 0) {
+      // The owner interleaves pushes and pops, and keeps popping once it has pushed everything.
+      for (uint i : zeroTo(ITEMS)) {
+        deque.push(i);
+        if (i % 3 == 0) {
+          ZC_IF_SOME(value, deque.pop()) { take(value); }
+        }
+      }
+      while (__atomic_load_n(&remaining, __ATOMIC_RELAXED) > 0) {
+        ZC_IF_SOME(value, deque.pop()) { take(value); }
+      }
+    } else {
+      while (__atomic_load_n(&remaining, __ATOMIC_RELAXED) > 0) {
+        ZC_IF_SOME(value, deque.steal()) {
+          take(value);
+        } else {
+          yieldThread();
+        }
+      }
+    }
+  });
+
+  for (uint i : zeroTo(ITEMS)) { ZC_ASSERT(taken[i] == 1, i, taken[i]); }
+}
+
+ZC_TEST("MpmcQueue calls its waker") {
+  class CountingWaker final : public QueueWaker {
+  public:
+    void wake() const override { ++count; }
+    mutable uint count = 0;
+  };
+
+  CountingWaker waker;
+  MpmcQueue<uint> queue(2);
+  queue.setWaker(waker);
+  ZC_EXPECT(queue.tryPush(1));
+  ZC_EXPECT(queue.tryPush(2));
+  ZC_EXPECT(!queue.tryPush(3));
+  ZC_EXPECT(waker.count == 2);
+
+  WorkStealingDeque<uint> deque;
+  deque.setWaker(waker);
+  deque.push(1);
+  ZC_EXPECT(waker.count == 3);
+
+  queue.setWaker(zc::none);
+  queue.tryPop();
+  ZC_EXPECT(queue.tryPush(4));
+  ZC_EXPECT(waker.count == 3);
+}
+
+constexpr uint BENCHMARK_ITEMS = 400000;
+
+template <typename Queue>
+void benchmarkThroughput(uint producers, uint consumers) {
+  // Moves BENCHMARK_ITEMS values from `producers` threads to `consumers` threads.
+  Queue queue;
+  uint perProducer = BENCHMARK_ITEMS / producers;
+  uint remaining = perProducer * producers;
+  runOnThreads(producers + consumers, [&](uint t) {
+    if (t < producers) {
+      for (uint i : zeroTo(perProducer)) {
+        while (!queue.tryPush(i)) { yieldThread(); }
+      }
+    } else {
+      while (__atomic_load_n(&remaining, __ATOMIC_RELAXED) > 0) {
+        if (queue.tryPop()) {
+          __atomic_sub_fetch(&remaining, 1, __ATOMIC_RELAXED);
+        } else {
+          yieldThread();
+        }
+      }
+    }
+  });
+}
+
+class LockFreeBenchmarkQueue {
+public:
+  bool tryPush(uint value) { return queue.tryPush(zc::mv(value)); }
+  bool tryPop() { return queue.tryPop() != zc::none; }
+
+private:
+  MpmcQueue<uint> queue{1024};
+};
+
+class MutexBenchmarkQueue {
+  // The same bounded ring as MpmcQueue, behind a mutex.
+
+public:
+  bool tryPush(uint value) {
+    auto lock = state.lockExclusive();
+    if (lock->end - lock->begin == 1024) return false;
+    lock->ring[lock->end++ % 1024] = value;
+    return true;
+  }
+  bool tryPop() {
+    auto lock = state.lockExclusive();
+    if (lock->begin == lock->end) return false;
+    ++lock->begin;
+    return true;
+  }
+
+private:
+  struct State {
+    uint ring[1024];
+    size_t begin = 0;
+    size_t end = 0;
+  };
+  MutexGuarded<State> state;
+};
+
+ZC_TEST("benchmark: MpmcQueue throughput") {
+  benchmarkThroughput<LockFreeBenchmarkQueue>(1, 1);
+  benchmarkThroughput<LockFreeBenchmarkQueue>(2, 2);
+  benchmarkThroughput<LockFreeBenchmarkQueue>(4, 4);
+}
+
+ZC_TEST("benchmark: MutexGuarded ring buffer throughput") {
+  benchmarkThroughput<MutexBenchmarkQueue>(1, 1);
+  benchmarkThroughput<MutexBenchmarkQueue>(2, 2);
+  benchmarkThroughput<MutexBenchmarkQueue>(4, 4);
+}
+
+ZC_TEST("benchmark: MpmcQueue round-trip latency") {
+  // Ping-pong a token between two threads and report the mean round trip.
+  constexpr uint ROUND_TRIPS = 20000;
+  MpmcQueue<uint> ping(2);
+  MpmcQueue<uint> pong(2);
+
+  auto start = systemPreciseMonotonicClock().now();
+  runOnThreads(2, [&](uint t) {
+    MpmcQueue<uint>& in = t == 0 ? pong : ping;
+    MpmcQueue<uint>& out = t == 0 ? ping : pong;
+    if (t == 0) { ZC_ASSERT(out.tryPush(0)); }
+    for (uint i ZC_UNUSED : zeroTo(t == 0 ? ROUND_TRIPS - 1 : ROUND_TRIPS)) {
+      for (;;) {
+        ZC_IF_SOME(value, in.tryPop()) {
+          ZC_ASSERT(out.tryPush(value + 1));
+          break;
+        }
+        yieldThread();
+      }
+    }
+  });
+  auto elapsed = systemPreciseMonotonicClock().now() - start;
+
+  ZC_ASSERT(ZC_ASSERT_NONNULL(pong.tryPop()) == 2 * ROUND_TRIPS - 1);
+  ZC_LOG(INFO, "MpmcQueue round trip", elapsed / ROUND_TRIPS);
+}
+
+}  // namespace
+}  // namespace zc
@@ -24,6 +24,9 @@
 #include <stdint.h>
 #include <zc/ztest/test.h>
 
+#include "zc/core/encoding-simd.h"
+#include "zc/core/vector.h"
+
 namespace zc {
 namespace {
 
@@ -533,5 +536,333 @@ ZC_TEST("base64 url encoding") {
   }
 }
 
+// =======================================================================================
+// SIMD kernels
+//
+// The tests above mostly use inputs too short to reach the vector loops of the SIMD kernels (ctest
+// runs them once per level anyway, with ZC_ENCODING_SIMD). The tests below compare every level the
+// CPU supports against the scalar kernels on long random inputs, where each interesting sequence
+// lands at every offset within a vector.
+
+constexpr _::SimdLevel SIMD_LEVELS[] = {_::SimdLevel::SCALAR, _::SimdLevel::SSE4,
+                                        _::SimdLevel::AVX2};
+
+template <typename Func>
+void forEachSimdLevel(Func&& func) {
+  // Calls `func` once with each set of kernels the CPU supports selected.
+  auto original = _::getEncodingKernels().level;
+  ZC_DEFER(_::setEncodingSimdLevel(original));
+  for (auto level : SIMD_LEVELS) {
+    if (_::setEncodingSimdLevel(level)) func(level);
+  }
+}
+
+template <typename Func>
+auto withScalarKernels(Func&& func) {
+  auto original = _::getEncodingKernels().level;
+  ZC_DEFER(_::setEncodingSimdLevel(original));
+  _::setEncodingSimdLevel(_::SimdLevel::SCALAR);
+  return func();
+}
+
+template <typename T>
+void expectSame(const EncodingResult<Array<T>>& actual, const EncodingResult<Array<T>>& expected,
+                _::SimdLevel level) {
+  ZC_ASSERT(actual.asPtr() == expected.asPtr(), static_cast<uint>(level));
+  ZC_ASSERT(actual.hadErrors == expected.hadErrors, static_cast<uint>(level));
+}
+
+void expectSame(const EncodingResult<String>& actual, const EncodingResult<String>& expected,
+                _::SimdLevel level) {
+  ZC_ASSERT(actual == expected, static_cast<uint>(level));
+  ZC_ASSERT(actual.hadErrors == expected.hadErrors, static_cast<uint>(level));
+}
+
+class Random {
+  // Deterministic, so that failures reproduce.
+
+public:
+  uint next() {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return state >> 33;
+  }
+  uint below(uint n) { return next() % n; }
+  byte nextByte() { return next(); }
+
+private:
+  uint64_t state = 1;
+};
+
+const StringPtr UTF8_PIECES[] = {
+    // Valid sequences, including the edges of each range.
+    "\xc2\x80", "\xdf\xbf", "\xe0\xa0\x80", "\xe2\x82\xac", "\xed\x9f\xbf", "\xee\x80\x80",
+    "\xef\xbf\xbf", "\xf0\x90\x80\x80", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf",
+    // Overlong sequences.
+    "\xc0\x80", "\xc1\xbf", "\xe0\x80\x80", "\xe0\x9f\xbf", "\xf0\x80\x80\x80", "\xf0\x8f\xbf\xbf",
+    // Surrogates, alone and as pairs.
+    "\xed\xa0\x80", "\xed\xbf\xbf", "\xed\xa0\xbd\xed\xb8\x80",
+    // Beyond U+10FFFF, and bytes that never appear.
+    "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xfe", "\xff",
+    // Stray continuations and truncated sequences.
+    "\x80", "\xbf", "\xc2", "\xe2\x82", "\xf0\x9f\x98", "\xf0\x9f",
+};
+
+String randomUtf8(Random& random) {
+  Vector<char> text;
+  for (uint piece = random.below(8); piece > 0; piece--) {
+    for (uint n = random.below(80); n > 0; n--) text.add(' ' + random.below(95));
+    if (random.below(8) == 0) {
+      for (uint n = random.below(5); n > 0; n--) text.add(0x80 | random.nextByte());
+    } else {
+      text.addAll(UTF8_PIECES[random.below(zc::size(UTF8_PIECES))]);
+    }
+  }
+  for (uint n = random.below(40); n > 0; n--) text.add(' ' + random.below(95));
+  text.add('\0');
+  return String(text.releaseAsArray());
+}
+
+Array<byte> randomBytes(Random& random, size_t size, bool ascii) {
+  auto result = heapArray<byte>(size);
+  for (byte& b : result) b = ascii ? random.below(0x80) : random.nextByte();
+  return result;
+}
+
+ZC_TEST("SIMD kernels: UTF-8 validation and transcoding") {
+  Random random;
+  for (uint round ZC_UNUSED : zeroTo(3000)) {
+    auto text = randomUtf8(random);
+    auto utf16 = withScalarKernels([&]() { return encodeUtf16(text); });
+    auto utf32 = withScalarKernels([&]() { return encodeUtf32(text); });
+    auto back16 = withScalarKernels([&]() { return decodeUtf16(utf16); });
+    auto back32 = withScalarKernels([&]() { return decodeUtf32(utf32); });
+
+    forEachSimdLevel([&](_::SimdLevel level) {
+      ZC_ASSERT(validateUtf8(text) == !utf16.hadErrors, text, static_cast<uint>(level));
+      expectSame(encodeUtf16(text), utf16, level);
+      expectSame(encodeUtf32(text), utf32, level);
+      expectSame(decodeUtf16(utf16), back16, level);
+      expectSame(decodeUtf32(utf32), back32, level);
+    });
+  }
+
+  forEachSimdLevel([&](_::SimdLevel level) {
+    ZC_EXPECT(validateUtf8(""));
+    ZC_EXPECT(validateUtf8(u8"ascii, ¢, € and \U00010348"));
+    ZC_EXPECT(!validateUtf8("truncated at the very end \xe2\x82"));
+
+    // An error in the last byte of a vector, or an incomplete sequence ending one.
+    for (size_t size : {15, 16, 17, 31, 32, 33, 63, 64, 65}) {
+      auto text = heapArray<char>(size);
+      memset(text.begin(), 'x', size);
+      ZC_EXPECT(validateUtf8(text));
+      text.back() = '\xff';
+      ZC_EXPECT(!validateUtf8(text), size);
+      text.back() = '\xe2';
+      ZC_EXPECT(!validateUtf8(text), size);
+      text[size - 2] = '\xc2';
+      text.back() = '\x80';
+      ZC_EXPECT(validateUtf8(text), size);
+    }
+  });
+}
+
+ZC_TEST("SIMD kernels: hex") {
+  Random random;
+  for (uint round ZC_UNUSED : zeroTo(1000)) {
+    auto bytes = randomBytes(random, random.below(200), false);
+    auto hex = withScalarKernels([&]() { return encodeHex(bytes); });
+    for (auto i : zc::indices(bytes)) {
+      ZC_ASSERT(hex[i * 2] == "0123456789abcdef"[bytes[i] / 16]);
+      ZC_ASSERT(hex[i * 2 + 1] == "0123456789abcdef"[bytes[i] % 16]);
+    }
+
+    // Mixed case, and sometimes an invalid digit or an odd length.
+    auto text = heapArray<char>(hex.asArray());
+    for (char& c : text) {
+      if (random.below(2) == 0 && c >= 'a') c -= 'a' - 'A';
+    }
+    if (text.size() > 0 && random.below(3) == 0) {
+      text[random.below(text.size())] = "g/:@G\x80 "[random.below(7)];
+    }
+    size_t size = text.size() - (text.size() > 0 && random.below(4) == 0);
+    auto decoded = withScalarKernels([&]() { return decodeHex(text.first(size)); });
+
+    forEachSimdLevel([&](_::SimdLevel level) {
+      ZC_ASSERT(encodeHex(bytes) == hex, static_cast<uint>(level));
+      expectSame(decodeHex(hex), EncodingResult<Array<byte>>(heapArray<byte>(bytes), false), level);
+      expectSame(decodeHex(text.first(size)), decoded, level);
+    });
+  }
+}
+
+ZC_TEST("SIMD kernels: base64") {
+  Random random;
+  for (uint round ZC_UNUSED : zeroTo(1000)) {
+    auto bytes = randomBytes(random, random.below(300), false);
+    auto base64 = withScalarKernels([&]() { return encodeBase64(bytes); });
+    auto lines = withScalarKernels([&]() { return encodeBase64(bytes, true); });
+    auto url = withScalarKernels([&]() { return encodeBase64Url(bytes); });
+    expectSame(withScalarKernels([&]() { return decodeBase64(base64); }),
+               EncodingResult<Array<byte>>(heapArray<byte>(bytes), false), _::SimdLevel::SCALAR);
+
+    // Line breaks every 72 characters, and the URL-safe alphabet without padding.
+    Vector<char> expectedLines;
+    Vector<char> expectedUrl;
+    for (size_t i = 0; i < base64.size(); i += 72) {
+      expectedLines.addAll(base64.asArray().slice(i, zc::min(base64.size(), i + 72)));
+      expectedLines.add('\n');
+    }
+    for (char c : base64) {
+      if (c != '=') expectedUrl.add(c == '+' ? '-' : c == '/' ? '_' : c);
+    }
+    ZC_ASSERT(lines == expectedLines.asPtr());
+    ZC_ASSERT(url == expectedUrl.asPtr());
+
+    // Corrupt the encoding with whitespace, padding and invalid characters, at any offset.
+    Vector<char> corrupt;
+    for (char c : base64) {
+      if (random.below(64) == 0) corrupt.add(" \n=*-_"[random.below(6)]);
+      corrupt.add(c);
+    }
+    auto corruptDecoded = withScalarKernels([&]() { return decodeBase64(corrupt.asPtr()); });
+
+    forEachSimdLevel([&](_::SimdLevel level) {
+      ZC_ASSERT(encodeBase64(bytes) == base64, static_cast<uint>(level));
+      ZC_ASSERT(encodeBase64(bytes, true) == lines, static_cast<uint>(level));
+      ZC_ASSERT(encodeBase64Url(bytes) == url, static_cast<uint>(level));
+      expectSame(decodeBase64(base64), EncodingResult<Array<byte>>(heapArray<byte>(bytes), false),
+                 level);
+      expectSame(decodeBase64(lines), EncodingResult<Array<byte>>(heapArray<byte>(bytes), false),
+                 level);
+      expectSame(decodeBase64(corrupt.asPtr()), corruptDecoded, level);
+    });
+  }
+}
+
+ZC_TEST("SIMD kernels: URI encoding") {
+  Random random;
+  for (uint round ZC_UNUSED : zeroTo(1000)) {
+    auto bytes = randomBytes(random, random.below(200), random.below(4) != 0);
+    auto component = withScalarKernels([&]() { return encodeUriComponent(bytes); });
+    auto fragment = withScalarKernels([&]() { return encodeUriFragment(bytes); });
+    auto path = withScalarKernels([&]() { return encodeUriPath(bytes); });
+    auto userInfo = withScalarKernels([&]() { return encodeUriUserInfo(bytes); });
+    auto form = withScalarKernels([&]() { return encodeWwwForm(bytes); });
+
+    // Text with escapes that are sometimes broken.
+    Vector<char> text;
+    for (uint n = random.below(200); n > 0; n--) {
+      text.add(random.below(16) == 0 ? "%+"[random.below(2)] : "0a-F~ "[random.below(6)]);
+    }
+    DecodeUriOptions plusToSpace{/*.nulTerminate=*/false, /*.plusToSpace=*/true};
+    auto decoded = withScalarKernels([&]() { return decodeBinaryUriComponent(text); });
+    auto formDecoded = withScalarKernels([&]() {
+      return decodeBinaryUriComponent(text, plusToSpace);
+    });
+
+    forEachSimdLevel([&](_::SimdLevel level) {
+      ZC_ASSERT(encodeUriComponent(bytes) == component, static_cast<uint>(level));
+      ZC_ASSERT(encodeUriFragment(bytes) == fragment, static_cast<uint>(level));
+      ZC_ASSERT(encodeUriPath(bytes) == path, static_cast<uint>(level));
+      ZC_ASSERT(encodeUriUserInfo(bytes) == userInfo, static_cast<uint>(level));
+      ZC_ASSERT(encodeWwwForm(bytes) == form, static_cast<uint>(level));
+
+      EncodingResult<Array<byte>> expected(heapArray<byte>(bytes), false);
+      expectSame(decodeBinaryUriComponent(component), expected, level);
+      expectSame(decodeBinaryUriComponent(form, plusToSpace), expected, level);
+      expectSame(decodeBinaryUriComponent(text), decoded, level);
+      expectSame(decodeBinaryUriComponent(text, plusToSpace), formDecoded, level);
+    });
+  }
+}
+
+#if defined(ZC_DEBUG) && !__OPTIMIZE__
+constexpr size_t BENCHMARK_BYTES = 1 << 17;
+#else
+constexpr size_t BENCHMARK_BYTES = 1 << 21;
+#endif
+constexpr size_t BENCHMARK_CHUNK = 1 << 16;
+// Each benchmark below processes BENCHMARK_BYTES of input, BENCHMARK_CHUNK at a time, so its
+// throughput is BENCHMARK_BYTES divided by its run time. The sizes are kept as small as the table
+// benchmarks', since these run as part of the ordinary test suite. On CPUs that lack a level, its
+// benchmarks do nothing.
+
+template <typename Func>
+void simdBenchmark(_::SimdLevel level, Func&& func) {
+  auto original = _::getEncodingKernels().level;
+  ZC_DEFER(_::setEncodingSimdLevel(original));
+  if (!_::setEncodingSimdLevel(level)) return;
+  for (size_t done = 0; done < BENCHMARK_BYTES; done += BENCHMARK_CHUNK) func();
+}
+
+String benchmarkText(StringPtr sentence) {
+  Vector<char> text(BENCHMARK_CHUNK + 1);
+  while (text.size() + sentence.size() <= BENCHMARK_CHUNK) text.addAll(sentence);
+  while (text.size() < BENCHMARK_CHUNK) text.add(' ');
+  text.add('\0');
+  return String(text.releaseAsArray());
+}
+
+void benchmarkValidateUtf8(_::SimdLevel level) {
+  // Mostly ASCII, as in most JSON or chat messages.
+  auto text = benchmarkText(u8"The quick brown fox jumps over the lazy dog. Ünïcødé: € 😀. ");
+  simdBenchmark(level, [&]() { ZC_ASSERT(validateUtf8(text)); });
+}
+
+void benchmarkEncodeUtf16(_::SimdLevel level) {
+  auto text = benchmarkText("{\"type\": \"message\", \"id\": 12345, \"text\": \"hello world\"}, ");
+  simdBenchmark(level, [&]() { ZC_ASSERT(!encodeUtf16(text).hadErrors); });
+}
+
+void benchmarkEncodeHex(_::SimdLevel level) {
+  Random random;
+  auto bytes = randomBytes(random, BENCHMARK_CHUNK, false);
+  simdBenchmark(level, [&]() { ZC_ASSERT(encodeHex(bytes).size() == BENCHMARK_CHUNK * 2); });
+}
+
+void benchmarkEncodeBase64(_::SimdLevel level) {
+  Random random;
+  auto bytes = randomBytes(random, BENCHMARK_CHUNK, false);
+  simdBenchmark(level, [&]() { ZC_ASSERT(encodeBase64(bytes).size() > BENCHMARK_CHUNK); });
+}
+
+void benchmarkDecodeBase64(_::SimdLevel level) {
+  Random random;
+  auto base64 = encodeBase64(randomBytes(random, BENCHMARK_CHUNK / 4 * 3, false));
+  simdBenchmark(level, [&]() { ZC_ASSERT(!decodeBase64(base64).hadErrors); });
+}
+
+void benchmarkEncodeUriComponent(_::SimdLevel level) {
+  auto text = benchmarkText("/search?q=simd+base64&lang=en-US&page=2 ");
+  simdBenchmark(level, [&]() { ZC_ASSERT(encodeUriComponent(text).size() > BENCHMARK_CHUNK); });
+}
+
+ZC_TEST("benchmark: validateUtf8, scalar") { benchmarkValidateUtf8(_::SimdLevel::SCALAR); }
+ZC_TEST("benchmark: validateUtf8, SSE4") { benchmarkValidateUtf8(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: validateUtf8, AVX2") { benchmarkValidateUtf8(_::SimdLevel::AVX2); }
+
+ZC_TEST("benchmark: encodeUtf16, scalar") { benchmarkEncodeUtf16(_::SimdLevel::SCALAR); }
+ZC_TEST("benchmark: encodeUtf16, SSE4") { benchmarkEncodeUtf16(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: encodeUtf16, AVX2") { benchmarkEncodeUtf16(_::SimdLevel::AVX2); }
+
+ZC_TEST("benchmark: encodeHex, scalar") { benchmarkEncodeHex(_::SimdLevel::SCALAR); }
+ZC_TEST("benchmark: encodeHex, SSE4") { benchmarkEncodeHex(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: encodeHex, AVX2") { benchmarkEncodeHex(_::SimdLevel::AVX2); }
+
+ZC_TEST("benchmark: encodeBase64, scalar") { benchmarkEncodeBase64(_::SimdLevel::SCALAR); }
+ZC_TEST("benchmark: encodeBase64, SSE4") { benchmarkEncodeBase64(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: encodeBase64, AVX2") { benchmarkEncodeBase64(_::SimdLevel::AVX2); }
+
+ZC_TEST("benchmark: decodeBase64, scalar") { benchmarkDecodeBase64(_::SimdLevel::SCALAR); }
+ZC_TEST("benchmark: decodeBase64, SSE4") { benchmarkDecodeBase64(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: decodeBase64, AVX2") { benchmarkDecodeBase64(_::SimdLevel::AVX2); }
+
+ZC_TEST("benchmark: encodeUriComponent, scalar") {
+  benchmarkEncodeUriComponent(_::SimdLevel::SCALAR);
+}
+ZC_TEST("benchmark: encodeUriComponent, SSE4") { benchmarkEncodeUriComponent(_::SimdLevel::SSE4); }
+ZC_TEST("benchmark: encodeUriComponent, AVX2") { benchmarkEncodeUriComponent(_::SimdLevel::AVX2); }
+
 }  // namespace
 }  // namespace zc
@@ -255,6 +255,118 @@ ZC_TEST("exception details") {
   ZC_EXPECT(zc::str(ZC_ASSERT_NONNULL(e2.getDetail(456)).asChars()) == "bar");
 }
 
+ZC_TEST("string literal descriptions are not copied") {
+  auto e = ZC_EXCEPTION(DISCONNECTED, "connection closed");
+  ZC_EXPECT(e.getDescription() == "connection closed");
+  Exception copy = e;
+  ZC_EXPECT(copy.getDescription().begin() == e.getDescription().begin());
+  Exception moved = zc::mv(copy);
+  ZC_EXPECT(moved.getDescription() == "connection closed");
+
+  // Anything else is formatted into the exception.
+  int fd = 3;
+  auto formatted = ZC_EXCEPTION(DISCONNECTED, "connection closed", fd);
+  ZC_EXPECT(formatted.getDescription() == "connection closed; fd = 3");
+  Exception formattedCopy = formatted;
+  ZC_EXPECT(formattedCopy.getDescription().begin() != formatted.getDescription().begin());
+  ZC_EXPECT(formattedCopy.getDescription() == formatted.getDescription());
+
+  char buffer[] = "temporary";
+  auto fromArray = ZC_EXCEPTION(FAILED, buffer);
+  buffer[0] = 'X';
+  ZC_EXPECT(fromArray.getDescription() == "buffer = temporary");
+
+  e.setDescription(zc::str("replaced"));
+  ZC_EXPECT(e.getDescription() == "replaced");
+  Exception replacedCopy = e;
+  ZC_EXPECT(replacedCopy.getDescription().begin() != e.getDescription().begin());
+  ZC_EXPECT(replacedCopy.getDescription() == "replaced");
+
+  // ZC_FAIL_*() macros take the same shortcut, ZC_REQUIRE() and friends can't.
+  auto failed = ZC_ASSERT_NONNULL(runCatchingExceptions([]() { ZC_FAIL_REQUIRE("gave up"); }));
+  ZC_EXPECT(failed.getDescription() == "gave up");
+  auto required = ZC_ASSERT_NONNULL(runCatchingExceptions([]() {
+    bool ok = false;
+    ZC_REQUIRE(ok, "gave up");
+  }));
+  ZC_EXPECT(required.getDescription() == "expected ok; gave up");
+
+  // A failure inside the recovery block of another one.
+  bool recovered = false;
+  auto nested = ZC_ASSERT_NONNULL(runCatchingExceptions([&]() {
+    ZC_FAIL_ASSERT("outer") {
+      auto inner = runCatchingExceptions([]() { ZC_FAIL_ASSERT("inner"); });
+      ZC_EXPECT(ZC_ASSERT_NONNULL(inner).getDescription() == "inner");
+      recovered = true;
+      break;
+    }
+  }));
+  ZC_EXPECT(recovered);
+  ZC_EXPECT(nested.getDescription() == "outer");
+}
+
+ZC_NOINLINE void throwDisconnected() {
+  throwRecoverableException(ZC_EXCEPTION(DISCONNECTED, "connection closed"));
+}
+
+ZC_NOINLINE void throwFailed() { throwRecoverableException(ZC_EXCEPTION(FAILED, "broken")); }
+
+ZC_TEST("setStackTraceEnabled()") {
+  ZC_EXPECT(isStackTraceEnabled(Exception::Type::DISCONNECTED));
+  setStackTraceEnabled(Exception::Type::DISCONNECTED, false);
+  ZC_DEFER(setStackTraceEnabled(Exception::Type::DISCONNECTED, true));
+  ZC_EXPECT(!isStackTraceEnabled(Exception::Type::DISCONNECTED));
+  ZC_EXPECT(isStackTraceEnabled(Exception::Type::FAILED));
+
+  try {
+    throwDisconnected();
+    ZC_FAIL_EXPECT("didn't throw");
+  } catch (const Exception& e) {
+    ZC_EXPECT(e.getType() == Exception::Type::DISCONNECTED);
+    ZC_EXPECT(e.getStackTrace().size() == 0);
+  }
+
+#if (__linux__ && __GLIBC__) || __APPLE__
+  try {
+    throwFailed();
+    ZC_FAIL_EXPECT("didn't throw");
+  } catch (const Exception& e) {
+    ZC_EXPECT(e.getStackTrace().size() > 0);
+  }
+#endif
+}
+
+ZC_TEST("stringifyStackTrace() gives the same result when frames are cached") {
+  void* space[32];
+  auto trace = zc::getStackTrace(space, 0);
+  auto first = stringifyStackTrace(trace);
+  ZC_EXPECT(stringifyStackTrace(trace) == first);
+  ZC_EXPECT(stringifyStackTrace(trace.first(trace.size() / 2)) ==
+            stringifyStackTrace(trace.first(trace.size() / 2)));
+}
+
+constexpr uint BENCHMARK_THROWS = 200000;
+
+void throwCatchBenchmark() {
+  uint caught = 0;
+  for (uint i ZC_UNUSED : zeroTo(BENCHMARK_THROWS)) {
+    try {
+      throwDisconnected();
+    } catch (const Exception& e) {
+      caught += e.getType() == Exception::Type::DISCONNECTED;
+    }
+  }
+  ZC_EXPECT(caught == BENCHMARK_THROWS);
+}
+
+ZC_TEST("benchmark: throw and catch ZC_EXCEPTION, with stack traces") { throwCatchBenchmark(); }
+
+ZC_TEST("benchmark: throw and catch ZC_EXCEPTION, without stack traces") {
+  setStackTraceEnabled(Exception::Type::DISCONNECTED, false);
+  ZC_DEFER(setStackTraceEnabled(Exception::Type::DISCONNECTED, true));
+  throwCatchBenchmark();
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace zc
@@ -80,6 +80,147 @@ ZC_TEST("GlobFilter") {
   }
 }
 
+bool referenceMatch(StringPtr pattern, StringPtr name) {
+  // Matches the whole of `name` against `pattern`, by brute force.
+  if (pattern.size() == 0) return name.size() == 0;
+  switch (pattern[0]) {
+    case '*':
+      if (referenceMatch(pattern.slice(1), name)) return true;
+      return name.size() > 0 && name[0] != '/' && name[0] != '\\' &&
+             referenceMatch(pattern, name.slice(1));
+    case '?':
+      return name.size() > 0 && name[0] != '/' && name[0] != '\\' &&
+             referenceMatch(pattern.slice(1), name.slice(1));
+    default:
+      return name.size() > 0 && name[0] == pattern[0] &&
+             referenceMatch(pattern.slice(1), name.slice(1));
+  }
+}
+
+bool referenceFilter(StringPtr pattern, StringPtr name) {
+  // A pattern can also match any suffix of the name that follows a separator.
+  if (referenceMatch(pattern, name)) return true;
+  for (uint i : indices(name)) {
+    if ((name[i] == '/' || name[i] == '\\') && referenceMatch(pattern, name.slice(i + 1))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ZC_TEST("GlobSet agrees with a brute-force matcher") {
+  StringPtr patterns[] = {"foo",   "foo*",  "foo*bar", "foo?bar", "*.cc",  "src/*/x?",
+                          "*a*b*", "**",    "?",       "a\\b",    "*/foo", "b*b*b"};
+  GlobSet set(patterns);
+
+  // Names made of characters that the patterns care about, and one they don't.
+  const char alphabet[] = "abfoxr/.c\\z";
+  uint seed = 1;
+  for (uint i ZC_UNUSED : zeroTo(20000)) {
+    seed = seed * 1103515245 + 12345;
+    char name[12];
+    uint size = (seed >> 8) % (sizeof(name) - 1);
+    name[size] = '\0';
+    for (uint j : zeroTo(size)) {
+      seed = seed * 1103515245 + 12345;
+      name[j] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+    }
+    StringPtr namePtr(name, size);
+    auto matching = set.matching(namePtr);
+
+    uint next = 0;
+    for (uint p : indices(patterns)) {
+      bool expected = referenceFilter(patterns[p], namePtr);
+      bool matched = next < matching.size() && matching[next] == p;
+      if (matched) ++next;
+      ZC_ASSERT(matched == expected, patterns[p], namePtr);
+    }
+    ZC_ASSERT(next == matching.size());
+  }
+  ZC_EXPECT(set.stateCount() > 10);
+  ZC_EXPECT(set.byteClassCount() < 16);
+}
+
+ZC_TEST("GlobSet state limit") {
+  // After "*a", the automaton must remember which of the last 12 characters were an 'a', which
+  // takes thousands of states.  With room for only 64, it keeps starting over, but stays correct.
+  StringPtr pattern = "*a????????????";
+  GlobSet set(arrayPtr(&pattern, 1), 64);
+
+  uint seed = 1;
+  uint matched = 0;
+  for (uint i ZC_UNUSED : zeroTo(5000)) {
+    seed = seed * 1103515245 + 12345;
+    char name[32];
+    uint size = (seed >> 8) % (sizeof(name) - 1);
+    name[size] = '\0';
+    for (uint j : zeroTo(size)) {
+      seed = seed * 1103515245 + 12345;
+      name[j] = (seed >> 16) % 16 == 0 ? '/' : "ab"[(seed >> 20) & 1];
+    }
+    StringPtr namePtr(name, size);
+    bool expected = referenceFilter(pattern, namePtr);
+    ZC_ASSERT(set.matchesAny(namePtr) == expected, namePtr);
+    ZC_ASSERT(set.stateCount() <= 64);
+    matched += expected;
+  }
+  ZC_EXPECT(matched > 100);
+}
+
+ZC_TEST("GlobSet builds states once") {
+  StringPtr patterns[] = {"*.cc", "src/*/*.h", "*test*"};
+  GlobSet set(patterns);
+  StringPtr names[] = {"src/foo/bar.h", "a/b/c-test.cc", "src/x.cc", "README"};
+  for (auto name : names) set.matching(name);
+  size_t states = set.stateCount();
+  for (uint i ZC_UNUSED : zeroTo(10)) {
+    for (auto name : names) set.matching(name);
+  }
+  ZC_EXPECT(set.stateCount() == states);
+
+  ZC_EXPECT(set.matching("src/foo/bar.h"_zc) == ArrayPtr<const uint>({1}));
+  ZC_EXPECT(set.matching("a/b/c-test.cc"_zc) == ArrayPtr<const uint>({0, 2}));
+  ZC_EXPECT(set.matching("README"_zc).size() == 0);
+}
+
+Array<String> benchmarkPatterns() {
+  auto patterns = heapArrayBuilder<String>(200);
+  for (uint i : zeroTo(100)) patterns.add(str("src/module", i, "/*.cc"));
+  for (uint i : zeroTo(100)) patterns.add(str("*test", i, "*.h"));
+  return patterns.finish();
+}
+
+Array<String> benchmarkNames() {
+  auto names = heapArrayBuilder<String>(20000);
+  for (uint i : zeroTo(20000)) {
+    names.add(str("/home/user/project/src/module", i % 150, "/file", i, i % 2 ? ".cc" : ".h"));
+  }
+  return names.finish();
+}
+
+ZC_TEST("benchmark: 200 GlobFilters") {
+  auto patterns = benchmarkPatterns();
+  auto names = benchmarkNames();
+  auto filters = heapArrayBuilder<GlobFilter>(patterns.size());
+  for (auto& pattern : patterns) filters.add(pattern.asArray());
+  uint matched = 0;
+  for (auto& name : names) {
+    for (auto& filter : filters) matched += filter.matches(name);
+  }
+  ZC_EXPECT(matched > 0);
+}
+
+ZC_TEST("benchmark: GlobSet of 200 patterns") {
+  auto patterns = benchmarkPatterns();
+  auto names = benchmarkNames();
+  auto patternPtrs = heapArrayBuilder<StringPtr>(patterns.size());
+  for (auto& pattern : patterns) patternPtrs.add(pattern);
+  GlobSet set(patternPtrs.asPtr());
+  uint matched = 0;
+  for (auto& name : names) matched += set.matching(name).size();
+  ZC_EXPECT(matched > 0);
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace zc
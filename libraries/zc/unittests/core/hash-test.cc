@@ -0,0 +1,167 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/hash.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/map.h"
+
+namespace zc {
+namespace {
+
+ZC_TEST("hash64 distinguishes lengths and contents") {
+  byte data[200];
+  for (uint i : zeroTo(sizeof(data))) data[i] = i * 7;
+
+  // Every prefix, covering each of the short, medium and long paths, hashes differently.
+  HashSet<uint64_t> seen;
+  for (size_t size : zeroTo(sizeof(data) + 1)) {
+    uint64_t h = hash64(arrayPtr(data, size));
+    ZC_EXPECT(h == hash64(arrayPtr(data, size)));
+    ZC_EXPECT(seen.find(h) == zc::none, size);
+    seen.insert(h);
+  }
+
+  // As do strings of zeros of different lengths.
+  byte zeros[64] = {};
+  ZC_EXPECT(hash64(arrayPtr(zeros, 0)) != hash64(arrayPtr(zeros, 1)));
+  ZC_EXPECT(hash64(arrayPtr(zeros, 17)) != hash64(arrayPtr(zeros, 18)));
+  ZC_EXPECT(hash64(arrayPtr(zeros, 49)) != hash64(arrayPtr(zeros, 64)));
+}
+
+ZC_TEST("hash64 avalanches") {
+  // Flipping any one input bit should flip about half of the output bits.
+  byte data[100];
+  for (uint i : zeroTo(sizeof(data))) data[i] = i * 13 + 5;
+
+  for (size_t size : {3, 8, 16, 33, 100}) {
+    uint64_t base = hash64(arrayPtr(data, size), 1234);
+    uint totalFlipped = 0;
+    for (uint bit : zeroTo(size * 8)) {
+      data[bit / 8] ^= 1 << (bit % 8);
+      uint flipped = __builtin_popcountll(base ^ hash64(arrayPtr(data, size), 1234));
+      data[bit / 8] ^= 1 << (bit % 8);
+      ZC_EXPECT(flipped >= 12, size, bit, flipped);
+      totalFlipped += flipped;
+    }
+    double average = double(totalFlipped) / (size * 8);
+    ZC_EXPECT(average > 28 && average < 36, size, average);
+  }
+}
+
+ZC_TEST("hash64 seeds") {
+  auto data = "some key"_zc.asBytes();
+  ZC_EXPECT(hash64(data, 1) != hash64(data, 2));
+  ZC_EXPECT(hash64(data) == hash64(data, getHashSeed()));
+
+  uint64_t oldSeed = getHashSeed();
+  uint before = hashCode("some key"_zc);
+  uint intBefore = hashCode(12345);
+  setHashSeed(oldSeed + 1);
+  ZC_DEFER(setHashSeed(oldSeed));
+  ZC_EXPECT(hashCode("some key"_zc) != before);
+  ZC_EXPECT(hashCode(12345) == intBefore);
+}
+
+ZC_TEST("hashCode() of strings is the same for every string type") {
+  uint expected = hashCode("hello world"_zc);
+  ZC_EXPECT(hashCode(heapString("hello world")) == expected);
+  ZC_EXPECT(hashCode("hello world"_zcc) == expected);
+  ZC_EXPECT(hashCode(SmallString("hello world"_zc)) == expected);
+  ZC_EXPECT(hashCode("hello world"_zc.asArray()) == expected);
+  ZC_EXPECT(hashCode("hello world"_zc.asBytes()) == expected);
+}
+
+ZC_TEST("hashCode() of strings is uniform in the low bits") {
+  // HashMap picks buckets using only the low bits.
+  constexpr uint KEYS = 8192;
+  constexpr uint BUCKETS = 256;
+  uint counts[BUCKETS] = {};
+  for (uint i : zeroTo(KEYS)) ++counts[hashCode(str("/some/path/", i)) % BUCKETS];
+  for (uint count : counts) ZC_EXPECT(count > 8 && count < 64, count);
+}
+
+uint murmur2(ArrayPtr<const byte> s) {
+  // The hash hashCode() used before hash64(), for comparison.
+  constexpr uint m = 0x5bd1e995;
+  constexpr uint r = 24;
+  uint h = s.size();
+  const byte* data = s.begin();
+  uint len = s.size();
+  for (; len >= 4; data += 4, len -= 4) {
+    uint k;
+    memcpy(&k, data, sizeof(k));
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h *= m;
+    h ^= k;
+  }
+  switch (len) {
+    case 3:
+      h ^= data[2] << 16;
+      ZC_FALLTHROUGH;
+    case 2:
+      h ^= data[1] << 8;
+      ZC_FALLTHROUGH;
+    case 1:
+      h ^= data[0];
+      h *= m;
+  }
+  h ^= h >> 13;
+  h *= m;
+  h ^= h >> 15;
+  return h;
+}
+
+constexpr uint BENCHMARK_BYTES = 1 << 30;
+
+template <typename Func>
+void hashBenchmark(size_t keySize, Func&& func) {
+  auto key = heapArray<byte>(keySize);
+  for (uint i : zeroTo(keySize)) key[i] = i;
+  uint64_t sum = 0;
+  for (uint i : zeroTo(BENCHMARK_BYTES / keySize)) {
+    key[0] = i;
+    sum += func(key.asPtr());
+  }
+  ZC_EXPECT(sum != 0);
+}
+
+ZC_TEST("benchmark: murmur2, 16-byte keys") {
+  hashBenchmark(16, [](ArrayPtr<const byte> key) { return murmur2(key); });
+}
+
+ZC_TEST("benchmark: hash64, 16-byte keys") {
+  hashBenchmark(16, [](ArrayPtr<const byte> key) { return hash64(key); });
+}
+
+ZC_TEST("benchmark: murmur2, 1KiB keys") {
+  hashBenchmark(1024, [](ArrayPtr<const byte> key) { return murmur2(key); });
+}
+
+ZC_TEST("benchmark: hash64, 1KiB keys") {
+  hashBenchmark(1024, [](ArrayPtr<const byte> key) { return hash64(key); });
+}
+
+}  // namespace
+}  // namespace zc
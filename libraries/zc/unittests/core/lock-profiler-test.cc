@@ -0,0 +1,215 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/lock-profiler.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/thread.h"
+#include "zc/core/vector.h"
+
+#if _WIN32
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <unistd.h>
+#endif
+
+namespace zc {
+namespace {
+
+#if _WIN32
+inline void delay() { Sleep(10); }
+#else
+inline void delay() { usleep(10000); }
+#endif
+
+class ProfilingScope {
+  // Profiles the test from a clean slate, and turns profiling off again afterwards.
+public:
+  ProfilingScope() {
+    resetLockProfile();
+    startLockProfiling();
+  }
+  ~ProfilingScope() noexcept(false) { stopLockProfiling(); }
+};
+
+template <typename T>
+Vector<LockProfileEntry> entriesFor(const MutexGuarded<T>& guarded) {
+  // MutexGuarded's mutex is its first member, so it has the same address.
+  Vector<LockProfileEntry> result;
+  for (auto& entry : getLockProfile()) {
+    if (entry.mutex == &guarded) result.add(entry);
+  }
+  return result;
+}
+
+template <typename T>
+LockProfileEntry totalFor(const MutexGuarded<T>& guarded, bool exclusive) {
+  // Adds up the entries for all the sites `guarded` was locked from in the given mode.
+  LockProfileEntry total{};
+  total.exclusive = exclusive;
+  for (auto& entry : entriesFor(guarded)) {
+    if (entry.exclusive != exclusive) continue;
+    total.acquisitions += entry.acquisitions;
+    total.contentions += entry.contentions;
+    total.timeouts += entry.timeouts;
+    total.totalWait += entry.totalWait;
+    total.maxWait = zc::max(total.maxWait, entry.maxWait);
+    total.holds += entry.holds;
+    total.totalHold += entry.totalHold;
+    total.maxHold = zc::max(total.maxHold, entry.maxHold);
+    for (uint i : zeroTo(LockProfileEntry::WAIT_HISTOGRAM_SIZE)) {
+      total.waitHistogram[i] += entry.waitHistogram[i];
+    }
+  }
+  return total;
+}
+
+ZC_TEST("lock profiler counts acquisitions and hold times") {
+  MutexGuarded<uint> value(0);
+  ProfilingScope scope;
+
+  for (uint i ZC_UNUSED : zeroTo(10)) { ++*value.lockExclusive(); }
+  {
+    auto lock = value.lockShared();
+    delay();
+  }
+
+  auto exclusive = totalFor(value, true);
+  auto shared = totalFor(value, false);
+  ZC_EXPECT(exclusive.acquisitions == 10);
+  ZC_EXPECT(exclusive.contentions == 0);
+  ZC_EXPECT(exclusive.holds == 10);
+  ZC_EXPECT(exclusive.totalWait == 0 * NANOSECONDS);
+
+  ZC_EXPECT(shared.acquisitions == 1);
+  ZC_EXPECT(shared.holds == 1);
+  ZC_EXPECT(shared.maxHold >= 10 * MILLISECONDS, shared.maxHold);
+  ZC_EXPECT(shared.totalHold == shared.maxHold);
+}
+
+ZC_TEST("lock profiler measures contention across threads") {
+  MutexGuarded<uint> value(0);
+  ProfilingScope scope;
+
+  {
+    bool locked = false;
+    Thread thread([&]() {
+      auto lock = value.lockExclusive();
+      __atomic_store_n(&locked, true, __ATOMIC_RELEASE);
+      delay();
+      delay();
+    });
+    while (!__atomic_load_n(&locked, __ATOMIC_ACQUIRE)) { delay(); }
+
+#if ZC_USE_FUTEX
+    // Timing out counts as contention, but not as an acquisition.
+    ZC_EXPECT(value.lockExclusiveWithTimeout(1 * MILLISECONDS) == zc::none);
+#endif
+    ++*value.lockExclusive();
+  }
+
+  auto entry = totalFor(value, true);
+  ZC_EXPECT(entry.acquisitions == 2);
+  ZC_EXPECT(entry.holds == 2);
+#if ZC_USE_FUTEX
+  ZC_EXPECT(entry.contentions == 2);
+  ZC_EXPECT(entry.timeouts == 1);
+#else
+  ZC_EXPECT(entry.contentions == 1);
+#endif
+  ZC_EXPECT(entry.maxWait > 0 * NANOSECONDS);
+  ZC_EXPECT(entry.totalWait >= entry.maxWait);
+  ZC_EXPECT(entry.maxHold >= 10 * MILLISECONDS, entry.maxHold);
+
+  uint64_t histogramTotal = 0;
+  for (auto count : entry.waitHistogram) { histogramTotal += count; }
+  ZC_EXPECT(histogramTotal == entry.contentions);
+
+  auto report = dumpLockProfile();
+  ZC_EXPECT(report.contains(", contended "), report);
+  ZC_EXPECT(report.contains("wait histogram: "), report);
+}
+
+ZC_TEST("lock profiler stops, resets and ignores locks held from before it started") {
+  MutexGuarded<uint> value(0);
+  {
+    ProfilingScope scope;
+    *value.lockExclusive() = 1;
+  }
+
+  // Nothing is recorded while stopped, but what was recorded stays.
+  *value.lockExclusive() = 2;
+  ZC_EXPECT(totalFor(value, true).acquisitions == 1);
+
+  auto lock = value.lockExclusive();
+  resetLockProfile();
+  ZC_EXPECT(entriesFor(value).size() == 0);
+
+  // Releasing a lock taken before profiling started is not a hold.
+  startLockProfiling();
+  ZC_DEFER(stopLockProfiling());
+  lock.release();
+  *value.lockShared();
+  ZC_EXPECT(totalFor(value, true).holds == 0);
+  ZC_EXPECT(totalFor(value, false).holds == 1);
+}
+
+#if ZC_SAVE_LOCK_LOCATIONS
+ZC_TEST("lock profiler separates acquisition sites") {
+  MutexGuarded<uint> value(0);
+  ProfilingScope scope;
+
+  uint firstLine = __LINE__ + 1;
+  ++*value.lockExclusive();
+  for (uint i ZC_UNUSED : zeroTo(3)) { ++*value.lockExclusive(); }
+
+  auto entries = entriesFor(value);
+  ZC_ASSERT(entries.size() == 2);
+  auto& first = entries[0].location.lineNumber == firstLine ? entries[0] : entries[1];
+  auto& second = entries[0].location.lineNumber == firstLine ? entries[1] : entries[0];
+  ZC_EXPECT(first.location.lineNumber == firstLine);
+  ZC_EXPECT(first.acquisitions == 1);
+  ZC_EXPECT(second.location.lineNumber == firstLine + 1);
+  ZC_EXPECT(second.acquisitions == 3);
+  ZC_EXPECT(dumpLockProfile().contains("lock-profiler-test.cc"));
+}
+#endif
+
+constexpr uint BENCHMARK_LOCKS = 5000000;
+
+ZC_TEST("benchmark: uncontended MutexGuarded, not profiling") {
+  MutexGuarded<uint> value(0);
+  for (uint i ZC_UNUSED : zeroTo(BENCHMARK_LOCKS)) { ++*value.lockExclusive(); }
+  ZC_EXPECT(*value.lockShared() == BENCHMARK_LOCKS);
+}
+
+ZC_TEST("benchmark: uncontended MutexGuarded, profiling") {
+  MutexGuarded<uint> value(0);
+  ProfilingScope scope;
+  for (uint i ZC_UNUSED : zeroTo(BENCHMARK_LOCKS)) { ++*value.lockExclusive(); }
+  ZC_EXPECT(*value.lockShared() == BENCHMARK_LOCKS);
+}
+
+}  // namespace
+}  // namespace zc
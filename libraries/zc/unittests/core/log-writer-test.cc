@@ -0,0 +1,288 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/log-writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zc/ztest/test.h>
+
+#include "zc/core/debug.h"
+#include "zc/core/io.h"
+#include "zc/core/miniposix.h"
+
+namespace zc {
+namespace {
+
+struct Pipe {
+  // Collects everything written to `out` on a thread of its own, so writes never block.
+
+  AutoCloseFd in;
+  AutoCloseFd out;
+  Vector<byte> received;
+  Own<Thread> reader;
+
+  Pipe() {
+    int fds[2];
+    ZC_SYSCALL(miniposix::pipe(fds));
+    in = AutoCloseFd(fds[0]);
+    out = AutoCloseFd(fds[1]);
+    reader = heap<Thread>([this]() {
+      byte buffer[4096];
+      for (;;) {
+        miniposix::ssize_t n;
+        ZC_SYSCALL(n = miniposix::read(in, buffer, sizeof(buffer)));
+        if (n == 0) return;
+        received.addAll(arrayPtr(buffer, n));
+      }
+    });
+  }
+
+  ~Pipe() noexcept(false) { out = nullptr; }
+
+  ArrayPtr<const byte> finish() {
+    out = nullptr;
+    reader = nullptr;
+    return received;
+  }
+};
+
+ZC_TEST("AsyncLogWriter writes text lines") {
+  Pipe pipe;
+  {
+    AsyncLogWriter writer({.fd = pipe.out});
+    ZC_EXPECT(writer.write(LogSeverity::INFO, "foo.c++", 123, 0, "hello"));
+    ZC_EXPECT(writer.write(LogSeverity::ERROR, "bar.c++", 45, 2, "world"));
+    writer.flush();
+
+    auto stats = writer.getStats();
+    ZC_EXPECT(stats.linesQueued == 2);
+    ZC_EXPECT(stats.linesWritten == 2);
+    ZC_EXPECT(stats.linesDropped == 0);
+    ZC_EXPECT(stats.bytesWritten == 52);
+    ZC_EXPECT(stats.writeErrors == 0);
+  }
+  ZC_EXPECT(pipe.finish().asChars() ==
+            "foo.c++:123: info: hello\n__bar.c++:45: error: world\n"_zc.asArray());
+}
+
+ZC_TEST("AsyncLogWriter writes binary records") {
+  Pipe pipe;
+  Date before = systemPreciseCalendarClock().now();
+  {
+    AsyncLogWriter writer({.fd = pipe.out, .format = AsyncLogWriter::Format::BINARY});
+    writer.write(LogSeverity::WARNING, "foo.c++", 123, 1, "hello");
+    writer.write(LogSeverity::INFO, "bar.c++", 45, 0, "");
+  }
+  Date after = systemPreciseCalendarClock().now();
+
+  auto input = pipe.finish();
+  LogRecord record = ZC_ASSERT_NONNULL(readLogRecord(input));
+  ZC_EXPECT(record.severity == LogSeverity::WARNING);
+  ZC_EXPECT(record.file == "foo.c++"_zc.asArray());
+  ZC_EXPECT(record.line == 123);
+  ZC_EXPECT(record.contextDepth == 1);
+  ZC_EXPECT(record.text == "hello"_zc.asArray());
+  ZC_EXPECT(record.time >= before && record.time <= after);
+
+  record = ZC_ASSERT_NONNULL(readLogRecord(input));
+  ZC_EXPECT(record.severity == LogSeverity::INFO);
+  ZC_EXPECT(record.file == "bar.c++"_zc.asArray());
+  ZC_EXPECT(record.text.size() == 0);
+
+  ZC_EXPECT(input.size() == 0);
+  ZC_EXPECT(readLogRecord(input) == zc::none);
+
+  // A partial record is left alone.
+  byte partial[sizeof(LogRecordHeader) + 4] = {};
+  LogRecordHeader header = {};
+  header.size = sizeof(partial) + 1;
+  memcpy(partial, &header, sizeof(header));
+  ArrayPtr<const byte> partialInput = partial;
+  ZC_EXPECT(readLogRecord(partialInput) == zc::none);
+  ZC_EXPECT(partialInput.size() == sizeof(partial));
+}
+
+ZC_TEST("AsyncLogWriter drops lines when the buffer is full") {
+  // Nothing reads the pipe until the end, so the writing thread soon blocks.
+  int fds[2];
+  ZC_SYSCALL(miniposix::pipe(fds));
+  AutoCloseFd in(fds[0]);
+  AutoCloseFd out(fds[1]);
+
+  AsyncLogWriter::Stats stats;
+  {
+    AsyncLogWriter writer({.fd = out, .threadBufferSize = 1024});
+    for (uint i ZC_UNUSED : zeroTo(1000)) writer.write(LogSeverity::INFO, "foo.c++", 1, 0, "hi");
+    stats = writer.getStats();
+
+    // Drain the pipe so the destructor can finish.
+    Thread reader([&]() {
+      byte buffer[4096];
+      while (miniposix::read(in, buffer, sizeof(buffer)) > 0) {}
+    });
+    ZC_DEFER(out = nullptr);
+    writer.flush();
+  }
+
+  ZC_EXPECT(stats.linesDropped > 0);
+  ZC_EXPECT(stats.linesQueued + stats.linesDropped == 1000);
+}
+
+ZC_TEST("AsyncLogWriter truncates long lines") {
+  Pipe pipe;
+  {
+    AsyncLogWriter writer({.fd = pipe.out, .threadBufferSize = 1024});
+    writer.write(LogSeverity::INFO, "foo.c++", 1, 0, str(repeat('x', 2000)));
+    ZC_EXPECT(writer.getStats().linesTruncated == 1);
+  }
+  auto text = pipe.finish().asChars();
+  ZC_EXPECT(text.size() == 512 - 8);
+  ZC_EXPECT(text.startsWith("foo.c++:1: info: xxx"_zc));
+  ZC_EXPECT(text.endsWith("xxx\n"_zc));
+}
+
+ZC_TEST("AsyncLogWriter rate-limits each call site") {
+  Pipe pipe;
+  AsyncLogWriter writer({.fd = pipe.out, .maxLinesPerSecondPerSite = 10});
+  for (uint i ZC_UNUSED : zeroTo(100)) {
+    writer.write(LogSeverity::INFO, "foo.c++", 1, 0, "noisy");
+    writer.write(LogSeverity::INFO, "foo.c++", 2, 0, "noisy");
+  }
+  writer.write(LogSeverity::INFO, "foo.c++", 3, 0, "quiet");
+  writer.flush();
+
+  // The count may restart once if a second boundary passes.
+  auto stats = writer.getStats();
+  ZC_EXPECT(stats.linesQueued >= 21 && stats.linesQueued <= 41, stats.linesQueued);
+  ZC_EXPECT(stats.linesQueued + stats.linesRateLimited == 201);
+}
+
+ZC_TEST("AsyncLogWriter keeps each thread's lines in order") {
+  constexpr uint THREADS = 4;
+  constexpr uint LINES = 2000;
+  Pipe pipe;
+  {
+    AsyncLogWriter writer({.fd = pipe.out, .threadBufferSize = 1 << 20});
+    for (uint t : zeroTo(THREADS)) {
+      // Each thread exits before the next starts, leaving its ring for the writer to free.
+      Thread thread([&]() {
+        for (uint i : zeroTo(LINES)) writer.write(LogSeverity::INFO, "t", t, 0, str(i));
+      });
+    }
+    writer.flush();
+    auto stats = writer.getStats();
+    ZC_EXPECT(stats.linesQueued == THREADS * LINES);
+    ZC_EXPECT(stats.linesWritten == THREADS * LINES);
+  }
+
+  uint next[THREADS] = {};
+  auto text = pipe.finish().asChars();
+  while (text.size() > 0) {
+    // "t:<thread>: info: <i>\n"
+    uint t = text[2] - '0';
+    auto number = text.slice(text.findFirst(' ').orDefault(0) + 7);
+    size_t end = ZC_ASSERT_NONNULL(number.findFirst('\n'));
+    uint i = heapString(number.first(end)).parseAs<uint>();
+    ZC_EXPECT(i == next[t]++, t, i);
+    text = number.slice(end + 1);
+  }
+  for (uint t : zeroTo(THREADS)) ZC_EXPECT(next[t] == LINES);
+}
+
+ZC_TEST("installed AsyncLogWriter receives the root callback's lines") {
+  // The test framework's callback sees ZC_LOG() lines on every thread before the root callback
+  // does, so call the root callback's hook directly.
+  Pipe pipe;
+  {
+    AsyncLogWriter writer({.fd = pipe.out});
+    ZC_EXPECT(!_::writeToInstalledLogWriter(LogSeverity::INFO, "foo.c++", 1, 0, "before"));
+    writer.install();
+    ZC_EXPECT_THROW_MESSAGE("already installed", AsyncLogWriter({.fd = pipe.out}).install());
+    ZC_EXPECT(_::writeToInstalledLogWriter(LogSeverity::WARNING, "foo.c++", 2, 0, "routed"));
+    writer.uninstall();
+    ZC_EXPECT(!_::writeToInstalledLogWriter(LogSeverity::INFO, "foo.c++", 3, 0, "after"));
+  }
+  ZC_EXPECT(pipe.finish().asChars() == "foo.c++:2: warning: routed\n"_zc.asArray());
+}
+
+ZC_TEST("AsyncLogWriter can be uninstalled while other threads are logging through it") {
+  Pipe pipe;
+  bool stop = false;
+  uint routed = 0;
+  {
+    auto threads = heapArrayBuilder<Own<Thread>>(4);
+    {
+      AsyncLogWriter writer({.fd = pipe.out});
+      writer.install();
+      for (uint t ZC_UNUSED : zeroTo(threads.capacity())) {
+        threads.add(heap<Thread>([&]() {
+          while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+            if (_::writeToInstalledLogWriter(LogSeverity::INFO, "foo.c++", 1, 0, "line")) {
+              __atomic_add_fetch(&routed, 1, __ATOMIC_RELAXED);
+            }
+          }
+        }));
+      }
+      while (__atomic_load_n(&routed, __ATOMIC_RELAXED) < 100) {}
+
+      // Once uninstall() returns, nothing may touch the writer any more.
+      writer.uninstall();
+    }
+    __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+  }
+  ZC_EXPECT(routed >= 100);
+}
+
+constexpr uint BENCHMARK_THREADS = 4;
+constexpr uint BENCHMARK_LINES = 200000;
+
+template <typename Func>
+void loggingBenchmark(Func&& log) {
+  auto threads = heapArrayBuilder<Own<Thread>>(BENCHMARK_THREADS);
+  for (uint t ZC_UNUSED : zeroTo(BENCHMARK_THREADS)) {
+    threads.add(heap<Thread>([&]() {
+      for (uint i : zeroTo(BENCHMARK_LINES)) log(str("request ", i, " took 12ms"));
+    }));
+  }
+}
+
+ZC_TEST("benchmark: write() per log line") {
+  Pipe pipe;
+  loggingBenchmark([&](String text) {
+    text = str("foo.c++:123: info: ", text, '\n');
+    ZC_ASSERT(miniposix::write(pipe.out, text.begin(), text.size()) == text.size());
+  });
+}
+
+ZC_TEST("benchmark: AsyncLogWriter") {
+  Pipe pipe;
+  AsyncLogWriter writer({.fd = pipe.out, .threadBufferSize = 1 << 20});
+  loggingBenchmark(
+      [&](String text) { writer.write(LogSeverity::INFO, "foo.c++", 123, 0, text); });
+  writer.flush();
+  auto stats = writer.getStats();
+  ZC_EXPECT(stats.linesQueued + stats.linesDropped == BENCHMARK_THREADS * BENCHMARK_LINES);
+  ZC_EXPECT(stats.writeCalls < stats.linesWritten);
+}
+
+}  // namespace
+}  // namespace zc
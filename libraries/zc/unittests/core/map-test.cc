@@ -221,6 +221,55 @@ ZC_TEST("HashMap<uint64> with int key") {
   ZC_EXPECT(zc::hashCode(0x1200000001ull) != zc::hashCode(1));
 }
 
+ZC_TEST("HashMap and HashSet with SwissHashIndex") {
+  HashMap<String, uint, SwissHashIndex> map;
+  HashSet<uint, SwissHashIndex> set;
+  for (uint i : zc::zeroTo(1000)) {
+    map.insert(zc::str(i), i);
+    set.insert(i);
+  }
+
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("123"_zc)) == 123);
+  ZC_EXPECT(map.find("1000"_zc) == zc::none);
+  ZC_EXPECT(set.contains(999u));
+  ZC_EXPECT(!set.contains(1000u));
+
+  ZC_EXPECT(map.eraseAll([](const String&, uint value) { return value % 2 == 0; }) == 500);
+  ZC_EXPECT(map.size() == 500);
+  ZC_EXPECT(map.find("122"_zc) == zc::none);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("123"_zc)) == 123);
+
+  map.upsert(zc::str("123"), 321);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find("123"_zc)) == 321);
+}
+
+ZC_TEST("TreeMap and TreeSet with IntTreeIndex") {
+  TreeMap<int, String, IntTreeIndex> map;
+  TreeSet<uint64_t, IntTreeIndex> set;
+  for (int i : zc::zeroTo(1000)) {
+    map.insert(500 - i, zc::str(500 - i));
+    set.insert(uint64_t(i) << 40);
+  }
+
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find(-123)) == "-123");
+  ZC_EXPECT(map.find(501) == zc::none);
+  ZC_EXPECT(set.find(uint64_t(999) << 40) != zc::none);
+  ZC_EXPECT(set.find(uint64_t(1)) == zc::none);
+
+  {
+    auto range = map.range(-2, 2);
+    auto iter = range.begin();
+    for (int i : {-2, -1, 0, 1}) { ZC_EXPECT((iter++)->key == i); }
+    ZC_EXPECT(iter == range.end());
+  }
+
+  ZC_EXPECT(map.eraseRange(0, 501) == 501);
+  ZC_EXPECT(map.size() == 499);
+  ZC_EXPECT(map.find(0) == zc::none);
+  ZC_EXPECT(map.eraseAll([](int key, StringPtr) { return key % 2 == 0; }) == 249);
+  ZC_EXPECT(ZC_ASSERT_NONNULL(map.find(-123)) == "-123");
+}
+
 }  // namespace
 }  // namespace _
 }  // namespace zc
@@ -615,6 +615,130 @@ ZC_TEST("condvar wait with flapping predicate") {
   }
 }
 
+#if ZC_USE_FUTEX
+ZC_TEST("MutexPolicy decides whether new readers wait for a waiting writer") {
+  for (auto policy : {MutexPolicy::PREFER_READERS, MutexPolicy::PREFER_WRITERS}) {
+    MutexGuarded<uint> value(policy, 0u);
+
+    {
+      auto reader = value.lockShared();
+      Thread writer([&]() { *value.lockExclusive() = 1; });
+
+      if (policy == MutexPolicy::PREFER_WRITERS) {
+        // Once the writer is waiting, new readers are turned away.
+        uint attempts = 0;
+        while (value.lockSharedWithTimeout(MILLISECONDS) != zc::none) {
+          ZC_ASSERT(++attempts < 1000, "writer never started waiting");
+          delay();
+        }
+      } else {
+        delay();  // let the writer start waiting
+        ZC_EXPECT(value.lockSharedWithTimeout(MILLISECONDS) != zc::none);
+      }
+
+      // A reader that blocks behind the writer still gets in after it.
+      Thread secondReader([&]() { ZC_EXPECT(*value.lockShared() <= 1u); });
+      delay();
+      reader.release();
+    }
+
+    ZC_EXPECT(*value.lockShared() == 1u);
+  }
+}
+
+ZC_TEST("reader that times out behind a waiting writer doesn't strand other readers") {
+  // The reader that times out clears the blocked-readers flag, which a reader still blocked
+  // behind the writer depends on to be woken.
+  MutexGuarded<uint> value(MutexPolicy::PREFER_WRITERS, 0u);
+  for (uint round : zeroTo(20)) {
+    auto reader = value.lockShared();
+    Thread writer([&]() { ++*value.lockExclusive(); });
+
+    uint attempts = 0;
+    while (value.lockSharedWithTimeout(MILLISECONDS) != zc::none) {
+      ZC_ASSERT(++attempts < 1000, "writer never started waiting");
+      delay();
+    }
+
+    // If it were stranded, joining it would hang.
+    Thread blockedReader([&]() { ZC_EXPECT(*value.lockShared() <= round + 1); });
+    delay();
+    ZC_EXPECT(value.lockSharedWithTimeout(MILLISECONDS) == zc::none);
+    delay();
+    reader.release();
+  }
+  ZC_EXPECT(*value.lockShared() == 20u);
+}
+#endif
+
+ZC_TEST("Mutex under contention from many threads") {
+  // Exercises the spinning and wake-one paths: writers take turns waking each other, and readers
+  // wake up behind them.
+  for (auto policy : {MutexPolicy::PREFER_READERS, MutexPolicy::PREFER_WRITERS}) {
+    MutexGuarded<uint> counter(policy, 0u);
+    constexpr uint THREADS = 16;
+    constexpr uint ITERATIONS = 2000;
+
+    {
+      auto threads = heapArrayBuilder<Own<Thread>>(THREADS);
+      for (uint t : zeroTo(THREADS)) {
+        threads.add(heap<Thread>([&counter, t]() {
+          for (uint i : zeroTo(ITERATIONS)) {
+            if ((i + t) % 4 == 0) {
+              uint observed = *counter.lockShared();
+              ZC_ASSERT(observed <= THREADS * ITERATIONS);
+            } else {
+              ++*counter.lockExclusive();
+            }
+          }
+        }));
+      }
+    }
+
+    ZC_EXPECT(*counter.lockShared() == THREADS * ITERATIONS * 3 / 4);
+  }
+}
+
+void benchmarkContention(MutexPolicy policy, uint writeEvery) {
+  // Hammers one mutex from 1 to 64 threads with a very short critical section, as in a
+  // MutexGuarded cache. One access in `writeEvery` is exclusive; the rest are shared.
+  constexpr uint TOTAL_OPERATIONS = 200000;
+
+  for (uint threadCount = 1; threadCount <= 64; threadCount *= 2) {
+    MutexGuarded<uint64_t> counter(policy, uint64_t(0));
+    uint perThread = TOTAL_OPERATIONS / threadCount;
+
+    auto start = systemPreciseMonotonicClock().now();
+    {
+      auto threads = heapArrayBuilder<Own<Thread>>(threadCount);
+      for (uint t ZC_UNUSED : zeroTo(threadCount)) {
+        threads.add(heap<Thread>([&counter, perThread, writeEvery]() {
+          uint64_t sum = 0;
+          for (uint i : zeroTo(perThread)) {
+            if (i % writeEvery == 0) {
+              ++*counter.lockExclusive();
+            } else {
+              sum += *counter.lockShared();
+            }
+          }
+          ZC_ASSERT(sum <= uint64_t(perThread) * TOTAL_OPERATIONS);
+        }));
+      }
+    }
+    auto elapsed = systemPreciseMonotonicClock().now() - start;
+    ZC_LOG(INFO, "mutex contention", threadCount, writeEvery, elapsed / TOTAL_OPERATIONS);
+  }
+}
+
+ZC_TEST("benchmark: Mutex contention, exclusive only") {
+  benchmarkContention(MutexPolicy::PREFER_READERS, 1);
+}
+
+ZC_TEST("benchmark: Mutex contention, mostly shared") {
+  benchmarkContention(MutexPolicy::PREFER_READERS, 8);
+  benchmarkContention(MutexPolicy::PREFER_WRITERS, 8);
+}
+
 #ifdef ZC_CONTENTION_WARNING_THRESHOLD
 ZC_TEST("make sure contended mutex warns") {
   class Expectation final : public ExceptionCallback {
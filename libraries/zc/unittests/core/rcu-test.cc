@@ -0,0 +1,273 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/rcu.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/async/async.h"
+#include "zc/core/refcount.h"
+#include "zc/core/thread.h"
+
+#if _WIN32
+#include <windows.h>
+
+#include "zc/core/windows-sanity.h"
+#else
+#include <unistd.h>
+#endif
+
+namespace zc {
+namespace {
+
+#if _WIN32
+inline void delay() { Sleep(10); }
+#else
+inline void delay() { usleep(10000); }
+#endif
+
+struct Counted {
+  // Counts its destructions, and poisons itself so that a reader of a destroyed version notices.
+  uint value;
+  uint* destroyed;
+
+  Counted(uint value, uint& destroyed) : value(value), destroyed(&destroyed) {}
+  Counted(const Counted& other) = default;
+  ~Counted() noexcept {
+    value = 0xdeadbeef;
+    __atomic_add_fetch(destroyed, 1, __ATOMIC_RELAXED);
+  }
+};
+
+inline uint destroyedCount(uint& destroyed) {
+  return __atomic_load_n(&destroyed, __ATOMIC_RELAXED);
+}
+
+ZC_TEST("Rcu publishes versions and destroys old ones once unused") {
+  uint destroyed = 0;
+  {
+    Rcu<Counted> rcu(1, destroyed);
+    auto old = rcu.read();
+    ZC_EXPECT(old->value == 1);
+
+    rcu.publish(heap<Counted>(2, destroyed));
+    ZC_EXPECT(rcu.read()->value == 2);
+    ZC_EXPECT(old->value == 1);
+
+    // Reads nest, and moving an RcuPtr doesn't end the read.
+    auto moved = zc::mv(old);
+    ZC_EXPECT(old.get() == nullptr);
+    rcu.update([](Counted& copy) { copy.value = 3; });
+    ZC_EXPECT(rcu.read()->value == 3);
+    ZC_EXPECT(moved->value == 1);
+    ZC_EXPECT(destroyedCount(destroyed) == 0);
+
+    moved.release();
+    rcuSynchronize();
+    ZC_EXPECT(destroyedCount(destroyed) == 2);
+  }
+  ZC_EXPECT(destroyedCount(destroyed) == 3);
+}
+
+ZC_TEST("Rcu waits for readers on other threads") {
+  uint destroyed = 0;
+  Rcu<Counted> rcu(1, destroyed);
+  bool reading = false;
+  bool released = false;
+
+  Thread thread([&]() {
+    auto version = rcu.read();
+    __atomic_store_n(&reading, true, __ATOMIC_RELEASE);
+    delay();
+    delay();
+    ZC_EXPECT(version->value == 1);
+    __atomic_store_n(&released, true, __ATOMIC_RELAXED);
+  });
+  while (!__atomic_load_n(&reading, __ATOMIC_ACQUIRE)) { delay(); }
+
+  rcu.publish(heap<Counted>(2, destroyed));
+  ZC_EXPECT(destroyedCount(destroyed) == 0);
+
+  rcuSynchronize();
+  ZC_EXPECT(__atomic_load_n(&released, __ATOMIC_RELAXED));
+  ZC_EXPECT(destroyedCount(destroyed) == 1);
+}
+
+ZC_TEST("Rcu updates from many threads are not lost") {
+  Rcu<uint> rcu(0);
+  constexpr uint THREADS = 4;
+  constexpr uint UPDATES = 1000;
+
+  {
+    auto threads = heapArrayBuilder<Own<Thread>>(THREADS);
+    for (uint t ZC_UNUSED : zeroTo(THREADS)) {
+      threads.add(heap<Thread>([&]() {
+        uint last = 0;
+        for (uint i ZC_UNUSED : zeroTo(UPDATES)) {
+          rcu.update([](uint& value) { ++value; });
+          uint value = *rcu.read();
+          ZC_ASSERT(value > last);
+          last = value;
+        }
+      }));
+    }
+  }
+
+  ZC_EXPECT(*rcu.read() == THREADS * UPDATES);
+}
+
+ZC_TEST("Rcu treats event loop turns as quiescent points") {
+  uint destroyed = 0;
+  Rcu<Counted> rcu(1, destroyed);
+
+  EventLoop loop;
+  WaitScope waitScope(loop);
+
+  MutexGuarded<Maybe<Own<CrossThreadPromiseFulfiller<void>>>> fulfiller;
+  Thread thread([&]() {
+    EventLoop loop;
+    WaitScope waitScope(loop);
+    auto paf = newPromiseAndCrossThreadFulfiller<void>();
+
+    // Read in one turn, and let the loop turn before going to sleep.
+    auto promise = evalLater([&]() { ZC_EXPECT(rcu.read()->value == 1); });
+    promise.wait(waitScope);
+
+    *fulfiller.lockExclusive() = zc::mv(paf.fulfiller);
+    paf.promise.wait(waitScope);
+  });
+
+  auto& sleeping = fulfiller.when([](auto& f) { return f != zc::none; },
+                                  [](auto& f) -> CrossThreadPromiseFulfiller<void>& {
+                                    return *ZC_ASSERT_NONNULL(f);
+                                  });
+
+  // Neither event loop thread holds reclamation back: this one is not running its loop, and the
+  // other is asleep.
+  rcu.publish(heap<Counted>(2, destroyed));
+  rcuSynchronize();
+  ZC_EXPECT(destroyedCount(destroyed) == 1);
+
+  // Reads within a turn on this thread need no pinning at all.
+  auto promise = evalLater([&]() { ZC_EXPECT(rcu.read()->value == 2); });
+  promise.wait(waitScope);
+
+  sleeping.fulfill();
+}
+
+ZC_TEST("Rcu doesn't wait for event loop threads blocked outside their loop") {
+  uint destroyed = 0;
+  Rcu<Counted> rcu(1, destroyed);
+
+  MutexGuarded<uint> step(0);
+  Thread thread([&]() {
+    EventLoop loop;
+    WaitScope waitScope(loop);
+    evalLater([&]() { ZC_EXPECT(rcu.read()->value == 1); }).wait(waitScope);
+
+    // Block on a mutex while the WaitScope is still alive.
+    *step.lockExclusive() = 1;
+    step.when([](const uint& s) { return s == 2; }, [](uint&) {});
+  });
+
+  step.when([](const uint& s) { return s == 1; }, [](uint&) {});
+  rcu.publish(heap<Counted>(2, destroyed));
+  rcuSynchronize();
+  ZC_EXPECT(destroyedCount(destroyed) == 1);
+
+  *step.lockExclusive() = 2;
+}
+
+ZC_TEST("Rcu readers always see a whole version") {
+  struct Pair {
+    uint a;
+    uint b;
+    ~Pair() noexcept { a = b = 1; }
+  };
+
+  Rcu<Pair> rcu(Pair{0, 0});
+  constexpr uint READERS = 3;
+  constexpr uint VERSIONS = 2000;
+  bool done = false;
+
+  {
+    auto threads = heapArrayBuilder<Own<Thread>>(READERS);
+    for (uint t ZC_UNUSED : zeroTo(READERS)) {
+      threads.add(heap<Thread>([&]() {
+        uint last = 0;
+        while (!__atomic_load_n(&done, __ATOMIC_RELAXED)) {
+          auto version = rcu.read();
+          ZC_ASSERT(version->b == version->a * 2, version->a, version->b);
+          ZC_ASSERT(version->a >= last);
+          last = version->a;
+        }
+      }));
+    }
+
+    for (uint i : zeroTo(VERSIONS)) { rcu.publish(heap<Pair>(Pair{i + 1, (i + 1) * 2})); }
+    __atomic_store_n(&done, true, __ATOMIC_RELAXED);
+  }
+
+  rcuSynchronize();
+  ZC_EXPECT(rcu.read()->a == VERSIONS);
+}
+
+constexpr uint BENCHMARK_THREADS = 8;
+constexpr uint BENCHMARK_READS = 2000000;
+
+template <typename Func>
+void runOnThreads(uint threadCount, Func func) {
+  auto threads = heapArrayBuilder<Own<Thread>>(threadCount);
+  for (uint t ZC_UNUSED : zeroTo(threadCount)) { threads.add(heap<Thread>(func)); }
+}
+
+ZC_TEST("benchmark: Rcu reads shared by threads") {
+  Rcu<uint> rcu(1);
+  runOnThreads(BENCHMARK_THREADS, [&]() {
+    uint sum = 0;
+    for (uint i ZC_UNUSED : zeroTo(BENCHMARK_READS)) { sum += *rcu.read(); }
+    ZC_ASSERT(sum == BENCHMARK_READS);
+  });
+}
+
+ZC_TEST("benchmark: MutexGuarded shared locks shared by threads") {
+  MutexGuarded<uint> value(1);
+  runOnThreads(BENCHMARK_THREADS, [&]() {
+    uint sum = 0;
+    for (uint i ZC_UNUSED : zeroTo(BENCHMARK_READS)) { sum += *value.lockShared(); }
+    ZC_ASSERT(sum == BENCHMARK_READS);
+  });
+}
+
+ZC_TEST("benchmark: atomic refcounts shared by threads") {
+  struct Shared : public AtomicRefcounted {
+    uint value = 1;
+  };
+  auto shared = zc::arc<Shared>();
+  runOnThreads(BENCHMARK_THREADS, [&]() {
+    uint sum = 0;
+    for (uint i ZC_UNUSED : zeroTo(BENCHMARK_READS)) { sum += shared.addRef()->value; }
+    ZC_ASSERT(sum == BENCHMARK_READS);
+  });
+}
+
+}  // namespace
+}  // namespace zc
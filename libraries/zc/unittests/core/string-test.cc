@@ -23,6 +23,8 @@
 
 #include <locale.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <zc/ztest/gtest.h>
 
 #include <string>
@@ -385,6 +387,101 @@ ZC_TEST("float stringification and parsing is not locale-dependent") {
   }
 }
 
+ZC_TEST("float stringification is shortest round-trip") {
+  ZC_EXPECT(str(0.1) == "0.1");
+  ZC_EXPECT(str(0.3) == "0.3");
+  ZC_EXPECT(str(1.0 / 3) == "0.3333333333333333");
+  ZC_EXPECT(str(100.0) == "100");
+  ZC_EXPECT(str(1e6) == "1000000");
+  ZC_EXPECT(str(123456789012345.0) == "123456789012345");
+  ZC_EXPECT(str(1e15) == "1e15");
+  ZC_EXPECT(str(123456789012345680.0) == "1.2345678901234568e17");
+  ZC_EXPECT(str(0.0001) == "0.0001");
+  ZC_EXPECT(str(0.00012345) == "0.00012345");
+  ZC_EXPECT(str(1e-5) == "1e-05");
+  ZC_EXPECT(str(-2.5e-300) == "-2.5e-300");
+  ZC_EXPECT(str(5e-324) == "5e-324");
+  ZC_EXPECT(str(1.7976931348623157e308) == "1.7976931348623157e308");
+  ZC_EXPECT(str(0.0) == "0");
+  ZC_EXPECT(str(-0.0) == "-0");
+  ZC_EXPECT(str(inf()) == "inf");
+  ZC_EXPECT(str(-inf()) == "-inf");
+  ZC_EXPECT(str(nan()) == "nan");
+
+  ZC_EXPECT(str(0.1f) == "0.1");
+  ZC_EXPECT(str(16777216.0f) == "16777216");
+  ZC_EXPECT(str(1e7f) == "1e07");
+  ZC_EXPECT(str(1.1754944e-38f) == "1.1754944e-38");
+
+  // Random bit patterns survive a round trip.
+  uint64_t state = 0x9e3779b97f4a7c15ull;
+  for (uint i ZC_UNUSED : zeroTo(100000)) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    double d;
+    memcpy(&d, &state, sizeof(d));
+    if (isNaN(d)) continue;
+    ZC_ASSERT(str(d).parseAs<double>() == d, d);
+
+    float single;
+    uint32_t bits = state >> 32;
+    memcpy(&single, &bits, sizeof(single));
+    if (isNaN(single)) continue;
+    ZC_ASSERT(str(single).parseAs<float>() == single, single);
+  }
+}
+
+ZC_TEST("parseAs() on text that is not NUL-terminated") {
+  auto text = "12345.5e2xyz"_zc.asArray();
+  ZC_EXPECT(parseAs<int>(text.first(3)) == 123);
+  ZC_EXPECT(parseAs<double>(text.first(7)) == 12345.5);
+  ZC_EXPECT(parseAs<double>(text.first(9)) == 1234550);
+  ZC_EXPECT(tryParseAs<double>(text.first(8)) == zc::none);
+  ZC_EXPECT(tryParseAs<uint>(text) == zc::none);
+  ZC_EXPECT(tryParseAs<uint64_t>(text.first(0)) == zc::none);
+
+  ZC_EXPECT(parseAs<int>("0x1fz"_zc.asArray().first(4)) == 31);
+  ZC_EXPECT(tryParseAs<int>("0x"_zc) == zc::none);
+  ZC_EXPECT_THROW_RECOVERABLE_MESSAGE("not contain valid", parseAs<int>("12 "_zc));
+}
+
+ZC_TEST("parseAs() accepts what strtod() and strtoll() do") {
+  ZC_EXPECT(" \t42"_zc.parseAs<int>() == 42);
+  ZC_EXPECT("+42"_zc.parseAs<int>() == 42);
+  ZC_EXPECT("-0x7fffffff"_zc.parseAs<int>() == -0x7fffffff);
+  ZC_EXPECT("-128"_zc.parseAs<signed char>() == -128);
+  ZC_EXPECT("-129"_zc.tryParseAs<signed char>() == zc::none);
+  ZC_EXPECT("-0"_zc.tryParseAs<uint>() == zc::none);
+
+  ZC_EXPECT(" 1.5"_zc.parseAs<double>() == 1.5);
+  ZC_EXPECT("+1.5"_zc.parseAs<double>() == 1.5);
+  ZC_EXPECT(".5"_zc.parseAs<double>() == 0.5);
+  ZC_EXPECT("5."_zc.parseAs<double>() == 5);
+  ZC_EXPECT("1E3"_zc.parseAs<double>() == 1000);
+  ZC_EXPECT("0x1p4"_zc.parseAs<double>() == 16);
+  ZC_EXPECT("-0X1.8P1"_zc.parseAs<double>() == -3);
+  ZC_EXPECT("0.1"_zc.parseAs<double>() == 0.1);
+  ZC_EXPECT("2.2250738585072011e-308"_zc.parseAs<double>() == 2.2250738585072011e-308);
+  ZC_EXPECT("1e-400"_zc.parseAs<double>() == 0);
+  ZC_EXPECT("-1e-400"_zc.parseAs<double>() == 0);
+  ZC_EXPECT("0.000000000000000000000000001e-300"_zc.parseAs<double>() == 0);
+  ZC_EXPECT("123456789e305"_zc.parseAs<double>() == inf());
+  ZC_EXPECT("0x1p99999"_zc.parseAs<double>() == inf());
+  ZC_EXPECT("1e39"_zc.parseAs<float>() == inf());
+  ZC_EXPECT("1e-50"_zc.parseAs<float>() == 0);
+
+  // Floats are rounded once, directly from the decimal text, not through a double.
+  ZC_EXPECT("1.00000005960464477550"_zc.parseAs<float>() == 1.0000001f);
+
+  ZC_EXPECT("--1"_zc.tryParseAs<double>() == zc::none);
+  ZC_EXPECT("0x"_zc.tryParseAs<double>() == zc::none);
+  ZC_EXPECT("0xinf"_zc.tryParseAs<double>() == zc::none);
+  ZC_EXPECT("1e"_zc.tryParseAs<double>() == zc::none);
+  ZC_EXPECT("infinit"_zc.tryParseAs<double>() == zc::none);
+  ZC_EXPECT("."_zc.tryParseAs<double>() == zc::none);
+}
+
 ZC_TEST("ConstString literal operator") {
   zc::ConstString theString = "it's a const string!"_zcc;
   ZC_EXPECT(theString == "it's a const string!");
@@ -435,6 +532,175 @@ ZC_TEST("ConstString attachment lifetimes") {
   ZC_EXPECT(destroyed3 == 3, destroyed3);
 }
 
+ZC_TEST("ConstString sharing") {
+  // Literals are shared without a refcount.
+  ConstString literal = "a literal"_zcc;
+  ConstString literalCopy = literal.share();
+  ZC_EXPECT(literalCopy.begin() == literal.begin());
+
+  // Other strings move into a shared buffer the first time, then are never copied again.
+  ConstString owned(heapString("owned"));
+  const char* original = owned.begin();
+  ConstString first = owned.share();
+  ZC_EXPECT(owned.begin() != original);
+  ZC_EXPECT(first.begin() == owned.begin());
+  ConstString second = first.share();
+  ZC_EXPECT(second.begin() == owned.begin());
+
+  owned = nullptr;
+  first = nullptr;
+  ZC_EXPECT(second == "owned");
+
+  ConstString shared = sharedString("shared"_zc);
+  ZC_EXPECT(shared.share().begin() == shared.begin());
+  ZC_EXPECT(shared == "shared");
+  ZC_EXPECT(ConstString().share() == nullptr);
+}
+
+ZC_TEST("SmallString") {
+  SmallString empty;
+  ZC_EXPECT(empty == nullptr);
+  ZC_EXPECT(empty.isInline());
+  ZC_EXPECT(*empty.cStr() == '\0');
+
+  SmallString small("short"_zc);
+  ZC_EXPECT(small.isInline());
+  ZC_EXPECT(small == "short");
+  ZC_EXPECT(small.size() == 5);
+  ZC_EXPECT(small.cStr()[5] == '\0');
+
+  StringPtr longText = "a string which is too long to be stored inline"_zc;
+  SmallString large(longText);
+  ZC_EXPECT(!large.isInline());
+  ZC_EXPECT(large == longText);
+
+  // Exactly INLINE_CAPACITY still fits.
+  String maxInline = heapString(SmallString::INLINE_CAPACITY);
+  for (char& c : maxInline) c = 'x';
+  ZC_EXPECT(SmallString(maxInline.asPtr()).isInline());
+  ZC_EXPECT(!SmallString(str(maxInline, 'x').asPtr()).isInline());
+
+  // Taking a String keeps its buffer.
+  String heap = heapString("adopted");
+  const char* heapChars = heap.begin();
+  SmallString adopted(zc::mv(heap));
+  ZC_EXPECT(!adopted.isInline());
+  ZC_EXPECT(adopted.begin() == heapChars);
+  ZC_EXPECT(SmallString(String()) == nullptr);
+
+  // Moving.
+  SmallString moved = zc::mv(small);
+  ZC_EXPECT(moved == "short");
+  ZC_EXPECT(small == nullptr);
+  const char* largeChars = large.begin();
+  moved = zc::mv(large);
+  ZC_EXPECT(moved.begin() == largeChars);
+  ZC_EXPECT(large == nullptr);
+  ZC_EXPECT(large.isInline());
+  moved = SmallString("again"_zc);
+  ZC_EXPECT(moved == "again");
+
+  // Comparisons and conversions.
+  ZC_EXPECT(moved == heapString("again"));
+  ZC_EXPECT(moved == SmallString("again"_zc));
+  ZC_EXPECT(moved < SmallString("b"_zc));
+  ZC_EXPECT(moved.startsWith("ag"));
+  ZC_EXPECT(moved.slice(2) == "ain");
+  ZC_EXPECT(str("[", moved, "]") == "[again]");
+  ZC_EXPECT(heapString(moved) == "again");
+  ZC_EXPECT(SmallString("123"_zc).parseAs<int>() == 123);
+  moved[0] = 'A';
+  ZC_EXPECT(moved == "Again");
+}
+
+ZC_TEST("smallStr()") {
+  auto small = smallStr("id", 42, '!');
+  ZC_EXPECT(small.isInline());
+  ZC_EXPECT(small == "id42!");
+
+  auto large = smallStr("a longer string: ", 12345678, ", ", 87654321);
+  ZC_EXPECT(!large.isInline());
+  ZC_EXPECT(large == "a longer string: 12345678, 87654321");
+}
+
+constexpr uint BENCHMARK_STRINGS = 2000000;
+
+ZC_TEST("benchmark: str() of short strings") {
+  size_t total = 0;
+  for (uint i : zeroTo(BENCHMARK_STRINGS)) { total += str("key-", i % 1000).size(); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: smallStr() of short strings") {
+  size_t total = 0;
+  for (uint i : zeroTo(BENCHMARK_STRINGS)) { total += smallStr("key-", i % 1000).size(); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: copying a header value with heapString()") {
+  String value = heapString("text/html; charset=utf-8");
+  size_t total = 0;
+  for (uint i ZC_UNUSED : zeroTo(BENCHMARK_STRINGS)) { total += heapString(value).size(); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: copying a header value with ConstString::share()") {
+  ConstString value = sharedString("text/html; charset=utf-8"_zc);
+  size_t total = 0;
+  for (uint i ZC_UNUSED : zeroTo(BENCHMARK_STRINGS)) { total += value.share().size(); }
+  ZC_EXPECT(total > 0);
+}
+
+constexpr uint BENCHMARK_NUMBERS = 1000000;
+
+double benchmarkDouble(uint i) {
+  // A mix of short and long decimal expansions, like measurements and ratios in a log.
+  return i % 2 == 0 ? i * 0.25 : 1.0 / (i + 3);
+}
+
+ZC_TEST("benchmark: str() of doubles") {
+  size_t total = 0;
+  for (uint i : zeroTo(BENCHMARK_NUMBERS)) { total += str(benchmarkDouble(i)).size(); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: snprintf() of doubles, for comparison") {
+  size_t total = 0;
+  for (uint i : zeroTo(BENCHMARK_NUMBERS)) {
+    char buffer[32];
+    total += snprintf(buffer, sizeof(buffer), "%.17g", benchmarkDouble(i));
+  }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: parseAs<double>()") {
+  auto texts = heapArray<String>(1000);
+  for (uint i : zeroTo(texts.size())) texts[i] = str(benchmarkDouble(i));
+  double total = 0;
+  for (uint i : zeroTo(BENCHMARK_NUMBERS)) { total += texts[i % texts.size()].parseAs<double>(); }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: strtod(), for comparison") {
+  auto texts = heapArray<String>(1000);
+  for (uint i : zeroTo(texts.size())) texts[i] = str(benchmarkDouble(i));
+  double total = 0;
+  for (uint i : zeroTo(BENCHMARK_NUMBERS)) {
+    total += strtod(texts[i % texts.size()].cStr(), nullptr);
+  }
+  ZC_EXPECT(total > 0);
+}
+
+ZC_TEST("benchmark: parseAs<uint64_t>() of Content-Length values") {
+  auto texts = heapArray<String>(1000);
+  for (uint i : zeroTo(texts.size())) texts[i] = str(uint64_t(i) * 7919);
+  uint64_t total = 0;
+  for (uint i : zeroTo(BENCHMARK_NUMBERS)) {
+    total += texts[i % texts.size()].parseAs<uint64_t>();
+  }
+  ZC_EXPECT(total > 0);
+}
+
 ZC_TEST("StringPtr find") {
   // Empty string doesn't find anything
   StringPtr empty("");
@@ -284,6 +284,78 @@ ZC_TEST("HashIndex with many erasures doesn't keep growing") {
   ZC_ASSERT(index.capacity() < 10);
 }
 
+ZC_TEST("SwissHashIndex with many erasures doesn't keep growing") {
+  SwissHashIndex<IntHasher> index;
+
+  zc::ArrayPtr<uint> rows = nullptr;
+
+  for (uint i : zc::zeroTo(1000000)) {
+    ZC_ASSERT(index.insert(rows, 0, i) == zc::none);
+    index.erase(rows, 0, i);
+  }
+
+  ZC_ASSERT(index.capacity() <= 16);
+}
+
+ZC_TEST("SwissHashIndex table") {
+  Table<uint, SwissHashIndex<IntHasher>> table;
+  ZC_EXPECT(table.find(1u) == zc::none);
+
+  // Enough rows to rehash several times and fill many groups.
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) { table.insert(i * 3); }
+  ZC_EXPECT_THROW_MESSAGE("inserted row already exists in table", table.insert(3));
+  ZC_EXPECT(table.size() == MEDIUM_PRIME);
+
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) {
+    ZC_ASSERT(ZC_ASSERT_NONNULL(table.find(i * 3)) == i * 3);
+    ZC_ASSERT(table.find(i * 3 + 1) == zc::none);
+  }
+
+  // Erasing moves the last row into the hole, which exercises move().
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) {
+    if (i % 3 == 0) { ZC_ASSERT(table.eraseMatch(i * 3)); }
+  }
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) {
+    if (i % 3 == 0) {
+      ZC_ASSERT(table.find(i * 3) == zc::none);
+    } else {
+      ZC_ASSERT(ZC_ASSERT_NONNULL(table.find(i * 3)) == i * 3);
+    }
+  }
+
+  // Erased slots are reused.
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) {
+    if (i % 3 == 0) { table.insert(i * 3); }
+  }
+  ZC_EXPECT(table.size() == MEDIUM_PRIME);
+  for (uint i : zc::zeroTo(MEDIUM_PRIME)) { ZC_ASSERT(table.find(i * 3) != zc::none); }
+
+  table.clear();
+  ZC_EXPECT(table.size() == 0);
+  ZC_EXPECT(table.find(3u) == zc::none);
+  table.insert(3);
+  ZC_EXPECT(table.find(3u) != zc::none);
+}
+
+ZC_TEST("SwissHashIndex when hash is always same") {
+  // Every row lands in the same group and shares a tag, so lookups have to fall through to later
+  // groups and compare rows.
+  Table<StringPtr, SwissHashIndex<BadHasher>> table;
+
+  zc::Vector<String> strings;
+  for (uint i : zc::zeroTo(100)) { strings.add(zc::str(i)); }
+  for (auto& str : strings) { table.insert(str); }
+  ZC_EXPECT_THROW_MESSAGE("inserted row already exists in table", table.insert("42"));
+
+  for (auto& str : strings) { ZC_ASSERT(ZC_ASSERT_NONNULL(table.find(str)) == str); }
+  ZC_EXPECT(table.find("100") == zc::none);
+
+  for (uint i = 0; i < 100; i += 2) { ZC_ASSERT(table.eraseMatch(strings[i])); }
+  for (uint i : zc::zeroTo(100)) {
+    ZC_ASSERT((table.find(strings[i]) == zc::none) == (i % 2 == 0));
+  }
+}
+
 struct SiPair {
   zc::StringPtr str;
   uint i;
@@ -384,13 +456,14 @@ public:
   uint hashCode(uint i) const { return zc::hashCode(i); }
 };
 
-ZC_TEST("benchmark: zc::Table<uint, HashIndex>") {
+template <template <typename> class Index>
+void benchmarkUintHashTable() {
   constexpr uint SOME_PRIME = BIG_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
 
   for (auto step : STEP) {
     ZC_CONTEXT(step);
-    Table<uint, HashIndex<UintHasher>> table;
+    Table<uint, Index<UintHasher>> table;
     for (uint i : zc::zeroTo(SOME_PRIME)) {
       uint j = (i * step) % SOME_PRIME;
       table.insert(j * 5 + 123);
@@ -418,6 +491,10 @@ ZC_TEST("benchmark: zc::Table<uint, HashIndex>") {
   }
 }
 
+ZC_TEST("benchmark: zc::Table<uint, HashIndex>") { benchmarkUintHashTable<HashIndex>(); }
+
+ZC_TEST("benchmark: zc::Table<uint, SwissHashIndex>") { benchmarkUintHashTable<SwissHashIndex>(); }
+
 ZC_TEST("benchmark: std::unordered_set<uint>") {
   constexpr uint SOME_PRIME = BIG_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
@@ -456,7 +533,8 @@ ZC_TEST("benchmark: std::unordered_set<uint>") {
   }
 }
 
-ZC_TEST("benchmark: zc::Table<StringPtr, HashIndex>") {
+template <template <typename> class Index>
+void benchmarkStringHashTable() {
   constexpr uint SOME_PRIME = BIG_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
 
@@ -465,7 +543,7 @@ ZC_TEST("benchmark: zc::Table<StringPtr, HashIndex>") {
 
   for (auto step : STEP) {
     ZC_CONTEXT(step);
-    Table<StringPtr, HashIndex<StringHasher>> table;
+    Table<StringPtr, Index<StringHasher>> table;
     for (uint i : zc::zeroTo(SOME_PRIME)) {
       uint j = (i * step) % SOME_PRIME;
       table.insert(strings[j]);
@@ -491,6 +569,52 @@ ZC_TEST("benchmark: zc::Table<StringPtr, HashIndex>") {
   }
 }
 
+ZC_TEST("benchmark: zc::Table<StringPtr, HashIndex>") { benchmarkStringHashTable<HashIndex>(); }
+
+ZC_TEST("benchmark: zc::Table<StringPtr, SwissHashIndex>") {
+  benchmarkStringHashTable<SwissHashIndex>();
+}
+
+template <template <typename> class Index>
+void benchmarkLookupsAtHighLoad() {
+  // Fill the index with as many rows as a HashIndex of the same capacity takes before it grows,
+  // then look up a mix of present and absent keys. This is where HashIndex's probe runs are
+  // longest; SwissHashIndex holds the same rows in the same number of slots.
+  zc::Vector<uint> rows;
+  {
+    HashIndex<UintHasher> probe;
+    probe.reserve(BIG_PRIME);
+    size_t capacity = probe.capacity();
+    while (probe.capacity() == capacity) {
+      rows.add(rows.size() * 7 + 1);
+      ZC_ASSERT(probe.insert(rows.asPtr(), rows.size() - 1, rows.back()) == zc::none);
+    }
+    rows.removeLast();
+  }
+
+  Index<UintHasher> index;
+  index.reserve(BIG_PRIME);
+  for (uint i : zc::zeroTo(rows.size())) {
+    ZC_ASSERT(index.insert(rows.asPtr(), i, rows[i]) == zc::none);
+  }
+  ZC_CONTEXT(rows.size(), index.capacity());
+
+  size_t found = 0;
+  for (uint round = 0; round < 20; round++) {
+    for (uint i : zc::zeroTo(rows.size())) {
+      found += index.find(rows.asPtr(), i * 7 + 1) != zc::none;
+      found += index.find(rows.asPtr(), i * 7 + 2) != zc::none;
+    }
+  }
+  ZC_ASSERT(found == rows.size() * 20);
+}
+
+ZC_TEST("benchmark: HashIndex lookups at high load") { benchmarkLookupsAtHighLoad<HashIndex>(); }
+
+ZC_TEST("benchmark: SwissHashIndex lookups at high load") {
+  benchmarkLookupsAtHighLoad<SwissHashIndex>();
+}
+
 struct StlStringHash {
   inline size_t operator()(StringPtr str) const { return zc::hashCode(str); }
 };
@@ -807,13 +931,18 @@ public:
   bool matches(uint a, uint b) const { return a == b; }
 };
 
-ZC_TEST("large tree table") {
+template <typename Callbacks>
+using TinyIntTreeIndex = SizedIntTreeIndex<Callbacks, 4, 4>;
+// Small nodes make every insert and erase path (splits, borrows, merges, root changes) run often.
+
+template <template <typename> class Index>
+void testLargeTreeTable() {
   constexpr uint SOME_PRIME = MEDIUM_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
 
   for (auto step : STEP) {
     ZC_CONTEXT(step);
-    Table<uint, TreeIndex<UintCompare>> table;
+    Table<uint, Index<UintCompare>> table;
     for (uint i : zc::zeroTo(SOME_PRIME)) {
       uint j = (i * step) % SOME_PRIME;
       table.insert(j * 5 + 123);
@@ -859,14 +988,20 @@ ZC_TEST("large tree table") {
   }
 }
 
-ZC_TEST("TreeIndex fuzz test") {
-  // A test which randomly modifies a TreeIndex to try to discover buggy state changes.
+ZC_TEST("large tree table") { testLargeTreeTable<TreeIndex>(); }
+
+ZC_TEST("large tree table with IntTreeIndex") {
+  testLargeTreeTable<IntTreeIndex>();
+  testLargeTreeTable<TinyIntTreeIndex>();
+}
 
+template <template <typename> class Index>
+void fuzzTreeIndex() {
   uint seed = (zc::systemPreciseCalendarClock().now() - zc::UNIX_EPOCH) / zc::NANOSECONDS;
   ZC_CONTEXT(seed);  // print the seed if the test fails
   srand(seed);
 
-  Table<uint, TreeIndex<UintCompare>> table;
+  Table<uint, Index<UintCompare>> table;
 
   auto randomInsert = [&]() { table.upsert(rand(), [](auto&&, auto&&) {}); };
   auto randomErase = [&]() {
@@ -920,6 +1055,16 @@ ZC_TEST("TreeIndex fuzz test") {
   }
 }
 
+ZC_TEST("TreeIndex fuzz test") {
+  // A test which randomly modifies a TreeIndex to try to discover buggy state changes.
+  fuzzTreeIndex<TreeIndex>();
+}
+
+ZC_TEST("IntTreeIndex fuzz test") {
+  fuzzTreeIndex<IntTreeIndex>();
+  fuzzTreeIndex<TinyIntTreeIndex>();
+}
+
 ZC_TEST("TreeIndex clear() leaves tree in valid state") {
   // A test which ensures that calling clear() does not break the internal state of a TreeIndex.
   // It used to be the case that clearing a non-empty tree would leave it thinking that it had room
@@ -939,13 +1084,82 @@ ZC_TEST("TreeIndex clear() leaves tree in valid state") {
   for (uint i = 0; i < 29; ++i) { ZC_EXPECT(table.find(i) != zc::none); }
 }
 
-ZC_TEST("benchmark: zc::Table<uint, TreeIndex>") {
+ZC_TEST("IntTreeIndex orders the full range of 64-bit keys") {
+  struct Row {
+    int64_t signedKey;
+    uint64_t unsignedKey;
+  };
+  struct SignedKey {
+    int64_t keyForRow(const Row& row) const { return row.signedKey; }
+  };
+  struct UnsignedKey {
+    uint64_t keyForRow(const Row& row) const { return row.unsignedKey; }
+  };
+
+  const int64_t values[] = {0, -1, 1, INT64_MIN, INT64_MAX, INT64_MIN + 1, INT64_MAX - 1, 12345};
+  Table<Row, TinyIntTreeIndex<SignedKey>, TinyIntTreeIndex<UnsignedKey>> table;
+  for (int64_t value : values) { table.insert(Row{value, uint64_t(value)}); }
+  table.verify();
+
+  ZC_EXPECT_THROW_RECOVERABLE_MESSAGE("inserted row already exists in table",
+                                      table.insert(Row{INT64_MAX, 7}));
+
+  // INT64_MAX doubles as the padding value inside nodes, so it needs to work as a real key too.
+  ZC_EXPECT(ZC_ASSERT_NONNULL(table.find<0>(INT64_MAX)).unsignedKey == uint64_t(INT64_MAX));
+  ZC_EXPECT(ZC_ASSERT_NONNULL(table.find<1>(~uint64_t(0))).signedKey == -1);
+  ZC_EXPECT(table.find<0>(2) == zc::none);
+
+  {
+    auto iter = table.ordered<0>().begin();
+    const int64_t expected[] = {INT64_MIN, INT64_MIN + 1, -1,           0,
+                                1,         12345,         INT64_MAX - 1, INT64_MAX};
+    for (int64_t value : expected) { ZC_EXPECT((*iter++).signedKey == value); }
+    ZC_EXPECT(iter == table.ordered<0>().end());
+  }
+  {
+    // As unsigned numbers, the negative values sort after the positive ones.
+    auto iter = table.ordered<1>().begin();
+    const int64_t expected[] = {0,         1,         12345,         INT64_MAX - 1,
+                                INT64_MAX, INT64_MIN, INT64_MIN + 1, -1};
+    for (int64_t value : expected) { ZC_EXPECT((*iter++).signedKey == value); }
+    ZC_EXPECT(iter == table.ordered<1>().end());
+  }
+
+  {
+    auto range = table.range<0>(-1, 12346);
+    auto iter = range.begin();
+    for (int64_t value : {-1, 0, 1, 12345}) { ZC_EXPECT((*iter++).signedKey == value); }
+    ZC_EXPECT(iter == range.end());
+  }
+  ZC_EXPECT((*table.seek<0>(2)).signedKey == 12345);
+  ZC_EXPECT(table.seek<0>(int64_t(0)) != table.ordered<0>().end());
+
+  table.eraseRange<0>(INT64_MIN, int64_t(0));
+  table.verify();
+  ZC_EXPECT(table.size() == 5);
+  ZC_EXPECT((*table.ordered<1>().begin()).signedKey == 0);
+
+  table.clear();
+  table.verify();
+  ZC_EXPECT(table.ordered<0>().begin() == table.ordered<0>().end());
+  table.insert(Row{3, 3});
+  ZC_EXPECT(table.find<0>(3) != zc::none);
+
+  // Search keys are compared as values of the rows' key type, whatever their own type is.
+  Table<uint, IntTreeIndex<UintCompare>> narrow;
+  narrow.insert(5);
+  ZC_EXPECT(narrow.find(uint64_t(5)) != zc::none);
+  ZC_EXPECT(narrow.find(int64_t(5)) != zc::none);
+}
+
+template <template <typename> class Index>
+void benchmarkUintTreeTable() {
   constexpr uint SOME_PRIME = BIG_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
 
   for (auto step : STEP) {
     ZC_CONTEXT(step);
-    Table<uint, TreeIndex<UintCompare>> table;
+    Table<uint, Index<UintCompare>> table;
     table.reserve(SOME_PRIME);
     for (uint i : zc::zeroTo(SOME_PRIME)) {
       uint j = (i * step) % SOME_PRIME;
@@ -974,6 +1188,10 @@ ZC_TEST("benchmark: zc::Table<uint, TreeIndex>") {
   }
 }
 
+ZC_TEST("benchmark: zc::Table<uint, TreeIndex>") { benchmarkUintTreeTable<TreeIndex>(); }
+
+ZC_TEST("benchmark: zc::Table<uint, IntTreeIndex>") { benchmarkUintTreeTable<IntTreeIndex>(); }
+
 ZC_TEST("benchmark: std::set<uint>") {
   constexpr uint SOME_PRIME = BIG_PRIME;
   constexpr uint STEP[] = {1, 2, 4, 7, 43, 127};
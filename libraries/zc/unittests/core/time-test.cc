@@ -27,6 +27,7 @@
 #include <zc/ztest/test.h>
 
 #include "zc/core/debug.h"
+#include "zc/core/thread.h"
 #include "zc/core/time.h"
 
 #if _WIN32
@@ -34,6 +35,7 @@
 
 #include "zc/core/windows-sanity.h"
 #else
+#include <time.h>
 #include <unistd.h>
 #endif
 
@@ -144,5 +146,66 @@ ZC_TEST("all clocks advance in real time") {
                  preciseMonoDiff / zc::MICROSECONDS);
 }
 
+ZC_TEST("fast clocks track the precise clocks") {
+  auto& fast = systemFastMonotonicClock();
+  auto& precise = systemPreciseMonotonicClock();
+  auto& fastCal = systemFastCalendarClock();
+  auto& preciseCal = systemPreciseCalendarClock();
+
+  // Run long enough for the fast clocks to calibrate. Each fast reading must fall between the
+  // precise readings around it, give or take the calibration error, and never go backwards.
+  TimePoint start = precise.now();
+  TimePoint last = fast.now();
+  uint reads = 0;
+  while (precise.now() - start < 50 * zc::MILLISECONDS) {
+    for (uint i ZC_UNUSED : zc::zeroTo(100)) {
+      TimePoint before = precise.now();
+      TimePoint reading = fast.now();
+      TimePoint after = precise.now();
+      ZC_ASSERT(reading >= last, last - reading);
+      ZC_ASSERT(reading > before - 100 * zc::MICROSECONDS, before - reading);
+      ZC_ASSERT(reading < after + 100 * zc::MICROSECONDS, reading - after);
+      last = reading;
+      ++reads;
+
+      Date calBefore = preciseCal.now();
+      Date fastCalNow = fastCal.now();
+      Date calAfter = preciseCal.now();
+      ZC_ASSERT(fastCalNow > calBefore - 1 * zc::MILLISECONDS, calBefore - fastCalNow);
+      ZC_ASSERT(fastCalNow < calAfter + 1 * zc::MILLISECONDS, fastCalNow - calAfter);
+    }
+  }
+  ZC_EXPECT(reads > 100);
+
+  // They also agree across threads.
+  Thread([&]() {
+    TimePoint before = precise.now();
+    TimePoint reading = fast.now();
+    TimePoint after = precise.now();
+    ZC_EXPECT(reading > before - 100 * zc::MICROSECONDS);
+    ZC_EXPECT(reading < after + 100 * zc::MICROSECONDS);
+  });
+}
+
+constexpr uint BENCHMARK_READS = 20'000'000;
+
+ZC_TEST("benchmark: systemPreciseMonotonicClock()") {
+  auto& clock = systemPreciseMonotonicClock();
+  int64_t sum = 0;
+  for (uint i ZC_UNUSED : zc::zeroTo(BENCHMARK_READS)) {
+    sum += (clock.now() - origin<TimePoint>()) / zc::NANOSECONDS;
+  }
+  ZC_EXPECT(sum != 0);
+}
+
+ZC_TEST("benchmark: systemFastMonotonicClock()") {
+  auto& clock = systemFastMonotonicClock();
+  int64_t sum = 0;
+  for (uint i ZC_UNUSED : zc::zeroTo(BENCHMARK_READS)) {
+    sum += (clock.now() - origin<TimePoint>()) / zc::NANOSECONDS;
+  }
+  ZC_EXPECT(sum != 0);
+}
+
 }  // namespace
 }  // namespace zc
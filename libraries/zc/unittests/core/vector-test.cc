@@ -0,0 +1,200 @@
+// Copyright (c) 2025 Zode.Z and contributors
+// Licensed under the MIT License:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "zc/core/vector.h"
+
+#include <zc/ztest/test.h>
+
+#include "zc/core/string.h"
+
+namespace zc {
+namespace {
+
+ZC_TEST("Vector") {
+  Vector<int> v;
+  ZC_EXPECT(v.empty());
+  for (int i : zeroTo(10)) v.add(i);
+  ZC_EXPECT(v.size() == 10);
+  ZC_EXPECT(v.capacity() == 16);
+  ZC_EXPECT(v.front() == 0);
+  ZC_EXPECT(v.back() == 9);
+
+  v.shrinkToFit();
+  ZC_EXPECT(v.capacity() == 10);
+  ZC_EXPECT(v.asPtr() == ArrayPtr<const int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  v.reserve(100);
+  ZC_EXPECT(v.capacity() == 100);
+  v.truncate(3);
+  auto array = v.releaseAsArray();
+  ZC_EXPECT(array == ArrayPtr<const int>({0, 1, 2}));
+  ZC_EXPECT(v.empty());
+}
+
+struct Counted {
+  // Tracks how many instances are alive, to check that InlineVector constructs and destroys every
+  // element exactly once.
+
+  static int live;
+  int value;
+  bool movedFrom = false;
+
+  Counted(int value) : value(value) { ++live; }
+  Counted(Counted&& other) : value(other.value) {
+    ZC_ASSERT(!other.movedFrom);
+    other.movedFrom = true;
+    ++live;
+  }
+  ~Counted() noexcept(false) { --live; }
+  ZC_DISALLOW_COPY(Counted);
+  Counted& operator=(Counted&& other) = delete;
+};
+int Counted::live = 0;
+
+ZC_TEST("InlineVector stays inline until it outgrows N") {
+  {
+    InlineVector<Counted, 4> v;
+    ZC_EXPECT(v.isInline());
+    ZC_EXPECT(v.capacity() == 4);
+
+    for (int i : zeroTo(4)) v.add(i);
+    ZC_EXPECT(v.isInline());
+    ZC_EXPECT(Counted::live == 4);
+
+    v.add(4);
+    ZC_EXPECT(!v.isInline());
+    ZC_EXPECT(v.capacity() == 8);
+    ZC_EXPECT(Counted::live == 5);
+    for (int i : zeroTo(5)) ZC_EXPECT(v[i].value == i && !v[i].movedFrom);
+
+    // Shrinking moves the elements back inline once they fit.
+    v.removeLast();
+    v.shrinkToFit();
+    ZC_EXPECT(v.isInline());
+    ZC_EXPECT(v.size() == 4);
+    ZC_EXPECT(Counted::live == 4);
+    ZC_EXPECT(v.back().value == 3);
+
+    v.truncate(1);
+    ZC_EXPECT(Counted::live == 1);
+  }
+  ZC_EXPECT(Counted::live == 0);
+}
+
+ZC_TEST("InlineVector move") {
+  {
+    InlineVector<Counted, 2> small;
+    small.add(1);
+    small.add(2);
+    InlineVector<Counted, 2> moved = zc::mv(small);
+    ZC_EXPECT(small.empty());
+    ZC_EXPECT(moved.size() == 2);
+    ZC_EXPECT(moved[1].value == 2);
+    ZC_EXPECT(Counted::live == 2);
+
+    InlineVector<Counted, 2> big;
+    for (int i : zeroTo(5)) big.add(i);
+    const Counted* elements = big.begin();
+    moved = zc::mv(big);
+    ZC_EXPECT(Counted::live == 5);
+    ZC_EXPECT(moved.begin() == elements, "heap elements should not be moved");
+    ZC_EXPECT(big.isInline() && big.empty());
+  }
+  ZC_EXPECT(Counted::live == 0);
+}
+
+ZC_TEST("InlineVector destroys only constructed elements when a copy throws") {
+  struct ThrowsOnCopy {
+    int value;
+    ThrowsOnCopy(int value) : value(value) { ++Counted::live; }
+    ThrowsOnCopy(const ThrowsOnCopy& other) : value(other.value) {
+      if (value < 0) ZC_FAIL_ASSERT("can't copy");
+      ++Counted::live;
+    }
+    ~ThrowsOnCopy() noexcept(false) { --Counted::live; }
+  };
+
+  {
+    ThrowsOnCopy source[] = {1, 2, -1};
+    ZC_EXPECT(Counted::live == 3);
+    {
+      InlineVector<ThrowsOnCopy, 4> v;
+      ZC_EXPECT_THROW_MESSAGE("can't copy", v.addAll(source, source + 3));
+      ZC_EXPECT(v.size() == 2);
+      ZC_EXPECT(Counted::live == 5);
+    }
+    ZC_EXPECT(Counted::live == 3);
+  }
+  ZC_EXPECT(Counted::live == 0);
+}
+
+ZC_TEST("InlineVector interoperates with ArrayPtr and Array") {
+  InlineVector<int, 4> v;
+  v.addAll(ArrayPtr<const int>({1, 2, 3}));
+  ArrayPtr<const int> ptr = v;
+  ZC_EXPECT(ptr == ArrayPtr<const int>({1, 2, 3}));
+  ZC_EXPECT(v.slice(1, 3) == ArrayPtr<const int>({2, 3}));
+
+  // Releasing inline elements allocates an array of exactly the right size.
+  Array<int> array = v.releaseAsArray();
+  ZC_EXPECT(array == ArrayPtr<const int>({1, 2, 3}));
+  ZC_EXPECT(v.empty() && v.isInline());
+
+  // An Array is adopted without copying.
+  const int* elements = array.begin();
+  InlineVector<int, 4> adopted = zc::mv(array);
+  ZC_EXPECT(!adopted.isInline());
+  ZC_EXPECT(adopted.begin() == elements);
+  adopted.add(4);
+  ZC_EXPECT(adopted.releaseAsArray() == ArrayPtr<const int>({1, 2, 3, 4}));
+
+  InlineVector<String, 2> strings;
+  strings.resize(3);
+  ZC_EXPECT(strings[2] == nullptr);
+  strings[0] = heapString("foo");
+  strings.resize(1);
+  ZC_EXPECT(strings.size() == 1);
+  ZC_EXPECT(strings[0] == "foo");
+}
+
+constexpr uint BENCHMARK_ROUNDS = 1 << 24;
+
+template <typename Collection>
+void smallCollectionBenchmark() {
+  // The shape of a per-request collection: a few elements are added, then the whole thing is
+  // released as an Array.
+  size_t sum = 0;
+  for (uint i : zeroTo(BENCHMARK_ROUNDS)) {
+    Collection c;
+    for (uint j : zeroTo(i % 4)) c.add(j);
+    sum += c.releaseAsArray().size();
+  }
+  ZC_EXPECT(sum > 0);
+}
+
+ZC_TEST("benchmark: Vector, 0-3 elements") { smallCollectionBenchmark<Vector<uint>>(); }
+
+ZC_TEST("benchmark: InlineVector, 0-3 elements") {
+  smallCollectionBenchmark<InlineVector<uint, 4>>();
+}
+
+}  // namespace
+}  // namespace zc
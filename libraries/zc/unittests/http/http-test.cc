@@ -1677,6 +1677,23 @@ ZC_TEST("HttpInputStream responses") {
   ZC_EXPECT(!input->awaitNextMessage().wait(waitScope));
 }
 
+ZC_TEST("HttpInputStream rejects Content-Length values that aren't plain digits") {
+  ZC_HTTP_TEST_SETUP_IO;
+
+  zc::HttpHeaderTable table;
+
+  zc::StringPtr badValues[] = {"-1", "+5", "0x5", "5 5", "18446744073709551616"};
+  for (auto value : badValues) {
+    ZC_CONTEXT(value);
+    auto pipe = zc::newOneWayPipe();
+    auto input = newHttpInputStream(*pipe.in, table);
+    auto message = zc::str("Content-Length: ", value, "\r\n\r\n");
+    auto writeTask = pipe.out->write(message.asBytes()).then([&]() { pipe.out = nullptr; });
+    ZC_EXPECT_THROW_MESSAGE("invalid Content-Length", input->readMessage().wait(waitScope));
+    writeTask.wait(waitScope);
+  }
+}
+
 ZC_TEST("HttpInputStream bare messages") {
   ZC_HTTP_TEST_SETUP_IO;
 
@@ -14,7 +14,12 @@
 
 #include "zomlang/compiler/driver/driver.h"
 
+#include <thread>
+
+#include "zc/core/debug.h"
 #include "zc/core/filesystem.h"
+#include "zc/core/map.h"
+#include "zc/core/thread.h"
 #include "zomlang/compiler/basic/frontend.h"
 #include "zomlang/compiler/source/manager.h"
 #include "zomlang/compiler/source/module.h"
@@ -23,6 +28,28 @@ namespace zomlang {
 namespace compiler {
 namespace driver {
 
+namespace {
+
+/// Writes `content` to `path` through an atomic replacement, unless the file already holds
+/// exactly these bytes. Returns whether the file was written.
+bool replaceFileIfChanged(const zc::Directory& dir, zc::PathPtr path,
+                          zc::ArrayPtr<const zc::byte> content) {
+  ZC_IF_SOME(existing, dir.tryOpenFile(path)) {
+    uint64_t size = existing->stat().size;
+    if (size == content.size() && (size == 0 || existing->mmap(0, size).asPtr() == content)) {
+      return false;
+    }
+  }
+
+  auto replacer = dir.replaceFile(
+      path, zc::WriteMode::CREATE | zc::WriteMode::MODIFY | zc::WriteMode::CREATE_PARENT);
+  replacer->get().writeAll(content);
+  replacer->commit();
+  return true;
+}
+
+}  // namespace
+
 // ========== CompilerDriver::Impl
 
 class CompilerDriver::Impl {
@@ -33,20 +60,29 @@ public:
   ZC_DISALLOW_COPY_AND_MOVE(Impl);
 
   struct OutputDirective {
-    zc::ArrayPtr<zc::byte> name;
+    zc::Own<ArtifactEmitter> emitter;
     zc::Maybe<zc::Path> dir;
 
     ZC_DISALLOW_COPY(OutputDirective);
     OutputDirective(OutputDirective&&) noexcept = default;
-    OutputDirective(const zc::ArrayPtr<zc::byte> name, zc::Maybe<zc::Path> dir)
-        : name(name), dir(zc::mv(dir)) {}
+    OutputDirective(zc::Own<ArtifactEmitter> emitter, zc::Maybe<zc::Path> dir)
+        : emitter(zc::mv(emitter)), dir(zc::mv(dir)) {}
   };
 
   zc::Maybe<const source::Module&> addSourceFileImpl(zc::StringPtr file);
+  zc::Maybe<const source::Module&> addSourceFileImpl(const zc::ReadableDirectory& dir,
+                                                     zc::PathPtr path);
+
+  void addOutputImpl(zc::Own<ArtifactEmitter> emitter, zc::Maybe<zc::Path> dir);
+  EmitResult emitOutputsImpl(const zc::Directory& baseDir, unsigned parallelism);
 
 private:
   zc::Own<source::ModuleLoader> loader;
   zc::Vector<OutputDirective> outputs;
+  /// Loaded modules in the order they were first added, which fixes the emission order.
+  zc::Vector<const source::Module*> modules;
+
+  zc::Maybe<const source::Module&> recordModule(zc::Maybe<const source::Module&> module);
 };
 
 CompilerDriver::Impl::Impl() noexcept : loader(zc::heap<source::ModuleLoader>()) {}
@@ -54,7 +90,85 @@ CompilerDriver::Impl::Impl() noexcept : loader(zc::heap<source::ModuleLoader>())
 CompilerDriver::Impl::~Impl() noexcept(false) = default;
 
 zc::Maybe<const source::Module&> CompilerDriver::Impl::addSourceFileImpl(const zc::StringPtr file) {
-  return loader->loadModule(file);
+  return recordModule(loader->loadModule(file));
+}
+
+zc::Maybe<const source::Module&> CompilerDriver::Impl::addSourceFileImpl(
+    const zc::ReadableDirectory& dir, const zc::PathPtr path) {
+  return recordModule(loader->loadModule(dir, path));
+}
+
+zc::Maybe<const source::Module&> CompilerDriver::Impl::recordModule(
+    zc::Maybe<const source::Module&> module) {
+  ZC_IF_SOME(m, module) {
+    for (const source::Module* existing : modules) {
+      if (*existing == m) { return m; }
+    }
+    modules.add(&m);
+  }
+  return module;
+}
+
+void CompilerDriver::Impl::addOutputImpl(zc::Own<ArtifactEmitter> emitter,
+                                         zc::Maybe<zc::Path> dir) {
+  outputs.add(zc::mv(emitter), zc::mv(dir));
+}
+
+EmitResult CompilerDriver::Impl::emitOutputsImpl(const zc::Directory& baseDir,
+                                                 unsigned parallelism) {
+  struct Job {
+    const source::Module& module;
+    const ArtifactEmitter& emitter;
+    zc::Path path;
+    bool written = false;
+    zc::Maybe<zc::Exception> exception = zc::none;
+  };
+
+  // Lay out every (output, module) pair up front so that the results do not depend on which
+  // worker happens to pick up which job.
+  zc::Vector<Job> jobs(outputs.size() * modules.size());
+  zc::HashSet<zc::String> seenPaths;
+  for (auto& output : outputs) {
+    for (const source::Module* module : modules) {
+      zc::Path path = output.emitter->getOutputPath(*module);
+      ZC_IF_SOME(dir, output.dir) { path = dir.append(path); }
+      zc::String key = path.toString();
+      ZC_REQUIRE(!seenPaths.contains(key), "two outputs would be written to the same path", key);
+      seenPaths.insert(zc::mv(key));
+      jobs.add(Job{*module, *output.emitter, zc::mv(path)});
+    }
+  }
+
+  size_t nextJob = 0;
+  auto runJobs = [&]() {
+    for (;;) {
+      size_t index = __atomic_fetch_add(&nextJob, 1, __ATOMIC_RELAXED);
+      if (index >= jobs.size()) { return; }
+      Job& job = jobs[index];
+      job.exception = zc::runCatchingExceptions([&]() {
+        zc::Array<zc::byte> content = job.emitter.serialize(job.module);
+        job.written = replaceFileIfChanged(baseDir, job.path, content);
+      });
+    }
+  };
+
+  if (parallelism == 0) { parallelism = zc::max(std::thread::hardware_concurrency(), 1u); }
+  size_t threadCount = zc::min(size_t(parallelism), jobs.size());
+  {
+    // The calling thread works too, so it only needs threadCount - 1 helpers.
+    zc::Vector<zc::Own<zc::Thread>> workers;
+    for (size_t i = 1; i < threadCount; i++) {
+      workers.add(zc::heap<zc::Thread>([&]() { runJobs(); }));
+    }
+    runJobs();
+  }
+
+  EmitResult result;
+  for (auto& job : jobs) {
+    ZC_IF_SOME(exception, job.exception) { zc::throwFatalException(zc::mv(exception)); }
+    (job.written ? result.written : result.unchanged).add(zc::mv(job.path));
+  }
+  return result;
 }
 
 // ========== CompilerDriver
@@ -66,6 +180,19 @@ zc::Maybe<const source::Module&> CompilerDriver::addSourceFile(const zc::StringP
   return impl->addSourceFileImpl(file);
 }
 
+zc::Maybe<const source::Module&> CompilerDriver::addSourceFile(const zc::ReadableDirectory& dir,
+                                                               const zc::PathPtr path) {
+  return impl->addSourceFileImpl(dir, path);
+}
+
+void CompilerDriver::addOutput(zc::Own<ArtifactEmitter> emitter, zc::Maybe<zc::Path> dir) {
+  impl->addOutputImpl(zc::mv(emitter), zc::mv(dir));
+}
+
+EmitResult CompilerDriver::emitOutputs(const zc::Directory& baseDir, const unsigned parallelism) {
+  return impl->emitOutputsImpl(baseDir, parallelism);
+}
+
 }  // namespace driver
 }  // namespace compiler
 }  // namespace zomlang
@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include "zc/core/filesystem.h"
 #include "zc/core/string.h"
+#include "zc/core/vector.h"
 
 namespace zomlang {
 namespace compiler {
@@ -25,12 +27,43 @@ class Module;
 
 namespace driver {
 
+/// Produces one kind of output artifact (serialized AST, IR, ...) for each loaded module.
+class ArtifactEmitter {
+public:
+  virtual ~ArtifactEmitter() noexcept(false) = default;
+
+  /// Returns the path of the artifact for `module`, relative to the output directory.
+  virtual zc::Path getOutputPath(const source::Module& module) const = 0;
+
+  /// Serializes the artifact for `module`. Called concurrently for different modules, so this must
+  /// not mutate shared state, and must be deterministic for unchanged outputs to be detected.
+  virtual zc::Array<zc::byte> serialize(const source::Module& module) const = 0;
+};
+
+struct EmitResult {
+  /// Outputs whose content changed and were atomically replaced.
+  zc::Vector<zc::Path> written;
+  /// Outputs left untouched because the existing file already had identical content.
+  zc::Vector<zc::Path> unchanged;
+};
+
 class CompilerDriver {
 public:
   CompilerDriver() noexcept;
   ~CompilerDriver() noexcept(false);
 
   zc::Maybe<const source::Module&> addSourceFile(zc::StringPtr file);
+  zc::Maybe<const source::Module&> addSourceFile(const zc::ReadableDirectory& dir,
+                                                 zc::PathPtr path);
+
+  /// Requests that `emitter`'s artifact be produced for every module, under `dir` if given.
+  void addOutput(zc::Own<ArtifactEmitter> emitter, zc::Maybe<zc::Path> dir = zc::none);
+
+  /// Serializes every requested output on `parallelism` threads (0 means one per CPU) and writes
+  /// them below `baseDir`. Files whose existing content is byte-identical are not touched, so
+  /// their modification times are preserved. Results are reported in a deterministic order
+  /// regardless of scheduling.
+  EmitResult emitOutputs(const zc::Directory& baseDir, unsigned parallelism = 0);
 
 private:
   class Impl;
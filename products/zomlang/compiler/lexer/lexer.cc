@@ -1 +1,459 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
 #include "zomlang/compiler/lexer/lexer.h"
+
+#include <string.h>
+
+#include "zc/core/debug.h"
+#include "zomlang/compiler/source/manager.h"
+
+namespace zomlang {
+namespace compiler {
+
+namespace {
+
+// Sorted by length so that lookup can stop at the first keyword longer than the text.
+constexpr zc::StringPtr KEYWORDS[] = {
+    "as"_zc,     "if"_zc,     "in"_zc,     "is"_zc,     "for"_zc,     "fun"_zc,
+    "let"_zc,    "var"_zc,    "else"_zc,   "enum"_zc,   "impl"_zc,    "null"_zc,
+    "true"_zc,   "break"_zc,  "const"_zc,  "false"_zc,  "match"_zc,   "trait"_zc,
+    "while"_zc,  "export"_zc, "import"_zc, "return"_zc, "struct"_zc,  "continue"_zc,
+};
+
+constexpr size_t MAX_KEYWORD_LENGTH = 8;
+
+bool isKeyword(zc::ArrayPtr<const char> text) {
+  if (text.size() > MAX_KEYWORD_LENGTH) { return false; }
+  for (zc::StringPtr keyword : KEYWORDS) {
+    if (keyword.size() < text.size()) { continue; }
+    if (keyword.size() > text.size()) { break; }
+    if (memcmp(keyword.begin(), text.begin(), text.size()) == 0) { return true; }
+  }
+  return false;
+}
+
+bool isDigit(char c) { return '0' <= c && c <= '9'; }
+
+bool isAsciiLetter(char c) { return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z'); }
+
+bool isPunctuation(char c) { return c != '\0' && strchr("(){}[],;:", c) != nullptr; }
+
+bool isHorizontalOrVerticalSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool isNewline(char c) { return c == '\n' || c == '\r'; }
+
+/// Whether a `/` following this token starts a regex literal rather than a division: it does
+/// wherever an operand is expected.
+bool canPrecedeRegex(tok kind, zc::ArrayPtr<const char> text) {
+  switch (kind) {
+    case tok::kIdentifier:
+    case tok::kInteger:
+    case tok::kFloat:
+    case tok::kString:
+    case tok::kStringTail:
+    case tok::kRegexLiteral:
+      return false;
+    case tok::kPunctuation:
+      return text[0] != ')' && text[0] != ']' && text[0] != '}';
+    case tok::kKeyword:
+      return text != "true"_zc.asArray() && text != "false"_zc.asArray() &&
+             text != "null"_zc.asArray();
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+Lexer::Lexer(const LangOptions& options, source::SourceManager& sourceMgr, DiagnosticEngine& diags,
+             zc::ArrayPtr<const char> buffer, SourceLoc bufferLoc)
+    : bufferStart(buffer.begin()),
+      bufferEnd(buffer.end()),
+      curPtr(buffer.begin()),
+      bufferLoc(bufferLoc),
+      commentMode(CommentRetentionMode::kNone),
+      langOpts(options),
+      sourceMgr(sourceMgr),
+      diags(diags) {
+  lexImpl();
+}
+
+void Lexer::lex(Token& result) {
+  result = nextToken;
+  if (result.getKind() != tok::kEOF) { lexImpl(); }
+}
+
+const Token& Lexer::peekNextToken() const { return nextToken; }
+
+void Lexer::setCommentRetentionMode(CommentRetentionMode mode) {
+  undoLookahead();
+  commentMode = mode;
+  lexImpl();
+}
+
+LexerMode Lexer::getCurrentMode() const {
+  return modeStack.empty() ? LexerMode::kNormal : modeStack.back().mode;
+}
+
+void Lexer::enterMode(LexerMode mode) {
+  ZC_REQUIRE(mode != LexerMode::kStringInterpolation,
+             "interpolations are entered by lexing a string literal");
+  undoLookahead();
+  modeStack.add(ModeFrame{mode, nullptr, '\0', 0, 0});
+  lexImpl();
+}
+
+void Lexer::exitMode(LexerMode mode) {
+  undoLookahead();
+  ZC_REQUIRE(mode != LexerMode::kStringInterpolation && getCurrentMode() == mode,
+             "exitMode() does not match the innermost enterMode()");
+  modeStack.removeLast();
+  lexImpl();
+}
+
+LexerState Lexer::getStateForBeginningOfToken(const Token& tok) const {
+  return LexerState(tok.getStart(), getCurrentMode());
+}
+
+void Lexer::restoreState(LexerState s, bool enableDiagnostics) {
+  ZC_REQUIRE(s.mode == LexerMode::kNormal,
+             "only positions outside string interpolations can be restored");
+  ZC_REQUIRE(bufferStart <= s.ptr && s.ptr <= bufferEnd, "state belongs to another buffer");
+  modeStack.clear();
+  curPtr = s.ptr;
+  regexContextKnown = false;
+  diagnosticsEnabled = enableDiagnostics;
+  lexImpl();
+  diagnosticsEnabled = true;
+}
+
+void Lexer::undoLookahead() {
+  const LookaheadUndo& undo = lookaheadUndo;
+  if (modeStack.size() > undo.stackSize) {
+    modeStack.removeLast();
+  } else if (modeStack.size() < undo.stackSize) {
+    modeStack.add(undo.top);
+  } else if (undo.stackSize > 0) {
+    modeStack.back() = undo.top;
+  }
+  regexAllowed = undo.regexAllowed;
+  regexContextKnown = undo.regexContextKnown;
+  curPtr = undo.triviaStart;
+}
+
+InFlightDiagnostic Lexer::diagnose(const char* loc, Diagnostic diag) {
+  return InFlightDiagnostic(diags, getLocForPtr(loc), zc::mv(diag));
+}
+
+SourceLoc Lexer::getLocForPtr(const char* ptr) const {
+  return bufferLoc.getAdvancedLoc(ptr - bufferStart);
+}
+
+void Lexer::diagnoseError(const char* loc, LexerDiagId id, zc::StringPtr message) {
+  if (!diagnosticsEnabled) { return; }
+  SourceLoc start = getLocForPtr(loc);
+  diagnose(loc, Diagnostic(DiagnosticKind::kError, static_cast<uint32_t>(id), message,
+                           CharSourceRange(start, start.getAdvancedLoc(1))));
+}
+
+bool Lexer::isAtEndOfFile() const { return curPtr == bufferEnd; }
+
+bool Lexer::isIdentifierStart(char c) const {
+  if (isAsciiLetter(c) || c == '_') { return true; }
+  if (c == '$') { return langOpts.allowDollarIdentifiers; }
+  // Any byte of a multi-byte UTF-8 sequence; the lexer does not classify code points.
+  return langOpts.useUnicode && static_cast<unsigned char>(c) >= 0x80;
+}
+
+bool Lexer::isIdentifierContinuation(char c) const { return isIdentifierStart(c) || isDigit(c); }
+
+bool Lexer::isOperatorStart(char c) const {
+  return c != '\0' && strchr("+-*/%=<>!&|^~?@#.", c) != nullptr;
+}
+
+void Lexer::formToken(tok kind, const char* tokStart) {
+  nextToken = Token(TokenDesc(kind, tokStart, curPtr - tokStart, getLocForPtr(tokStart)));
+  if (kind != tok::kComment) {
+    regexAllowed = canPrecedeRegex(kind, zc::arrayPtr(tokStart, curPtr));
+    regexContextKnown = true;
+  }
+}
+
+void Lexer::lexImpl() {
+  lookaheadUndo = {curPtr, modeStack.size(), modeStack.empty() ? ModeFrame{} : modeStack.back(),
+                   regexAllowed, regexContextKnown};
+  skipTrivia();
+
+  if (isAtEndOfFile()) {
+    for (const ModeFrame& frame : modeStack) {
+      if (frame.mode == LexerMode::kStringInterpolation) {
+        diagnoseError(frame.stringStart, LexerDiagId::kUnterminatedString,
+                      "unterminated string literal");
+      }
+    }
+    return formToken(tok::kEOF, curPtr);
+  }
+
+  const char* tokStart = curPtr;
+  char c = *curPtr;
+
+  if (c == '/' && curPtr + 1 != bufferEnd && (curPtr[1] == '/' || curPtr[1] == '*')) {
+    // Only reached when comments are returned as tokens; otherwise skipTrivia() ate them.
+    lexComment();
+    return formToken(tok::kComment, tokStart);
+  }
+  if (getCurrentMode() == LexerMode::kStringInterpolation) {
+    ModeFrame& frame = modeStack.back();
+    if (c == '(') {
+      ++frame.parenDepth;
+    } else if (c == ')') {
+      if (frame.parenDepth == 0) {
+        ++curPtr;
+        return lexStringSegment(tokStart, false);
+      }
+      --frame.parenDepth;
+    }
+  }
+
+  if (isIdentifierStart(c)) { return lexIdentifier(); }
+  if (isDigit(c)) { return lexNumber(); }
+
+  if (c == '"' || c == '\'') { return lexStringLiteral(); }
+  if (c == '#') {
+    const char* quote = curPtr;
+    while (quote != bufferEnd && *quote == '#') { ++quote; }
+    if (quote != bufferEnd && (*quote == '"' || *quote == '\'')) {
+      curPtr = quote;
+      return lexStringLiteral(quote - tokStart);
+    }
+  }
+  if (c == '`') { return lexEscapedIdentifier(); }
+  if (isPunctuation(c)) {
+    ++curPtr;
+    return formToken(tok::kPunctuation, tokStart);
+  }
+  if (c == '/' && tryLexRegexLiteral(tokStart)) { return; }
+  if (isOperatorStart(c)) { return lexOperator(); }
+
+  recoverFromLexingError();
+}
+
+void Lexer::skipTrivia() {
+  while (!isAtEndOfFile()) {
+    char c = *curPtr;
+    if (isHorizontalOrVerticalSpace(c)) {
+      ++curPtr;
+    } else if (c == '/' && commentMode != CommentRetentionMode::kReturnAsTokens &&
+               curPtr + 1 != bufferEnd && (curPtr[1] == '/' || curPtr[1] == '*')) {
+      lexComment();
+    } else {
+      return;
+    }
+  }
+}
+
+void Lexer::lexComment() {
+  const char* start = curPtr;
+  if (curPtr[1] == '/') {
+    const void* newline = memchr(curPtr, '\n', bufferEnd - curPtr);
+    curPtr = newline == nullptr ? bufferEnd : static_cast<const char*>(newline);
+    return;
+  }
+
+  // Block comments do not nest, so the first "*/" always closes them.
+  curPtr += 2;
+  while (true) {
+    if (isAtEndOfFile()) {
+      diagnoseError(start, LexerDiagId::kUnterminatedBlockComment, "unterminated '/*' comment");
+      return;
+    }
+    if (*curPtr == '*' && curPtr + 1 != bufferEnd && curPtr[1] == '/') {
+      curPtr += 2;
+      return;
+    }
+    ++curPtr;
+  }
+}
+
+void Lexer::lexIdentifier() {
+  const char* tokStart = curPtr++;
+  while (!isAtEndOfFile() && isIdentifierContinuation(*curPtr)) { ++curPtr; }
+  bool keyword = isKeyword(zc::arrayPtr(tokStart, curPtr));
+  formToken(keyword ? tok::kKeyword : tok::kIdentifier, tokStart);
+}
+
+void Lexer::lexEscapedIdentifier() {
+  const char* tokStart = curPtr++;
+  const char* end = curPtr;
+  while (end != bufferEnd && isIdentifierContinuation(*end)) { ++end; }
+  if (end == curPtr || end == bufferEnd || *end != '`') {
+    // Not `identifier`: treat the backtick on its own as an invalid character.
+    curPtr = tokStart;
+    return recoverFromLexingError();
+  }
+  curPtr = end + 1;
+  formToken(tok::kIdentifier, tokStart);
+}
+
+void Lexer::lexNumber() {
+  const char* tokStart = curPtr;
+
+  if (*curPtr == '0' && curPtr + 1 != bufferEnd &&
+      (curPtr[1] == 'x' || curPtr[1] == 'X' || curPtr[1] == 'b' || curPtr[1] == 'B' ||
+       curPtr[1] == 'o' || curPtr[1] == 'O')) {
+    // Radix prefix. The digits are validated when the literal is evaluated.
+    curPtr += 2;
+    while (!isAtEndOfFile() && (isDigit(*curPtr) || isAsciiLetter(*curPtr) || *curPtr == '_')) {
+      ++curPtr;
+    }
+    return formToken(tok::kInteger, tokStart);
+  }
+
+  auto skipDigits = [this]() {
+    while (!isAtEndOfFile() && (isDigit(*curPtr) || *curPtr == '_')) { ++curPtr; }
+  };
+
+  skipDigits();
+  bool isFloat = false;
+
+  // A '.' only belongs to the literal if a digit follows, so that `1..2` and `1.foo` still work.
+  if (curPtr + 1 < bufferEnd && curPtr[0] == '.' && isDigit(curPtr[1])) {
+    isFloat = true;
+    ++curPtr;
+    skipDigits();
+  }
+
+  if (!isAtEndOfFile() && (*curPtr == 'e' || *curPtr == 'E')) {
+    const char* exponent = curPtr + 1;
+    if (exponent != bufferEnd && (*exponent == '+' || *exponent == '-')) { ++exponent; }
+    if (exponent != bufferEnd && isDigit(*exponent)) {
+      isFloat = true;
+      curPtr = exponent;
+      skipDigits();
+    }
+  }
+
+  formToken(isFloat ? tok::kFloat : tok::kInteger, tokStart);
+}
+
+void Lexer::lexStringLiteral(unsigned customDelimiterLen) {
+  const char* tokStart = curPtr - customDelimiterLen;
+  // Every string gets a frame; it is popped again unless the string turns out to interpolate.
+  modeStack.add(
+      ModeFrame{LexerMode::kStringInterpolation, tokStart, *curPtr, customDelimiterLen, 0});
+  ++curPtr;
+  lexStringSegment(tokStart, true);
+}
+
+void Lexer::lexStringSegment(const char* tokStart, bool isFirst) {
+  const ModeFrame& frame = modeStack.back();
+  const char* stringStart = frame.stringStart;
+  const char quote = frame.quote;
+  const unsigned delimiterLength = frame.delimiterLength;
+
+  // In a `#"..."#` string, quotes and escapes only count when followed by as many '#'.
+  auto delimiterFollows = [&]() {
+    if (size_t(bufferEnd - curPtr) < delimiterLength) { return false; }
+    for (unsigned i = 0; i < delimiterLength; i++) {
+      if (curPtr[i] != '#') { return false; }
+    }
+    return true;
+  };
+
+  while (true) {
+    if (isAtEndOfFile() || isNewline(*curPtr)) {
+      // Recover by ending the literal at the end of the line.
+      diagnoseError(stringStart, LexerDiagId::kUnterminatedString, "unterminated string literal");
+      modeStack.removeLast();
+      return formToken(isFirst ? tok::kString : tok::kStringTail, tokStart);
+    }
+
+    char c = *curPtr++;
+    if (c == quote && delimiterFollows()) {
+      curPtr += delimiterLength;
+      modeStack.removeLast();
+      return formToken(isFirst ? tok::kString : tok::kStringTail, tokStart);
+    }
+    if (c == '\\' && delimiterFollows()) {
+      curPtr += delimiterLength;
+      if (isAtEndOfFile() || isNewline(*curPtr)) { continue; }
+      if (*curPtr++ == '(') {
+        return formToken(isFirst ? tok::kStringHead : tok::kStringMiddle, tokStart);
+      }
+    }
+  }
+}
+
+bool Lexer::isRegexAllowedAt(const char* tokStart) const {
+  if (!langOpts.supportRegexLiterals) { return false; }
+  if (getCurrentMode() == LexerMode::kRegexLiteral) { return true; }
+  if (regexContextKnown) { return regexAllowed; }
+  return sourceMgr.isRegexLiteralStart(getLocForPtr(tokStart));
+}
+
+bool Lexer::tryLexRegexLiteral(const char* tokStart) {
+  if (!isRegexAllowedAt(tokStart)) { return false; }
+
+  // The decision is made from context alone: an unterminated literal is reported rather than
+  // re-lexed as a division, so every byte is scanned once.
+  curPtr = tokStart + 1;
+  bool inClass = false;
+  while (true) {
+    if (isAtEndOfFile() || isNewline(*curPtr)) {
+      diagnoseError(tokStart, LexerDiagId::kUnterminatedRegex, "unterminated regex literal");
+      break;
+    }
+    char c = *curPtr++;
+    if (c == '\\') {
+      if (!isAtEndOfFile() && !isNewline(*curPtr)) { ++curPtr; }
+    } else if (c == '[') {
+      inClass = true;
+    } else if (c == ']') {
+      inClass = false;
+    } else if (c == '/' && !inClass) {
+      while (!isAtEndOfFile() && isIdentifierContinuation(*curPtr)) { ++curPtr; }
+      break;
+    }
+  }
+
+  sourceMgr.recordRegexLiteralStartLoc(getLocForPtr(tokStart));
+  formToken(tok::kRegexLiteral, tokStart);
+  return true;
+}
+
+void Lexer::lexOperator() {
+  const char* tokStart = curPtr++;
+  while (!isAtEndOfFile() && isOperatorStart(*curPtr)) {
+    // A comment start ends the operator, as in `a+/* c */b`.
+    if (*curPtr == '/' && curPtr + 1 != bufferEnd && (curPtr[1] == '/' || curPtr[1] == '*')) {
+      break;
+    }
+    ++curPtr;
+  }
+  formToken(tok::kOperator, tokStart);
+}
+
+void Lexer::recoverFromLexingError() {
+  const char* tokStart = curPtr++;
+  // Swallow the rest of a UTF-8 sequence so that a single bad character yields a single token.
+  while (!isAtEndOfFile() && (static_cast<unsigned char>(*curPtr) & 0xC0) == 0x80) { ++curPtr; }
+  diagnoseError(tokStart, LexerDiagId::kInvalidCharacter, "invalid character in source file");
+  formToken(tok::kUnknown, tokStart);
+}
+
+}  // namespace compiler
+}  // namespace zomlang
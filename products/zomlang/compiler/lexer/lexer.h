@@ -28,7 +28,9 @@ class SourceManager;
 
 enum class LexerMode {
   kNormal,
+  /// Inside the `\(...)` of an interpolated string; a `)` that closes it resumes the string.
   kStringInterpolation,
+  /// A `/` always starts a regex literal, whatever the preceding token.
   kRegexLiteral,
   // more...
 };
@@ -39,6 +41,14 @@ enum class CommentRetentionMode {
   kReturnAsTokens      // Return comments as separate tags
 };
 
+/// Identifiers of the diagnostics reported by the lexer.
+enum class LexerDiagId : uint32_t {
+  kInvalidCharacter = 1,
+  kUnterminatedString,
+  kUnterminatedBlockComment,
+  kUnterminatedRegex,
+};
+
 struct LexerState {
   const char* ptr;
   LexerMode mode;
@@ -49,9 +59,10 @@ struct LexerState {
 
 class Lexer {
 public:
-  // Constructor
-  Lexer(const LangOptions& options, const source::SourceManager& sourceMgr, DiagnosticEngine& diags)
-      : langOpts(options), sourceMgr(sourceMgr), diags(diags) {}
+  /// Lexes `buffer`, whose first byte is at `bufferLoc`. The buffer must outlive the lexer and
+  /// the tokens it produces. Regex literal start locations are recorded in `sourceMgr`.
+  Lexer(const LangOptions& options, source::SourceManager& sourceMgr, DiagnosticEngine& diags,
+        zc::ArrayPtr<const char> buffer, SourceLoc bufferLoc);
 
   // Main lexical analysis function
   void lex(Token& result);
@@ -59,21 +70,26 @@ public:
   // Preview the next token
   const Token& peekNextToken() const;
 
-  // State management
+  // State management. Only positions outside string interpolations can be restored. Whether a
+  // `/` at the restored position starts a regex is looked up in the SourceManager, since the
+  // preceding token is unknown.
   LexerState getStateForBeginningOfToken(const Token& tok) const;
   void restoreState(LexerState s, bool enableDiagnostics = false);
 
-  // Mode switching
+  // Mode switching, for the parser to force or cancel regex literals where only the grammar can
+  // tell. The lookahead token is lexed again under the new mode.
   void enterMode(LexerMode mode);
   void exitMode(LexerMode mode);
+  ZC_NODISCARD LexerMode getCurrentMode() const;
 
   // Unicode support
   static unsigned lexUnicodeEscape(const char*& curPtr, DiagnosticEngine* diags);
 
-  // Regular expression support
+  // Regular expression support. Returns false, without scanning, if a regex cannot start here.
   bool tryLexRegexLiteral(const char* tokStart);
 
-  // String interpolation support
+  // String interpolation support. `curPtr` is at the opening quote, preceded by
+  // `customDelimiterLen` '#' characters.
   void lexStringLiteral(unsigned customDelimiterLen = 0);
 
   // Code completion support
@@ -94,13 +110,40 @@ private:
   const char* bufferStart;
   const char* bufferEnd;
   const char* curPtr;
+  SourceLoc bufferLoc;
+
+  /// One entry per mode entered; an empty stack means kNormal.
+  struct ModeFrame {
+    LexerMode mode;
+    // For kStringInterpolation: where the string began, its quote, the number of '#' around it
+    // and the number of '(' currently open inside the interpolation.
+    const char* stringStart;
+    char quote;
+    unsigned delimiterLength;
+    unsigned parenDepth;
+  };
+  zc::Vector<ModeFrame> modeStack;
+
+  /// Whether a `/` after the last token starts a regex literal. Unknown after restoreState().
+  bool regexAllowed = true;
+  bool regexContextKnown = true;
+  bool diagnosticsEnabled = true;
+
+  /// State from before `nextToken` was lexed, so that it can be lexed again. Lexing one token
+  /// pushes, pops or updates at most one mode frame.
+  struct LookaheadUndo {
+    const char* triviaStart;
+    size_t stackSize;
+    ModeFrame top;
+    bool regexAllowed;
+    bool regexContextKnown;
+  } lookaheadUndo;
 
   Token nextToken;
-  LexerMode currentMode;
   CommentRetentionMode commentMode;
 
   const LangOptions& langOpts;
-  const source::SourceManager& sourceMgr;
+  source::SourceManager& sourceMgr;
   DiagnosticEngine& diags;
 
   // Token cache
@@ -114,7 +157,9 @@ private:
   void skipTrivia();
   void lexIdentifier();
   void lexNumber();
-  void lexStringLiteralImpl();
+  void lexStringSegment(const char* tokStart, bool isFirst);
+  void undoLookahead();
+  bool isRegexAllowedAt(const char* tokStart) const;
   void lexEscapedIdentifier();
   void lexOperator();
 
@@ -141,6 +186,8 @@ private:
   bool isAtEndOfFile() const;
 
   // Helper functions
+  SourceLoc getLocForPtr(const char* ptr) const;
+  void diagnoseError(const char* loc, LexerDiagId id, zc::StringPtr message);
   bool isIdentifierStart(char c) const;
   bool isIdentifierContinuation(char c) const;
   bool isOperatorStart(char c) const;
@@ -13,6 +13,12 @@ enum class tok {
   kInteger,
   kFloat,
   kString,
+  /// Parts of an interpolated string "a\(x)b\(y)c": `"a\(` is the head, `)b\(` a middle and
+  /// `)c"` the tail. The interpolated expressions are lexed as ordinary tokens in between.
+  kStringHead,
+  kStringMiddle,
+  kStringTail,
+  kRegexLiteral,
   kOperator,
   kPunctuation,
   kComment,
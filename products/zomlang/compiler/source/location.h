@@ -57,6 +57,8 @@ public:
   bool operator>(const SourceLoc& rhs) const { return value > rhs.value; }
   bool operator>=(const SourceLoc& rhs) const { return value >= rhs.value; }
 
+  ZC_NODISCARD unsigned hashCode() const { return value; }
+
 private:
   unsigned value;
 };
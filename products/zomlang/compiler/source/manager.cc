@@ -14,31 +14,85 @@
 
 #include "zomlang/compiler/source/manager.h"
 
+#include <algorithm>
 #include <unordered_map>
 
 #include "zc/core/debug.h"
+#include "zc/core/map.h"
 #include "zomlang/compiler/source/module.h"
 
 namespace zomlang {
 namespace compiler {
 namespace source {
 
-// ========== SourceManager::Impl
+namespace {
 
-class SourceManager::Impl {
+/// Maps disjoint half-open location ranges to values. Entries are keyed by the end of their range,
+/// so the only range that can contain a location is the first one ending after it: lookups and
+/// overlap checks are a single O(log n) B-tree seek.
+template <typename T>
+class RangeIndex {
 public:
-  struct VirtualFile {
-    CharSourceRange range;
-    zc::StringPtr name;
-    int lineOffset;
-  };
+  ZC_NODISCARD bool overlaps(unsigned begin, unsigned end) const {
+    for (auto& entry : byEnd.range(begin + 1, MAX_KEY)) { return entry.value.begin < end; }
+    return false;
+  }
+
+  ZC_NODISCARD zc::Maybe<const T&> find(unsigned loc) const {
+    for (auto& entry : byEnd.range(loc + 1, MAX_KEY)) {
+      if (entry.value.begin <= loc) { return entry.value.value; }
+      break;
+    }
+    return zc::none;
+  }
+
+  /// The caller checks overlaps() first.
+  void insert(unsigned begin, unsigned end, T value) {
+    byEnd.insert(end, Item{begin, zc::mv(value)});
+  }
+
+  void erase(unsigned end) { byEnd.erase(end); }
+
+  void reserve(size_t size) { byEnd.reserve(size); }
+  ZC_NODISCARD size_t size() const { return byEnd.size(); }
 
-  struct GeneratedSourceInfo {
-    zc::String originalSource;
-    zc::String generatedSource;
-    zc::Array<FixIt> fixIts;
+private:
+  static constexpr unsigned MAX_KEY = zc::maxValue;
+
+  struct Item {
+    unsigned begin;
+    T value;
   };
+  zc::TreeMap<unsigned, Item> byEnd;
+};
 
+struct PendingRange {
+  unsigned begin;
+  unsigned end;
+  size_t index;
+};
+
+/// Checks that `ranges` are disjoint from each other and from everything in `index`. Sorts
+/// `ranges` by start location.
+template <typename T>
+void requireDisjoint(zc::ArrayPtr<PendingRange> ranges, const RangeIndex<T>& index,
+                     zc::StringPtr what) {
+  std::sort(ranges.begin(), ranges.end(),
+            [](const PendingRange& a, const PendingRange& b) { return a.begin < b.begin; });
+  for (size_t i = 0; i < ranges.size(); i++) {
+    ZC_REQUIRE(i == 0 || ranges[i - 1].end <= ranges[i].begin, what, "overlap each other",
+               ranges[i - 1].index, ranges[i].index);
+    ZC_REQUIRE(!index.overlaps(ranges[i].begin, ranges[i].end), what,
+               "overlaps one registered earlier", ranges[i].index);
+  }
+}
+
+}  // namespace
+
+// ========== SourceManager::Impl
+
+class SourceManager::Impl {
+public:
   explicit Impl(const zc::Filesystem& disk, zc::Own<const zc::ReadableFile> file,
                 const zc::ReadableDirectory& sourceDir, zc::Path path) noexcept;
   ~Impl() noexcept(false);
@@ -49,13 +103,13 @@ public:
                             const zc::StringPtr& bufIdentifier, Module* module);
 
   // Virtual file management
-  void createVirtualFile(const SourceLoc& loc, const zc::StringPtr name, int lineOffset,
-                         unsigned length);
+  void createVirtualFiles(zc::Array<VirtualFile> files);
   const VirtualFile* getVirtualFile(const SourceLoc& loc) const;
 
   // Generated source info
-  void setGeneratedSourceInfo(uint64_t bufferId, const GeneratedSourceInfo& info);
+  void setGeneratedSourceInfos(zc::Array<GeneratedSource> sources);
   const GeneratedSourceInfo* getGeneratedSourceInfo(uint64_t bufferId) const;
+  zc::Maybe<uint64_t> findGeneratedBufferContainingLoc(const SourceLoc& loc) const;
 
   // Location and range operations
   SourceLoc getLocForOffset(uint64_t bufferId, unsigned offset) const;
@@ -111,8 +165,14 @@ private:
   /// Path to the source file being compiled.
   const zc::Path path;
 
-  zc::Vector<VirtualFile> virtualFiles;
-  zc::Vector<SourceLoc> regexLiteralStartLocs;
+  RangeIndex<zc::Own<VirtualFile>> virtualFiles;
+
+  zc::HashMap<uint64_t, zc::Own<GeneratedSourceInfo>> generatedSources;
+  /// Generated ranges to the buffer they belong to.
+  RangeIndex<uint64_t> generatedRanges;
+  /// Start locations of the regex literals lexed so far, so that a lexer restored to an arbitrary
+  /// position can tell a regex from a division without re-lexing from the start of the buffer.
+  zc::HashSet<SourceLoc> regexLiteralStartLocs;
 
   mutable struct BufferLocCache_ {
     zc::Vector<uint64_t> sortedBuffers;
@@ -131,13 +191,98 @@ SourceManager::Impl::Impl(const zc::Filesystem& disk, zc::Own<const zc::Readable
 
 SourceManager::Impl::~Impl() noexcept(false) = default;
 
-void SourceManager::Impl::createVirtualFile(const SourceLoc& loc, zc::StringPtr name,
-                                            int lineOffset, unsigned length) {
-  VirtualFile vf;
-  vf.range = CharSourceRange{loc, length};
-  vf.name = name;
-  vf.lineOffset = lineOffset;
-  virtualFiles.add(zc::mv(vf));
+void SourceManager::Impl::createVirtualFiles(zc::Array<VirtualFile> files) {
+  auto pending = zc::heapArray<PendingRange>(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    const CharSourceRange& range = files[i].range;
+    ZC_REQUIRE(range.getStart().isValid() && range.length() > 0, "empty virtual file", i);
+    pending[i] = {range.getStart().getOpaqueValue(), range.getEnd().getOpaqueValue(), i};
+  }
+  requireDisjoint(pending.asPtr(), virtualFiles, "virtual files");
+
+  virtualFiles.reserve(virtualFiles.size() + files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    PendingRange& range = pending[i];
+    virtualFiles.insert(range.begin, range.end, zc::heap(zc::mv(files[range.index])));
+  }
+}
+
+const VirtualFile* SourceManager::Impl::getVirtualFile(const SourceLoc& loc) const {
+  ZC_IF_SOME(file, virtualFiles.find(loc.getOpaqueValue())) { return file.get(); }
+  return nullptr;
+}
+
+void SourceManager::Impl::setGeneratedSourceInfos(zc::Array<GeneratedSource> sources) {
+  zc::HashSet<uint64_t> bufferIds;
+  bufferIds.reserve(sources.size());
+  for (auto& source : sources) {
+    ZC_REQUIRE(bufferIds.find(source.bufferId) == zc::none, "buffer listed twice",
+               source.bufferId);
+    bufferIds.insert(source.bufferId);
+  }
+
+  // A buffer registered again gives up its old range before the new ones are checked, and gets
+  // it back if the check fails.
+  struct ReplacedRange {
+    unsigned begin;
+    unsigned end;
+    uint64_t bufferId;
+  };
+  zc::Vector<ReplacedRange> replaced;
+  for (auto& source : sources) {
+    ZC_IF_SOME(old, generatedSources.find(source.bufferId)) {
+      const CharSourceRange& range = old->generatedSourceRange;
+      if (range.length() > 0) {
+        replaced.add(ReplacedRange{range.getStart().getOpaqueValue(),
+                                   range.getEnd().getOpaqueValue(), source.bufferId});
+        generatedRanges.erase(range.getEnd().getOpaqueValue());
+      }
+    }
+  }
+
+  zc::Vector<PendingRange> pending(sources.size());
+  for (size_t i = 0; i < sources.size(); i++) {
+    const CharSourceRange& range = sources[i].info.generatedSourceRange;
+    if (range.length() > 0) {
+      pending.add(
+          PendingRange{range.getStart().getOpaqueValue(), range.getEnd().getOpaqueValue(), i});
+    }
+  }
+  {
+    ZC_ON_SCOPE_FAILURE({
+      for (auto& old : replaced) { generatedRanges.insert(old.begin, old.end, old.bufferId); }
+    });
+    requireDisjoint(pending.asPtr(), generatedRanges, "generated source ranges");
+  }
+
+  for (auto& range : pending) {
+    generatedRanges.insert(range.begin, range.end, sources[range.index].bufferId);
+  }
+  for (auto& source : sources) {
+    generatedSources.upsert(source.bufferId, zc::heap(zc::mv(source.info)),
+                            [](auto& existing, auto&& replacement) {
+                              existing = zc::mv(replacement);
+                            });
+  }
+}
+
+const GeneratedSourceInfo* SourceManager::Impl::getGeneratedSourceInfo(uint64_t bufferId) const {
+  ZC_IF_SOME(info, generatedSources.find(bufferId)) { return info.get(); }
+  return nullptr;
+}
+
+zc::Maybe<uint64_t> SourceManager::Impl::findGeneratedBufferContainingLoc(
+    const SourceLoc& loc) const {
+  ZC_IF_SOME(bufferId, generatedRanges.find(loc.getOpaqueValue())) { return bufferId; }
+  return zc::none;
+}
+
+void SourceManager::Impl::recordRegexLiteralStartLoc(const SourceLoc& loc) {
+  regexLiteralStartLocs.upsert(SourceLoc(loc), [](SourceLoc&, SourceLoc&&) {});
+}
+
+bool SourceManager::Impl::isRegexLiteralStart(const SourceLoc& loc) const {
+  return regexLiteralStartLocs.contains(loc);
 }
 
 void SourceManager::Impl::getMessage(const SourceLoc& loc, DiagnosticKind kind,
@@ -155,7 +300,44 @@ SourceManager::~SourceManager() noexcept(false) = default;
 
 void SourceManager::createVirtualFile(const SourceLoc& loc, const zc::StringPtr name,
                                       const int lineOffset, const unsigned length) {
-  impl->createVirtualFile(loc, name, lineOffset, length);
+  auto files = zc::heapArrayBuilder<VirtualFile>(1);
+  files.add(VirtualFile{CharSourceRange::getCharRange(loc, loc.getAdvancedLoc(length)),
+                        zc::heapString(name), lineOffset});
+  impl->createVirtualFiles(files.finish());
+}
+
+void SourceManager::createVirtualFiles(zc::Array<VirtualFile> files) {
+  impl->createVirtualFiles(zc::mv(files));
+}
+
+const VirtualFile* SourceManager::getVirtualFile(const SourceLoc& loc) const {
+  return impl->getVirtualFile(loc);
+}
+
+void SourceManager::setGeneratedSourceInfo(uint64_t bufferId, GeneratedSourceInfo info) {
+  auto sources = zc::heapArrayBuilder<GeneratedSource>(1);
+  sources.add(GeneratedSource{bufferId, zc::mv(info)});
+  impl->setGeneratedSourceInfos(sources.finish());
+}
+
+void SourceManager::setGeneratedSourceInfos(zc::Array<GeneratedSource> sources) {
+  impl->setGeneratedSourceInfos(zc::mv(sources));
+}
+
+const GeneratedSourceInfo* SourceManager::getGeneratedSourceInfo(uint64_t bufferId) const {
+  return impl->getGeneratedSourceInfo(bufferId);
+}
+
+zc::Maybe<uint64_t> SourceManager::findGeneratedBufferContainingLoc(const SourceLoc& loc) const {
+  return impl->findGeneratedBufferContainingLoc(loc);
+}
+
+void SourceManager::recordRegexLiteralStartLoc(const SourceLoc& loc) {
+  impl->recordRegexLiteralStartLoc(loc);
+}
+
+bool SourceManager::isRegexLiteralStart(const SourceLoc& loc) const {
+  return impl->isRegexLiteralStart(loc);
 }
 
 void SourceManager::getMessage(const SourceLoc& loc, DiagnosticKind kind, const zc::String& msg,
@@ -33,6 +33,30 @@ struct LineAndColumn {
   LineAndColumn(const unsigned l, const unsigned c) : line(l), column(c) {}
 };
 
+/// A region of a buffer that diagnostics report under another file name and line numbering,
+/// e.g. generated code mapped back to the template it came from.
+struct VirtualFile {
+  CharSourceRange range;
+  zc::String name;
+  int lineOffset;
+};
+
+/// Describes a buffer produced by expanding a macro or running a code generator.
+struct GeneratedSourceInfo {
+  /// The source the generated text was produced from, or replaces.
+  CharSourceRange originalSourceRange;
+  /// The locations covered by the generated text. Generated ranges never overlap.
+  CharSourceRange generatedSourceRange;
+  zc::String originalSource;
+  zc::String generatedSource;
+  zc::Array<FixIt> fixIts;
+};
+
+struct GeneratedSource {
+  uint64_t bufferId;
+  GeneratedSourceInfo info;
+};
+
 class SourceManager {
 public:
   explicit SourceManager(const zc::Filesystem& disk, zc::Own<const zc::ReadableFile> file,
@@ -46,13 +70,21 @@ public:
   uint64_t addMemBufferCopy(zc::ArrayPtr<const zc::byte> inputData,
                             const zc::StringPtr& bufIdentifier, Module* module);
 
-  // Virtual file management
+  // Virtual file management. Virtual files must not overlap. Lookups are O(log n).
   void createVirtualFile(const SourceLoc& loc, zc::StringPtr name, int lineOffset, unsigned length);
-  const struct VirtualFile* getVirtualFile(const SourceLoc& loc) const;
-
-  // Generated source info
-  void setGeneratedSourceInfo(uint64_t bufferId, const struct GeneratedSourceInfo& info);
-  const struct GeneratedSourceInfo* getGeneratedSourceInfo(uint64_t bufferId) const;
+  /// Registers many virtual files at once, as emitted by a code generator. Either all of them are
+  /// added or, if any two overlap or one overlaps an existing virtual file, none is.
+  void createVirtualFiles(zc::Array<VirtualFile> files);
+  const VirtualFile* getVirtualFile(const SourceLoc& loc) const;
+
+  // Generated source info. Registering a buffer again replaces its previous info.
+  void setGeneratedSourceInfo(uint64_t bufferId, GeneratedSourceInfo info);
+  /// Bulk form of setGeneratedSourceInfo(), with the same all-or-nothing overlap check as
+  /// createVirtualFiles().
+  void setGeneratedSourceInfos(zc::Array<GeneratedSource> sources);
+  const GeneratedSourceInfo* getGeneratedSourceInfo(uint64_t bufferId) const;
+  /// The generated buffer whose generated range contains `loc`, if any. O(log n).
+  zc::Maybe<uint64_t> findGeneratedBufferContainingLoc(const SourceLoc& loc) const;
 
   // Location and range operations
   SourceLoc getLocForOffset(uint64_t bufferId, unsigned offset) const;
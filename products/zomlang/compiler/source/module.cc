@@ -100,7 +100,7 @@ public:
   ~Impl() noexcept(false) = default;
 
   /// Returns the source name of this module.
-  zc::StringPtr getModuleName();
+  ZC_NODISCARD zc::StringPtr getModuleName() const;
 
   /// Returns true if this module is compiled.
   ZC_NODISCARD bool isCompiled() const;
@@ -122,7 +122,7 @@ Module::Impl::Impl(zc::Own<SourceManager> sm, zc::StringPtr moduleName, const ui
   ZC_REQUIRE(moduleName.size() > 0);
 }
 
-zc::StringPtr Module::Impl::getModuleName() { return moduleName; }
+zc::StringPtr Module::Impl::getModuleName() const { return moduleName; }
 
 bool Module::Impl::isCompiled() const { return compiled; }
 
@@ -139,7 +139,7 @@ Module::~Module() noexcept(false) = default;
 zc::Own<Module> Module::create(zc::Own<SourceManager> sm, zc::StringPtr moduleName, uint64_t id) {
   return zc::heap<Module>(zc::mv(sm), moduleName, id);
 }
-zc::StringPtr Module::getModuleName() { return impl->getModuleName(); }
+zc::StringPtr Module::getModuleName() const { return impl->getModuleName(); }
 bool Module::isCompiled() const { return impl->isCompiled(); }
 uint64_t Module::getModuleId() const { return impl->getModuleId(); }
 
@@ -32,7 +32,7 @@ public:
   static zc::Own<Module> create(zc::Own<SourceManager> sm, zc::StringPtr moduleName, uint64_t id);
 
   /// Returns the source name of this module.
-  zc::StringPtr getModuleName();
+  ZC_NODISCARD zc::StringPtr getModuleName() const;
   /// Returns the source content of this module.
   ZC_NODISCARD bool isCompiled() const;
   /// Retrieves the unique ID of the module
@@ -0,0 +1,228 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+// Measures how the per-byte cost of frontend stages scales with input size. Each input family is
+// generated (or, for corpus files, tiled) at doubling sizes; a stage whose per-byte cost at the
+// largest size exceeds `--max-growth` times its cost at the smallest size is reported as
+// superlinear and the tool exits with an error.
+
+#include <math.h>
+
+#include "zc/core/main.h"
+#include "zc/core/time.h"
+#include "zomlang/fuzz/harness.h"
+
+namespace zomlang {
+namespace compiler {
+namespace fuzz {
+
+namespace {
+
+/// Fills `size` bytes by repeating `unit`.
+zc::String tile(zc::ArrayPtr<const char> unit, size_t size) {
+  zc::String result = zc::heapString(size);
+  for (size_t i = 0; i < size; i++) { result[i] = unit[i % unit.size()]; }
+  return result;
+}
+
+/// `prefix` followed by `fill` repeated up to `size` bytes.
+zc::String prefixed(zc::StringPtr prefix, zc::StringPtr fill, size_t size) {
+  return zc::str(prefix, tile(fill, size - prefix.size()));
+}
+
+zc::String nestedParens(size_t size) {
+  zc::String result = zc::heapString(size);
+  for (size_t i = 0; i < size; i++) { result[i] = i < size / 2 ? '(' : ')'; }
+  return result;
+}
+
+struct Family {
+  const char* name;
+  zc::String (*generate)(size_t size);
+};
+
+// Inputs that have tripped up hand-written lexers and parsers: unbounded lookahead, rescanning
+// after a failed match, and recursion proportional to nesting depth.
+const Family FAMILIES[] = {
+    {"nested-parens", nestedParens},
+    {"identifier-run", [](size_t size) { return tile("a"_zc, size); }},
+    {"operator-run", [](size_t size) { return tile("+-"_zc, size); }},
+    {"number-run", [](size_t size) { return tile("1_"_zc, size); }},
+    {"unterminated-string", [](size_t size) { return prefixed("\""_zc, "a\\\""_zc, size); }},
+    {"unterminated-string-lines", [](size_t size) { return tile("\"ab\n"_zc, size); }},
+    {"unterminated-block-comment", [](size_t size) { return prefixed("/*"_zc, "*/*"_zc, size); }},
+    {"unterminated-regex", [](size_t size) { return prefixed("x = /"_zc, "a[("_zc, size); }},
+    {"unterminated-regex-lines", [](size_t size) { return tile("x = /a\n"_zc, size); }},
+    {"regex-class-run", [](size_t size) { return tile("(/["_zc, size); }},
+    {"regex-run", [](size_t size) { return tile("(/a/)"_zc, size); }},
+    {"interpolation-nesting", [](size_t size) { return tile("\"\\("_zc, size); }},
+    {"interpolation-run", [](size_t size) { return tile("\"a\\(b)c\" "_zc, size); }},
+    {"raw-string-quotes", [](size_t size) { return prefixed("###\""_zc, "\"##"_zc, size); }},
+    {"unterminated-escaped-identifier", [](size_t size) { return prefixed("`"_zc, "a"_zc, size); }},
+    {"backtick-run", [](size_t size) { return tile("`a"_zc, size); }},
+    {"statements", [](size_t size) { return tile("let x: i32 = 42; // answer\n"_zc, size); }},
+};
+
+struct Stage {
+  const char* name;
+  size_t (FrontendHarness::*run)(zc::ArrayPtr<const char> text);
+};
+
+// The parser gets a stage here once it exists.
+const Stage STAGES[] = {
+    {"lex", &FrontendHarness::lex},
+};
+
+}  // namespace
+
+class PerfMain {
+public:
+  explicit PerfMain(zc::ProcessContext& context)
+      : context(context), fs(zc::newDiskFilesystem()) {}
+
+  zc::MainFunc getMain() {
+    return zc::MainBuilder(context, "ZomLang frontend perf harness",
+                           "Checks that frontend stages run in linear time on adversarial inputs "
+                           "and on each file of the optional <corpus>.")
+        .addOptionWithArg({"min-size"}, ZC_BIND_METHOD(*this, setMinSize), "<bytes>",
+                          "Size of the smallest input (default 16384).")
+        .addOptionWithArg({"steps"}, ZC_BIND_METHOD(*this, setSteps), "<n>",
+                          "Number of times the input size is doubled (default 4).")
+        .addOptionWithArg({"repeats"}, ZC_BIND_METHOD(*this, setRepeats), "<n>",
+                          "Runs per measurement; the fastest one counts (default 3).")
+        .addOptionWithArg({"max-growth"}, ZC_BIND_METHOD(*this, setMaxGrowth), "<ratio>",
+                          "Largest tolerated increase of the per-byte cost (default 4).")
+        .expectZeroOrMoreArgs("<corpus>", ZC_BIND_METHOD(*this, addCorpus))
+        .callAfterParsing(ZC_BIND_METHOD(*this, run))
+        .build();
+  }
+
+  zc::MainBuilder::Validity setMinSize(zc::StringPtr arg) {
+    ZC_IF_SOME(value, arg.tryParseAs<size_t>()) {
+      if (value > 0) {
+        minSize = value;
+        return true;
+      }
+    }
+    return "expected a positive number of bytes";
+  }
+
+  zc::MainBuilder::Validity setSteps(zc::StringPtr arg) {
+    ZC_IF_SOME(value, arg.tryParseAs<unsigned>()) {
+      if (value > 0 && value < 16) {
+        steps = value;
+        return true;
+      }
+    }
+    return "expected a number between 1 and 15";
+  }
+
+  zc::MainBuilder::Validity setRepeats(zc::StringPtr arg) {
+    ZC_IF_SOME(value, arg.tryParseAs<unsigned>()) {
+      if (value > 0) {
+        repeats = value;
+        return true;
+      }
+    }
+    return "expected a positive number";
+  }
+
+  zc::MainBuilder::Validity setMaxGrowth(zc::StringPtr arg) {
+    ZC_IF_SOME(value, arg.tryParseAs<double>()) {
+      if (value >= 1) {
+        maxGrowth = value;
+        return true;
+      }
+    }
+    return "expected a ratio of at least 1";
+  }
+
+  zc::MainBuilder::Validity addCorpus(zc::StringPtr arg) {
+    for (auto& input : readCorpus(*fs, arg)) {
+      if (input.content.size() > 0) { corpus.add(zc::mv(input)); }
+    }
+    return true;
+  }
+
+  zc::MainBuilder::Validity run() {
+    for (const Stage& stage : STAGES) {
+      for (const Family& family : FAMILIES) { measure(stage, family.name, family.generate); }
+      for (auto& input : corpus) {
+        auto unit = input.content.asChars();
+        measure(stage, input.name, [unit](size_t size) { return tile(unit, size); });
+      }
+    }
+
+    context.warning(zc::str("worst per-byte cost: ", worstNsPerByte, " ns (", worstName, ")"));
+    if (failures > 0) { return zc::str(failures, " input(s) scale superlinearly"); }
+    return true;
+  }
+
+private:
+  zc::ProcessContext& context;
+  zc::Own<zc::Filesystem> fs;
+  zc::Vector<CorpusInput> corpus;
+  FrontendHarness harness;
+
+  size_t minSize = 16384;
+  unsigned steps = 4;
+  unsigned repeats = 3;
+  double maxGrowth = 4;
+
+  unsigned failures = 0;
+  double worstNsPerByte = 0;
+  zc::String worstName = zc::str("none");
+
+  template <typename Generate>
+  void measure(const Stage& stage, zc::StringPtr name, Generate&& generate) {
+    auto& clock = zc::systemPreciseMonotonicClock();
+    double first = 0;
+    double last = 0;
+
+    for (unsigned step = 0; step <= steps; step++) {
+      size_t size = minSize << step;
+      zc::String text = generate(size);
+
+      zc::Duration best = 0 * zc::NANOSECONDS;
+      for (unsigned i = 0; i < repeats; i++) {
+        zc::TimePoint start = clock.now();
+        (harness.*stage.run)(text);
+        zc::Duration elapsed = clock.now() - start;
+        if (i == 0 || elapsed < best) { best = elapsed; }
+      }
+
+      // Clamp to one nanosecond per input so that a timer tick of zero cannot divide by zero.
+      double nsPerByte = zc::max(best / zc::NANOSECONDS, int64_t(1)) / double(size);
+      if (step == 0) { first = nsPerByte; }
+      last = nsPerByte;
+      if (nsPerByte > worstNsPerByte) {
+        worstNsPerByte = nsPerByte;
+        worstName = zc::str(stage.name, ":", name);
+      }
+    }
+
+    double growth = last / first;
+    bool superlinear = growth > maxGrowth || !isfinite(growth);
+    if (superlinear) { ++failures; }
+    context.warning(zc::str(stage.name, ":", name, ": ", first, " -> ", last,
+                            " ns/byte, growth ", growth, superlinear ? "  SUPERLINEAR" : ""));
+  }
+};
+
+}  // namespace fuzz
+}  // namespace compiler
+}  // namespace zomlang
+
+ZC_MAIN(zomlang::compiler::fuzz::PerfMain)
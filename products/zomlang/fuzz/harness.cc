@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "zomlang/fuzz/harness.h"
+
+#include <algorithm>
+
+#include "zc/core/debug.h"
+#include "zomlang/compiler/diagnostics/diagnostic-engine.h"
+#include "zomlang/compiler/lexer/lexer.h"
+#include "zomlang/compiler/source/manager.h"
+
+namespace zomlang {
+namespace compiler {
+namespace fuzz {
+
+FrontendHarness::FrontendHarness()
+    : disk(zc::newDiskFilesystem()), sourceDir(zc::newInMemoryDirectory(zc::nullClock())) {
+  zc::Path path("fuzz.zom");
+  auto file = sourceDir->openFile(path, zc::WriteMode::CREATE);
+  sourceMgr = zc::heap<source::SourceManager>(*disk, zc::mv(file), *sourceDir, zc::mv(path));
+}
+
+FrontendHarness::~FrontendHarness() noexcept(false) = default;
+
+size_t FrontendHarness::lex(zc::ArrayPtr<const char> text) {
+  DiagnosticEngine diags(*sourceMgr);
+  // Opaque value 0 is the invalid location, so the buffer starts at 1.
+  SourceLoc bufferLoc = SourceLoc::getFromOpaqueValue(1);
+  Lexer lexer(langOpts, *sourceMgr, diags, text, bufferLoc);
+
+  size_t count = 0;
+  const char* prevEnd = text.begin();
+  Token token;
+  do {
+    lexer.lex(token);
+    ++count;
+
+    const char* start = token.getStart();
+    ZC_ASSERT(start >= prevEnd && token.getLength() <= size_t(text.end() - start),
+              "token overlaps its predecessor or runs past the buffer", count);
+    ZC_ASSERT(token.getLength() > 0 || token.getKind() == tok::kEOF, "empty token", count);
+    ZC_ASSERT(token.getLocation() == bufferLoc.getAdvancedLoc(start - text.begin()),
+              "token location does not match its offset", count);
+    ZC_ASSERT(count <= text.size() + 1, "lexer stopped making progress");
+    prevEnd = start + token.getLength();
+  } while (token.getKind() != tok::kEOF);
+
+  ZC_ASSERT(prevEnd == text.end(), "EOF token is not at the end of the buffer");
+  return count;
+}
+
+namespace {
+
+void readCorpusDir(const zc::ReadableDirectory& dir, zc::StringPtr prefix,
+                   zc::Vector<CorpusInput>& inputs) {
+  auto entries = dir.listEntries();
+  std::sort(entries.begin(), entries.end());
+  for (auto& entry : entries) {
+    zc::Path path(entry.name);
+    zc::String name = zc::str(prefix, "/", entry.name);
+    switch (entry.type) {
+      case zc::FsNode::Type::FILE:
+        inputs.add(CorpusInput{zc::mv(name), dir.openFile(path)->readAllBytes()});
+        break;
+      case zc::FsNode::Type::DIRECTORY:
+        readCorpusDir(*dir.openSubdir(path), name, inputs);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+zc::Vector<CorpusInput> readCorpus(const zc::Filesystem& fs, zc::StringPtr path) {
+  zc::Vector<CorpusInput> inputs;
+  zc::Path absolute = fs.getCurrentPath().evalNative(path);
+  auto& root = fs.getRoot();
+
+  if (root.lstat(absolute).type == zc::FsNode::Type::DIRECTORY) {
+    readCorpusDir(*root.openSubdir(absolute), path, inputs);
+  } else {
+    inputs.add(CorpusInput{zc::heapString(path), root.openFile(absolute)->readAllBytes()});
+  }
+  return inputs;
+}
+
+}  // namespace fuzz
+}  // namespace compiler
+}  // namespace zomlang
@@ -0,0 +1,62 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include "zc/core/filesystem.h"
+#include "zc/core/memory.h"
+#include "zc/core/string.h"
+#include "zc/core/vector.h"
+#include "zomlang/compiler/basic/zomlang-opts.h"
+
+namespace zomlang {
+namespace compiler {
+
+namespace source {
+class SourceManager;
+}
+
+namespace fuzz {
+
+/// Runs frontend stages over in-memory buffers, for fuzzing and performance measurement. Every
+/// run checks the structural invariants of its output and throws when one is violated, so that a
+/// fuzzer reports the input as a crash.
+class FrontendHarness {
+public:
+  FrontendHarness();
+  ~FrontendHarness() noexcept(false);
+
+  ZC_DISALLOW_COPY_AND_MOVE(FrontendHarness);
+
+  /// Lexes `text` to the end and returns the number of tokens produced, EOF included.
+  size_t lex(zc::ArrayPtr<const char> text);
+
+private:
+  LangOptions langOpts;
+  zc::Own<zc::Filesystem> disk;
+  zc::Own<const zc::Directory> sourceDir;
+  zc::Own<source::SourceManager> sourceMgr;
+};
+
+struct CorpusInput {
+  zc::String name;
+  zc::Array<zc::byte> content;
+};
+
+/// Reads `path` if it is a file, or every file below it if it is a directory, in name order.
+zc::Vector<CorpusInput> readCorpus(const zc::Filesystem& fs, zc::StringPtr path);
+
+}  // namespace fuzz
+}  // namespace compiler
+}  // namespace zomlang
@@ -0,0 +1,28 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+// libFuzzer entry point for the lexer. Build with ZOM_ENABLE_FUZZING to link against libFuzzer;
+// otherwise the target is linked with replay-main.cc and just runs the inputs it is given.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "zomlang/fuzz/harness.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  static zomlang::compiler::fuzz::FrontendHarness harness;
+  harness.lex(zc::arrayPtr(reinterpret_cast<const char*>(data), size));
+  return 0;
+}
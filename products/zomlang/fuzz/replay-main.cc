@@ -0,0 +1,68 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+// Stand-in for the libFuzzer driver in builds without -fsanitize=fuzzer: runs the fuzz target
+// once on every input named on the command line, so the corpus doubles as a regression test.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "zc/core/main.h"
+#include "zomlang/fuzz/harness.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace zomlang {
+namespace compiler {
+namespace fuzz {
+
+class ReplayMain {
+public:
+  explicit ReplayMain(zc::ProcessContext& context)
+      : context(context), fs(zc::newDiskFilesystem()) {}
+
+  zc::MainFunc getMain() {
+    return zc::MainBuilder(context, "ZomLang fuzz replay",
+                           "Runs the fuzz target on each <input>. Directories are searched "
+                           "recursively.")
+        .expectOneOrMoreArgs("<input>", ZC_BIND_METHOD(*this, replay))
+        .callAfterParsing(ZC_BIND_METHOD(*this, report))
+        .build();
+  }
+
+  zc::MainBuilder::Validity replay(zc::StringPtr arg) {
+    for (auto& input : readCorpus(*fs, arg)) {
+      LLVMFuzzerTestOneInput(input.content.begin(), input.content.size());
+      ++count;
+    }
+    return true;
+  }
+
+  zc::MainBuilder::Validity report() {
+    context.warning(zc::str("ran ", count, " inputs"));
+    return true;
+  }
+
+private:
+  zc::ProcessContext& context;
+  zc::Own<zc::Filesystem> fs;
+  size_t count = 0;
+};
+
+}  // namespace fuzz
+}  // namespace compiler
+}  // namespace zomlang
+
+ZC_MAIN(zomlang::compiler::fuzz::ReplayMain)
@@ -0,0 +1,502 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "zomlang/runtime/gc/heap.h"
+
+#include <string.h>
+
+#include "zc/core/debug.h"
+#include "zc/core/mutex.h"
+
+namespace zomlang {
+namespace runtime {
+namespace gc {
+
+namespace {
+
+/// A contiguous region of memory allocated by bumping `top`.
+struct Space {
+  zc::byte* start = nullptr;
+  zc::byte* top = nullptr;
+  zc::byte* end = nullptr;
+
+  Space() = default;
+  Space(zc::byte* start, size_t size) : start(start), top(start), end(start + size) {}
+
+  ZC_NODISCARD bool contains(const void* ptr) const { return start <= ptr && ptr < end; }
+  ZC_NODISCARD size_t used() const { return top - start; }
+  ZC_NODISCARD size_t available() const { return end - top; }
+
+  zc::byte* bump(size_t size) {
+    if (size > available()) { return nullptr; }
+    zc::byte* result = top;
+    top += size;
+    return result;
+  }
+
+  void reset() { top = start; }
+};
+
+size_t roundUpTo8(size_t size) { return (size + 7) & ~size_t(7); }
+
+zc::TimePoint now() { return zc::systemPreciseMonotonicClock().now(); }
+
+void recordPause(zc::Duration pause, zc::Duration& total, zc::Duration& max) {
+  total += pause;
+  if (pause > max) { max = pause; }
+}
+
+}  // namespace
+
+// ================================================================================
+// HeapStats
+
+double HeapStats::allocationRate() const {
+  double seconds = double(elapsed / zc::NANOSECONDS) / 1e9;
+  return seconds > 0 ? double(bytesAllocated) / seconds : 0;
+}
+
+zc::String HeapStats::toString() const {
+  return zc::str("minor: ", minorCollections, " collections, ", totalMinorPause, " total pause, ",
+                 maxMinorPause, " max pause; major: ", majorCollections, " collections, ",
+                 totalMajorPause, " total pause, ", maxMajorPause, " max pause; allocated ",
+                 bytesAllocated, " bytes (", uint64_t(allocationRate()), " bytes/s), survived ",
+                 bytesSurvived, ", promoted ", bytesPromoted, ", compacted ", bytesCompacted,
+                 "; in use: young ", youngBytesInUse, ", old ", oldBytesInUse);
+}
+
+// ================================================================================
+// Heap::Impl
+
+class Heap::Impl {
+public:
+  Impl(Heap& heap, const HeapOptions& options) noexcept;
+  ~Impl() noexcept(false) = default;
+
+  struct State {
+    Space eden;
+    Space from;
+    Space to;
+    Space old;
+
+    zc::Vector<Mutator*> mutators;
+    /// Number of registered mutators currently blocked in `park()`.
+    unsigned parked = 0;
+    /// True from the moment a collection is requested until it has finished.
+    bool collecting = false;
+
+    zc::Vector<ObjectHeader**> roots;
+    /// Old objects that may hold references into the young generation.
+    zc::Vector<ObjectHeader*> remembered;
+
+    HeapStats stats;
+  };
+
+  /// Runs a collection on behalf of the calling mutator. The caller holds the lock and no other
+  /// collection may be in progress.
+  void collect(zc::Locked<State>& lock, bool full);
+  /// Blocks the calling mutator until the in-progress collection finishes.
+  void park(zc::Locked<State>& lock);
+
+  void retireTlab(State& state, Mutator& mutator);
+
+  zc::Array<zc::byte> youngMemory;
+  zc::Array<zc::byte> oldMemory;
+  zc::MutexGuarded<State> state;
+  const zc::TimePoint createdAt;
+
+private:
+  Heap& heap;
+  const uint8_t tenureAge;
+
+  template <typename Func>
+  void forEachRoot(State& state, Func&& func);
+
+  void minorCollection(State& state);
+  void majorCollection(State& state);
+
+  void rememberIfPointsYoung(State& state, ObjectHeader* object);
+};
+
+Heap::Impl::Impl(Heap& heap, const HeapOptions& options) noexcept
+    : youngMemory(zc::heapArray<zc::byte>(roundUpTo8(options.edenBytes) +
+                                          2 * roundUpTo8(options.survivorBytes))),
+      oldMemory(zc::heapArray<zc::byte>(roundUpTo8(options.oldBytes))),
+      createdAt(now()),
+      heap(heap),
+      tenureAge(options.tenureAge) {
+  auto lock = state.lockExclusive();
+  size_t edenBytes = roundUpTo8(options.edenBytes);
+  size_t survivorBytes = roundUpTo8(options.survivorBytes);
+  lock->eden = Space(youngMemory.begin(), edenBytes);
+  lock->from = Space(youngMemory.begin() + edenBytes, survivorBytes);
+  lock->to = Space(youngMemory.begin() + edenBytes + survivorBytes, survivorBytes);
+  lock->old = Space(oldMemory.begin(), oldMemory.size());
+}
+
+void Heap::Impl::park(zc::Locked<State>& lock) {
+  ++lock->parked;
+  lock.wait([](const State& state) { return !state.collecting; });
+  --lock->parked;
+}
+
+void Heap::Impl::retireTlab(State& state, Mutator& mutator) {
+  state.stats.bytesAllocated += mutator.tlabTop - mutator.tlabStart;
+  mutator.tlabStart = nullptr;
+  mutator.tlabTop = nullptr;
+  mutator.tlabEnd = nullptr;
+}
+
+void Heap::Impl::collect(zc::Locked<State>& lock, bool full) {
+  ZC_IREQUIRE(!lock->collecting);
+
+  lock->collecting = true;
+  __atomic_store_n(&heap.collectionRequested, true, __ATOMIC_RELEASE);
+
+  // Wait for every other mutator to reach a safepoint. The requester itself is registered too.
+  lock.wait([](const State& state) { return state.parked + 1 == state.mutators.size(); });
+
+  State& s = *lock;
+  for (Mutator* mutator : s.mutators) {
+    retireTlab(s, *mutator);
+    s.remembered.addAll(mutator->remembered);
+    mutator->remembered.clear();
+  }
+
+  // A minor collection may promote everything that is currently young. If the old generation
+  // cannot take that, compact it first; young objects stay where they are during compaction.
+  if (full || s.old.available() < s.eden.used() + s.from.used()) { majorCollection(s); }
+  minorCollection(s);
+
+  s.collecting = false;
+  __atomic_store_n(&heap.collectionRequested, false, __ATOMIC_RELEASE);
+}
+
+template <typename Func>
+void Heap::Impl::forEachRoot(State& state, Func&& func) {
+  for (Mutator* mutator : state.mutators) {
+    for (Frame* frame = mutator->topFrame; frame != nullptr; frame = frame->parent) {
+      for (uint32_t index : frame->map->refSlots) { func(frame->slots[index]); }
+    }
+  }
+  for (ObjectHeader** root : state.roots) { func(*root); }
+}
+
+void Heap::Impl::rememberIfPointsYoung(State& state, ObjectHeader* object) {
+  bool pointsYoung = false;
+  object->forEachRef(
+      [&](ObjectHeader*& slot) { pointsYoung = pointsYoung || heap.isYoung(slot); });
+  if (pointsYoung && !(object->flags & ObjectHeader::kRemembered)) {
+    object->flags |= ObjectHeader::kRemembered;
+    state.remembered.add(object);
+  }
+}
+
+void Heap::Impl::minorCollection(State& s) {
+  zc::TimePoint start = now();
+
+  s.to.reset();
+  zc::byte* toScan = s.to.start;
+  zc::byte* oldScan = s.old.top;
+  uint64_t survived = 0;
+  uint64_t promoted = 0;
+
+  auto evacuate = [&](ObjectHeader*& slot) {
+    ObjectHeader* object = slot;
+    if (object == nullptr || !(s.eden.contains(object) || s.from.contains(object))) { return; }
+    if (object->forward != nullptr) {
+      slot = object->forward;
+      return;
+    }
+
+    size_t size = object->size;
+    uint8_t age = object->age < 0xff ? object->age + 1 : 0xff;
+    zc::byte* memory = age < tenureAge ? s.to.bump(size) : nullptr;
+    // Promote tenured objects and anything that overflows the survivor space. `collect()` runs a
+    // major collection first whenever the old generation could not take a worst-case promotion,
+    // so the survivor space is only a last resort here.
+    if (memory == nullptr) { memory = s.old.bump(size); }
+    if (memory == nullptr) { memory = s.to.bump(size); }
+    ZC_ASSERT(memory != nullptr, "zomlang heap exhausted", size);
+    if (s.old.contains(memory)) {
+      promoted += size;
+    } else {
+      survived += size;
+    }
+
+    memcpy(memory, object, size);
+    ObjectHeader* copy = reinterpret_cast<ObjectHeader*>(memory);
+    copy->age = age;
+    copy->flags = 0;
+    copy->forward = nullptr;
+    object->forward = copy;
+    slot = copy;
+  };
+
+  forEachRoot(s, evacuate);
+
+  // Old objects that were written to since the last collection are roots too. Each one is
+  // re-remembered only if it still points into the young generation afterwards.
+  zc::Vector<ObjectHeader*> remembered = zc::mv(s.remembered);
+  for (ObjectHeader* object : remembered) {
+    object->flags &= ~ObjectHeader::kRemembered;
+    object->forEachRef(evacuate);
+    rememberIfPointsYoung(s, object);
+  }
+
+  // Cheney scan over both destinations until no new copies appear.
+  while (toScan < s.to.top || oldScan < s.old.top) {
+    while (toScan < s.to.top) {
+      ObjectHeader* object = reinterpret_cast<ObjectHeader*>(toScan);
+      toScan += object->size;
+      object->forEachRef(evacuate);
+    }
+    while (oldScan < s.old.top) {
+      ObjectHeader* object = reinterpret_cast<ObjectHeader*>(oldScan);
+      oldScan += object->size;
+      object->forEachRef(evacuate);
+      rememberIfPointsYoung(s, object);
+    }
+  }
+
+  s.eden.reset();
+  s.from.reset();
+  Space emptied = s.from;
+  s.from = s.to;
+  s.to = emptied;
+
+  s.stats.bytesSurvived += survived;
+  s.stats.bytesPromoted += promoted;
+  s.stats.minorCollections++;
+  recordPause(now() - start, s.stats.totalMinorPause, s.stats.maxMinorPause);
+}
+
+void Heap::Impl::majorCollection(State& s) {
+  zc::TimePoint start = now();
+
+  // Mark. Young objects are traced so that old objects reachable only through them survive, and
+  // remembered so their references can be updated below.
+  zc::Vector<ObjectHeader*> markStack;
+  zc::Vector<ObjectHeader*> youngMarked;
+  auto mark = [&](ObjectHeader*& slot) {
+    ObjectHeader* object = slot;
+    if (object == nullptr || (object->flags & ObjectHeader::kMarked)) { return; }
+    object->flags |= ObjectHeader::kMarked;
+    markStack.add(object);
+    if (heap.isYoung(object)) { youngMarked.add(object); }
+  };
+
+  forEachRoot(s, mark);
+  while (!markStack.empty()) {
+    ObjectHeader* object = markStack.back();
+    markStack.removeLast();
+    object->forEachRef(mark);
+  }
+
+  // Compute forwarding addresses for live old objects.
+  zc::byte* compactTop = s.old.start;
+  for (zc::byte* ptr = s.old.start; ptr < s.old.top;) {
+    ObjectHeader* object = reinterpret_cast<ObjectHeader*>(ptr);
+    ptr += object->size;
+    if (object->flags & ObjectHeader::kMarked) {
+      object->forward = reinterpret_cast<ObjectHeader*>(compactTop);
+      compactTop += object->size;
+    }
+  }
+
+  // Update references. The remembered set is rebuilt from scratch while walking live old objects.
+  auto relocate = [&](ObjectHeader*& slot) {
+    if (slot != nullptr && heap.isOld(slot)) { slot = slot->forward; }
+  };
+
+  forEachRoot(s, relocate);
+
+  s.remembered.clear();
+  for (zc::byte* ptr = s.old.start; ptr < s.old.top;) {
+    ObjectHeader* object = reinterpret_cast<ObjectHeader*>(ptr);
+    ptr += object->size;
+    if (!(object->flags & ObjectHeader::kMarked)) { continue; }
+
+    bool pointsYoung = false;
+    object->forEachRef([&](ObjectHeader*& slot) {
+      relocate(slot);
+      pointsYoung = pointsYoung || heap.isYoung(slot);
+    });
+    if (pointsYoung) {
+      object->flags |= ObjectHeader::kRemembered;
+      s.remembered.add(object->forward);
+    } else {
+      object->flags &= ~ObjectHeader::kRemembered;
+    }
+  }
+
+  for (ObjectHeader* object : youngMarked) {
+    object->forEachRef(relocate);
+    object->flags &= ~ObjectHeader::kMarked;
+  }
+
+  // Slide live objects down. Destinations never overlap an object that has not been moved yet.
+  for (zc::byte* ptr = s.old.start; ptr < s.old.top;) {
+    ObjectHeader* object = reinterpret_cast<ObjectHeader*>(ptr);
+    size_t size = object->size;
+    ptr += size;
+    if (object->flags & ObjectHeader::kMarked) {
+      ObjectHeader* dest = object->forward;
+      memmove(dest, object, size);
+      dest->flags &= ~ObjectHeader::kMarked;
+      dest->forward = nullptr;
+    }
+  }
+
+  s.stats.bytesCompacted += s.old.top - compactTop;
+  s.old.top = compactTop;
+  s.stats.majorCollections++;
+  recordPause(now() - start, s.stats.totalMajorPause, s.stats.maxMajorPause);
+}
+
+// ================================================================================
+// Heap
+
+Heap::Heap(HeapOptions options) noexcept
+    : options(options),
+      impl(zc::heap<Impl>(*this, options)),
+      youngStart(impl->youngMemory.begin()),
+      youngEnd(impl->youngMemory.end()),
+      oldStart(impl->oldMemory.begin()),
+      oldEnd(impl->oldMemory.end()) {
+  ZC_REQUIRE(options.tlabBytes > 0 && options.edenBytes >= options.tlabBytes,
+             "eden must hold at least one allocation buffer");
+  ZC_REQUIRE(options.tenureAge > 0);
+}
+
+Heap::~Heap() noexcept(false) {
+  ZC_ASSERT(impl->state.lockShared()->mutators.empty(), "heap destroyed with live mutators");
+}
+
+void Heap::addRoot(ObjectHeader*& slot) { impl->state.lockExclusive()->roots.add(&slot); }
+
+void Heap::removeRoot(ObjectHeader*& slot) {
+  auto lock = impl->state.lockExclusive();
+  for (size_t i = 0; i < lock->roots.size(); i++) {
+    if (lock->roots[i] == &slot) {
+      lock->roots[i] = lock->roots.back();
+      lock->roots.removeLast();
+      return;
+    }
+  }
+  ZC_FAIL_REQUIRE("not a registered root");
+}
+
+HeapStats Heap::getStats() const {
+  auto lock = impl->state.lockShared();
+  HeapStats stats = lock->stats;
+  stats.youngBytesInUse = lock->eden.used() + lock->from.used();
+  stats.oldBytesInUse = lock->old.used();
+  stats.elapsed = now() - impl->createdAt;
+  return stats;
+}
+
+// ================================================================================
+// Mutator
+
+Mutator::Mutator(Heap& heap) : heap(heap) {
+  auto lock = heap.impl->state.lockExclusive();
+  // Joining in the middle of a collection would leave the collector waiting for us forever.
+  lock.wait([](const Heap::Impl::State& state) { return !state.collecting; });
+  lock->mutators.add(this);
+}
+
+Mutator::~Mutator() noexcept(false) {
+  Heap::Impl& impl = *heap.impl;
+  auto lock = impl.state.lockExclusive();
+  if (lock->collecting) { impl.park(lock); }
+
+  impl.retireTlab(*lock, *this);
+  lock->remembered.addAll(remembered);
+
+  auto& mutators = lock->mutators;
+  for (size_t i = 0; i < mutators.size(); i++) {
+    if (mutators[i] == this) {
+      mutators[i] = mutators.back();
+      mutators.removeLast();
+      break;
+    }
+  }
+}
+
+ObjectHeader* Mutator::allocateSlow(const TypeInfo& type, size_t size) {
+  ZC_REQUIRE(size <= 0xffffffffu, "object too large", size);
+
+  Heap::Impl& impl = *heap.impl;
+  auto lock = impl.state.lockExclusive();
+
+  if (size > heap.options.tlabBytes / 2) {
+    // Large objects go straight to the old generation so they are never copied.
+    for (unsigned attempt = 0;; attempt++) {
+      if (lock->collecting) { impl.park(lock); }
+      zc::byte* memory = lock->old.bump(size);
+      if (memory != nullptr) {
+        lock->stats.bytesAllocated += size;
+        lock.release();
+        memset(memory + sizeof(ObjectHeader), 0, size - sizeof(ObjectHeader));
+        return initObject(memory, type, size);
+      }
+      ZC_REQUIRE(attempt == 0, "zomlang heap exhausted", size);
+      impl.collect(lock, true);
+    }
+  }
+
+  for (;;) {
+    if (lock->collecting) { impl.park(lock); }
+    impl.retireTlab(*lock, *this);
+
+    size_t chunk = zc::min(heap.options.tlabBytes, lock->eden.available());
+    if (chunk >= size) {
+      zc::byte* memory = lock->eden.bump(chunk);
+      lock.release();
+
+      // No collection can start until this thread reaches a safepoint, so the buffer can be
+      // cleared without holding the lock.
+      memset(memory, 0, chunk);
+      tlabStart = memory;
+      tlabTop = memory + size;
+      tlabEnd = memory + chunk;
+      return initObject(memory, type, size);
+    }
+
+    impl.collect(lock, false);
+  }
+}
+
+void Mutator::parkSlow() {
+  Heap::Impl& impl = *heap.impl;
+  auto lock = impl.state.lockExclusive();
+  if (lock->collecting) { impl.park(lock); }
+}
+
+void Mutator::collect(bool full) {
+  Heap::Impl& impl = *heap.impl;
+  auto lock = impl.state.lockExclusive();
+  if (lock->collecting) { impl.park(lock); }
+  impl.collect(lock, full);
+}
+
+void Mutator::rememberSlow(ObjectHeader* holder) {
+  holder->flags |= ObjectHeader::kRemembered;
+  remembered.add(holder);
+}
+
+}  // namespace gc
+}  // namespace runtime
+}  // namespace zomlang
@@ -0,0 +1,251 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include "zc/core/memory.h"
+#include "zc/core/string.h"
+#include "zc/core/time.h"
+#include "zc/core/vector.h"
+#include "zomlang/runtime/gc/object.h"
+
+namespace zomlang {
+namespace runtime {
+namespace gc {
+
+class Mutator;
+
+struct HeapOptions {
+  /// Size of the eden space, where all small objects are born.
+  size_t edenBytes = 8u << 20;
+  /// Size of each of the two survivor semispaces.
+  size_t survivorBytes = 1u << 20;
+  /// Size of the old generation.
+  size_t oldBytes = 64u << 20;
+  /// Size of the thread-local allocation buffers carved out of eden. Objects larger than half a
+  /// buffer are allocated directly in the old generation.
+  size_t tlabBytes = 32u << 10;
+  /// Number of minor collections an object survives before it is promoted.
+  uint8_t tenureAge = 2;
+};
+
+struct HeapStats {
+  uint64_t minorCollections = 0;
+  uint64_t majorCollections = 0;
+  zc::Duration totalMinorPause = 0 * zc::NANOSECONDS;
+  zc::Duration maxMinorPause = 0 * zc::NANOSECONDS;
+  zc::Duration totalMajorPause = 0 * zc::NANOSECONDS;
+  zc::Duration maxMajorPause = 0 * zc::NANOSECONDS;
+
+  /// Bytes handed out to mutators, including objects that died young.
+  uint64_t bytesAllocated = 0;
+  /// Bytes copied into a survivor space by minor collections.
+  uint64_t bytesSurvived = 0;
+  /// Bytes copied into the old generation by minor collections.
+  uint64_t bytesPromoted = 0;
+  /// Bytes reclaimed from the old generation by major collections.
+  uint64_t bytesCompacted = 0;
+
+  size_t youngBytesInUse = 0;
+  size_t oldBytesInUse = 0;
+
+  /// Time since the heap was created.
+  zc::Duration elapsed = 0 * zc::NANOSECONDS;
+
+  /// Average allocation rate over the lifetime of the heap, in bytes per second.
+  ZC_NODISCARD double allocationRate() const;
+
+  ZC_NODISCARD zc::String toString() const;
+};
+
+/// Generational heap for managed runtime objects.
+///
+/// Small objects are bump-allocated in per-thread allocation buffers carved out of eden. A minor
+/// collection copies live young objects into a survivor semispace (Cheney-style) and promotes
+/// those that reached `tenureAge` into the old generation. When the old generation cannot absorb
+/// a worst-case promotion, a major collection marks the whole heap and slides live old objects
+/// down (Lisp-2 mark-compact); young objects are traced but not moved by a major collection.
+///
+/// Collections are stop-the-world. Every thread that touches managed objects must own a
+/// `Mutator`, keep its references in shadow-stack frames, and reach a safepoint (allocation or
+/// `Mutator::safepoint()`) regularly so that a collection requested by another thread can proceed.
+class Heap {
+public:
+  explicit Heap(HeapOptions options = HeapOptions()) noexcept;
+  ~Heap() noexcept(false);
+
+  ZC_DISALLOW_COPY_AND_MOVE(Heap);
+
+  /// Registers a global root. `slot` must stay valid until it is removed.
+  void addRoot(ObjectHeader*& slot);
+  void removeRoot(ObjectHeader*& slot);
+
+  ZC_NODISCARD HeapStats getStats() const;
+  ZC_NODISCARD const HeapOptions& getOptions() const { return options; }
+
+  ZC_NODISCARD bool isYoung(const void* ptr) const { return youngStart <= ptr && ptr < youngEnd; }
+  ZC_NODISCARD bool isOld(const void* ptr) const { return oldStart <= ptr && ptr < oldEnd; }
+
+private:
+  class Impl;
+
+  const HeapOptions options;
+  zc::Own<Impl> impl;
+
+  // Address ranges of the two generations, fixed for the lifetime of the heap so that the write
+  // barrier can classify pointers without locking.
+  const zc::byte* youngStart;
+  const zc::byte* youngEnd;
+  const zc::byte* oldStart;
+  const zc::byte* oldEnd;
+
+  /// Set while a collection is pending or running; polled by `Mutator::safepoint()`.
+  bool collectionRequested = false;
+
+  friend class Mutator;
+};
+
+/// Per-thread handle onto a `Heap`. Owns the thread's allocation buffer, shadow stack and
+/// remembered-set buffer. Must be created and destroyed on the thread that uses it.
+class Mutator {
+public:
+  explicit Mutator(Heap& heap);
+  ~Mutator() noexcept(false);
+
+  ZC_DISALLOW_COPY_AND_MOVE(Mutator);
+
+  /// Allocates an object with `payloadBytes` of zeroed payload. This is a safepoint: any
+  /// reference not stored in a pushed frame or global root may be invalidated.
+  ObjectHeader* allocate(const TypeInfo& type, size_t payloadBytes);
+
+  /// Stores `value` into a reference slot of `holder`, recording old-to-young edges.
+  void store(ObjectHeader* holder, ObjectHeader*& slot, ObjectHeader* value);
+
+  /// Parks this thread if another thread has requested a collection. Compiled code calls this on
+  /// loop back-edges.
+  void safepoint();
+
+  /// Runs a collection on behalf of this thread. `full` forces a major collection.
+  void collect(bool full = false);
+
+  void pushFrame(Frame& frame);
+  void popFrame(Frame& frame);
+
+  ZC_NODISCARD Heap& getHeap() const { return heap; }
+
+private:
+  Heap& heap;
+
+  // Thread-local allocation buffer. `tlabStart` marks where the current buffer began, for
+  // allocation accounting when it is retired.
+  zc::byte* tlabStart = nullptr;
+  zc::byte* tlabTop = nullptr;
+  zc::byte* tlabEnd = nullptr;
+
+  Frame* topFrame = nullptr;
+
+  /// Old objects that this thread made point into the young generation since the last
+  /// collection. Merged into the heap's remembered set when the heap collects.
+  zc::Vector<ObjectHeader*> remembered;
+
+  ObjectHeader* allocateSlow(const TypeInfo& type, size_t size);
+  void parkSlow();
+  void rememberSlow(ObjectHeader* holder);
+
+  static ObjectHeader* initObject(zc::byte* memory, const TypeInfo& type, size_t size);
+
+  friend class Heap;
+};
+
+/// Frame for runtime code written in C++: `N` reference slots, all of them roots.
+template <size_t N>
+class RootScope {
+public:
+  explicit RootScope(Mutator& mutator) : mutator(mutator) {
+    for (uint32_t i = 0; i < N; i++) {
+      slots[i] = nullptr;
+      indices[i] = i;
+    }
+    map.numSlots = N;
+    map.refSlots = zc::arrayPtr(indices, N);
+    frame.map = &map;
+    frame.slots = slots;
+    mutator.pushFrame(frame);
+  }
+  ~RootScope() noexcept(false) { mutator.popFrame(frame); }
+
+  ZC_DISALLOW_COPY_AND_MOVE(RootScope);
+
+  ObjectHeader*& operator[](size_t index) {
+    ZC_IREQUIRE(index < N);
+    return slots[index];
+  }
+
+private:
+  Mutator& mutator;
+  ObjectHeader* slots[N];
+  uint32_t indices[N];
+  StackMap map;
+  Frame frame;
+};
+
+// =======================================================================================
+// Inline implementation details
+
+inline ObjectHeader* Mutator::allocate(const TypeInfo& type, size_t payloadBytes) {
+  size_t size = (sizeof(ObjectHeader) + payloadBytes + 7) & ~size_t(7);
+  if (ZC_LIKELY(size <= size_t(tlabEnd - tlabTop))) {
+    zc::byte* memory = tlabTop;
+    tlabTop += size;
+    return initObject(memory, type, size);
+  }
+  return allocateSlow(type, size);
+}
+
+inline ObjectHeader* Mutator::initObject(zc::byte* memory, const TypeInfo& type, size_t size) {
+  ObjectHeader* object = reinterpret_cast<ObjectHeader*>(memory);
+  object->type = &type;
+  object->forward = nullptr;
+  object->size = size;
+  object->age = 0;
+  object->flags = 0;
+  object->reserved = 0;
+  return object;
+}
+
+inline void Mutator::store(ObjectHeader* holder, ObjectHeader*& slot, ObjectHeader* value) {
+  slot = value;
+  if (value != nullptr && !(holder->flags & ObjectHeader::kRemembered) && heap.isOld(holder) &&
+      heap.isYoung(value)) {
+    rememberSlow(holder);
+  }
+}
+
+inline void Mutator::safepoint() {
+  if (ZC_UNLIKELY(__atomic_load_n(&heap.collectionRequested, __ATOMIC_ACQUIRE))) { parkSlow(); }
+}
+
+inline void Mutator::pushFrame(Frame& frame) {
+  frame.parent = topFrame;
+  topFrame = &frame;
+}
+
+inline void Mutator::popFrame(Frame& frame) {
+  ZC_IREQUIRE(topFrame == &frame, "GC frames must be popped in LIFO order");
+  topFrame = frame.parent;
+}
+
+}  // namespace gc
+}  // namespace runtime
+}  // namespace zomlang
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#pragma once
+
+#include "zc/core/common.h"
+
+namespace zomlang {
+namespace runtime {
+namespace gc {
+
+/// How the collector finds the references inside an object's payload.
+enum class Layout : uint8_t {
+  /// References live at the byte offsets listed in `TypeInfo::refOffsets`.
+  kFixed,
+  /// Every pointer-sized word of the payload is a reference (closure environments, arrays).
+  kRefArray,
+  /// The payload contains no references (`str` contents, numeric buffers).
+  kBytes,
+};
+
+/// Static description of a managed type. The compiler emits one per type so that the collector
+/// can trace objects precisely; the runtime defines a handful for its own builtins.
+struct TypeInfo {
+  const char* name;
+  Layout layout;
+  /// Byte offsets of reference slots, relative to the start of the payload. Only used by kFixed.
+  zc::ArrayPtr<const uint32_t> refOffsets;
+};
+
+/// Header prepended to every managed object. A reference to a managed object is a pointer to its
+/// header; the payload follows immediately.
+struct ObjectHeader {
+  enum Flags : uint8_t {
+    /// Set on live objects during a major collection.
+    kMarked = 1 << 0,
+    /// The object lives in the old generation and is in the remembered set.
+    kRemembered = 1 << 1,
+  };
+
+  const TypeInfo* type;
+  /// New location of the object while a collection is moving it, null otherwise.
+  ObjectHeader* forward;
+  /// Total size of the object including this header, in bytes. Always a multiple of 8.
+  uint32_t size;
+  /// Number of minor collections the object has survived.
+  uint8_t age;
+  uint8_t flags;
+  uint16_t reserved;
+
+  zc::byte* payload() { return reinterpret_cast<zc::byte*>(this + 1); }
+  const zc::byte* payload() const { return reinterpret_cast<const zc::byte*>(this + 1); }
+  ZC_NODISCARD size_t payloadSize() const { return size - sizeof(ObjectHeader); }
+
+  template <typename T>
+  T& as() {
+    return *reinterpret_cast<T*>(payload());
+  }
+
+  ObjectHeader*& refAt(size_t index) {
+    return reinterpret_cast<ObjectHeader**>(payload())[index];
+  }
+
+  /// Calls `func(ObjectHeader*& slot)` for every reference slot in the payload.
+  template <typename Func>
+  void forEachRef(Func&& func);
+};
+
+static_assert(sizeof(ObjectHeader) % 8 == 0, "object payloads must stay 8-byte aligned");
+
+/// Describes one function's GC frame: which of its slots hold managed references at the points
+/// where the function may enter the collector (calls and allocation sites). Code generation emits
+/// one stack map per function as static data alongside the function body.
+struct StackMap {
+  uint32_t numSlots;
+  /// Indices into `Frame::slots` that hold references.
+  zc::ArrayPtr<const uint32_t> refSlots;
+};
+
+/// One activation record on a mutator's shadow stack. Compiled code pushes a frame on entry and
+/// pops it on exit, spilling live references into `slots` before every safepoint. The collector
+/// walks the chain to find roots and rewrites the slots when it moves objects.
+struct Frame {
+  Frame* parent;
+  const StackMap* map;
+  ObjectHeader** slots;
+};
+
+// =======================================================================================
+// Inline implementation details
+
+template <typename Func>
+inline void ObjectHeader::forEachRef(Func&& func) {
+  switch (type->layout) {
+    case Layout::kFixed:
+      for (uint32_t offset : type->refOffsets) {
+        func(*reinterpret_cast<ObjectHeader**>(payload() + offset));
+      }
+      break;
+    case Layout::kRefArray: {
+      ObjectHeader** slots = reinterpret_cast<ObjectHeader**>(payload());
+      for (size_t i = 0, n = payloadSize() / sizeof(ObjectHeader*); i < n; i++) { func(slots[i]); }
+      break;
+    }
+    case Layout::kBytes:
+      break;
+  }
+}
+
+}  // namespace gc
+}  // namespace runtime
+}  // namespace zomlang
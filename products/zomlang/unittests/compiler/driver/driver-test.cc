@@ -0,0 +1,149 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "zomlang/compiler/driver/driver.h"
+
+#include "zc/core/common.h"
+#include "zc/core/string.h"
+#include "zc/ztest/gtest.h"
+#include "zc/ztest/test.h"
+#include "zomlang/compiler/source/module.h"
+
+namespace zomlang {
+namespace compiler {
+namespace driver {
+namespace {
+
+class TestClock final : public zc::Clock {
+public:
+  void tick() { time += 1 * zc::SECONDS; }
+
+  [[nodiscard]] zc::Date now() const override { return time; }
+
+private:
+  zc::Date time = zc::UNIX_EPOCH + 1 * zc::SECONDS;
+};
+
+class TestEmitter final : public ArtifactEmitter {
+public:
+  explicit TestEmitter(zc::StringPtr version) : version(version) {}
+
+  zc::Path getOutputPath(const source::Module& module) const override {
+    return zc::Path::parse(zc::str(module.getModuleName(), ".out"));
+  }
+
+  zc::Array<zc::byte> serialize(const source::Module& module) const override {
+    return zc::heapArray(zc::str(version, ":", module.getModuleName()).asBytes());
+  }
+
+private:
+  zc::StringPtr version;
+};
+
+ZC_TEST("CompilerDriver emits one output per module") {
+  TestClock clock;
+  auto src = zc::newInMemoryDirectory(clock);
+  auto out = zc::newInMemoryDirectory(clock);
+
+  CompilerDriver driver;
+  for (int i = 0; i < 16; i++) {
+    auto path = zc::Path::parse(zc::str("mod", i, ".zom"));
+    src->openFile(path, zc::WriteMode::CREATE)->writeAll(zc::str("let x = ", i, ";"));
+    ZC_EXPECT(driver.addSourceFile(*src, path) != zc::none);
+  }
+  driver.addOutput(zc::heap<TestEmitter>("v1"), zc::Path("gen"));
+
+  auto result = driver.emitOutputs(*out, 4);
+  ZC_EXPECT(result.written.size() == 16);
+  ZC_EXPECT(result.unchanged.size() == 0);
+
+  // Results come back in the order the modules were added, whatever the scheduling was.
+  for (int i = 0; i < 16; i++) {
+    ZC_EXPECT(result.written[i].toString() == zc::str("gen/mod", i, ".zom.out"));
+    auto content = out->openFile(result.written[i])->readAllText();
+    ZC_EXPECT(content == zc::str("v1:mod", i, ".zom"), content);
+  }
+}
+
+ZC_TEST("CompilerDriver does not rewrite unchanged outputs") {
+  TestClock clock;
+  auto src = zc::newInMemoryDirectory(clock);
+  auto out = zc::newInMemoryDirectory(clock);
+
+  src->openFile(zc::Path("a.zom"), zc::WriteMode::CREATE)->writeAll("a");
+  src->openFile(zc::Path("b.zom"), zc::WriteMode::CREATE)->writeAll("b");
+
+  {
+    CompilerDriver driver;
+    driver.addSourceFile(*src, zc::Path("a.zom"));
+    driver.addSourceFile(*src, zc::Path("b.zom"));
+    driver.addOutput(zc::heap<TestEmitter>("v1"));
+    ZC_EXPECT(driver.emitOutputs(*out, 2).written.size() == 2);
+  }
+
+  zc::Date firstWrite = out->openFile(zc::Path("a.zom.out"))->stat().lastModified;
+  clock.tick();
+
+  {
+    CompilerDriver driver;
+    driver.addSourceFile(*src, zc::Path("a.zom"));
+    driver.addSourceFile(*src, zc::Path("b.zom"));
+    driver.addOutput(zc::heap<TestEmitter>("v1"));
+    auto result = driver.emitOutputs(*out, 2);
+    ZC_EXPECT(result.written.size() == 0);
+    ZC_EXPECT(result.unchanged.size() == 2);
+  }
+
+  ZC_EXPECT(out->openFile(zc::Path("a.zom.out"))->stat().lastModified == firstWrite);
+
+  {
+    CompilerDriver driver;
+    driver.addSourceFile(*src, zc::Path("a.zom"));
+    driver.addOutput(zc::heap<TestEmitter>("v2"));
+    auto result = driver.emitOutputs(*out, 2);
+    ZC_EXPECT(result.written.size() == 1);
+    ZC_EXPECT(out->openFile(zc::Path("a.zom.out"))->readAllText() == "v2:a.zom");
+  }
+}
+
+ZC_TEST("CompilerDriver adds each module only once") {
+  TestClock clock;
+  auto src = zc::newInMemoryDirectory(clock);
+  auto out = zc::newInMemoryDirectory(clock);
+  src->openFile(zc::Path("a.zom"), zc::WriteMode::CREATE)->writeAll("a");
+
+  CompilerDriver driver;
+  driver.addSourceFile(*src, zc::Path("a.zom"));
+  driver.addSourceFile(*src, zc::Path("a.zom"));
+  driver.addOutput(zc::heap<TestEmitter>("v1"));
+  ZC_EXPECT(driver.emitOutputs(*out).written.size() == 1);
+}
+
+ZC_TEST("CompilerDriver rejects outputs that collide") {
+  TestClock clock;
+  auto src = zc::newInMemoryDirectory(clock);
+  auto out = zc::newInMemoryDirectory(clock);
+  src->openFile(zc::Path("a.zom"), zc::WriteMode::CREATE)->writeAll("a");
+
+  CompilerDriver driver;
+  driver.addSourceFile(*src, zc::Path("a.zom"));
+  driver.addOutput(zc::heap<TestEmitter>("v1"));
+  driver.addOutput(zc::heap<TestEmitter>("v2"));
+  ZC_EXPECT_THROW_MESSAGE("same path", driver.emitOutputs(*out));
+}
+
+}  // namespace
+}  // namespace driver
+}  // namespace compiler
+}  // namespace zomlang
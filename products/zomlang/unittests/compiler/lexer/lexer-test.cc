@@ -0,0 +1,222 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+
+#include "zomlang/compiler/lexer/lexer.h"
+
+#include "zc/core/common.h"
+#include "zc/core/string.h"
+#include "zc/ztest/gtest.h"
+#include "zc/ztest/test.h"
+#include "zomlang/compiler/source/manager.h"
+
+namespace zomlang {
+namespace compiler {
+namespace {
+
+class RecordingConsumer final : public DiagnosticConsumer {
+public:
+  explicit RecordingConsumer(zc::Vector<uint32_t>& ids) : ids(ids) {}
+
+  void handleDiagnostic(const SourceLoc& loc, const Diagnostic& diagnostic) override {
+    ids.add(diagnostic.getId());
+  }
+
+private:
+  zc::Vector<uint32_t>& ids;
+};
+
+/// Lexes a string and collects the tokens and diagnostic ids.
+struct LexResult {
+  zc::Vector<tok> kinds;
+  zc::Vector<zc::String> texts;
+  zc::Vector<uint32_t> diagIds;
+};
+
+/// Owns what a Lexer needs besides its buffer.
+struct LexerContext {
+  zc::Own<zc::Filesystem> disk = zc::newDiskFilesystem();
+  zc::Own<const zc::Directory> dir = zc::newInMemoryDirectory(zc::nullClock());
+  source::SourceManager sourceMgr{*disk, dir->openFile(zc::Path("test.zom"), zc::WriteMode::CREATE),
+                                  *dir, zc::Path("test.zom")};
+  DiagnosticEngine diags{sourceMgr};
+  LangOptions options;
+  LexResult result;
+
+  LexerContext() { diags.addConsumer(zc::heap<RecordingConsumer>(result.diagIds)); }
+
+  Lexer newLexer(zc::StringPtr text) {
+    return Lexer(options, sourceMgr, diags, text, SourceLoc::getFromOpaqueValue(1));
+  }
+};
+
+void lexRest(Lexer& lexer, LexResult& result) {
+  Token token;
+  do {
+    lexer.lex(token);
+    result.kinds.add(token.getKind());
+    result.texts.add(zc::heapString(token.getStart(), token.getLength()));
+  } while (token.getKind() != tok::kEOF);
+}
+
+LexResult lexAll(zc::StringPtr text, CommentRetentionMode mode = CommentRetentionMode::kNone) {
+  LexerContext context;
+  Lexer lexer = context.newLexer(text);
+  if (mode != CommentRetentionMode::kNone) { lexer.setCommentRetentionMode(mode); }
+  lexRest(lexer, context.result);
+  return zc::mv(context.result);
+}
+
+ZC_TEST("Lexer splits a statement into tokens") {
+  auto result = lexAll("let x: i32 = a+=b;");
+  const tok expected[] = {tok::kKeyword,  tok::kIdentifier,  tok::kPunctuation, tok::kIdentifier,
+                          tok::kOperator, tok::kIdentifier,  tok::kOperator,    tok::kIdentifier,
+                          tok::kPunctuation, tok::kEOF};
+  ZC_EXPECT(result.kinds.asPtr() == zc::arrayPtr(expected));
+  ZC_EXPECT(result.texts[6] == "+=");
+  ZC_EXPECT(result.diagIds.size() == 0);
+}
+
+ZC_TEST("Lexer numbers") {
+  auto result = lexAll("0x1F 1_000 1.5 2e10 3E-2 1..2 4.foo");
+  const tok expected[] = {tok::kInteger, tok::kInteger, tok::kFloat,      tok::kFloat,
+                          tok::kFloat,   tok::kInteger, tok::kOperator,   tok::kInteger,
+                          tok::kInteger, tok::kOperator, tok::kIdentifier, tok::kEOF};
+  ZC_EXPECT(result.kinds.asPtr() == zc::arrayPtr(expected));
+  ZC_EXPECT(result.texts[4] == "3E-2");
+}
+
+ZC_TEST("Lexer comments") {
+  auto skipped = lexAll("a // one\n/* two */ b");
+  ZC_EXPECT(skipped.kinds.size() == 3);
+
+  auto kept = lexAll("a // one\n/* two */ b", CommentRetentionMode::kReturnAsTokens);
+  ZC_EXPECT(kept.kinds.size() == 5);
+  ZC_EXPECT(kept.texts[1] == "// one");
+  ZC_EXPECT(kept.texts[2] == "/* two */");
+
+  auto unterminated = lexAll("a /* b");
+  ZC_EXPECT(unterminated.kinds.size() == 2);
+  ZC_EXPECT(unterminated.diagIds.size() == 1);
+  ZC_EXPECT(unterminated.diagIds[0] == uint32_t(LexerDiagId::kUnterminatedBlockComment));
+}
+
+ZC_TEST("Lexer recovers from unterminated strings at the end of the line") {
+  auto result = lexAll("\"a\\\"b\" 'c' \"open\nx");
+  ZC_EXPECT(result.texts[0] == "\"a\\\"b\"");
+  ZC_EXPECT(result.kinds[1] == tok::kString);
+  ZC_EXPECT(result.texts[2] == "\"open");
+  ZC_EXPECT(result.texts[3] == "x");
+  ZC_EXPECT(result.diagIds.size() == 1);
+  ZC_EXPECT(result.diagIds[0] == uint32_t(LexerDiagId::kUnterminatedString));
+}
+
+ZC_TEST("Lexer invalid characters and escaped identifiers") {
+  auto result = lexAll("`let` \x01 `open");
+  ZC_EXPECT(result.kinds[0] == tok::kIdentifier);
+  ZC_EXPECT(result.texts[0] == "`let`");
+  ZC_EXPECT(result.kinds[1] == tok::kUnknown);
+  ZC_EXPECT(result.kinds[2] == tok::kUnknown);
+  ZC_EXPECT(result.texts[3] == "open");
+  ZC_EXPECT(result.diagIds.size() == 2);
+}
+
+ZC_TEST("Lexer string interpolation") {
+  auto result = lexAll("\"a\\(x + (1))b\\(\"c\\(y)\")d\" z");
+  const tok expected[] = {
+      tok::kStringHead,  tok::kIdentifier,   tok::kOperator,   tok::kPunctuation,
+      tok::kInteger,     tok::kPunctuation,  tok::kStringMiddle, tok::kStringHead,
+      tok::kIdentifier,  tok::kStringTail,   tok::kStringTail, tok::kIdentifier,
+      tok::kEOF};
+  ZC_EXPECT(result.kinds.asPtr() == zc::arrayPtr(expected));
+  ZC_EXPECT(result.texts[0] == "\"a\\(");
+  ZC_EXPECT(result.texts[6] == ")b\\(");
+  ZC_EXPECT(result.texts[10] == ")d\"");
+  ZC_EXPECT(result.diagIds.size() == 0);
+
+  auto unterminated = lexAll("\"a\\(x");
+  ZC_EXPECT(unterminated.kinds.size() == 3);
+  ZC_EXPECT(unterminated.diagIds.size() == 1);
+  ZC_EXPECT(unterminated.diagIds[0] == uint32_t(LexerDiagId::kUnterminatedString));
+}
+
+ZC_TEST("Lexer raw strings") {
+  auto result = lexAll("#\"a\"b\\(x)\"# ##\"\\##(y)\"#\"##");
+  ZC_EXPECT(result.kinds[0] == tok::kString);
+  ZC_EXPECT(result.texts[0] == "#\"a\"b\\(x)\"#");
+  ZC_EXPECT(result.kinds[1] == tok::kStringHead);
+  ZC_EXPECT(result.texts[1] == "##\"\\##(");
+  ZC_EXPECT(result.kinds[3] == tok::kStringTail);
+  ZC_EXPECT(result.texts[3] == ")\"#\"##");
+}
+
+ZC_TEST("Lexer regex literals") {
+  auto result = lexAll("a / b / c; x = f(/a[/]b\\//g) / 2; [/x/, /y/]");
+  const tok expected[] = {
+      tok::kIdentifier,   tok::kOperator,    tok::kIdentifier,   tok::kOperator,
+      tok::kIdentifier,   tok::kPunctuation, tok::kIdentifier,   tok::kOperator,
+      tok::kIdentifier,   tok::kPunctuation, tok::kRegexLiteral, tok::kPunctuation,
+      tok::kOperator,     tok::kInteger,     tok::kPunctuation,  tok::kPunctuation,
+      tok::kRegexLiteral, tok::kPunctuation, tok::kRegexLiteral, tok::kPunctuation,
+      tok::kEOF};
+  ZC_EXPECT(result.kinds.asPtr() == zc::arrayPtr(expected));
+  ZC_EXPECT(result.texts[10] == "/a[/]b\\//g");
+
+  auto unterminated = lexAll("x = /abc\ny");
+  ZC_EXPECT(unterminated.texts[2] == "/abc");
+  ZC_EXPECT(unterminated.texts[3] == "y");
+  ZC_EXPECT(unterminated.diagIds.size() == 1);
+  ZC_EXPECT(unterminated.diagIds[0] == uint32_t(LexerDiagId::kUnterminatedRegex));
+}
+
+ZC_TEST("Lexer regex mode") {
+  LexerContext context;
+  Lexer lexer = context.newLexer("a /x/ / b");
+  Token token;
+  lexer.lex(token);
+  ZC_EXPECT(lexer.peekNextToken().getKind() == tok::kOperator);
+
+  lexer.enterMode(LexerMode::kRegexLiteral);
+  ZC_EXPECT(lexer.peekNextToken().getKind() == tok::kRegexLiteral);
+  lexer.lex(token);
+  lexer.exitMode(LexerMode::kRegexLiteral);
+
+  lexRest(lexer, context.result);
+  const tok expected[] = {tok::kOperator, tok::kIdentifier, tok::kEOF};
+  ZC_EXPECT(context.result.kinds.asPtr() == zc::arrayPtr(expected));
+}
+
+ZC_TEST("Lexer restored state uses recorded regex starts") {
+  LexerContext context;
+  zc::StringPtr text = "q = /x/ / 2";
+  Lexer lexer = context.newLexer(text);
+
+  Token regex;
+  Token division;
+  Token token;
+  do {
+    lexer.lex(token);
+    if (token.getKind() == tok::kRegexLiteral) { regex = token; }
+    if (token.getKind() == tok::kOperator && token.getStart()[0] == '/') { division = token; }
+  } while (token.getKind() != tok::kEOF);
+
+  lexer.restoreState(lexer.getStateForBeginningOfToken(regex));
+  ZC_EXPECT(lexer.peekNextToken().getKind() == tok::kRegexLiteral);
+  lexer.restoreState(lexer.getStateForBeginningOfToken(division));
+  ZC_EXPECT(lexer.peekNextToken().getKind() == tok::kOperator);
+}
+
+}  // namespace
+}  // namespace compiler
+}  // namespace zomlang
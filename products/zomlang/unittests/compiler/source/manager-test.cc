@@ -232,5 +232,141 @@ ZC_TEST("ModuleLoader TestSameContentDifferentPaths") {
   }
 }
 
+ZC_TEST("SourceManager records regex literal starts") {
+  TestClock clock;
+  auto dir = newInMemoryDirectory(clock);
+  auto disk = zc::newDiskFilesystem();
+  auto file = dir->openFile(zc::Path("re.zom"), zc::WriteMode::CREATE);
+  source::SourceManager sourceMgr(*disk, zc::mv(file), *dir, zc::Path("re.zom"));
+
+  for (unsigned i = 1; i <= 10000; i += 2) {
+    sourceMgr.recordRegexLiteralStartLoc(SourceLoc::getFromOpaqueValue(i));
+  }
+  // Recording the same location again is harmless.
+  sourceMgr.recordRegexLiteralStartLoc(SourceLoc::getFromOpaqueValue(1));
+
+  ZC_EXPECT(sourceMgr.isRegexLiteralStart(SourceLoc::getFromOpaqueValue(1)));
+  ZC_EXPECT(sourceMgr.isRegexLiteralStart(SourceLoc::getFromOpaqueValue(9999)));
+  ZC_EXPECT(!sourceMgr.isRegexLiteralStart(SourceLoc::getFromOpaqueValue(2)));
+  ZC_EXPECT(!sourceMgr.isRegexLiteralStart(SourceLoc::getFromOpaqueValue(10001)));
+}
+
+SourceLoc locAt(unsigned offset) { return SourceLoc::getFromOpaqueValue(offset); }
+
+CharSourceRange rangeAt(unsigned begin, unsigned end) {
+  return CharSourceRange::getCharRange(locAt(begin), locAt(end));
+}
+
+ZC_TEST("SourceManager finds virtual files by location") {
+  TestClock clock;
+  auto dir = newInMemoryDirectory(clock);
+  auto disk = zc::newDiskFilesystem();
+  auto file = dir->openFile(zc::Path("gen.zom"), zc::WriteMode::CREATE);
+  source::SourceManager sourceMgr(*disk, zc::mv(file), *dir, zc::Path("gen.zom"));
+
+  // Ten thousand generated regions, ten characters each with a gap of five between them.
+  auto files = zc::heapArrayBuilder<source::VirtualFile>(10000);
+  for (unsigned i = 0; i < 10000; i++) {
+    files.add(source::VirtualFile{rangeAt(1 + i * 15, 11 + i * 15), zc::str("v", i), int(i)});
+  }
+  sourceMgr.createVirtualFiles(files.finish());
+  sourceMgr.createVirtualFile(locAt(200000), "single", -1, 5);
+
+  for (unsigned i = 0; i < 10000; i += 97) {
+    auto vf = sourceMgr.getVirtualFile(locAt(1 + i * 15));
+    ZC_ASSERT(vf != nullptr);
+    ZC_EXPECT(vf->name == zc::str("v", i));
+    ZC_EXPECT(sourceMgr.getVirtualFile(locAt(10 + i * 15)) == vf);
+    ZC_EXPECT(sourceMgr.getVirtualFile(locAt(11 + i * 15)) == nullptr);
+  }
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(200004))->name == "single");
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(200005)) == nullptr);
+}
+
+ZC_TEST("SourceManager rejects overlapping virtual files") {
+  TestClock clock;
+  auto dir = newInMemoryDirectory(clock);
+  auto disk = zc::newDiskFilesystem();
+  auto file = dir->openFile(zc::Path("gen.zom"), zc::WriteMode::CREATE);
+  source::SourceManager sourceMgr(*disk, zc::mv(file), *dir, zc::Path("gen.zom"));
+
+  sourceMgr.createVirtualFile(locAt(10), "a", 0, 10);
+  ZC_EXPECT_THROW_MESSAGE("overlaps", sourceMgr.createVirtualFile(locAt(15), "b", 0, 10));
+  ZC_EXPECT_THROW_MESSAGE("overlaps", sourceMgr.createVirtualFile(locAt(5), "b", 0, 6));
+
+  // A bulk registration with one bad entry adds nothing.
+  auto files = zc::heapArrayBuilder<source::VirtualFile>(3);
+  files.add(source::VirtualFile{rangeAt(40, 50), zc::str("c"), 0});
+  files.add(source::VirtualFile{rangeAt(30, 35), zc::str("d"), 0});
+  files.add(source::VirtualFile{rangeAt(45, 60), zc::str("e"), 0});
+  ZC_EXPECT_THROW_MESSAGE("overlap each other", sourceMgr.createVirtualFiles(files.finish()));
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(30)) == nullptr);
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(40)) == nullptr);
+
+  // Adjacent files are fine.
+  sourceMgr.createVirtualFile(locAt(20), "f", 0, 10);
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(19))->name == "a");
+  ZC_EXPECT(sourceMgr.getVirtualFile(locAt(20))->name == "f");
+}
+
+ZC_TEST("SourceManager maps locations to generated buffers") {
+  TestClock clock;
+  auto dir = newInMemoryDirectory(clock);
+  auto disk = zc::newDiskFilesystem();
+  auto file = dir->openFile(zc::Path("gen.zom"), zc::WriteMode::CREATE);
+  source::SourceManager sourceMgr(*disk, zc::mv(file), *dir, zc::Path("gen.zom"));
+
+  auto sources = zc::heapArrayBuilder<source::GeneratedSource>(1000);
+  for (unsigned i = 0; i < 1000; i++) {
+    source::GeneratedSourceInfo info;
+    info.generatedSourceRange = rangeAt(100 + i * 100, 150 + i * 100);
+    info.generatedSource = zc::str("gen", i);
+    sources.add(source::GeneratedSource{i, zc::mv(info)});
+  }
+  sourceMgr.setGeneratedSourceInfos(sources.finish());
+
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(99)) == zc::none);
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(100)) == uint64_t(0));
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(149)) == uint64_t(0));
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(150)) == zc::none);
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(50020)) == uint64_t(499));
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(7)->generatedSource == "gen7");
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(1000) == nullptr);
+
+  // Replacing a buffer's info moves its range.
+  source::GeneratedSourceInfo moved;
+  moved.generatedSourceRange = rangeAt(200000, 200010);
+  moved.generatedSource = zc::str("moved");
+  sourceMgr.setGeneratedSourceInfo(0, zc::mv(moved));
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(100)) == zc::none);
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(200005)) == uint64_t(0));
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(0)->generatedSource == "moved");
+
+  source::GeneratedSourceInfo overlapping;
+  overlapping.generatedSourceRange = rangeAt(220, 230);
+  ZC_EXPECT_THROW_MESSAGE("overlaps", sourceMgr.setGeneratedSourceInfo(5000, zc::mv(overlapping)));
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(5000) == nullptr);
+
+  // A failed replacement leaves the buffer where it was.
+  source::GeneratedSourceInfo clash;
+  clash.generatedSourceRange = rangeAt(320, 330);
+  ZC_EXPECT_THROW_MESSAGE("overlaps", sourceMgr.setGeneratedSourceInfo(1, zc::mv(clash)));
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(200)) == uint64_t(1));
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(1)->generatedSource == "gen1");
+
+  // A batch that lists a buffer twice is rejected and changes nothing.
+  auto twice = zc::heapArrayBuilder<source::GeneratedSource>(2);
+  for (unsigned begin : {300000, 300100}) {
+    source::GeneratedSourceInfo info;
+    info.generatedSourceRange = rangeAt(begin, begin + 10);
+    info.generatedSource = zc::str("twice");
+    twice.add(source::GeneratedSource{2, zc::mv(info)});
+  }
+  ZC_EXPECT_THROW_MESSAGE("buffer listed twice", sourceMgr.setGeneratedSourceInfos(twice.finish()));
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(300000)) == zc::none);
+  ZC_EXPECT(sourceMgr.findGeneratedBufferContainingLoc(locAt(300)) == uint64_t(2));
+  ZC_EXPECT(sourceMgr.getGeneratedSourceInfo(2)->generatedSource == "gen2");
+}
+
 }  // namespace compiler
 }  // namespace zomlang
\ No newline at end of file
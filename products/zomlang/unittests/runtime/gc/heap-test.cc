@@ -0,0 +1,245 @@
+// Copyright (c) 2025 Zode.Z. All rights reserved
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+// License for the specific language governing permissions and limitations under
+// the License.
+
+#include "zomlang/runtime/gc/heap.h"
+
+#include "zc/core/thread.h"
+#include "zc/ztest/gtest.h"
+#include "zc/ztest/test.h"
+
+namespace zomlang {
+namespace runtime {
+namespace gc {
+namespace {
+
+// A closure: one captured reference plus an integer.
+struct Closure {
+  ObjectHeader* env;
+  int64_t value;
+};
+
+const uint32_t CLOSURE_REFS[] = {0};
+const TypeInfo CLOSURE_TYPE = {"closure", Layout::kFixed, zc::arrayPtr(CLOSURE_REFS, 1)};
+const TypeInfo ARRAY_TYPE = {"array", Layout::kRefArray, nullptr};
+const TypeInfo STR_TYPE = {"str", Layout::kBytes, nullptr};
+
+HeapOptions smallHeap() {
+  HeapOptions options;
+  options.edenBytes = 64 << 10;
+  options.survivorBytes = 16 << 10;
+  options.oldBytes = 1 << 20;
+  options.tlabBytes = 4 << 10;
+  options.tenureAge = 2;
+  return options;
+}
+
+ObjectHeader* newClosure(Mutator& mutator, ObjectHeader* env, int64_t value) {
+  ObjectHeader* object = mutator.allocate(CLOSURE_TYPE, sizeof(Closure));
+  object->as<Closure>().env = env;
+  object->as<Closure>().value = value;
+  return object;
+}
+
+ZC_TEST("Heap allocations are zeroed and aligned") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+
+  ObjectHeader* object = mutator.allocate(STR_TYPE, 13);
+  ZC_EXPECT(object->size % 8 == 0);
+  ZC_EXPECT(object->payloadSize() >= 13);
+  ZC_EXPECT(reinterpret_cast<uintptr_t>(object->payload()) % 8 == 0);
+  for (auto b : zc::arrayPtr(object->payload(), object->payloadSize())) { ZC_EXPECT(b == 0); }
+  ZC_EXPECT(heap.isYoung(object));
+}
+
+ZC_TEST("Heap minor collection keeps rooted objects and drops garbage") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<2> roots(mutator);
+
+  roots[0] = newClosure(mutator, nullptr, 1);
+  roots[0]->as<Closure>().env = newClosure(mutator, nullptr, 2);
+  for (int i = 0; i < 100; i++) { newClosure(mutator, nullptr, i); }
+
+  ObjectHeader* before = roots[0];
+  mutator.collect();
+
+  ZC_EXPECT(roots[0] != before);
+  ZC_EXPECT(heap.isYoung(roots[0]));
+  ZC_EXPECT(roots[0]->as<Closure>().value == 1);
+  ZC_EXPECT(roots[0]->as<Closure>().env->as<Closure>().value == 2);
+
+  auto stats = heap.getStats();
+  ZC_EXPECT(stats.minorCollections == 1);
+  ZC_EXPECT(stats.majorCollections == 0);
+  ZC_EXPECT(stats.bytesSurvived == 2 * roots[0]->size);
+  ZC_EXPECT(stats.youngBytesInUse == 2 * roots[0]->size);
+}
+
+ZC_TEST("Heap promotes objects after tenureAge collections") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<1> roots(mutator);
+
+  roots[0] = newClosure(mutator, nullptr, 42);
+  mutator.collect();
+  ZC_EXPECT(heap.isYoung(roots[0]));
+  mutator.collect();
+  ZC_EXPECT(heap.isOld(roots[0]));
+  ZC_EXPECT(roots[0]->as<Closure>().value == 42);
+  ZC_EXPECT(heap.getStats().bytesPromoted == roots[0]->size);
+}
+
+ZC_TEST("Heap write barrier keeps young objects referenced from old ones alive") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<1> roots(mutator);
+
+  roots[0] = newClosure(mutator, nullptr, 1);
+  mutator.collect();
+  mutator.collect();
+  ZC_ASSERT(heap.isOld(roots[0]));
+
+  ObjectHeader* young = newClosure(mutator, nullptr, 7);
+  mutator.store(roots[0], roots[0]->as<Closure>().env, young);
+  mutator.collect();
+
+  ObjectHeader* env = roots[0]->as<Closure>().env;
+  ZC_EXPECT(env != young);
+  ZC_EXPECT(heap.isYoung(env));
+  ZC_EXPECT(env->as<Closure>().value == 7);
+
+  // The old object still points into the young generation, so it must stay remembered.
+  mutator.collect();
+  ZC_EXPECT(heap.isOld(roots[0]->as<Closure>().env));
+  ZC_EXPECT(roots[0]->as<Closure>().env->as<Closure>().value == 7);
+}
+
+ZC_TEST("Heap major collection compacts the old generation") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<2> roots(mutator);
+
+  // Promote a chain of closures, then drop every other one.
+  roots[0] = mutator.allocate(ARRAY_TYPE, 16 * sizeof(ObjectHeader*));
+  for (unsigned i = 0; i < 16; i++) {
+    ObjectHeader* closure = newClosure(mutator, nullptr, i);
+    mutator.store(roots[0], roots[0]->refAt(i), closure);
+  }
+  mutator.collect();
+  mutator.collect();
+  ZC_ASSERT(heap.isOld(roots[0]));
+  for (unsigned i = 0; i < 16; i++) { ZC_ASSERT(heap.isOld(roots[0]->refAt(i))); }
+
+  for (unsigned i = 0; i < 16; i += 2) { roots[0]->refAt(i) = nullptr; }
+  size_t oldBefore = heap.getStats().oldBytesInUse;
+
+  // A young object referenced only from the old array, and an old object referenced only from a
+  // young one: both must survive compaction with their references updated.
+  roots[1] = newClosure(mutator, roots[0]->refAt(15), 99);
+  mutator.store(roots[0], roots[0]->refAt(0), newClosure(mutator, nullptr, 100));
+
+  mutator.collect(true);
+
+  auto stats = heap.getStats();
+  ZC_EXPECT(stats.majorCollections == 1);
+  ZC_EXPECT(stats.oldBytesInUse < oldBefore);
+  ZC_EXPECT(stats.bytesCompacted == oldBefore - stats.oldBytesInUse);
+
+  for (unsigned i = 1; i < 16; i += 2) { ZC_EXPECT(roots[0]->refAt(i)->as<Closure>().value == i); }
+  ZC_EXPECT(roots[0]->refAt(0)->as<Closure>().value == 100);
+  ZC_EXPECT(roots[1]->as<Closure>().value == 99);
+  ZC_EXPECT(roots[1]->as<Closure>().env == roots[0]->refAt(15));
+}
+
+ZC_TEST("Heap global roots") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+
+  ObjectHeader* global = newClosure(mutator, nullptr, 5);
+  heap.addRoot(global);
+  mutator.collect(true);
+  ZC_EXPECT(global->as<Closure>().value == 5);
+  heap.removeRoot(global);
+}
+
+ZC_TEST("Heap survives closure-heavy churn") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<1> roots(mutator);
+
+  // Keep a rolling linked list of the last few closures alive while allocating many more.
+  for (int i = 0; i < 100000; i++) {
+    ObjectHeader* next = newClosure(mutator, roots[0], i);
+    roots[0] = next;
+    if (i % 8 == 0) {
+      ObjectHeader* node = roots[0];
+      for (int depth = 0; depth < 4 && node != nullptr; depth++) { node = node->as<Closure>().env; }
+      if (node != nullptr) { mutator.store(node, node->as<Closure>().env, nullptr); }
+    }
+  }
+
+  int64_t expected = 99999;
+  for (ObjectHeader* node = roots[0]; node != nullptr; node = node->as<Closure>().env) {
+    ZC_EXPECT(node->as<Closure>().value == expected--);
+  }
+
+  auto stats = heap.getStats();
+  ZC_EXPECT(stats.minorCollections > 0);
+  ZC_EXPECT(stats.bytesAllocated >= 99000 * (sizeof(ObjectHeader) + sizeof(Closure)));
+  ZC_EXPECT(stats.allocationRate() > 0);
+  ZC_EXPECT(stats.maxMinorPause > 0 * zc::NANOSECONDS);
+}
+
+ZC_TEST("Heap large objects are allocated in the old generation") {
+  Heap heap(smallHeap());
+  Mutator mutator(heap);
+  RootScope<1> roots(mutator);
+
+  roots[0] = mutator.allocate(STR_TYPE, 8 << 10);
+  ZC_EXPECT(heap.isOld(roots[0]));
+  roots[0] = nullptr;
+
+  // Filling the old generation with garbage forces a major collection rather than a failure.
+  for (int i = 0; i < 1000; i++) { mutator.allocate(STR_TYPE, 8 << 10); }
+  ZC_EXPECT(heap.getStats().majorCollections > 0);
+}
+
+ZC_TEST("Heap collects with multiple mutator threads") {
+  Heap heap(smallHeap());
+
+  auto work = [&heap](int64_t seed) {
+    Mutator mutator(heap);
+    RootScope<1> roots(mutator);
+    for (int64_t i = 0; i < 20000; i++) {
+      roots[0] = newClosure(mutator, roots[0], seed + i);
+      if (i % 4 == 0) { roots[0]->as<Closure>().env = nullptr; }
+      mutator.safepoint();
+    }
+    ZC_EXPECT(roots[0]->as<Closure>().value == seed + 19999);
+  };
+
+  {
+    zc::Thread t1([&]() { work(0); });
+    zc::Thread t2([&]() { work(1000000); });
+    zc::Thread t3([&]() { work(2000000); });
+  }
+
+  ZC_EXPECT(heap.getStats().minorCollections > 0);
+}
+
+}  // namespace
+}  // namespace gc
+}  // namespace runtime
+}  // namespace zomlang